@@ -0,0 +1,48 @@
+/*
+ * main.cpp
+ *
+ * (Un)License: Public Domain
+ * You can use and modify this file without any restriction.
+ * Do what you want.
+ * No warranties and disclaimer of any damages.
+ * More info: http://unlicense.org
+ * The latest sources: https://github.com/republib
+ */
+
+/** @file
+ * Converts binary log files (written by ReBinaryFileAppender) into text.
+ */
+#include "base/rebase.hpp"
+#include <QCoreApplication>
+
+static void usage(const char* message, const char* argument = "") {
+   fprintf(stderr,
+           "Usage: rebinlog [-f <format_table>] <log_file> [<log_file> ...]\n"
+           "  <format_table>: created by tools/mk_logformats.pl\n"
+           "+++ %s%s\n", message, argument);
+   exit(1);
+}
+
+int main(int argc, char* argv[]) {
+   QCoreApplication a(argc, argv);
+   QMap<int, QByteArray> formats;
+   int ix = 1;
+   if (ix < argc && strcmp(argv[ix], "-f") == 0) {
+      if (++ix >= argc)
+         usage("missing format table");
+      if (ReBinaryLogReader::loadFormats(argv[ix], formats) == 0)
+         usage("no formats found in ", argv[ix]);
+      ix++;
+   }
+   if (ix >= argc)
+      usage("missing log file");
+   ReBinaryLogReader reader(&formats);
+   for (; ix < argc; ix++) {
+      if (!reader.open(argv[ix]))
+         usage("not a binary log file: ", argv[ix]);
+      const ReBinaryLogRecord_t* record;
+      while ((record = reader.nextRecord()) != NULL)
+         printf("%s\n", reader.asText(record).constData());
+   }
+   return 0;
+}
@@ -0,0 +1,18 @@
+QT       += core
+QT       -= gui
+
+TARGET = rebinlog
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH = ../..
+
+SOURCES += main.cpp \
+	../../base/ReLogger.cpp \
+	../../base/ReBinaryLogger.cpp \
+	../../base/ReStringUtils.cpp \
+	../../base/ReException.cpp
+
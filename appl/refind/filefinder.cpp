@@ -10,8 +10,10 @@
  */
 
 #include <QDir>
+#include <QElapsedTimer>
 #include "base/rebase.hpp"
 #include "gui/regui.hpp"
+#include "os/reos.hpp"
 #include "utils.hpp"
 #include "mainwindow.hpp"
 #include "filefinder.hpp"
@@ -34,10 +36,18 @@ FileFinder::FileFinder() :
    m_checkDates(false),
    m_excludedDirs(),
    m_textFinder(NULL),
-   m_table(NULL),
+   m_model(NULL),
    m_statistics(),
    m_guiQueue(NULL),
-   m_maxHits(0) {
+   m_maxHits(0),
+   m_stop(false),
+   m_pool(),
+   m_freeSlots(4 * QThread::idealThreadCount()),
+   m_mutex(),
+   m_index(NULL),
+   m_lastPath(),
+   m_currentPath(),
+   m_nextUpdate(0) {
    m_youngerThan.setMSecsSinceEpoch(0);
    m_olderThan.setMSecsSinceEpoch(0);
 }
@@ -46,6 +56,7 @@ FileFinder::FileFinder() :
  * Destructor.
  */
 FileFinder::~FileFinder() {
+   m_pool.waitForDone();
 }
 
 /**
@@ -56,34 +67,57 @@ void FileFinder::clear() {
 }
 
 /**
- * Returns a string representation of the filesize.
+ * Returns the type of a directory entry.
  *
- * @param size  the size to convert
- * @return      the filesize as a string
+ * @param type  the type of the traverser or the index, e.g. TF_SUBDIR
+ * @return      the file type, e.g. ReFileResultStore::FT_DIR
  */
-QString fileSize(int64_t size) {
-   QString rc;
-   rc.sprintf("%12.6f", (double) size / 1000000.0);
+static ReFileResultStore::FileType typeOf(ReDirStatus_t::Type_t type) {
+   ReFileResultStore::FileType rc;
+   switch (type) {
+   case ReDirStatus_t::TF_SUBDIR:
+      rc = ReFileResultStore::FT_DIR;
+      break;
+   case ReDirStatus_t::TF_LINK_DIR:
+      rc = ReFileResultStore::FT_LINK_DIR;
+      break;
+   case ReDirStatus_t::TF_LINK:
+      rc = ReFileResultStore::FT_LINK_FILE;
+      break;
+   default:
+      rc = ReFileResultStore::FT_FILE;
+      break;
+   }
    return rc;
 }
+
 /**
- * Returns the type of the file.
+ * Adds a row for a found file to the table.
  *
- * @param info  the file info
- * @return      a string describing the text
- */
-QString typeOf(const QFileInfo& info) {
-   QString rc;
-   if (info.isSymLink()) {
-      if (info.isDir())
-         rc = QObject::tr("link (dir)");
-      else
-         rc = QObject::tr("link (file)");
-   } else if (info.isDir())
-      rc = QObject::tr("dir");
-   else
-      rc = QObject::tr("file");
-   return rc;
+ * Can be called by the walker and by the content search workers.
+ *
+ * @param node      the filename without path
+ * @param path      the directory of the file
+ * @param size      the file size
+ * @param modified  the modification time in msec since the epoch
+ * @param type      the file type, e.g. ReFileResultStore::FT_DIR
+ * @return          <code>false</code>: the maximal hit count is reached
+ */
+bool FileFinder::addRow(const QString& node, const QString& path, int64_t size,
+                        int64_t modified, ReFileResultStore::FileType type) {
+   QMutexLocker locker(&m_mutex);
+   if (m_maxHits.load() <= 0)
+      return false;
+   if (type == ReFileResultStore::FT_DIR
+         || type == ReFileResultStore::FT_LINK_DIR)
+      m_statistics.m_dirs++;
+   else {
+      m_statistics.m_files++;
+      m_statistics.m_bytes += size;
+   }
+   // the cells are formatted by the model when they become visible:
+   m_model->add(node, path, size, modified, type);
+   return m_maxHits.fetchAndAddOrdered(-1) > 1;
 }
 
 /**
@@ -95,101 +129,146 @@ void FileFinder::setTextFinder(TextFinder* textFinder) {
    m_textFinder = textFinder;
 }
 
+/**
+ * Processes a directory entry found by the traverser or the index.
+ *
+ * @param path      the directory of the entry
+ * @param node      the name of the entry
+ * @param size      the file size
+ * @param modified  the modification time in msec since the epoch
+ * @param type      the type of the entry, e.g. ReDirStatus_t::TF_REGULAR
+ * @return          <code>false</code>: the search should be stopped
+ */
+bool FileFinder::foundEntry(const QByteArray& path, const char* node,
+                            int64_t size, int64_t modified, ReDirStatus_t::Type_t type) {
+   if (path != m_lastPath) {
+      m_lastPath = path;
+      int length = m_lastPath.length();
+      if (length > 1 && m_lastPath.endsWith(OS_SEPARATOR))
+         length--;
+      m_currentPath = I18N::b2s(m_lastPath.constData(), length);
+   }
+   bool rc = true;
+   ReFileResultStore::FileType fileType = typeOf(type);
+   if (shouldStop())
+      rc = false;
+   else if (!wildcardsMatch(node))
+      rc = true;
+   else if (m_textFinder == NULL)
+      rc = addRow(I18N::b2s(node), m_currentPath, size, modified, fileType);
+   else if (fileType != ReFileResultStore::FT_DIR
+              && fileType != ReFileResultStore::FT_LINK_DIR) {
+      QByteArray fullName(m_lastPath);
+      if (!fullName.endsWith(OS_SEPARATOR))
+         fullName.append(OS_SEPARATOR);
+      fullName.append(node);
+      // the content is searched by the pool, the walker continues:
+      m_freeSlots.acquire();
+      // the workers may have reached the limit while we were waiting:
+      if (shouldStop()) {
+         m_freeSlots.release();
+         rc = false;
+      } else
+         m_pool.start(new ContentSearchTask(this, I18N::b2s(node),
+                                            m_currentPath, I18N::b2s(fullName), size, modified, fileType));
+   }
+   clock_t now = clock();
+   if (now > m_nextUpdate) {
+      m_guiQueue->pushBack(ReGuiQueueItem(ReGuiQueueItem::LogMessage, NULL,
+                                          m_currentPath));
+      m_nextUpdate = now + CLOCKS_PER_SEC;
+   }
+   return rc;
+}
+
 /**
  * Fills the table with the data of the filtered files of a given directory.
  *
- * This method is recursive over all directories.
+ * If the directory is part of a file index the disk is not accessed.
+ * Otherwise the whole tree is walked by one traverser: each directory is
+ * read only once and the file status is fetched only if a filter condition
+ * needs it.
  *
  * @param path          the directory to inspect
- * @param depth         the depth of the directory (relative to base directory)
  */
-void FileFinder::fillTable(const QString& path, int depth) {
-   QFileInfoList entries;
-#if defined __linux__
-   QDir dir(path);
-#elif defined WIN32
-   QDir dir(path.length() == 2 && path[1] == ':' ? path + "\\" : path);
-#endif
-   QDir::Filters filters = m_fileTypes | QDir::NoDotAndDotDot;
-   if (m_patterns.count() == 0)
-      entries = dir.entryInfoList(filters, QDir::NoSort);
-   else
-      entries = dir.entryInfoList(m_patterns, filters, QDir::NoSort);
-   //QString relativePath = ReQStringUtils::nativePath(
-   //path.mid(1 + m_baseDir.length()));
-   QString node, ext;
-   QList<QRegExp*> antiPatterns;
-   QStringList::const_iterator it3;
-   for (it3 = m_antiPatterns.begin(); it3 != m_antiPatterns.end(); ++it3) {
-      QString pattern(*it3);
-      antiPatterns.append(new QRegExp(pattern, Qt::CaseInsensitive, QRegExp::Wildcard));
-   }
-   QList<QRegExp*>::const_iterator it2;
-   QList <QFileInfo>::const_iterator it;
-   clock_t nextUpdate = clock() + CLOCKS_PER_SEC;
-   QString row, size, type, modified;
-   for (it = entries.begin(); it != entries.end(); ++it) {
-      node = it->fileName();
-      if (node == "." || node == "..")
-         continue;
-      bool ignore = false;
-      for (it2 = antiPatterns.begin(); it2 != antiPatterns.end(); ++it2) {
-         if ((*it2)->indexIn(node) >= 0) {
-            ignore = true;
-            break;
-         }
-      }
-      if (ignore)
-         continue;
-      if (m_stop)
+void FileFinder::fillTable(const QString& path) {
+   QStringList excludes(m_excludedDirs);
+   QStringList patterns;
+   QStringList antiPatterns;
+   m_wildcardPatterns.clear();
+   m_wildcardAntiPatterns.clear();
+   // '?' and '[' are not supported by ReMatcher: QRegExp as before
+   QStringList::const_iterator it;
+   for (it = m_patterns.cbegin(); it != m_patterns.cend(); ++it) {
+      if (it->indexOf('?') >= 0 || it->indexOf('[') >= 0)
          break;
-      if (depth >= m_minDepth && isValid(*it)) {
-         bool isDir = it->isDir();
-         if (isDir)
-            m_statistics.m_dirs++;
-         else
-            m_statistics.m_files++;
-         row.clear();
-         // TC_NODE, TC_EXT, TC_SIZE, TC_MODIFIED, TC_TYPE, TC_PATH
-         int ix = node.lastIndexOf('.');
-         ext = ix <= 0 ? "" : node.mid(ix + 1).toLower();
-         type = typeOf(*it);
-         if (isDir)
-            size.clear();
-         else
-            size = fileSize(it->size());
-         modified = it->lastModified().toString("yyyy.MM.dd/hh:mm:ss");
-         row.reserve(6 + node.length() + ext.length() + size.length()
-                     + modified.length() + type.length() + path.length());
-         row.append('\t').append(node).append('\t').append(ext);
-         row.append('\t').append(size).append('\t').append(modified);
-         row.append('\t').append(type).append('\t').append(path);
-         if (!isDir)
-            m_statistics.m_bytes += it->size();
-         m_guiQueue->pushBack(ReGuiQueueItem(ReGuiQueueItem::NewTableRow, m_table, row));
-         if (--m_maxHits <= 0)
-            break;
-      }
-      clock_t now = clock();
-      if (now > nextUpdate) {
-         m_guiQueue->pushBack(ReGuiQueueItem(ReGuiQueueItem::LogMessage, NULL, path));
-         nextUpdate = now + CLOCKS_PER_SEC;
-      }
    }
-   for (it2 = antiPatterns.begin(); it2 != antiPatterns.end(); ++it2) {
-      delete *it2;
+   if (it == m_patterns.cend())
+      patterns = m_patterns;
+   else {
+      // one of the alternatives needs QRegExp: all are tested by QRegExp
+      for (it = m_patterns.cbegin(); it != m_patterns.cend(); ++it)
+         m_wildcardPatterns.append(QRegExp(*it, Qt::CaseInsensitive,
+                                           QRegExp::Wildcard));
    }
-   if (! m_stop && (depth < m_maxDepth || m_maxDepth < 0) && m_maxHits > 0) {
-      entries = dir.entryInfoList(
-                   QDir::NoSymLinks | QDir::NoDotAndDotDot | QDir::AllDirs, QDir::NoSort);
-      bool filtered = m_excludedDirs.length() > 0;
-      for (it = entries.begin(); it != entries.end(); ++it) {
-         QString node = it->fileName();
-         if (!filtered || !isExcludedDir(node))
-            fillTable(path + QDir::separator() + node, depth + 1);
-      }
+   for (it = m_antiPatterns.cbegin(); it != m_antiPatterns.cend(); ++it) {
+      if (it->indexOf('?') >= 0 || it->indexOf('[') >= 0)
+         m_wildcardAntiPatterns.append(QRegExp(*it, Qt::CaseInsensitive,
+                                               QRegExp::Wildcard));
+      else
+         // an anti pattern may match anywhere in the name:
+         antiPatterns.append("*" + *it + "*");
+   }
+#if defined __linux__
+   // QDir does not show hidden files without QDir::Hidden:
+   if ((m_fileTypes & QDir::Hidden) == 0) {
+      excludes.append(".*");
+      antiPatterns.append(".*");
+   }
+#endif
+   ReIncludeExcludeMatcher dirPatterns(ReQStringUtils::m_emptyList, excludes,
+                                       Qt::CaseInsensitive, true);
+   ReIncludeExcludeMatcher nodePatterns(patterns, antiPatterns,
+                                        Qt::CaseInsensitive, true);
+   ReDirEntryFilter filter;
+   filter.m_nodePatterns = &nodePatterns;
+   filter.m_pathPatterns = &dirPatterns;
+   int types = 0;
+   bool withLinks = (m_fileTypes & QDir::NoSymLinks) == 0;
+   if ((m_fileTypes & QDir::Files) != 0)
+      types |= ReDirStatus_t::TF_REGULAR | (withLinks ? ReDirStatus_t::TF_LINK : 0);
+   if ((m_fileTypes & QDir::Dirs) != 0)
+      types |= ReDirStatus_t::TF_SUBDIR
+               | (withLinks ? ReDirStatus_t::TF_LINK_DIR : 0);
+   filter.m_types = ReDirStatus_t::Type_t(types);
+   filter.m_minSize = m_minSize;
+   filter.m_maxSize = m_maxSize;
+   if (m_olderThan.toMSecsSinceEpoch() > 0)
+      ReDirStatus_t::timeToFiletime(m_olderThan.toTime_t(), filter.m_minAge);
+   if (m_youngerThan.toMSecsSinceEpoch() > 0)
+      ReDirStatus_t::timeToFiletime(m_youngerThan.toTime_t(), filter.m_maxAge);
+   filter.m_minDepth = m_minDepth;
+   filter.m_maxDepth = m_maxDepth < 0
+                       || m_maxDepth >= MAX_ENTRY_STACK_DEPTH
+                       ? MAX_ENTRY_STACK_DEPTH - 1 : m_maxDepth;
+   m_lastPath.clear();
+   m_currentPath.clear();
+   m_nextUpdate = clock() + CLOCKS_PER_SEC;
+   QByteArray thePath = I18N::s2b(path);
+   if (m_index != NULL && m_index->query(thePath, filter, *this) >= 0)
+      return;
+   ReTraverser traverser(thePath.constData());
+   traverser.setDepthFirst(false);
+   traverser.setPropertiesFromFilter(&filter);
+   int level = 0;
+   ReDirStatus_t* entry;
+   while (!shouldStop() && (entry = traverser.nextFile(level, &filter)) != NULL) {
+      if (!foundEntry(entry->m_path, entry->node(), entry->fileSize(),
+                      ReDirStatus_t::filetimeToMSec(entry->modified()), entry->type()))
+         break;
    }
 }
+
 /**
  * Runs a file search in a second thread.
  */
@@ -201,14 +280,16 @@ void FileFinder::run() {
  * Fills the table with the data of the filtered files of a given directory.
  */
 void FileFinder::search() {
-   clock_t start = clock();
+   // clock() would sum up the time of all workers:
+   QElapsedTimer timer;
+   timer.start();
    setStop(false);
    m_statistics.clear();
    QString path = ReFileUtils::nativePath(m_baseDir);
    path = ReQStringUtils::chomp(path, OS_SEPARATOR);
-   fillTable(path, 0);
-   m_statistics.m_runtimeSeconds = (double) (clock() - start)
-                                   / CLOCKS_PER_SEC;
+   fillTable(path);
+   m_pool.waitForDone();
+   m_statistics.m_runtimeSeconds = timer.elapsed() / 1000.0;
    QString msg;
    msg.sprintf(
       I18N::s2b(QObject::tr(
@@ -219,56 +300,49 @@ void FileFinder::search() {
 }
 
 /**
- * Checks whether a filename matches the list of excluded directories.
+ * Sets the stop flag.
  *
- * @param node  filename to check
- * @return      <code>true</code>: the node is part of the excluded dirs
- */
-bool FileFinder::isExcludedDir(const QString& node) {
-   bool rc = false;
-   QList <QString>::iterator it;
-   for (it = m_excludedDirs.begin(); it != m_excludedDirs.end(); ++it) {
-      if (QString::compare(node, *it, Qt::CaseInsensitive) == 0) {
-         rc = true;
-         break;
-      }
-   }
-   return rc;
+ * @param stop  <code>true</code>: the file search must be stopped
+ */
+void FileFinder::setStop(bool stop) {
+   m_stop.store(stop ? 1 : 0);
 }
 
 /**
- * Tests whether a file matches the filter conditions.
+ * Tests a filename against the patterns which are not handled by
+ * <code>ReMatcher</code>.
  *
- * @param file  the file to inspect
- * @return      <code>true</code>: the file matches the filter condition
- */
-bool FileFinder::isValid(const QFileInfo& file) {
-   int64_t size = file.size();
-   bool rc = size >= m_minSize && (m_maxSize < 0 || size <= m_maxSize);
-   bool checkYounger;
-   if (rc
-         && ((checkYounger = m_youngerThan.toMSecsSinceEpoch() > 0)
-             || m_olderThan.toMSecsSinceEpoch() > 0)) {
-      QDateTime date = file.lastModified();
-      rc = !checkYounger || date >= m_youngerThan;
-      if (rc)
-         rc = m_olderThan.toMSecsSinceEpoch() == 0 || date <= m_olderThan;
-   }
-   if (rc && m_textFinder != NULL) {
-      QString full = file.absoluteFilePath();
-      TextFinder textFinder(full, file.size());
-      textFinder.getSearchParameter(*m_textFinder);
-      rc = textFinder.contains();
+ * The file patterns must match the whole name, the anti patterns may match
+ * anywhere in the name (like the former <code>QRegExp</code> filter).
+ *
+ * @param node  the filename without path
+ * @return      <code>true</code>: the name matches the patterns
+ */
+bool FileFinder::wildcardsMatch(const char* node) const {
+   bool rc = true;
+   if (!m_wildcardPatterns.isEmpty() || !m_wildcardAntiPatterns.isEmpty()) {
+      QString name = I18N::b2s(node);
+      if (!m_wildcardPatterns.isEmpty()) {
+         rc = false;
+         for (int ix = 0; !rc && ix < m_wildcardPatterns.size(); ix++)
+            rc = m_wildcardPatterns.at(ix).exactMatch(name);
+      }
+      for (int ix = 0; rc && ix < m_wildcardAntiPatterns.size(); ix++)
+         rc = m_wildcardAntiPatterns.at(ix).indexIn(name) < 0;
    }
    return rc;
 }
+
 /**
- * Sets the stop flag.
+ * Tests whether the search should end.
  *
- * @param stop  <code>true</code>: the file search must be stopped
+ * Can be called by the walker and by the content search workers.
+ *
+ * @return  <code>true</code>: the search is stopped or the maximal hit count
+ *          is reached
  */
-void FileFinder::setStop(bool stop) {
-   m_stop = stop;
+bool FileFinder::shouldStop() const {
+   return m_stop.load() != 0 || m_maxHits.load() <= 0;
 }
 
 
@@ -278,7 +352,7 @@ void FileFinder::setStop(bool stop) {
  * @param maxHits	the maximal hit count
  */
 void FileFinder::setMaxHits(int maxHits) {
-   m_maxHits = maxHits;
+   m_maxHits.store(maxHits);
 }
 
 /**
@@ -290,6 +364,15 @@ void FileFinder::setGuiQueue(ReGuiQueue* guiQueue) {
    m_guiQueue = guiQueue;
 }
 
+/**
+ * Sets the file index used instead of the file system.
+ *
+ * @param index NULL or the index containing the base directory
+ */
+void FileFinder::setIndex(ReFileIndex* index) {
+   m_index = index;
+}
+
 /**
  * Sets the base directory.
  *
@@ -354,6 +437,14 @@ void FileFinder::setMinSize(const int64_t& minSize) {
    m_minSize = minSize;
 }
 
+/**
+ * Sets the model to fill.
+ * @param model		the model of the table containing the found files
+ */
+void FileFinder::setModel(ReFileTableModel* model) {
+   m_model = model;
+}
+
 /**
  * Sets the observer object. Will be notified about the search exit.
  * @param observer
@@ -394,14 +485,6 @@ void FileFinder::setPatterns(const QStringList& patterns) {
    }
 }
 
-/**
- * Sets the table to fill.
- * @param table		the table containing the found files
- */
-void FileFinder::setTable(QTableWidget* table) {
-   m_table = table;
-}
-
 /**
  * Sets the date time which is the upper bound.
  *
@@ -421,3 +504,63 @@ void FileFinder::setYoungerThan(const QDateTime& youngerThan) {
 const Statistics& FileFinder::statistics() const {
    return m_statistics;
 }
+
+/**
+ * Processes an entry found by the file index.
+ *
+ * @param path   the directory of the entry with a trailing separator
+ * @param node   the name of the entry
+ * @param entry  the meta data of the entry
+ * @return       <code>false</code>: the query should be stopped
+ */
+bool FileFinder::visit(const QByteArray& path, const char* node,
+                       const ReIndexEntry_t& entry) {
+   return foundEntry(path, node, entry.m_size, entry.m_modified,
+                     ReDirStatus_t::Type_t(entry.m_type));
+}
+
+/** @class ContentSearchTask filefinder.hpp "filefinder.hpp"
+ *
+ * @brief Searches the text in one file.
+ *
+ * The directory walk (<code>FileFinder::fillTable()</code>) creates a task
+ * for each file matching the other filter conditions. The tasks run in the
+ * thread pool of the finder, so reading and searching the files is done
+ * in parallel to the walk.
+ */
+
+/**
+ * Constructor.
+ *
+ * @param finder    the owner: contains the search parameters
+ * @param node      the filename without path
+ * @param path      the directory of the file
+ * @param fullName  the filename with path
+ * @param size      the file size
+ * @param modified  the modification time in msec since the epoch
+ * @param type      the file type, e.g. ReFileResultStore::FT_FILE
+ */
+ContentSearchTask::ContentSearchTask(FileFinder* finder, const QString& node,
+                                     const QString& path, const QString& fullName, int64_t size,
+                                     int64_t modified, ReFileResultStore::FileType type) :
+   m_finder(finder),
+   m_node(node),
+   m_path(path),
+   m_fullName(fullName),
+   m_size(size),
+   m_modified(modified),
+   m_type(type) {
+}
+
+/**
+ * Searches the text in the file and adds the file to the table if found.
+ */
+void ContentSearchTask::run() {
+   if (!m_finder->shouldStop()) {
+      TextFinder textFinder(m_fullName, m_size);
+      textFinder.getSearchParameter(*m_finder->m_textFinder);
+      if (textFinder.contains())
+         m_finder->addRow(m_node, m_path, m_size, m_modified, m_type);
+   }
+   m_finder->m_freeSlots.release();
+}
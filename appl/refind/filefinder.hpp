@@ -11,19 +11,45 @@
 
 #ifndef FILEFINDER_HPP
 #define FILEFINDER_HPP
-#include <QTableWidget>
 #include <QFileInfo>
 #include <QDir>
 #include <QDateTime>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QAtomicInt>
+#include <QRegExp>
 
 class TextFinder;
-class FileFinder : public QThread {
+class FileFinder;
+/**
+ * Searches the text in one file. Runs in a thread of the pool of the finder.
+ */
+class ContentSearchTask : public QRunnable {
+public:
+   ContentSearchTask(FileFinder* finder, const QString& node,
+                     const QString& path, const QString& fullName, int64_t size,
+                     int64_t modified, ReFileResultStore::FileType type);
+public:
+   virtual void run();
+private:
+   FileFinder* m_finder;
+   QString m_node;
+   QString m_path;
+   QString m_fullName;
+   int64_t m_size;
+   int64_t m_modified;
+   ReFileResultStore::FileType m_type;
+};
+
+class FileFinder : public QThread, public ReFileIndexVisitor {
+   friend class ContentSearchTask;
 public:
    FileFinder();
    ~FileFinder();
 public:
    void clear();
-   void fillTable(const QString& path, int depth);
+   void fillTable(const QString& path);
    void run();
    void search();
    void setAppend(bool append);
@@ -32,23 +58,30 @@ public:
    void setFiletypes(const QDir::Filters& filetypes);
    void setExcludedDirs(const QStringList& excludedDirs);
    void setGuiQueue(ReGuiQueue* guiQueue);
+   void setIndex(ReFileIndex* index);
    void setMaxDepth(int maxDepth);
    void setMaxHits(int maxHits);
    void setMaxSize(const int64_t& maxSize);
    void setMinDepth(int minDepth);
    void setMinSize(const int64_t& minSize);
+   void setModel(ReFileTableModel* model);
    void setObserver(ReObserver* observer);
    void setOlderThan(const QDateTime& olderThan);
    void setPatterns(const QStringList& patterns);
    void setStop(bool stop);
-   void setTable(QTableWidget* table);
    void setTextFinder(TextFinder* textFinder);
    void setYoungerThan(const QDateTime& youngerThan);
    const Statistics& statistics() const;
+   virtual bool visit(const QByteArray& path, const char* node,
+                      const ReIndexEntry_t& entry);
 
 private:
-   bool isExcludedDir(const QString& node);
-   bool isValid(const QFileInfo& file);
+   bool addRow(const QString& node, const QString& path, int64_t size,
+               int64_t modified, ReFileResultStore::FileType type);
+   bool foundEntry(const QByteArray& path, const char* node, int64_t size,
+                   int64_t modified, ReDirStatus_t::Type_t type);
+   bool shouldStop() const;
+   bool wildcardsMatch(const char* node) const;
 private:
    QStringList m_patterns;
    QStringList m_antiPatterns;
@@ -64,12 +97,31 @@ private:
    QStringList m_excludedDirs;
    // Only used to hold the search parameters:
    TextFinder* m_textFinder;
-   QTableWidget* m_table;
+   // receives the found files:
+   ReFileTableModel* m_model;
    Statistics m_statistics;
    ReObserver* m_observer;
    ReGuiQueue* m_guiQueue;
-   int m_maxHits;
-   bool m_stop;
+   // the count of hits still allowed: decremented by the workers
+   QAtomicInt m_maxHits;
+   // != 0: the search must be stopped. Set by the GUI thread
+   QAtomicInt m_stop;
+   // the workers searching the text in the files:
+   QThreadPool m_pool;
+   // limits the count of waiting tasks:
+   QSemaphore m_freeSlots;
+   // protects m_statistics and the hit counting:
+   QMutex m_mutex;
+   // NULL or the file index containing the base directory:
+   ReFileIndex* m_index;
+   // the path of the last found entry: converted only if it changes
+   QByteArray m_lastPath;
+   QString m_currentPath;
+   clock_t m_nextUpdate;
+   // the file patterns with '?' or '[' (not supported by ReMatcher):
+   QList<QRegExp> m_wildcardPatterns;
+   // the anti patterns with '?' or '[' (not anchored):
+   QList<QRegExp> m_wildcardAntiPatterns;
 };
 
 #endif // FILEFINDER_HPP
@@ -11,6 +11,7 @@
 
 #include <QMouseEvent>
 #include <QApplication>
+#include <QHeaderView>
 #include "mainwindow.hpp"
 #include "filetablewidget.hpp"
 
@@ -18,7 +19,11 @@
  * Constructor.
  */
 FileTableWidget::FileTableWidget(QWidget* parent) :
-   QTableWidget(parent), m_mainWindow(NULL), m_dragStartPosition(0, 0) {
+   QTableView(parent), m_mainWindow(NULL), m_dragStartPosition(0, 0) {
+   // rows of equal height: scrolling does not need to measure all rows
+   QHeaderView* header = verticalHeader();
+   header->setSectionResizeMode(QHeaderView::Fixed);
+   header->setDefaultSectionSize(fontMetrics().height() + 6);
 }
 
 /**
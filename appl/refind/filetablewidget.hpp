@@ -11,10 +11,10 @@
 
 #ifndef CUSTOMWIDGETS_HPP
 #define CUSTOMWIDGETS_HPP
-#include <QTableWidget>
+#include <QTableView>
 
 class MainWindow;
-class FileTableWidget: public QTableWidget {
+class FileTableWidget: public QTableView {
    Q_OBJECT
 public:
    FileTableWidget(QWidget* parent);
@@ -11,6 +11,7 @@
 
 #include "base/rebase.hpp"
 #include "gui/regui.hpp"
+#include "os/reos.hpp"
 #include "utils.hpp"
 #include "textfinder.hpp"
 #include "mainwindow.hpp"
@@ -63,20 +64,38 @@ MainWindow::MainWindow(const QString& startDir, const QString& homeDir,
    m_contextHandlers(),
    m_logger(new ReMemoryLogger()),
    m_finder(NULL),
+   m_indexer(NULL),
    m_guiQueue(),
-   m_guiTimer(new QTimer(this)) {
+   m_guiTimer(new QTimer(this)),
+   m_tableModel(NULL) {
    ui->setupUi(this);
    initializeHome();
+   m_indexer = new ReFileIndexer(I18N::s2b(m_homeDir), m_logger);
+   m_indexer->start(QThread::LowPriority);
    m_statusMessage = new QLabel(tr("Welcome at refind"));
    if (!startDir.isEmpty())
       ui->comboBoxDirectory->setCurrentText(startDir);
    if (ui->comboBoxDirectory->currentText().isEmpty())
       ui->comboBoxDirectory->setCurrentText(QDir::currentPath());
    ui->tableWidget->setMainWindow(this);
+   QList<ReFileTableModel::Column> columns;
+   // TC_NODE, TC_EXT, TC_SIZE, TC_MODIFIED, TC_TYPE, TC_PATH
+   columns << ReFileTableModel::COL_NODE << ReFileTableModel::COL_EXT
+           << ReFileTableModel::COL_SIZE_MBYTE << ReFileTableModel::COL_MODIFIED
+           << ReFileTableModel::COL_TYPE << ReFileTableModel::COL_PATH;
+   m_tableModel = new ReFileTableModel(columns, this);
+   m_tableModel->setDateFormat("yyyy.MM.dd/hh:mm:ss");
+   QStringList labels;
+   labels << tr("Filename") << tr("Ext") << tr("Size (MByte)") << tr("Modified")
+          << tr("Type") << tr("Path");
+   m_tableModel->setHeaderLabels(labels);
+   ui->tableWidget->setModel(m_tableModel);
    statusBar()->addWidget(m_statusMessage);
    connect(ui->actionStart, SIGNAL(triggered()), this, SLOT(search()));
    connect(ui->actionClear, SIGNAL(triggered()), this, SLOT(clear()));
    connect(ui->actionStop, SIGNAL(triggered()), this, SLOT(stop()));
+   connect(ui->actionIndexBaseDirectory, SIGNAL(triggered()), this,
+           SLOT(indexBaseDirectory()));
    connect(ui->pushButtonSearch, SIGNAL(clicked()), this, SLOT(search()));
    connect(ui->pushButtonSearch2, SIGNAL(clicked()), this, SLOT(search()));
    connect(ui->pushButtonStop, SIGNAL(clicked()), this, SLOT(stop()));
@@ -130,6 +149,8 @@ MainWindow::MainWindow(const QString& startDir, const QString& homeDir,
  * @brief Destructor.
  */
 MainWindow::~MainWindow() {
+   // saves the indexes:
+   delete m_indexer;
    delete ui;
 }
 
@@ -173,7 +194,7 @@ void MainWindow::options() {
  * Puts the absolute path of the current (selected) file into the clipboard.
  */
 void MainWindow::absPathToClipboard() {
-   int row = ui->tableWidget->currentRow();
+   int row = ui->tableWidget->currentIndex().row();
    if (row >= 0) {
       QClipboard* clipboard = QApplication::clipboard();
       clipboard->setText(buildAbsPath(row));
@@ -237,11 +258,7 @@ QDir::Filters MainWindow::buildFileTypes() {
  * @return      the text of the given cell
  */
 QString MainWindow::cellAsText(int row, int col) {
-   QTableWidgetItem* widget = ui->tableWidget->item(row, col);
-   QString rc;
-   if (widget != NULL)
-      rc = widget->text();
-   return rc;
+   return m_tableModel->cellText(row, col);
 }
 
 /**
@@ -287,7 +304,7 @@ void MainWindow::closing() {
  * Clears the table.
  */
 void MainWindow::clear() {
-   ui->tableWidget->setRowCount(0);
+   m_tableModel->clear();
 }
 
 /**
@@ -334,7 +351,7 @@ void MainWindow::exportToStream(QTextStream& stream, int maxRow) {
       stream << replaceGlobalPlaceholders(ui->comboBoxHeader, placeholders)
              << endl;
    }
-   int count = ui->tableWidget->rowCount();
+   int count = m_tableModel->rowCount();
    if (count > 0 && maxRow > 0)
       count = maxRow;
    QString error;
@@ -342,16 +359,15 @@ void MainWindow::exportToStream(QTextStream& stream, int maxRow) {
       QString line = ui->comboBoxTemplate->currentText();
       QMap < QString, QString > placeholders;
       QString path = m_lastBaseDir.absoluteFilePath(
-                        ReFileUtils::pathAppend(ui->tableWidget->item(ii, TC_PATH)->text(),
-                              ui->tableWidget->item(ii, TC_NODE)->text()));
+                        ReFileUtils::pathAppend(cellAsText(ii, TC_PATH),
+                              cellAsText(ii, TC_NODE)));
       placeholders.insert("full", addEsc(ReQStringUtils::nativePath(path)));
-      path = ReFileUtils::nativePath(ui->tableWidget->item(ii, TC_PATH)->text());
+      path = ReFileUtils::nativePath(cellAsText(ii, TC_PATH));
       placeholders.insert("path", addEsc(path));
-      placeholders.insert("ext", ui->tableWidget->item(ii, TC_EXT)->text());
-      placeholders.insert("node", ui->tableWidget->item(ii, TC_NODE)->text());
-      placeholders.insert("modified",
-                          ui->tableWidget->item(ii, TC_MODIFIED)->text());
-      placeholders.insert("size", ui->tableWidget->item(ii, TC_SIZE)->text());
+      placeholders.insert("ext", cellAsText(ii, TC_EXT));
+      placeholders.insert("node", cellAsText(ii, TC_NODE));
+      placeholders.insert("modified", cellAsText(ii, TC_MODIFIED));
+      placeholders.insert("size", cellAsText(ii, TC_SIZE));
       if (!ReQStringUtils::replacePlaceholders(line, placeholders, &error)) {
          guiError(ui->comboBoxTemplate, error);
          break;
@@ -371,14 +387,13 @@ void MainWindow::fileDragging() {
    QDrag* drag = new QDrag(this);
    QMimeData* mimeData = new QMimeData;
    QList < QUrl > urls;
-   QList < QTableWidgetSelectionRange > ranges =
-      ui->tableWidget->selectedRanges();
-   QList <QTableWidgetSelectionRange>::iterator it;
+   QItemSelection ranges = ui->tableWidget->selectionModel()->selection();
+   QItemSelection::const_iterator it;
    int files = 0;
    int dirs = 0;
    bool isDir = false;
    for (it = ranges.begin(); it != ranges.end(); ++it) {
-      for (int row = (*it).topRow(); row <= (*it).bottomRow(); row++) {
+      for (int row = (*it).top(); row <= (*it).bottom(); row++) {
          isDir = cellAsText(row, TC_SIZE).isEmpty();
          QUrl url(buildAbsPath(row, true, true));
          urls.append(url);
@@ -432,7 +447,7 @@ void MainWindow::footerPlaceholder() {
  * Puts the absolute full name of the current (selected) file into the clipboard.
  */
 void MainWindow::fullNameToClipboard() {
-   int row = ui->tableWidget->currentRow();
+   int row = ui->tableWidget->currentIndex().row();
    if (row >= 0) {
       QClipboard* clipboard = QApplication::clipboard();
       QString path = buildAbsPath(row);
@@ -446,11 +461,13 @@ void MainWindow::fullNameToClipboard() {
  * Callback method of the GUI timer.
  */
 void MainWindow::guiTimerUpdate() {
-   int count = m_guiQueue.count();
-   while(count-- > 0) {
-      ReGuiQueueItem item = m_guiQueue.popFront();
-      if (item.m_type == ReGuiQueueItem::Undef)
-         break;
+   QVector<ReGuiQueueItem> items;
+   int count = m_guiQueue.popFront(items);
+   // the found files are passed by the model, not by the queue.
+   // All files found before a ReadyMessage are already pending:
+   m_tableModel->flushPending();
+   for (int ix = 0; ix < count; ix++) {
+      const ReGuiQueueItem& item = items.at(ix);
       if (! item.apply()) {
          switch (item.m_type) {
          case ReGuiQueueItem::ReadyMessage:
@@ -480,13 +497,12 @@ void MainWindow::handleCopyToClipboard(int currentRow, const QString& full) {
    QMimeData* mimeData = new QMimeData;
    QList < QUrl > urls;
    bool isInSelection = false;
-   QList < QTableWidgetSelectionRange > ranges =
-      ui->tableWidget->selectedRanges();
-   QList <QTableWidgetSelectionRange>::iterator it;
+   QItemSelection ranges = ui->tableWidget->selectionModel()->selection();
+   QItemSelection::const_iterator it;
    QString textList;
-   textList.reserve(ui->tableWidget->rowCount() * 80);
+   textList.reserve(m_tableModel->rowCount() * 80);
    for (it = ranges.begin(); it != ranges.end(); ++it) {
-      for (int row = (*it).topRow(); row <= (*it).bottomRow(); row++) {
+      for (int row = (*it).top(); row <= (*it).bottom(); row++) {
          isInSelection = isInSelection || row == currentRow;
          QString name(buildAbsPath(row, true));
          QUrl url(name);
@@ -575,14 +591,14 @@ void MainWindow::handlePlaceholder(QComboBox* target) {
  *
  * @return  the number of selected rows
  */
-static int countSelectedRows(QTableWidget* table, int currentRow,
+static int countSelectedRows(QTableView* table, int currentRow,
                              bool& isInSelection) {
    int rc = 0;
    isInSelection = false;
-   QList < QTableWidgetSelectionRange > ranges = table->selectedRanges();
-   QList <QTableWidgetSelectionRange>::iterator it;
+   QItemSelection ranges = table->selectionModel()->selection();
+   QItemSelection::const_iterator it;
    for (it = ranges.begin(); it != ranges.end(); ++it) {
-      for (int row = (*it).topRow(); row <= (*it).bottomRow(); row++) {
+      for (int row = (*it).top(); row <= (*it).bottom(); row++) {
          isInSelection = isInSelection || row == currentRow;
          rc++;
       }
@@ -599,7 +615,7 @@ void MainWindow::handleTableContextMenu(const QPoint& position) {
    int currentRow = ui->tableWidget->rowAt(position.y());
    if (currentRow >= 0) {
       QMenu menu;
-      QString node = ui->tableWidget->item(currentRow, TC_NODE)->text();
+      QString node = cellAsText(currentRow, TC_NODE);
       QString parent = buildAbsPath(currentRow);
       QString full = ReFileUtils::pathAppend(parent, node);
       QFileInfo file(full);
@@ -653,7 +669,7 @@ void MainWindow::headerClicked(int col) {
    m_lastOrder =
       m_lastOrder == Qt::AscendingOrder ?
       Qt::DescendingOrder : Qt::AscendingOrder;
-   ui->tableWidget->sortItems(col, m_lastOrder);
+   m_tableModel->sort(col, m_lastOrder);
    m_horizontalHeader->setSortIndicatorShown(true);
    m_horizontalHeader->setSortIndicator(col, m_lastOrder);
 }
@@ -665,6 +681,25 @@ void MainWindow::headerPlaceholder() {
    handlePlaceholder(ui->comboBoxHeader);
 }
 
+/**
+ * Handles the action "index the base directory".
+ *
+ * The index is built in the background. The following searches below the
+ * base directory use the index instead of the file system.
+ */
+void MainWindow::indexBaseDirectory() {
+   QString path = comboText(ui->comboBoxDirectory);
+   QFileInfo dir(path);
+   if (!dir.isDir())
+      guiError(ui->comboBoxDirectory, tr("not a directory: ") + path);
+   else {
+      path = ReQStringUtils::chomp(ReFileUtils::nativePath(
+                                      dir.absoluteFilePath()), OS_SEPARATOR);
+      m_indexer->addBase(I18N::s2b(path));
+      say(LOG_INFO, tr("the index will be built in the background: ") + path);
+   }
+}
+
 /**
  * Informs the instance about some state changes.
  *
@@ -824,13 +859,16 @@ void MainWindow::saveState() {
  */
 void MainWindow::populateFinder(FileFinder& finder) {
    if (! ui->checkBoxAppend->isChecked()) {
-      ui->tableWidget->setRowCount(0);
+      m_tableModel->clear();
       m_statistics.clear();
    }
    finder.setObserver(this);
    finder.setGuiQueue(&this->m_guiQueue);
    finder.setBaseDir(comboText(ui->comboBoxDirectory));
-   finder.setTable(ui->tableWidget);
+   QString baseDir = ReQStringUtils::chomp(ReFileUtils::nativePath(
+         comboText(ui->comboBoxDirectory)), OS_SEPARATOR);
+   finder.setIndex(m_indexer->indexOf(I18N::s2b(baseDir)));
+   finder.setModel(m_tableModel);
    m_lastBaseDir.cd(comboText(ui->comboBoxDirectory));
    finder.setMaxSize(comboSize(ui->comboBoxMaxSize));
    finder.setMinSize(comboSize(ui->comboBoxMinSize));
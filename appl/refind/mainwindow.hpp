@@ -35,6 +35,7 @@ enum TableColumns {
    TC_NODE, TC_EXT, TC_SIZE, TC_MODIFIED, TC_TYPE, TC_PATH
 };
 class FileFinder;
+class ReFileIndexer;
 
 class MainWindow: public QMainWindow, public ReGuiValidator, protected ReObserver {
 
@@ -64,6 +65,7 @@ private slots:
    void handleTableContextMenu(const QPoint& position);
    void headerClicked(int col);
    void headerPlaceholder();
+   void indexBaseDirectory();
    virtual ReturnCode notify(const char* message);
    void options();
    void preview();
@@ -110,8 +112,12 @@ private:
    ContextHandlerList m_contextHandlers;
    ReLogger* m_logger;
    FileFinder* m_finder;
+   // maintains the file indexes in the background:
+   ReFileIndexer* m_indexer;
    ReGuiQueue m_guiQueue;
    QTimer* m_guiTimer;
+   // the content of ui->tableWidget:
+   ReFileTableModel* m_tableModel;
 };
 
 #endif // MAINWINDOW_HPP
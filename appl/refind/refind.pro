@@ -21,12 +21,16 @@ SOURCES += main.cpp\
 	 ../../base/ReQStringUtils.cpp \
 	 ../../base/ReFileUtils.cpp \
 	 ../../base/ReLogger.cpp \
+	 ../../base/ReMatcher.cpp \
+	 ../../os/ReTraverser.cpp \
+	 ../../os/ReFileIndex.cpp \
 	 filefinder.cpp \
 	 textfinder.cpp \
 	 aboutdialog.cpp \
 	 ../../gui/ReStateStorage.cpp \
 	 ../../gui/ReGuiValidator.cpp \
 	 ../../gui/ReGuiQueue.cpp \
+	 ../../gui/ReFileTableModel.cpp \
 	 dialogglobalplaceholder.cpp \
 	 dialogfileplaceholder.cpp \
 	 utils.cpp \
@@ -47,7 +51,10 @@ HEADERS  += mainwindow.hpp \
 	 utils.hpp \
 	 dialogoptions.hpp \
 	 filetablewidget.hpp \
-	../../gui/ReGuiQueue.hpp
+	../../gui/ReGuiQueue.hpp \
+	../../gui/ReFileTableModel.hpp \
+	../../os/ReTraverser.hpp \
+	../../os/ReFileIndex.hpp
 
 
 FORMS    += mainwindow.ui \
@@ -13,6 +13,67 @@
 #include "utils.hpp"
 #include "textfinder.hpp"
 
+/** @class TextFinder textfinder.hpp "textfinder.hpp"
+ *
+ * @brief Searches a text or a regular expression in a file.
+ *
+ * The search works on the raw bytes of the file: small files are mapped into
+ * the memory, large files are read in large blocks. A line is converted into
+ * a <code>QString</code> only if a regular expression must be tested or a
+ * non ASCII text is searched case insensitive.
+ *
+ * A regular expression is tested only in the lines containing its
+ * required literal (see <code>requiredLiteral()</code>).
+ *
+ * The instance given to <code>FileFinder::setTextFinder()</code> holds the
+ * search parameters, each search uses its own instance.
+ */
+
+static uint8_t s_fold[256];
+/**
+ * Initializes the folding table: ASCII upper case to lower case.
+ *
+ * @return  <code>true</code>
+ */
+static bool initFold() {
+   for (int ix = 0; ix < 256; ix++)
+      s_fold[ix] = ix >= 'A' && ix <= 'Z' ? ix + 'a' - 'A' : ix;
+   return true;
+}
+static const bool s_foldInitialized = initFold();
+
+/**
+ * Tests whether a buffer contains valid UTF-8.
+ *
+ * A sequence cut by the end of the buffer is accepted.
+ *
+ * @param data      the buffer to inspect
+ * @param length    the length of <code>data</code>
+ * @return          <code>true</code>: the buffer is UTF-8 (or ASCII)
+ */
+static bool isUtf8(const char* data, int64_t length) {
+   const uint8_t* ptr = reinterpret_cast<const uint8_t*>(data);
+   const uint8_t* end = ptr + length;
+   bool rc = true;
+   while (rc && ptr < end) {
+      uint8_t cc = *ptr++;
+      int follow = 0;
+      if (cc >= 0x80) {
+         if (cc >= 0xC2 && cc <= 0xDF)
+            follow = 1;
+         else if (cc >= 0xE0 && cc <= 0xEF)
+            follow = 2;
+         else if (cc >= 0xF0 && cc <= 0xF4)
+            follow = 3;
+         else
+            rc = false;
+      }
+      for (; rc && follow > 0 && ptr < end; follow--)
+         rc = (*ptr++ & 0xC0) == 0x80;
+   }
+   return rc;
+}
+
 /**
  * Constructor.
  */
@@ -26,7 +87,10 @@ TextFinder::TextFinder() :
    m_isRegExpr(false),
    m_ignoreCase(false),
    m_ownsRegExpr(false),
-   m_text() {
+   m_text(),
+   m_pattern(),
+   m_byteSearch(true) {
+   memset(m_shift, 0, sizeof m_shift);
 }
 
 TextFinder::TextFinder(const QString& fullName, int64_t length) :
@@ -39,7 +103,10 @@ TextFinder::TextFinder(const QString& fullName, int64_t length) :
    m_isRegExpr(false),
    m_ignoreCase(false),
    m_ownsRegExpr(false),
-   m_text() {
+   m_text(),
+   m_pattern(),
+   m_byteSearch(true) {
+   memset(m_shift, 0, sizeof m_shift);
    m_valid = m_file.open(QIODevice::ReadOnly);
 }
 
@@ -56,35 +123,220 @@ TextFinder::~TextFinder() {
 /**
  * Search a text pattern in the given file.
  *
+ * The search stops at the first hit.
+ *
+ * The raw bytes are searched only if the start of the file is UTF-8.
+ * Otherwise (e.g. Latin-1) the file is decoded by a <code>QTextStream</code>.
+ *
  * @return              <code>true</code>: the pattern was found
  */
 bool TextFinder::contains() {
    bool rc = false;
-   if (!m_ignoreBinary || !isBinary()) {
-      m_file.seek(0);
-      QTextStream stream(&m_file);
-      QString line;
-      if (m_regExpr != NULL) {
-         QRegularExpressionMatch match;
-         while (!stream.atEnd()) {
-            line = stream.readLine();
-            match = m_regExpr->match(line);
-            if (match.hasMatch()) {
-               rc = true;
-               break;
-            }
-         }
-      } else {
-         Qt::CaseSensitivity mode =
-            m_ignoreCase ? Qt::CaseInsensitive : Qt::CaseSensitive;
-         while (!stream.atEnd()) {
-            line = stream.readLine();
-            if (line.indexOf(m_text, 0, mode) >= 0) {
-               rc = true;
-               break;
-            }
+   uchar* memory = NULL;
+   if (!m_valid)
+      rc = false;
+   else if (m_length <= 0 || m_length > MAX_MAPPED_SIZE
+            || (memory = m_file.map(0, m_length)) == NULL)
+      rc = containsInBlocks();
+   else {
+      const char* data = reinterpret_cast<const char*>(memory);
+      int64_t testLength = qMin(m_length, (int64_t) BINARY_TEST_SIZE);
+      bool decode = false;
+      if (m_ignoreBinary && memchr(data, '\0', testLength) != NULL)
+         rc = false;
+      else if (!isUtf8(data, testLength))
+         decode = true;
+      else
+         rc = searchBuffer(data, m_length);
+      m_file.unmap(memory);
+      if (decode)
+         rc = containsInStream();
+   }
+   return rc;
+}
+
+/**
+ * Searches the pattern in a file read block by block.
+ *
+ * A block is searched up to its last line end, the rest is searched with
+ * the next block. Therefore a hit cannot be split by a block boundary.
+ *
+ * @return  <code>true</code>: the pattern was found
+ */
+bool TextFinder::containsInBlocks() {
+   bool rc = false;
+   QByteArray buffer;
+   buffer.resize(BLOCK_SIZE);
+   int64_t rest = 0;
+   bool first = true;
+   m_file.seek(0);
+   for (;;) {
+      if (rest == buffer.length())
+         buffer.resize(2 * buffer.length());
+      int64_t bytes = m_file.read(buffer.data() + rest, buffer.length() - rest);
+      if (bytes <= 0) {
+         rc = rest > 0 && searchBuffer(buffer.constData(), rest);
+         break;
+      }
+      int64_t length = rest + bytes;
+      const char* data = buffer.constData();
+      if (first) {
+         first = false;
+         int64_t testLength = qMin(length, (int64_t) BINARY_TEST_SIZE);
+         if (m_ignoreBinary && memchr(data, '\0', testLength) != NULL)
+            break;
+         if (!isUtf8(data, testLength)) {
+            rc = containsInStream();
+            break;
          }
       }
+      int64_t complete = length;
+      while (complete > 0 && data[complete - 1] != '\n')
+         complete--;
+      // a very long line (or binary data) is searched without the rest:
+      if (complete == 0 && length >= 16 * BLOCK_SIZE)
+         complete = length;
+      if (complete > 0 && searchBuffer(data, complete)) {
+         rc = true;
+         break;
+      }
+      rest = length - complete;
+      memmove(buffer.data(), data + complete, rest);
+   }
+   return rc;
+}
+
+/**
+ * Searches the pattern in a file which is not UTF-8.
+ *
+ * The lines are decoded by a <code>QTextStream</code> (the codec of the
+ * locale or the byte order mark).
+ *
+ * @return  <code>true</code>: the pattern was found
+ */
+bool TextFinder::containsInStream() {
+   bool rc = false;
+   m_file.seek(0);
+   QTextStream stream(&m_file);
+   while (!rc && !stream.atEnd())
+      rc = textMatches(stream.readLine());
+   return rc;
+}
+
+/**
+ * Searches the literal pattern in a buffer.
+ *
+ * Case sensitive: <code>memmem()</code> (if available), otherwise the
+ * Boyer-Moore-Horspool algorithm with ASCII case folding.
+ *
+ * @param data      the buffer to inspect
+ * @param length    the length of <code>data</code>
+ * @return          -1: not found<br>
+ *                  otherwise: the offset of the first hit
+ */
+int64_t TextFinder::indexOf(const char* data, int64_t length) const {
+   int patternLength = m_pattern.length();
+   if (patternLength == 0)
+      return 0;
+   if (length < patternLength)
+      return -1;
+   const uint8_t* text = reinterpret_cast<const uint8_t*>(data);
+   const uint8_t* pattern = reinterpret_cast<const uint8_t*>(m_pattern.constData());
+#if defined __linux__
+   if (!m_ignoreCase) {
+      const void* found = memmem(text, length, pattern, patternLength);
+      return found == NULL ? -1 : reinterpret_cast<const uint8_t*>(found) - text;
+   }
+#endif
+   int last = patternLength - 1;
+   uint8_t lastByte = pattern[last];
+   for (int64_t pos = 0; pos <= length - patternLength;) {
+      uint8_t cc = m_ignoreCase ? s_fold[text[pos + last]] : text[pos + last];
+      if (cc == lastByte) {
+         int ix = last - 1;
+         if (m_ignoreCase)
+            while (ix >= 0 && s_fold[text[pos + ix]] == pattern[ix])
+               ix--;
+         else
+            while (ix >= 0 && text[pos + ix] == pattern[ix])
+               ix--;
+         if (ix < 0)
+            return pos;
+      }
+      pos += m_shift[cc];
+   }
+   return -1;
+}
+
+/**
+ * Tests whether a line matches the search parameters.
+ *
+ * @param start the start of the line
+ * @param end   the end of the line (the position of the line end)
+ * @return      <code>true</code>: the line contains a hit
+ */
+bool TextFinder::lineMatches(const char* start, const char* end) const {
+   if (end > start && end[-1] == '\r')
+      end--;
+   return textMatches(QString::fromUtf8(start, end - start));
+}
+
+/**
+ * Tests whether a decoded line matches the search parameters.
+ *
+ * @param line  the line to test
+ * @return      <code>true</code>: the line contains a hit
+ */
+bool TextFinder::textMatches(const QString& line) const {
+   bool rc;
+   if (m_regExpr != NULL)
+      rc = m_regExpr->match(line).hasMatch();
+   else
+      rc = line.indexOf(m_text, 0,
+                        m_ignoreCase ? Qt::CaseInsensitive : Qt::CaseSensitive) >= 0;
+   return rc;
+}
+
+/**
+ * Searches in a buffer containing complete lines.
+ *
+ * @param data      the buffer to inspect
+ * @param length    the length of <code>data</code>
+ * @return          <code>true</code>: the buffer contains a hit
+ */
+bool TextFinder::searchBuffer(const char* data, int64_t length) const {
+   bool rc = false;
+   const char* end = data + length;
+   if (m_pattern.isEmpty() || !m_byteSearch) {
+      // no prefilter: each line must be tested
+      const char* start = data;
+      while (!rc && start < end) {
+         const char* lineEnd = reinterpret_cast<const char*>(memchr(start, '\n',
+                               end - start));
+         if (lineEnd == NULL)
+            lineEnd = end;
+         rc = lineMatches(start, lineEnd);
+         start = lineEnd + 1;
+      }
+   } else if (m_regExpr == NULL)
+      rc = indexOf(data, length) >= 0;
+   else {
+      // only the lines containing the required literal are tested:
+      const char* pos = data;
+      while (!rc && pos < end) {
+         int64_t offset = indexOf(pos, end - pos);
+         if (offset < 0)
+            break;
+         const char* start = pos + offset;
+         while (start > data && start[-1] != '\n')
+            start--;
+         const char* lineEnd = reinterpret_cast<const char*>(memchr(pos + offset,
+                               '\n', end - pos - offset));
+         if (lineEnd == NULL)
+            lineEnd = end;
+         rc = lineMatches(start, lineEnd);
+         pos = lineEnd + 1;
+      }
    }
    return rc;
 }
@@ -100,6 +352,9 @@ void TextFinder::getSearchParameter(const TextFinder& source) {
    m_isRegExpr = source.m_isRegExpr;
    m_ignoreCase = source.m_ignoreCase;
    m_text = source.m_text;
+   m_pattern = source.m_pattern;
+   m_byteSearch = source.m_byteSearch;
+   memcpy(m_shift, source.m_shift, sizeof m_shift);
 }
 
 /**
@@ -230,6 +485,106 @@ void TextFinder::setSearchParameter(const QString& text, bool ignoreCase,
       m_ownsRegExpr = true;
       m_regExpr = new QRegularExpression(text, option);
    }
+   setPattern(isRegExpr ? requiredLiteral(text) : text);
+}
+
+/**
+ * Prepares the byte search of a literal.
+ *
+ * @param pattern   the literal to search
+ */
+void TextFinder::setPattern(const QString& pattern) {
+   m_pattern = pattern.toUtf8();
+   m_byteSearch = true;
+   int length = m_pattern.length();
+   uint8_t* bytes = reinterpret_cast<uint8_t*>(m_pattern.data());
+   if (m_ignoreCase) {
+      for (int ix = 0; ix < length; ix++) {
+         if (bytes[ix] >= 0x80)
+            m_byteSearch = false;
+         bytes[ix] = s_fold[bytes[ix]];
+      }
+   }
+   if (!m_byteSearch && m_isRegExpr) {
+      // no prefilter possible:
+      m_pattern.clear();
+      length = 0;
+   }
+   for (int ix = 0; ix < 256; ix++)
+      m_shift[ix] = length;
+   for (int ix = 0; ix < length - 1; ix++)
+      m_shift[bytes[ix]] = length - 1 - ix;
+}
+
+/**
+ * Returns the longest literal which must be part of each hit of a regular
+ * expression.
+ *
+ * Only simple cases are recognized: if the expression contains an alternative
+ * or an option group, no literal is returned. Literals inside groups are
+ * ignored.
+ *
+ * @param regExpr   the regular expression to inspect
+ * @return          "": no literal found<br>
+ *                  otherwise: the literal
+ */
+QString TextFinder::requiredLiteral(const QString& regExpr) {
+   QString rc;
+   if (regExpr.indexOf('|') >= 0 || regExpr.indexOf("(?") >= 0)
+      return rc;
+   QString current;
+   int depth = 0;
+   int length = regExpr.length();
+   bool stop = false;
+   for (int ix = 0; ix <= length && !stop; ix++) {
+      bool endOfRun = true;
+      QChar cc = ix < length ? regExpr.at(ix) : QChar(' ');
+      if (ix == length)
+         stop = true;
+      else if (cc == '\\') {
+         QChar next = ix + 1 < length ? regExpr.at(ix + 1) : QChar(' ');
+         if (next.isLetterOrNumber()) {
+            // \d, \b...: no literal. \x41, \1...: the rest is unsafe
+            if (QString("xuUpPNckgo0123456789").indexOf(next) >= 0)
+               stop = true;
+         } else if (depth == 0) {
+            current += next;
+            endOfRun = false;
+         }
+         ix++;
+      } else if (cc == '[') {
+         ix++;
+         if (ix < length && regExpr.at(ix) == '^')
+            ix++;
+         if (ix < length && regExpr.at(ix) == ']')
+            ix++;
+         while (ix < length && regExpr.at(ix) != ']') {
+            if (regExpr.at(ix) == '\\')
+               ix++;
+            ix++;
+         }
+      } else if (cc == '(')
+         depth++;
+      else if (cc == ')')
+         depth--;
+      else if (cc == '?' || cc == '*' || cc == '{') {
+         // the previous char is optional:
+         current.chop(1);
+         while (cc == '{' && ix < length && regExpr.at(ix) != '}')
+            ix++;
+      } else if (cc == '+' || cc == '.' || cc == '^' || cc == '$') {
+         // nothing to do
+      } else if (depth == 0) {
+         current += cc;
+         endOfRun = false;
+      }
+      if (endOfRun) {
+         if (current.toUtf8().length() > rc.toUtf8().length())
+            rc = current;
+         current.clear();
+      }
+   }
+   return rc;
 }
 
 /**
@@ -14,6 +14,15 @@
 
 #include <QRegularExpression>
 class TextFinder {
+public:
+   enum {
+      /// files up to this size are mapped into the memory
+      MAX_MAPPED_SIZE = 256 * 1024 * 1024,
+      /// larger files are read in blocks of this size
+      BLOCK_SIZE = 1024 * 1024,
+      /// the binary test inspects so many bytes
+      BINARY_TEST_SIZE = 64 * 1024
+   };
 public:
    TextFinder();
    TextFinder(const QString& fullName, int64_t length);
@@ -21,6 +30,7 @@ public:
 public:
    void getSearchParameter(const TextFinder& source);
    bool contains();
+   int64_t indexOf(const char* data, int64_t length) const;
    bool isBinary();
    bool isText(const QByteArray& data, bool* trueAscii = NULL);
    bool isUTF8(const QByteArray& data, bool* trueAscii) const;
@@ -28,6 +38,15 @@ public:
    void setSearchParameter(const QString& text, bool ignoreCase, bool isRegExpr,
                            bool ignoreBinary);
    QString regExprError();
+public:
+   static QString requiredLiteral(const QString& regExpr);
+private:
+   bool containsInBlocks();
+   bool containsInStream();
+   bool lineMatches(const char* start, const char* end) const;
+   bool searchBuffer(const char* data, int64_t length) const;
+   void setPattern(const QString& pattern);
+   bool textMatches(const QString& line) const;
 private:
    bool m_ignoreBinary;
    QString m_filename;
@@ -39,6 +58,13 @@ private:
    bool m_ignoreCase;
    bool m_ownsRegExpr;
    QString m_text;
+   // the literal to search in the raw bytes (UTF-8, folded if m_ignoreCase).
+   // Regular expression: a literal which must be part of each hit ("": none)
+   QByteArray m_pattern;
+   // false: the literal cannot be searched bytewise (not ASCII and m_ignoreCase)
+   bool m_byteSearch;
+   // Boyer-Moore-Horspool: the shift for each (folded) byte
+   int m_shift[256];
 };
 
 #endif // TEXTFINDER_HPP
@@ -15,6 +15,10 @@ INCLUDEPATH += ../..
 
 SOURCES += \
 	 ../../gui/ReEdit.cpp \
+	 ../../gui/ReHighlighter.cpp \
+	 ../../expr/ReLexer.cpp \
+	 ../../expr/ReSource.cpp \
+	 ../../base/ReStringUtils.cpp \
 	 ../../gui/ReStateStorage.cpp \
 	 ../../gui/ReSettings.cpp \
 	 ../../base/ReFile.cpp \
@@ -24,6 +28,8 @@ SOURCES += \
 	../../base/ReQStringUtils.cpp \
 	../../base/ReFileUtils.cpp \
 	../../base/ReException.cpp \
+	../../base/ReByteStorage.cpp \
+	../../base/RePool.cpp \
 	../../base/ReDiff.cpp \
 	../../os/ReFileSystem.cpp \
 	projectselection.cpp \
@@ -44,6 +50,7 @@ HEADERS  += mainwindow.hpp \
 	 ../../base/rebase.hpp \
 	 ../../gui/regui.hpp \
 	 ../../gui/ReEdit.hpp \
+	 ../../gui/ReHighlighter.hpp \
 	 ../../gui/ReStateStorage.hpp \
 	 ../../gui/ReSettings.hpp \
 	../../base/ReStringUtils.hpp \
@@ -20,7 +20,8 @@ const char* EditorView::NAME = "Editor";
 EditorView::EditorView(MainWindow* mainWindow) :
    View(NAME, mainWindow),
    m_edit(new ReEdit(NULL)),
-   m_file(NULL) {
+   m_file(NULL),
+   m_highlighter(NULL) {
    m_edit->setLines(&m_dummyFile);
 }
 
@@ -28,6 +29,9 @@ EditorView::EditorView(MainWindow* mainWindow) :
  * Destructor.
  */
 EditorView::~EditorView() {
+   // the highlighter thread uses the edit field:
+   delete m_highlighter;
+   m_highlighter = NULL;
    delete m_edit;
    m_edit = NULL;
 }
@@ -38,8 +42,20 @@ EditorView::~EditorView() {
  * @param filename	the filename with path
  */
 void EditorView::openFile(const QString& filename) {
+   if (m_highlighter != NULL) {
+      m_edit->removeBuilder(m_highlighter);
+      delete m_highlighter;
+      m_highlighter = NULL;
+   }
    delete m_file;
    m_file = new ReFile(filename, false, m_mainWindow->logger());
+   ReLexer* lexer = ReHighlighter::createLexer(filename);
+   if (lexer != NULL) {
+      m_highlighter = new ReHighlighter(m_edit, lexer);
+      // behind the standard builder, in front of the cursor line builder:
+      m_edit->insertBuilder(1, m_highlighter);
+      m_highlighter->start(QThread::LowPriority);
+   }
    m_edit->setLines(m_file);
 }
 
@@ -35,6 +35,8 @@ public:
 protected:
    ReEdit* m_edit;
    ReFile* m_file;
+   // NULL or the syntax highlighter of m_file:
+   ReHighlighter* m_highlighter;
    ReLines m_dummyFile;
 };
 
@@ -18,6 +18,7 @@ SOURCES += \
 	 ../../gui/ReStateStorage.cpp \
 	 ../../gui/ReSettings.cpp \
 	 ../../gui/ReFileTree.cpp \
+	 ../../gui/ReFileTableModel.cpp \
 	 ../../gui/ReGuiValidator.cpp \
 	 ../../base/ReMatcher.cpp \
 	 ../../base/ReFile.cpp \
@@ -29,6 +30,8 @@ SOURCES += \
 	../../base/ReQStringUtils.cpp \
 	../../base/ReFileUtils.cpp \
 	../../base/ReException.cpp \
+	../../base/ReByteStorage.cpp \
+	../../base/RePool.cpp \
 	idosmain.cpp \
 	main.cpp \
 	FileCommander.cpp \
@@ -39,6 +42,7 @@ HEADERS  +=  ../../base/rebase.hpp \
 	 ../../gui/ReEdit.hpp \
 	 ../../gui/ReStateStorage.hpp \
 	 ../../gui/ReSettings.hpp \
+	 ../../gui/ReFileTableModel.hpp \
 	../../base/ReStringUtils.hpp \
 	../../base/ReQStringUtils.hpp \
 	../../base/ReException.hpp \
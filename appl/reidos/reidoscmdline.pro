@@ -32,6 +32,8 @@ SOURCES += \
 	../../base/ReQStringUtils.cpp \
 	../../base/ReFileUtils.cpp \
 	../../base/ReException.cpp \
+	../../base/ReByteStorage.cpp \
+	../../base/RePool.cpp \
 	../../base/ReProgramArgs.cpp \
 	maincmdline.cpp
 
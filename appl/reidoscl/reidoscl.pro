@@ -26,6 +26,8 @@ SOURCES += \
 	../../base/ReQStringUtils.cpp \
 	../../base/ReFileUtils.cpp \
 	../../base/ReException.cpp \
+	../../base/ReByteStorage.cpp \
+	../../base/RePool.cpp \
 	../../base/ReProgramArgs.cpp \
 	reidoscl.cpp
 
@@ -13,8 +13,10 @@
 #include "gui/regui.hpp"
 #include "converter.hpp"
 #include "mainwindow.hpp"
-#include <QRegularExpression>
 #include <QRegExp>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QElapsedTimer>
 
 /** @file
  *
@@ -32,10 +34,10 @@
  *
  * @subsection conv_sec Conversion Details
  *
- * If an image is lower than the given limits it will be copied without
- * conversion
- * This program is only the GUI of an Perl script which does the conversion.
- * The script uses the
+ * If an image is lower than the given limits it keeps its size, but it is
+ * encoded again in the target format (and quality).
+ * The images are decoded, scaled and encoded by Qt in a thread pool with
+ * one thread per processor core. No external program is needed.
  *
  * @section install_sec Installation
  *
@@ -45,7 +47,7 @@
  * @subsection req_sec Requirements
  *
  * <ul>
- * <li>ImageMagick</li>
+ * <li>The Qt image format plugins of the used formats, e.g. JPEG</li>
  * </ul>
  *
  * @section prog_sec Programming Features
@@ -57,9 +59,8 @@
  * <li>Threads</li>
  * <li>Using GUI wizzard</li>
  * <li>Abstract class as interface</li>
- * <li>Calling an external script</li>
- * <li>Lists the output of the external list line by line at the moment
- *  the line is created</li>
+ * <li>Thread pool with a memory budget</li>
+ * <li>Lists the result of each file at the moment the file is converted</li>
  * </ul>
  *
  * @section version_sec Release Notes
@@ -97,14 +98,56 @@
  * Search all images in a given path and converts them into the given format.
  *
  * The task is done in a thread because it can take long time.
+ * This thread searches the files and reads the image sizes (only the header).
+ * The conversions are done by a thread pool. The memory of the decoded images
+ * is much larger than the files, so the images in conversion are limited by
+ * a memory budget.
  *
- * The thread can be stopped from outside, then the conversion of the current
- * image will be finished and no more files will be processed.
+ * The thread can be stopped from outside, then the conversions in progress
+ * will be finished and no more files will be processed.
  *
+ * The results are passed to the main window by its GUI queue.
+ */
+
+/** @class ConvertTask converter.hpp "converter.hpp"
+ *
+ * @brief Converts one image in a thread of the pool.
  */
 
 QString sizeToString(qint64 size);
 
+/**
+ * @brief Constructor.
+ *
+ * @param converter the converter which does the work
+ * @param source    the source filename with path
+ * @param target    the target filename with path
+ * @param size      the size of the source file (in bytes)
+ * @param width     the width of the source image
+ * @param height    the height of the source image
+ * @param memory    the reserved part of the memory budget
+ */
+ConvertTask::ConvertTask(Converter* converter, const QString& source,
+                         const QString& target, qint64 size, int width, int height,
+                         qint64 memory) :
+   QRunnable(),
+   m_converter(converter),
+   m_source(source),
+   m_target(target),
+   m_size(size),
+   m_width(width),
+   m_height(height),
+   m_memory(memory) {
+}
+
+/**
+ * @brief Converts the image and gives back the reserved memory.
+ */
+void ConvertTask::run() {
+   m_converter->convertOneFile(m_source, m_target, m_size, m_width, m_height);
+   m_converter->releaseMemory(m_memory);
+}
+
 /**
  * @brief Constructor.
  *
@@ -139,31 +182,24 @@ Converter::Converter(const QString& directory, const QString& targetDirectory,
    m_squareWidth(squareX),
    m_quality(targetType == "jpg" ? quality : 0),
    m_mainWindows(mainWindow),
-   m_shouldStop(false),
-   m_imageInfo(
-      new QRegularExpression(" (PNG|GIF|JPEG) (\\d+)x(\\d+) ")),
-   m_groupWidth(2),
-   m_groupHeight(3) {
+   m_shouldStop(0),
+   m_pool(),
+   m_memoryBudget(qint64(512) * 1024 * 1024),
+   m_memoryMutex(),
+   m_memoryReleased(),
+   m_memoryInUse(0),
+   m_converted(0) {
+   m_pool.setMaxThreadCount(QThread::idealThreadCount());
 }
 
 /**
  * @brief Destructor.
  */
 Converter::~Converter() {
-   delete m_imageInfo;
-}
-
-/**
- * @brief Appends an argument to the argument list.
- *
- * @param args      IN/OUT: the argument list
- * @param prefix    the string starting the argument
- * @param value     the value of the argument
- */
-void addArg(QStringList& args, const char* prefix, int value) {
-   QString arg;
-   arg.sprintf("%s%d", prefix, value);
-   args << arg;
+   m_shouldStop.store(1);
+   wait();
+   // the tasks use the members:
+   m_pool.waitForDone();
 }
 
 /**
@@ -173,100 +209,78 @@ void addArg(QStringList& args, const char* prefix, int value) {
  * @param info      an info about the change
  */
 void Converter::changeState(Converter::State state, const QString& info) {
-   m_mainWindows->on_threadStateChanged(state, info);
+   // the value: "<state> <info>"
+   m_mainWindows->guiQueue().pushBack(ReGuiQueueItem(
+                                         ReGuiQueueItem::UserDefined1, NULL,
+                                         QString::number(state) + " " + info));
 }
 
 /**
  * Converts an image into another format.
  *
  * @param source    the source filename with path
- * @param target    the target filename with path
- * @param width     the old width of the image
- * @param height    the old height of the image
+ * @param target    the target filename with path. The extension determines
+ *                  the image format
  * @param widthNew  the new width of the image
  * @param heightNew the new height of the image
  * @param quality   0 or quality in % (only for JPEG targets)
+ * @throws ConverterException
  */
-void Converter::convert(const QString& source, const QString& target, int width,
-                        int height, int widthNew, int heightNew, int quality) {
-   QStringList args;
-   // convert -size 100x200 source.png -resize 50x100 target.jpg";
-   args << "-size" << QString::number(width) + "x" + QString::number(height);
-   args << source;
+void Converter::convert(const QString& source, const QString& target,
+                        int widthNew, int heightNew, int quality) {
+   QImageReader reader(source);
+   QImage image = reader.read();
+   if (image.isNull())
+      error(QObject::tr("cannot read %1: %2").arg(source).arg(
+               reader.errorString()));
+   if (image.width() != widthNew || image.height() != heightNew)
+      image = image.scaled(widthNew, heightNew, Qt::IgnoreAspectRatio,
+                           Qt::SmoothTransformation);
+   QImageWriter writer(target);
    if (quality > 0)
-      args << "-quality" << QString::number(quality);
-   args << "-resize"
-        << QString::number(widthNew) + "x" + QString::number(heightNew);
-   args << target;
-   QProcess process;
-   process.start("/usr/bin/convert", args);
-   QByteArray output;
-   while (process.waitForReadyRead()) {
-      output = process.readAll();
-   }
-   output = process.readAllStandardError();
-   if (!output.isEmpty())
-      error(output);
-   process.close();
+      writer.setQuality(quality);
+   if (!writer.write(image))
+      error(QObject::tr("cannot write %1: %2").arg(target).arg(
+               writer.errorString()));
 }
 
 /**
  * @brief Converts one file.
  *
+ * This method is called in a thread of the pool.
+ *
  * @param source    the file's name with path
  * @param target    the new filename with path
- * @param size  the size of the file (in byte)
+ * @param size      the size of the file (in byte)
+ * @param width     the width of the image
+ * @param height    the height of the image
  */
 void Converter::convertOneFile(const QString& source, const QString& target,
-                               qint64 size) {
-   int width = 0;
-   int height = 0;
-   QString info;
-   clock_t start = clock();
-   if (readProperties(source, width, height, info)) {
-      bool doConvert = false;
-      int widthNew, heightNew;
-      if (abs(width - height) < 5) {
-         // Square format:
-         doConvert = width > m_squareWidth;
-         if (doConvert)
-            widthNew = heightNew = m_squareWidth;
-      } else if (width > height) {
-         // Landscape:
-         doConvert = width > m_landscapeWidth || height > m_landscapeHeight;
-         if (doConvert) {
-            if (width > m_landscapeWidth && m_landscapeWidth > 0) {
-               widthNew = m_landscapeWidth;
-               heightNew = height * m_landscapeWidth / width;
-            } else {
-               heightNew = m_landscapeHeight;
-               widthNew = width * m_landscapeHeight / height;
-            }
-         }
-      } else {
-         // Portrait
-         doConvert = width > m_portraitWidth || height > m_portraitHeight;
-         if (doConvert) {
-            if (width > m_portraitWidth && m_portraitWidth > 0) {
-               widthNew = m_portraitWidth;
-               heightNew = height * m_portraitWidth / width;
-            } else {
-               heightNew = m_portraitHeight;
-               widthNew = width * m_portraitHeight / height;
-            }
-         }
-      }
-      log(
-         source + " " + info + " " + sizeToString(size)
-         + QString(" -> %1x%2 ").arg(widthNew).arg(heightNew));
-      convert(source, target, width, height, widthNew, heightNew, m_quality);
-      struct stat info;
-      if (stat(I18N::s2b(target).constData(), &info) == 0)
-         m_mainWindows->logAppendLast(sizeToString(info.st_size) + " ");
+                               qint64 size, int width, int height) {
+   // the files waiting in the pool will not be converted:
+   if (m_shouldStop.load() != 0)
+      return;
+   QElapsedTimer timer;
+   timer.start();
+   int widthNew, heightNew;
+   if (!newSize(width, height, widthNew, heightNew)) {
+      widthNew = width;
+      heightNew = height;
+   }
+   try {
+      convert(source, target, widthNew, heightNew, m_quality);
+      QString message = source + QString(" %1x%2 ").arg(width).arg(height)
+                        + sizeToString(size)
+                        + QString(" -> %1x%2 ").arg(widthNew).arg(heightNew);
+      QFileInfo info(target);
+      if (info.exists())
+         message += sizeToString(info.size()) + " ";
+      message += QString("").sprintf("%.3f sec", timer.elapsed() / 1000.0);
+      m_converted.fetchAndAddOrdered(1);
+      log(message);
+   } catch (ConverterException exc) {
+      // the error is already logged: the next file will be processed
    }
-   m_mainWindows->logAppendLast(
-      QString("").sprintf("%.3f sec",
-                          double(clock() - start) / CLOCKS_PER_SEC));
 }
 
 /**
@@ -277,7 +291,7 @@ void Converter::convertOneFile(const QString& source, const QString& target,
  * @throws ConverterException
  */
 bool Converter::error(const QString& message) {
-   m_mainWindows->log(message);
+   log("+++ " + message);
    throw ConverterException(message);
    return false;
 }
@@ -285,67 +299,134 @@ bool Converter::error(const QString& message) {
 /**
  * @brief Logs a message.
  *
+ * This method can be called by any thread.
+ *
  * @param message   the message to log
  * @return          <code>true</code>
  */
 bool Converter::log(const QString& message) {
    printf("%s\n", I18N::s2b(message).constData());
-   m_mainWindows->log(message);
+   m_mainWindows->guiQueue().pushBack(ReGuiQueueItem(
+                                         ReGuiQueueItem::LogMessage, NULL, message));
    return true;
 }
 
 /**
- * Reads the image properties using the external program "identify".
+ * Calculates the new size of an image.
+ *
+ * @param width     the width of the image
+ * @param height    the height of the image
+ * @param widthNew  OUT: the new width
+ * @param heightNew OUT: the new height
+ * @return          <code>true</code>: the image must be scaled<br>
+ *                  <code>false</code>: the image fits into the limits
+ */
+bool Converter::newSize(int width, int height, int& widthNew, int& heightNew) {
+   bool rc = false;
+   widthNew = width;
+   heightNew = height;
+   if (abs(width - height) < 5) {
+      // Square format:
+      rc = width > m_squareWidth;
+      if (rc)
+         widthNew = heightNew = m_squareWidth;
+   } else if (width > height) {
+      // Landscape:
+      rc = width > m_landscapeWidth || height > m_landscapeHeight;
+      if (rc) {
+         if (width > m_landscapeWidth && m_landscapeWidth > 0) {
+            widthNew = m_landscapeWidth;
+            heightNew = height * m_landscapeWidth / width;
+         } else {
+            heightNew = m_landscapeHeight;
+            widthNew = width * m_landscapeHeight / height;
+         }
+      }
+   } else {
+      // Portrait
+      rc = width > m_portraitWidth || height > m_portraitHeight;
+      if (rc) {
+         if (width > m_portraitWidth && m_portraitWidth > 0) {
+            widthNew = m_portraitWidth;
+            heightNew = height * m_portraitWidth / width;
+         } else {
+            heightNew = m_portraitHeight;
+            widthNew = width * m_portraitHeight / height;
+         }
+      }
+   }
+   if (widthNew <= 0 || heightNew <= 0) {
+      // no limit given:
+      rc = false;
+      widthNew = width;
+      heightNew = height;
+   }
+   return rc;
+}
+
+/**
+ * Reads the image size.
+ *
+ * Only the header of the image file is read.
  *
  * @param name      the filename with path
  * @param width     OUT: the width of the image
  * @param height    OUT: the height of the image
- * @param info      OUT: an info about the image
  * @return          <code>true</code>: success
- *                  <code>false</code>: properties not readable
+ * @throws ConverterException
  */
-bool Converter::readProperties(const QString& name, int& width, int& height,
-                               QString& info) {
-   QStringList args;
-   args << name;
-   QProcess process;
-   process.start("/usr/bin/identify", args);
-   QByteArray output;
-   bool rc = false;
-   while (process.waitForReadyRead()) {
-      output = process.readAll();
-      QRegularExpressionMatch match = m_imageInfo->match(output);
-      if (!match.hasMatch())
-         error(
-            QObject::tr("I am confused (wrong image data):\n%1\nExpected: %2").arg(
-               output.constData()).arg(m_imageInfo->pattern()));
-      else {
-         width = match.captured(m_groupWidth).toInt();
-         height = match.captured(m_groupHeight).toInt();
-         rc = true;
-         info = QString("%1x%2").arg(width).arg(height);
-         break;
-      }
+bool Converter::readProperties(const QString& name, int& width, int& height) {
+   QImageReader reader(name);
+   QSize size = reader.size();
+   bool rc = size.isValid();
+   if (!rc)
+      error(QObject::tr("cannot read the image size of %1: %2").arg(name).arg(
+               reader.errorString()));
+   else {
+      width = size.width();
+      height = size.height();
    }
-   output = process.readAll();
-   output = process.readAllStandardError();
-   if (!output.isEmpty())
-      error(output);
-   process.close();
    return rc;
 }
 
+/**
+ * Gives back a part of the memory budget.
+ *
+ * @param memory    the amount of memory (in bytes)
+ */
+void Converter::releaseMemory(qint64 memory) {
+   QMutexLocker locker(&m_memoryMutex);
+   m_memoryInUse -= memory;
+   m_memoryReleased.wakeAll();
+}
+
+/**
+ * Reserves a part of the memory budget.
+ *
+ * Waits until enough memory is released by the running conversions.
+ *
+ * @param memory    the amount of memory (in bytes)
+ */
+void Converter::reserveMemory(qint64 memory) {
+   QMutexLocker locker(&m_memoryMutex);
+   // one image is always allowed, even if it exceeds the budget:
+   while (m_memoryInUse > 0 && m_memoryInUse + memory > m_memoryBudget)
+      m_memoryReleased.wait(&m_memoryMutex);
+   m_memoryInUse += memory;
+}
+
 /**
  * @brief Runs the thread's task.
  *
  * <ul>
  *<li>Makes the target directory (if necessary)</li>
- *<li>Search the images *.png / *.jpg and converts them</li>
+ *<li>Search the images *.png / *.jpg and passes them to the thread pool</li>
+ *<li>Waits until all conversions are finished</li>
  *</ul>
  */
 void Converter::run() {
    QString msg;
-   int no = 0;
+   m_converted = 0;
    try {
       if (!m_dir.exists())
          error(
@@ -363,11 +444,11 @@ void Converter::run() {
             + m_targetDir.absolutePath());
       }
       changeState(Converter::STATE_STARTING, "");
-      m_shouldStop = false;
+      m_shouldStop.store(0);
       QDirIterator it(m_dir.absolutePath());
       QRegExp regExpr(m_sourcePattern, Qt::CaseInsensitive, QRegExp::Wildcard);
       while (it.hasNext()) {
-         if (m_shouldStop) {
+         if (m_shouldStop.load() != 0) {
             log(QObject::tr("Canceled by the user"));
             break;
          }
@@ -376,24 +457,38 @@ void Converter::run() {
             continue;
          QString node = it.fileName();
          if (regExpr.indexIn(node) >= 0) {
-            no++;
             QString path = m_dir.absoluteFilePath(node);
             qint64 length = it.fileInfo().size();
             QString nodeTarget = ReQStringUtil::replaceExtension(node,
                                  "." + m_targetType);
             QString target = m_targetDir.absoluteFilePath(nodeTarget);
-            convertOneFile(path, target, length);
+            int width, height, widthNew, heightNew;
+            try {
+               if (!readProperties(path, width, height))
+                  continue;
+            } catch (ConverterException exc) {
+               // already logged: the file is ignored
+               continue;
+            }
+            newSize(width, height, widthNew, heightNew);
+            // 4 bytes per pixel for the decoded and the scaled image:
+            qint64 memory = (qint64(width) * height
+                             + qint64(widthNew) * heightNew) * 4;
+            reserveMemory(memory);
+            m_pool.start(new ConvertTask(this, path, target, length, width,
+                                         height, memory));
          }
       }
+      m_pool.waitForDone();
       changeState(Converter::STATE_SUB_TASK_STOPPED, msg);
    } catch (ConverterException exc) {
       log(
          QObject::tr("Execution stopped because of error(s): ")
          + exc.message());
    }
-   msg = QObject::tr("%1 file(s) converted").arg(no);
+   m_pool.waitForDone();
+   msg = QObject::tr("%1 file(s) converted").arg(m_converted.load());
    changeState(Converter::STATE_READY, msg);
-   m_mainWindows->switchRun(true);
 }
 
 /**
@@ -15,9 +15,13 @@
 #include <QDir>
 #include <QDirIterator>
 #include <QStringList>
-#include <QProcess>
 #include <QList>
 #include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
 
 class MainWindow;
 class ConverterException {
@@ -39,6 +43,25 @@ public:
    virtual bool error(const QString& message) = 0;
 };
 
+class Converter;
+class ConvertTask: public QRunnable {
+public:
+   ConvertTask(Converter* converter, const QString& source,
+               const QString& target, qint64 size, int width, int height,
+               qint64 memory);
+public:
+   virtual void run();
+private:
+   Converter* m_converter;
+   QString m_source;
+   QString m_target;
+   qint64 m_size;
+   int m_width;
+   int m_height;
+   // the reserved part of the memory budget
+   qint64 m_memory;
+};
+
 class Converter: public QThread {
    Q_OBJECT
 public:
@@ -52,21 +75,22 @@ public:
              MainWindow* mainWindows);
    ~Converter();
 public:
+   void convertOneFile(const QString& source, const QString& target,
+                       qint64 size, int width, int height);
    bool error(const QString& message);
    bool log(const QString& message);
+   void releaseMemory(qint64 memory);
    void run();
    void stop() {
-      m_shouldStop = true;
+      m_shouldStop.store(1);
    }
 protected:
-   bool buildArgs();
    void changeState(State state, const QString& info);
-   void convert(const QString& source, const QString& target, int width,
-                int height, int widthNew, int heightNew, int quality);
-   void convertOneFile(const QString& source, const QString& target,
-                       qint64 size);
-   bool readProperties(const QString& name, int& width, int& height,
-                       QString& info);
+   void convert(const QString& source, const QString& target, int widthNew,
+                int heightNew, int quality);
+   bool newSize(int width, int height, int& widthNew, int& heightNew);
+   bool readProperties(const QString& name, int& width, int& height);
+   void reserveMemory(qint64 memory);
 private:
    QDir m_dir;
    QDir m_targetDir;
@@ -79,10 +103,17 @@ private:
    int m_squareWidth;
    int m_quality;
    MainWindow* m_mainWindows;
-   bool m_shouldStop;
-   QRegularExpression* m_imageInfo;
-   int m_groupWidth;
-   int m_groupHeight;
+   // != 0: the conversion should end. Set by the GUI thread, read by all
+   QAtomicInt m_shouldStop;
+   // the images are converted in parallel:
+   QThreadPool m_pool;
+   // the memory of the images in conversion may not exceed this limit
+   qint64 m_memoryBudget;
+   // protects m_memoryInUse
+   QMutex m_memoryMutex;
+   QWaitCondition m_memoryReleased;
+   qint64 m_memoryInUse;
+   QAtomicInt m_converted;
 };
 
 #endif // CONVERTER_HPP
@@ -36,7 +36,10 @@ MainWindow::MainWindow(const QString& homeDir, QWidget* parent) :
    m_homeDir(homeDir),
    m_storageFile(),
    ui(new Ui::MainWindow),
-   m_converter(NULL) {
+   m_converter(NULL),
+   m_statusMessage(NULL),
+   m_guiQueue(),
+   m_guiTimer(new QTimer(this)) {
    ui->setupUi(this);
    initializeHome();
    switchRun(true);
@@ -56,14 +59,17 @@ MainWindow::MainWindow(const QString& homeDir, QWidget* parent) :
            this, SLOT(on_templateChangeIndex(const QString&)));
    connect(ui->pushButtonActivate, SIGNAL(clicked()), this, SLOT(activate()));
    restoreState();
+   connect(m_guiTimer, SIGNAL(timeout()), this, SLOT(guiTimerUpdate()));
+   m_guiTimer->start(100);
 }
 
 /**
  * @brief Destructor
  */
 MainWindow::~MainWindow() {
-   delete ui;
+   // the converter threads use the GUI queue:
    delete m_converter;
+   delete ui;
 }
 
 /**
@@ -127,6 +133,34 @@ void MainWindow::about() {
    dialog.exec();
 }
 
+/**
+ * Callback method of the GUI timer.
+ *
+ * Shows the data passed by the converter threads.
+ */
+void MainWindow::guiTimerUpdate() {
+   QVector<ReGuiQueueItem> items;
+   int count = m_guiQueue.popFront(items);
+   for (int ix = 0; ix < count; ix++) {
+      const ReGuiQueueItem& item = items.at(ix);
+      switch (item.m_type) {
+      case ReGuiQueueItem::LogMessage:
+         log(item.m_value);
+         break;
+      case ReGuiQueueItem::UserDefined1: {
+         // state change: "<state> <info>"
+         int blank = item.m_value.indexOf(' ');
+         on_threadStateChanged(Converter::State(item.m_value.left(blank).toInt()),
+                               item.m_value.mid(blank + 1));
+         break;
+      }
+      default:
+         item.apply();
+         break;
+      }
+   }
+}
+
 /**
  * initializeHomeializes the program home directory.
  */
@@ -213,14 +247,14 @@ void MainWindow::on_pushButtonConvert_clicked() {
  * @brief Handles the event "thread changed".
  *
  * @param state     the new state of the thread
- * @param info      info about the new state. Not used
+ * @param info      info about the new state
  */
-void MainWindow::on_threadStateChanged(Converter::State state, const QString&) {
+void MainWindow::on_threadStateChanged(Converter::State state,
+                                       const QString& info) {
    switch (state) {
    case Converter::STATE_READY:
-      ui->pushButtonConvert->show();
-      ui->pushButtonStop->hide();
-      //ui->statusBar->showMessage(info);
+      switchRun(true);
+      setStatusMessage(false, info);
       break;
    case Converter::STATE_SUB_TASK_STOPPED:
       //ui->statusBar->showMessage(info);
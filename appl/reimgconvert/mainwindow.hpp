@@ -16,6 +16,7 @@
 #include <QFileDialog>
 #include <QResizeEvent>
 #include <QLabel>
+#include <QTimer>
 #include "converter.hpp"
 #include "gui/regui.hpp"
 namespace Ui {
@@ -36,6 +37,12 @@ public:
       log("+++ " + message);
       return false;
    }
+   /** Returns the queue for the data from the converter threads.
+    * @return  the GUI queue
+    */
+   ReGuiQueue& guiQueue() {
+      return m_guiQueue;
+   }
    bool log(const QString& message);
    bool logAppendLast(const QString& message);
    void setStatusMessage(bool error, const QString& message);
@@ -50,6 +57,7 @@ public slots:
 private slots:
    void activate();
    void about();
+   void guiTimerUpdate();
    void on_pushButtonFileSelect_clicked();
    void on_pushButtonStop_clicked();
    void on_pushButtonConvert_clicked();
@@ -62,6 +70,8 @@ private:
    Ui::MainWindow* ui;
    Converter* m_converter;
    QLabel* m_statusMessage;
+   ReGuiQueue m_guiQueue;
+   QTimer* m_guiTimer;
 };
 
 #endif // MAINWINDOW_HPP
@@ -19,6 +19,7 @@ SOURCES += main.cpp\
 	 ../../base/ReLogger.cpp \
 	 ../../gui/ReStateStorage.cpp \
 	 ../../gui/ReGuiValidator.cpp \
+	 ../../gui/ReGuiQueue.cpp \
 	 mainwindow.cpp \
 	 converter.cpp \
 	 aboutdialog.cpp
@@ -28,6 +29,7 @@ HEADERS  += mainwindow.hpp \
 	 ../../base/ReQStringUtil.hpp \
 	 ../../gui/ReStateStorage.hpp \
 	 ../../gui/ReGuiValidator.hpp \
+	 ../../gui/ReGuiQueue.hpp \
 	 ../../gui/regui.hpp \
 	 converter.hpp \
 	 aboutdialog.hpp
@@ -17,20 +17,111 @@
 #include "assert.h"
 #include "base/rebase.hpp"
 #include "Prime.hpp"
+#include <QThreadPool>
+#include <QRunnable>
+#include <QElapsedTimer>
+
+/**
+ * The pattern of the multiples of 3, 5 and 7 in the odd numbers.
+ *
+ * Index i stands for the odd number 2*i+1. The pattern repeats after
+ * <code>Prime::WHEEL_SIZE</code> odd numbers.
+ */
+class PrimeWheel {
+public:
+   PrimeWheel() {
+      for (int ix = 0; ix < Prime::WHEEL_SIZE; ix++) {
+         int x = 2 * ix + 1;
+         m_pattern[ix] = x % 3 == 0 || x % 5 == 0 || x % 7 == 0;
+      }
+   }
+public:
+   uint8_t m_pattern[Prime::WHEEL_SIZE];
+};
+static const PrimeWheel s_wheel;
+
+/**
+ * Sieves one segment in a thread of the pool.
+ */
+class SieveTask: public QRunnable {
+public:
+   SieveTask(int64_t start, int length, const QVector<int64_t>& basePrimes,
+             bool storePrimes) :
+      QRunnable(),
+      m_start(start),
+      m_length(length),
+      m_basePrimes(basePrimes),
+      m_storePrimes(storePrimes),
+      m_primes(),
+      m_count(0) {
+   }
+public:
+   virtual void run() {
+      uint8_t* segment = new uint8_t[m_length];
+      m_count = Prime::sieveSegment(m_start, m_length, m_basePrimes, segment,
+                                    m_storePrimes ? &m_primes : NULL);
+      delete[] segment;
+   }
+public:
+   int64_t m_start;
+   int m_length;
+   const QVector<int64_t>& m_basePrimes;
+   bool m_storePrimes;
+   QVector<int64_t> m_primes;
+   int m_count;
+};
+
+/**
+ * Calculates (a * b) % m without overflow.
+ *
+ * @param a     the first factor
+ * @param b     the second factor
+ * @param m     the modulus
+ * @return      (a * b) % m
+ */
+static inline uint64_t mulMod(uint64_t a, uint64_t b, uint64_t m) {
+#if defined __SIZEOF_INT128__
+   return uint64_t((unsigned __int128) a * b % m);
+#else
+   uint64_t rc = 0;
+   a %= m;
+   while (b > 0) {
+      if (b & 1)
+         rc = rc >= m - a ? rc - (m - a) : rc + a;
+      a = a >= m - a ? a - (m - a) : a + a;
+      b >>= 1;
+   }
+   return rc;
+#endif
+}
+
+/**
+ * Calculates (base ** exponent) % m.
+ *
+ * @param base      the base
+ * @param exponent  the exponent
+ * @param m         the modulus
+ * @return          (base ** exponent) % m
+ */
+static uint64_t powMod(uint64_t base, uint64_t exponent, uint64_t m) {
+   uint64_t rc = 1;
+   base %= m;
+   while (exponent > 0) {
+      if (exponent & 1)
+         rc = mulMod(rc, base, m);
+      base = mulMod(base, base, m);
+      exponent >>= 1;
+   }
+   return rc;
+}
 
 Prime::Prime(int64_t from, int count) :
    m_from(from),
    m_count(count),
-   m_primes(NULL),
-   m_sizePrimes(0),
-   m_countPrimes(0),
-   m_maxStoredPrimes(0) {
-   m_maxStoredPrimes = int (sqrt((double) m_from / 3 / log(sqrt(m_from)))) + 100;
-   m_sizePrimes = m_maxStoredPrimes + 10;
-   fprintf(stderr, "Storing %d primes\n", m_sizePrimes);
-   m_primes = new int64_t[m_sizePrimes];
-   m_primes[0] = 2;
-   m_countPrimes = 1;
+   m_primes(),
+   m_threads(QThread::idealThreadCount()) {
+   if (m_threads < 1)
+      m_threads = 1;
 }
 
 Prime::~Prime() {
@@ -50,79 +141,143 @@ void toFile(const char* prefix, int64_t* primes, int count) {
    }
 }
 
+/**
+ * Measures the speed of the sieve and of the Miller-Rabin test.
+ *
+ * @param limit     the primes below this limit will be counted
+ */
+void Prime::benchmark(int64_t limit) {
+   Prime prime(limit, 1);
+   prime.storePrimes(PRETEST_LIMIT);
+   QElapsedTimer timer;
+   timer.start();
+   int64_t count = prime.sieve(0, limit, NULL);
+   double duration = max(timer.elapsed() / 1000.0, 0.001);
+   fprintf(stderr, "sieve: %lld primes below %lld threads: %d %.3f sec"
+           " %.3f Mio primes/sec\n", (long long) count, (long long) limit,
+           prime.m_threads, duration, count / duration / 1E6);
+   // the candidates of calculate() are near the end of the 63 bit range:
+   int64_t x = 0x7fffffffffffffffL;
+   int candidates = 1000 * 1000;
+   timer.restart();
+   count = 0;
+   for (int ix = 0; ix < candidates; ix++, x -= 2)
+      if (prime.isPrime(x))
+         count++;
+   duration = max(timer.elapsed() / 1000.0, 0.001);
+   fprintf(stderr, "Miller-Rabin: %d candidates below 2**63: %lld primes"
+           " %.3f sec %.0f primes/sec\n", candidates, (long long) count,
+           duration, count / duration);
+}
+
+/**
+ * Finds <code>m_count</code> primes below <code>m_from</code>.
+ *
+ * The primes are spread over the range below <code>m_from</code>.
+ */
 void Prime::calculate() {
-   int64_t x = lastPrime() * lastPrime();
    int64_t* primes = new int64_t[m_count];
-   assert(x % 2 == 1);
+   int64_t x = (m_from & 1) != 0 ? m_from : m_from - 1;
    int nPrinted = 0;
-   while (nPrinted < m_count) {
-      while (x > 0) {
+   while (nPrinted < m_count && x > 2) {
+      if (!isPrime(x))
          x -= 2;
-         bool isPrime = true;
-         for (int ix = 0; ix < m_countPrimes; ix++) {
-            int64_t fac = m_primes[ix];
-            if (x % fac == 0) {
-               isPrime = false;
-               break;
-            }
-         }
-         if (isPrime) {
-            printf("%lld, // %llx\n", (long long) x, (long long) x);
-            fflush(stdout);
-            primes[nPrinted++] = x;
-            x -= m_from / m_count / 5;
-            if (x % 2 == 0)
-               x--;
-            break;
-         }
+      else {
+         printf("%lld, // %llx\n", (long long) x, (long long) x);
+         fflush(stdout);
+         primes[nPrinted++] = x;
+         x -= m_from / m_count / 5 + 2;
+         if (x % 2 == 0)
+            x--;
       }
    }
-   toFile("primes.sorted", primes, m_count);
+   toFile("primes.sorted", primes, nPrinted);
    ReKISSRandomizer random;
    random.nearTrueRandom();
-   random.shuffle(primes, m_count, sizeof primes[0]);
-   toFile("primes.shuffled", primes, m_count);
-}
-
-void Prime::storePrimes() {
-   clock_t start = clock();
-   int counter2 = 0;
-   for (int64_t x = 3; true; x += 2) {
-      if (x % (10*1000*1000) == 1) {
-         fprintf(stderr, "%ld Mio: %8.3f\n", x / (1000*1000),
-                 (clock() - start) / double(CLOCKS_PER_SEC));
-         if (counter2++ % 5 == 0)
-            dump();
-         fflush(stderr);
-      }
-      bool isPrime = true;
-      for (int ix = 0; ix < m_countPrimes; ix++) {
-         int64_t fac = m_primes[ix];
-         if (x % fac == 0) {
-            isPrime = false;
-            break;
-         } else if (fac * fac > x)
-            break;
-      }
-      if (isPrime) {
-         m_primes[m_countPrimes++] = x;
-         // hex(sqrt(2**63-1)) == 0xb504f333:
-         if (m_countPrimes >= m_maxStoredPrimes
-               || x * x > m_from || x > 0xb504f333)
-            break;
-      }
-   }
-   dump();
+   random.shuffle(primes, nPrinted, sizeof primes[0]);
+   toFile("primes.shuffled", primes, nPrinted);
+   delete[] primes;
 }
 
 void Prime::dump() {
    int64_t last = lastPrime();
-   fprintf(stderr, "count/primes: %d/%d last: %lx lp*lp: %lx %.2f%%\n",
-           m_countPrimes, m_sizePrimes, last, last * last,
+   fprintf(stderr, "count: %d last: %llx lp*lp: %llx %.2f%%\n",
+           m_primes.size(), (long long) last, (long long) (last * last),
            (double) last * last * 100.0 / m_from);
 }
 
+/**
+ * Tests whether a number is a prime.
+ *
+ * The stored primes are used for trial division. If they are not sufficient
+ * the deterministic Miller-Rabin test is done.
+ *
+ * @param x     the number to test
+ * @return      <code>true</code>: x is a prime
+ */
+bool Prime::isPrime(int64_t x) const {
+   if (x < 2)
+      return false;
+   for (int ix = 0; ix < m_primes.size(); ix++) {
+      int64_t prime = m_primes.at(ix);
+      if (x % prime == 0)
+         return x == prime;
+      else if (prime * prime > x)
+         return true;
+   }
+   return millerRabin(uint64_t(x));
+}
+
+/**
+ * Tests whether a number is a prime with the Miller-Rabin test.
+ *
+ * The test is deterministic for all 64 bit numbers.
+ *
+ * @param n     the number to test
+ * @return      <code>true</code>: n is a prime
+ */
+bool Prime::millerRabin(uint64_t n) {
+   // these bases are sufficient for all n < 3.3E24:
+   static const uint64_t bases[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31,
+                                     37
+                                   };
+   static const int countBases = sizeof bases / sizeof bases[0];
+   if (n < 2)
+      return false;
+   for (int ix = 0; ix < countBases; ix++) {
+      if (n % bases[ix] == 0)
+         return n == bases[ix];
+   }
+   uint64_t d = n - 1;
+   int shifts = 0;
+   while ((d & 1) == 0) {
+      d >>= 1;
+      shifts++;
+   }
+   for (int ix = 0; ix < countBases; ix++) {
+      uint64_t x = powMod(bases[ix], d, n);
+      if (x == 1 || x == n - 1)
+         continue;
+      bool composite = true;
+      for (int ixShift = 1; ixShift < shifts && composite; ixShift++) {
+         x = mulMod(x, x, n);
+         composite = x != n - 1;
+      }
+      if (composite)
+         return false;
+   }
+   return true;
+}
+
 void Prime::run(int argc, char* argv[]) {
+   if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+      int64_t limit = 1000 * 1000 * 1000;
+      long long lValue;
+      if (argc > 2 && sscanf(argv[2], "%lld", &lValue) == 1)
+         limit = lValue;
+      benchmark(limit);
+      return;
+   }
    int64_t from = 0x7fffffffefffefffL;
    int count = 150;
    if (argc > 1) {
@@ -140,14 +295,154 @@ void Prime::run(int argc, char* argv[]) {
       }
    }
    fprintf(stderr, "from: %ld/%lx count: %d\n", from, from, count);
-   clock_t start = clock();
+   QElapsedTimer timer;
+   timer.start();
    Prime prime(from, count);
-   prime.storePrimes();
-   fprintf (stderr, "storePrime: %f sec\n",
-            double (clock() - start) / CLOCKS_PER_SEC);
-   prime.dump();
+   prime.storePrimes(PRETEST_LIMIT);
+   fprintf (stderr, "storePrime: %f sec\n", timer.elapsed() / 1000.0);
    prime.calculate();
-   double duration = double (clock() - start) / CLOCKS_PER_SEC;
+   double duration = timer.elapsed() / 1000.0;
    fprintf (stderr, "duration: %f sec\n", duration);
 }
 
+/**
+ * Finds the primes in a given range with a segmented sieve of Eratosthenes.
+ *
+ * The segments are sieved in parallel by a thread pool.
+ *
+ * @param from      the start of the range (including)
+ * @param to        the end of the range (excluding)
+ * @param primes    NULL or OUT: the found primes are appended (sorted)
+ * @return          the count of found primes
+ */
+int64_t Prime::sieve(int64_t from, int64_t to, QVector<int64_t>* primes) {
+   QVector<int64_t> basePrimes;
+   simplePrimes(int64_t(sqrt(double(to))) + 2, basePrimes);
+   int64_t rc = 0;
+   if (from <= 2 && to > 2) {
+      rc++;
+      if (primes != NULL)
+         primes->append(2);
+   }
+   int64_t start = from < 1 ? 1 : from | 1;
+   QThreadPool pool;
+   pool.setMaxThreadCount(m_threads);
+   QVector<SieveTask*> tasks;
+   while (start < to) {
+      // a batch of segments: the results are collected in the right order
+      tasks.clear();
+      for (int ix = 0; ix < 4 * m_threads && start < to; ix++) {
+         int64_t length = (to - start + 1) / 2;
+         if (length > SEGMENT_SIZE)
+            length = SEGMENT_SIZE;
+         SieveTask* task = new SieveTask(start, int(length), basePrimes,
+                                         primes != NULL);
+         task->setAutoDelete(false);
+         tasks.append(task);
+         pool.start(task);
+         start += 2 * length;
+      }
+      pool.waitForDone();
+      for (int ix = 0; ix < tasks.size(); ix++) {
+         SieveTask* task = tasks.at(ix);
+         rc += task->m_count;
+         if (primes != NULL)
+            *primes += task->m_primes;
+         delete task;
+      }
+   }
+   return rc;
+}
+
+/**
+ * Sieves a segment of odd numbers.
+ *
+ * The multiples of 3, 5 and 7 are copied from a wheel pattern, the other
+ * base primes cross out their odd multiples.
+ *
+ * @param start         the first number of the segment. Must be odd
+ * @param length        the count of odd numbers in the segment
+ * @param basePrimes    the primes up to the square root of the segment end
+ * @param segment       a buffer with at least <code>length</code> bytes
+ * @param primes        NULL or OUT: the found primes are appended
+ * @return              the count of found primes
+ */
+int Prime::sieveSegment(int64_t start, int length,
+                        const QVector<int64_t>& basePrimes, uint8_t* segment,
+                        QVector<int64_t>* primes) {
+   int offset = int(((start - 1) / 2) % WHEEL_SIZE);
+   for (int ix = 0; ix < length; offset = 0) {
+      int part = WHEEL_SIZE - offset;
+      if (part > length - ix)
+         part = length - ix;
+      memcpy(segment + ix, s_wheel.m_pattern + offset, part);
+      ix += part;
+   }
+   // the end of the segment (excluding):
+   int64_t end = start + 2 * int64_t(length);
+   for (int ixPrime = 0; ixPrime < basePrimes.size(); ixPrime++) {
+      int64_t prime = basePrimes.at(ixPrime);
+      if (prime <= 7)
+         continue;
+      int64_t multiple = prime * prime;
+      if (multiple >= end)
+         break;
+      if (multiple < start) {
+         multiple = (start + prime - 1) / prime * prime;
+         if ((multiple & 1) == 0)
+            multiple += prime;
+      }
+      for (int64_t ix = (multiple - start) / 2; ix < length; ix += prime)
+         segment[ix] = 1;
+   }
+   // the wheel primes are crossed out by the pattern:
+   for (int64_t x = 3; x <= 7; x += 2) {
+      if (x >= start && x < end)
+         segment[(x - start) / 2] = 0;
+   }
+   if (start == 1)
+      segment[0] = 1;
+   int rc = 0;
+   for (int ix = 0; ix < length; ix++) {
+      if (segment[ix] == 0) {
+         rc++;
+         if (primes != NULL)
+            primes->append(start + 2 * int64_t(ix));
+      }
+   }
+   return rc;
+}
+
+/**
+ * Finds the primes below a small limit with the classic sieve.
+ *
+ * @param limit     the primes below this limit will be found
+ * @param primes    OUT: the primes
+ */
+void Prime::simplePrimes(int64_t limit, QVector<int64_t>& primes) {
+   primes.clear();
+   if (limit > 2)
+      primes.append(2);
+   // index i stands for 2*i+1:
+   QByteArray composite(int(limit / 2), '\0');
+   for (int64_t ix = 1; ix < composite.size(); ix++) {
+      if (composite.at(ix) == 0) {
+         int64_t prime = 2 * ix + 1;
+         primes.append(prime);
+         for (int64_t ix2 = (prime * prime) / 2; ix2 < composite.size();
+               ix2 += prime)
+            composite[int(ix2)] = 1;
+      }
+   }
+}
+
+/**
+ * Stores the primes below a given limit.
+ *
+ * @param limit     the primes below this limit will be stored
+ */
+void Prime::storePrimes(int64_t limit) {
+   m_primes.clear();
+   sieve(0, limit, &m_primes);
+   dump();
+}
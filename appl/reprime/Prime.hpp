@@ -14,25 +14,42 @@
 
 //typedef long long int int64_t;
 class Prime {
+public:
+   enum {
+      // bytes of a sieve segment (one byte per odd number): fits into L2 cache
+      SEGMENT_SIZE = 128 * 1024,
+      // the period of the wheel (3*5*7) counted in odd numbers
+      WHEEL_SIZE = 105,
+      // the stored primes are used as pretest of isPrime()
+      PRETEST_LIMIT = 10000
+   };
 public:
    Prime(int64_t from, int count);
    virtual ~Prime();
 public:
-   void storePrimes();
    void calculate();
    void dump();
+   bool isPrime(int64_t x) const;
    int64_t lastPrime() const {
-      return m_primes[m_countPrimes - 1];
+      return m_primes.last();
    }
+   int64_t sieve(int64_t from, int64_t to, QVector<int64_t>* primes);
+   void storePrimes(int64_t limit);
 public:
+   static void benchmark(int64_t limit);
+   static bool millerRabin(uint64_t n);
    static void run(int argc, char* argv[]);
+   static int sieveSegment(int64_t start, int length,
+                           const QVector<int64_t>& basePrimes, uint8_t* segment,
+                           QVector<int64_t>* primes);
+   static void simplePrimes(int64_t limit, QVector<int64_t>& primes);
 private:
    int64_t m_from;
    int m_count;
-   int64_t* m_primes;
-   int m_sizePrimes;
-   int m_countPrimes;
-   int m_maxStoredPrimes;
+   // the primes below a limit, see storePrimes()
+   QVector<int64_t> m_primes;
+   // the number of worker threads of the sieve
+   int m_threads;
 };
 
 #endif /* PRIME_HPP_ */
@@ -0,0 +1,600 @@
+/*
+ * ReBinaryLogger.cpp
+ *
+ * (Un)License: Public Domain
+ * You can use and modify this file without any restriction.
+ * Do what you want.
+ * No warranties and disclaimer of any damages.
+ * More info: http://unlicense.org
+ * The latest sources: https://github.com/republib
+ */
+
+/** @file
+ * A logging appender storing the unformatted arguments in a binary file.
+ */
+/** @file base/ReBinaryLogger.hpp
+ *
+ * Definitions for a logging appender storing unformatted arguments.
+ */
+#include "base/rebase.hpp"
+
+const char ReBinaryLogFormat::m_magic[8] = { 'R', 'e', 'B', 'L', 'o', 'g', '1',
+                                             '\n'
+                                           };
+
+/**
+ * Returns the current time with the highest available precision.
+ *
+ * @return  the nanoseconds since the epoch
+ */
+static int64_t nanoTime() {
+#if defined __linux__
+   struct timespec now;
+   clock_gettime(CLOCK_REALTIME, &now);
+   return now.tv_sec * 1000000000LL + now.tv_nsec;
+#else
+   return QDateTime::currentMSecsSinceEpoch() * 1000000LL;
+#endif
+}
+
+/**
+ * Parses a placeholder of a printf like format.
+ *
+ * @param fmt	IN: points behind the '%'<br>
+ *				OUT: points behind the conversion char
+ * @param size	OUT: the length modifier: '\0': int, 'l': long,
+ *				'L': long long, 'z': size_t or ptrdiff_t, 'D': long double
+ * @return		the conversion char, e.g. 'd' or 's'<br>
+ *				'\0': end of format reached
+ */
+static char parsePlaceholder(const char*& fmt, char& size) {
+   size = '\0';
+   while (*fmt != '\0' && strchr("-+ #0'", *fmt) != NULL)
+      fmt++;
+   while (isdigit(*fmt) || *fmt == '.' || *fmt == '*')
+      fmt++;
+   char cc;
+   while ((cc = *fmt) != '\0' && strchr("hlLqjzt", cc) != NULL) {
+      fmt++;
+      switch (cc) {
+      case 'l':
+         size = size == 'l' ? 'L' : 'l';
+         break;
+      case 'q':
+      case 'j':
+         size = 'L';
+         break;
+      case 'z':
+      case 't':
+         size = 'z';
+         break;
+      case 'L':
+         size = 'D';
+         break;
+      default:
+         break;
+      }
+   }
+   if (cc != '\0')
+      fmt++;
+   return cc;
+}
+
+/**
+ * Stores a 64 bit value into a buffer.
+ *
+ * @param ptr	IN/OUT: the position to store
+ * @param end	the end of the buffer
+ * @param value	the value to store
+ * @return		<code>true</code>: success<br>
+ *				<code>false</code>: buffer too small
+ */
+static inline bool putInt64(uint8_t*& ptr, uint8_t* end, int64_t value) {
+   bool rc = ptr + sizeof value <= end;
+   if (rc) {
+      memcpy(ptr, &value, sizeof value);
+      ptr += sizeof value;
+   }
+   return rc;
+}
+
+/** @class ReBinaryLogFormat ReBinaryLogger.hpp "base/ReBinaryLogger.hpp"
+ *
+ * @brief Stores the arguments of a printf like format without formatting.
+ *
+ * The format itself is not stored: each logging location has a unique
+ * identifier which allows to find the format later
+ * (see <code>tools/mk_logformats.pl</code>).
+ *
+ * The arguments are stored in the order of the placeholders:
+ * <ul><li>integers (including '*' for width or precision), chars and pointers:
+ * 8 bytes</li>
+ * <li>floating point values: 8 bytes (double)</li>
+ * <li>strings: 2 bytes length followed by the content without '\\0'</li>
+ * </ul>
+ */
+
+/**
+ * Packs the arguments of a printf like format into a buffer.
+ *
+ * @param format		the format with placeholders (like printf)
+ * @param args			the values of the placeholders
+ * @param buffer		OUT: the packed arguments
+ * @param bufferSize	the size of <code>buffer</code>
+ * @return				the count of used bytes in <code>buffer</code>
+ */
+int ReBinaryLogFormat::packArguments(const char* format, va_list& args,
+                                     uint8_t* buffer, int bufferSize) {
+   uint8_t* ptr = buffer;
+   uint8_t* end = buffer + bufferSize;
+   const char* fmt = format;
+   bool full = false;
+   while (!full && (fmt = strchr(fmt, '%')) != NULL) {
+      const char* start = ++fmt;
+      char size;
+      char conversion = parsePlaceholder(fmt, size);
+      for (const char* star = start; star < fmt; star++) {
+         if (*star == '*' && !full)
+            full = !putInt64(ptr, end, va_arg(args, int));
+      }
+      if (full)
+         break;
+      switch (conversion) {
+      case 'd':
+      case 'i':
+      case 'c':
+         full = !putInt64(ptr, end,
+                          size == 'l' ? va_arg(args, long)
+                          : size == 'L' ? va_arg(args, long long)
+                          : size == 'z' ? va_arg(args, ptrdiff_t) : va_arg(args, int));
+         break;
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X':
+         full = !putInt64(ptr, end,
+                          size == 'l' ? va_arg(args, unsigned long)
+                          : size == 'L' ? va_arg(args, unsigned long long)
+                          : size == 'z' ? va_arg(args, size_t)
+                          : va_arg(args, unsigned int));
+         break;
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'F':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A': {
+         double value = size == 'D' ? (double) va_arg(args, long double)
+                        : va_arg(args, double);
+         int64_t value2;
+         memcpy(&value2, &value, sizeof value2);
+         full = !putInt64(ptr, end, value2);
+         break;
+      }
+      case 'p':
+         full = !putInt64(ptr, end, (int64_t) va_arg(args, void*));
+         break;
+      case 'n':
+         va_arg(args, void*);
+         break;
+      case 's': {
+         const char* value = va_arg(args, const char*);
+         if (value == NULL)
+            value = "(null)";
+         int length = strlen(value);
+         if (ptr + 2 + length > end) {
+            length = end - ptr - 2;
+            full = true;
+         }
+         if (length >= 0) {
+            uint16_t length2 = (uint16_t) length;
+            memcpy(ptr, &length2, sizeof length2);
+            memcpy(ptr + 2, value, length);
+            ptr += 2 + length;
+         }
+         break;
+      }
+      case '\0':
+         fmt = "";
+         break;
+      default:
+         break;
+      }
+   }
+   return ptr - buffer;
+}
+
+/**
+ * Formats a message from a format and the packed arguments.
+ *
+ * @param format	the format with placeholders (like printf)
+ * @param data		the arguments packed by <code>packArguments()</code>
+ * @param length	the length of <code>data</code>
+ * @return			the formatted message
+ */
+QByteArray ReBinaryLogFormat::unpackArguments(const char* format,
+      const uint8_t* data, int length) {
+   QByteArray rc;
+   QByteArray spec;
+   char buffer[512];
+   const uint8_t* end = data + length;
+   const char* fmt = format;
+   const char* percent;
+   int64_t value;
+   while ((percent = strchr(fmt, '%')) != NULL) {
+      rc.append(fmt, percent - fmt);
+      fmt = percent + 1;
+      char size;
+      char conversion = parsePlaceholder(fmt, size);
+      if (conversion == '%') {
+         rc.append('%');
+         continue;
+      }
+      if (conversion == '\0')
+         break;
+      spec.resize(0);
+      bool missing = false;
+      for (const char* ptr = percent; ptr < fmt - 1; ptr++) {
+         if (strchr("hlLqjzt", *ptr) != NULL)
+            continue;
+         if (*ptr != '*')
+            spec.append(*ptr);
+         else if (data + sizeof value > end)
+            missing = true;
+         else {
+            memcpy(&value, data, sizeof value);
+            data += sizeof value;
+            spec.append(QByteArray::number((int) value));
+         }
+      }
+      if (conversion == 'n')
+         continue;
+      if (conversion == 's') {
+         uint16_t length2 = 0;
+         if (data + sizeof length2 > end)
+            missing = true;
+         else {
+            memcpy(&length2, data, sizeof length2);
+            data += sizeof length2;
+            if (data + length2 > end)
+               length2 = end - data;
+         }
+         if (!missing) {
+            QByteArray value2((const char*) data, length2);
+            data += length2;
+            if (spec == "%")
+               rc.append(value2);
+            else {
+               spec.append('s');
+               qsnprintf(buffer, sizeof buffer, spec.constData(),
+                         value2.constData());
+               rc.append(buffer);
+            }
+         }
+      } else if (data + sizeof value > end)
+         missing = true;
+      else {
+         memcpy(&value, data, sizeof value);
+         data += sizeof value;
+         switch (conversion) {
+         case 'c':
+         case 'p':
+            spec.append(conversion);
+            if (conversion == 'c')
+               qsnprintf(buffer, sizeof buffer, spec.constData(), (int) value);
+            else
+               qsnprintf(buffer, sizeof buffer, spec.constData(), (void*) value);
+            break;
+         case 'd':
+         case 'i':
+         case 'u':
+         case 'o':
+         case 'x':
+         case 'X':
+            spec.append("ll").append(conversion);
+            qsnprintf(buffer, sizeof buffer, spec.constData(), (long long) value);
+            break;
+         default: {
+            double value2;
+            memcpy(&value2, &value, sizeof value2);
+            spec.append(conversion);
+            qsnprintf(buffer, sizeof buffer, spec.constData(), value2);
+            break;
+         }
+         }
+         rc.append(buffer);
+      }
+      if (missing)
+         rc.append('?');
+   }
+   rc.append(fmt);
+   return rc;
+}
+
+/** @class ReBinaryFileAppender ReBinaryLogger.hpp "base/ReBinaryLogger.hpp"
+ *
+ * @brief Puts the logging info into binary files.
+ *
+ * The appender does not format the messages: it stores the time, the level,
+ * the location and the packed arguments (see <code>ReBinaryLogFormat</code>)
+ * into a memory mapped file. This is much cheaper than formatting.
+ * The program <code>appl/rebinlog</code> converts the files into text.
+ *
+ * Like <code>ReFileAppender</code> the appender creates a collection of files
+ * with a limited size and a limited count.
+ * Each logfile's name has a given name prefix, a running number
+ * and the suffix ".rlog", e.g. "globallogger.003.rlog".
+ */
+
+/**
+ * @brief Constructor.
+ *
+ * @param prefix		the prefix of the log file name, e.g. /var/log/server
+ * @param maxSize		the maximum of the file size
+ * @param maxCount		the maximal count of files. If neccessary the oldest file will be deleted
+ * @param appenderName	the name of the appender. @see ReLogger::findAppender()
+ */
+ReBinaryFileAppender::ReBinaryFileAppender(const QByteArray& prefix,
+      int maxSize, int maxCount, const char* appenderName) :
+   ReAppender(QByteArray(appenderName)),
+   m_prefix(prefix),
+   m_maxSize(max(maxSize, 2 * ReBinaryLogFormat::MAX_RECORD_LENGTH)),
+   m_maxCount(maxCount),
+   m_currentNo(0),
+   m_file(),
+   m_memory(NULL),
+   m_position(0) {
+   m_withRawArguments = true;
+   open();
+}
+
+/**
+ * @brief Destructor.
+ */
+ReBinaryFileAppender::~ReBinaryFileAppender() {
+   close();
+}
+
+/**
+ * @brief Closes the current log file.
+ *
+ * The unused tail of the file will be removed.
+ */
+void ReBinaryFileAppender::close() {
+   if (m_memory != NULL) {
+      m_file.unmap(m_memory);
+      m_memory = NULL;
+      m_file.resize(m_position);
+   }
+   if (m_file.isOpen())
+      m_file.close();
+}
+
+/**
+ * @brief Logs (or not) the current location.
+ *
+ * @param level		the level of the location
+ * @param location	an unique identifier of the location
+ * @param message	the logging message
+ * @param logger    the calling logger
+ */
+void ReBinaryFileAppender::log(ReLoggerLevel level, int location,
+                               const char* message, ReLogger* logger) {
+   ReUseParameter(logger);
+   int length = strlen(message);
+   putRecord(level, location, ReBinaryLogFormat::RT_TEXT,
+             (const uint8_t*) message, length);
+}
+
+/**
+ * @brief Logs (or not) the current location without formatting the message.
+ *
+ * @param level		the level of the location
+ * @param location	an unique identifier of the location
+ * @param format	the logging message with placeholders (like printf)
+ * @param args		the values of the placeholders
+ * @param logger    the calling logger
+ */
+void ReBinaryFileAppender::logArguments(ReLoggerLevel level, int location,
+                                        const char* format, va_list& args, ReLogger* logger) {
+   ReUseParameter(logger);
+   putRecord(level, location, ReBinaryLogFormat::RT_ARGUMENTS,
+             (const uint8_t*) format, -1, &args);
+}
+
+/**
+ * @brief Opens the next log file.
+ */
+void ReBinaryFileAppender::open() {
+   close();
+   char fullName[512];
+   if (m_maxCount > 0 && m_currentNo >= m_maxCount) {
+      qsnprintf(fullName, sizeof fullName, "%s.%03d.rlog", m_prefix.data(),
+                m_currentNo + 1 - m_maxCount);
+      unlink(fullName);
+   }
+   qsnprintf(fullName, sizeof fullName, "%s.%03d.rlog", m_prefix.data(),
+             ++m_currentNo);
+   m_file.setFileName(fullName);
+   if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+      fprintf(stderr, "cannot open: %s\n", fullName);
+   else if (!m_file.resize(m_maxSize)
+            || (m_memory = m_file.map(0, m_maxSize)) == NULL) {
+      fprintf(stderr, "cannot map: %s\n", fullName);
+      m_file.close();
+   } else {
+      memcpy(m_memory, ReBinaryLogFormat::m_magic,
+             sizeof ReBinaryLogFormat::m_magic);
+      m_position = sizeof ReBinaryLogFormat::m_magic;
+   }
+}
+
+/**
+ * @brief Puts a record into the mapped file.
+ *
+ * If the rest of the current file is too small the next file will be opened.
+ *
+ * @param level		the level of the location
+ * @param location	an unique identifier of the location
+ * @param type		the record type: RT_TEXT or RT_ARGUMENTS
+ * @param data		RT_TEXT: the message<br>
+ *					RT_ARGUMENTS: the format
+ * @param length	RT_TEXT: the length of <code>data</code><br>
+ *					RT_ARGUMENTS: not used
+ * @param args		NULL or the values of the placeholders of the format
+ */
+void ReBinaryFileAppender::putRecord(ReLoggerLevel level, int location,
+                                     uint8_t type, const uint8_t* data, int length, va_list* args) {
+   if (m_memory != NULL
+         && m_position + ReBinaryLogFormat::MAX_RECORD_LENGTH > m_maxSize)
+      open();
+   if (m_memory != NULL) {
+      ReBinaryLogRecord_t* record = (ReBinaryLogRecord_t*)(m_memory
+                                    + m_position);
+      uint8_t* content = (uint8_t*)(record + 1);
+      // reserve 7 bytes for the alignment:
+      int maxLength = ReBinaryLogFormat::MAX_RECORD_LENGTH - sizeof *record - 7;
+      if (args != NULL)
+         length = ReBinaryLogFormat::packArguments((const char*) data, *args,
+                  content, maxLength);
+      else {
+         if (length > maxLength)
+            length = maxLength;
+         memcpy(content, data, length);
+      }
+      // 8 byte alignment: the tail of the file is filled with 0 by resize()
+      int recordLength = (sizeof *record + length + 7) & ~7;
+      record->m_length = (uint16_t) recordLength;
+      record->m_type = type;
+      record->m_level = (uint8_t) level;
+      record->m_location = location;
+      record->m_time = nanoTime();
+      m_position += recordLength;
+   }
+}
+
+/** @class ReBinaryLogReader ReBinaryLogger.hpp "base/ReBinaryLogger.hpp"
+ *
+ * @brief Reads the files written by <code>ReBinaryFileAppender</code>.
+ *
+ * The formats of the locations are taken from a table, normally created
+ * from the sources by <code>tools/mk_logformats.pl</code>.
+ */
+
+/**
+ * Constructor.
+ *
+ * @param formats	NULL or the format table: location -> format
+ */
+ReBinaryLogReader::ReBinaryLogReader(const QMap<int, QByteArray>* formats) :
+   m_formats(formats),
+   m_content(),
+   m_position(0) {
+}
+
+/**
+ * Converts a record into a text line like <code>ReFileAppender</code>.
+ *
+ * @param record	the record to convert
+ * @return			the text line (without '\\n')
+ */
+QByteArray ReBinaryLogReader::asText(const ReBinaryLogRecord_t* record) const {
+   time_t seconds = time_t(record->m_time / 1000000000LL);
+   struct tm* now2 = localtime(&seconds);
+   char buffer[64];
+   qsnprintf(buffer, sizeof buffer, "%c%d.%02d.%02d %02d:%02d:%02d (%d): ",
+             ReLogger::getPrefixOfLevel((ReLoggerLevel) record->m_level),
+             now2->tm_year + 1900, now2->tm_mon + 1, now2->tm_mday,
+             now2->tm_hour, now2->tm_min, now2->tm_sec, record->m_location);
+   QByteArray rc(buffer);
+   const uint8_t* data = (const uint8_t*)(record + 1);
+   int length = record->m_length - sizeof *record;
+   if (record->m_type == ReBinaryLogFormat::RT_TEXT)
+      rc.append((const char*) data, strnlen((const char*) data, length));
+   else if (m_formats == NULL || !m_formats->contains(record->m_location))
+      rc.append("<unknown format> ").append(
+         ReStringUtils::hexDump(data, length, length));
+   else
+      rc.append(ReBinaryLogFormat::unpackArguments(
+                   (*m_formats)[record->m_location].constData(), data, length));
+   return rc;
+}
+
+/**
+ * Reads a format table.
+ *
+ * Each line contains the location, a TAB and the format (as C string content),
+ * e.g. <code>10801\\tsend: flags: %x %s\\n</code>.
+ *
+ * @param filename	the name of the table file
+ * @param formats	OUT: the format table: location -> format
+ * @return			the count of read formats
+ */
+int ReBinaryLogReader::loadFormats(const char* filename,
+                                   QMap<int, QByteArray>& formats) {
+   int rc = 0;
+   QFile file(filename);
+   if (file.open(QIODevice::ReadOnly)) {
+      QByteArray line;
+      while (!(line = file.readLine()).isEmpty()) {
+         int ix = line.indexOf('\t');
+         if (ix > 0) {
+            bool ok;
+            int location = line.left(ix).toInt(&ok);
+            if (ok) {
+               QByteArray format = line.mid(ix + 1);
+               if (format.endsWith('\n'))
+                  format.chop(1);
+               formats[location] = format.replace("\\n", "\n").replace("\\t",
+                                   "\t").replace("\\\"", "\"").replace("\\\\", "\\");
+               rc++;
+            }
+         }
+      }
+      file.close();
+   }
+   return rc;
+}
+
+/**
+ * Returns the next record of the log file.
+ *
+ * @return	NULL: no more records<br>
+ *			otherwise: the next record
+ */
+const ReBinaryLogRecord_t* ReBinaryLogReader::nextRecord() {
+   const ReBinaryLogRecord_t* rc = NULL;
+   if (m_position + (int) sizeof *rc <= m_content.length()) {
+      rc = (const ReBinaryLogRecord_t*)(m_content.constData() + m_position);
+      if (rc->m_length < sizeof *rc
+            || m_position + rc->m_length > m_content.length())
+         rc = NULL;
+      else
+         m_position += rc->m_length;
+   }
+   return rc;
+}
+
+/**
+ * Reads a binary log file.
+ *
+ * @param filename	the name of the log file
+ * @return			<code>true</code>: success<br>
+ *					<code>false</code>: file not readable or not a binary log
+ */
+bool ReBinaryLogReader::open(const char* filename) {
+   QFile file(filename);
+   m_content.clear();
+   m_position = 0;
+   bool rc = file.open(QIODevice::ReadOnly);
+   if (rc) {
+      m_content = file.readAll();
+      file.close();
+      rc = m_content.startsWith(QByteArray(ReBinaryLogFormat::m_magic,
+                                           sizeof ReBinaryLogFormat::m_magic));
+      m_position = sizeof ReBinaryLogFormat::m_magic;
+   }
+   return rc;
+}
@@ -0,0 +1,119 @@
+/*
+ * ReBinaryLogger.hpp
+ *
+ * (Un)License: Public Domain
+ * You can use and modify this file without any restriction.
+ * Do what you want.
+ * No warranties and disclaimer of any damages.
+ * More info: http://unlicense.org
+ * The latest sources: https://github.com/republib
+ */
+#ifndef REBINARYLOGGER_HPP
+#define REBINARYLOGGER_HPP
+
+/**
+ * The head of a record of a binary log file.
+ *
+ * The record is followed by the packed arguments (see
+ * <code>ReBinaryLogFormat</code>) or by the message text.
+ * All values are stored in the byte order of the writing host.
+ */
+typedef struct {
+   /// the length of the record including this head
+   uint16_t m_length;
+   /// RT_ARGUMENTS or RT_TEXT
+   uint8_t m_type;
+   /// the logging level, e.g. LOG_ERROR
+   uint8_t m_level;
+   /// the unique identifier of the logging location
+   int32_t m_location;
+   /// the nanoseconds since the epoch
+   int64_t m_time;
+} ReBinaryLogRecord_t;
+
+/**
+ * Packs and unpacks the arguments of printf like formats.
+ */
+class ReBinaryLogFormat {
+public:
+   enum RecordType {
+      RT_UNDEF,
+      /// the record contains the packed arguments of a format
+      RT_ARGUMENTS,
+      /// the record contains the message as text
+      RT_TEXT
+   };
+   enum {
+      /// the maximal length of a record
+      MAX_RECORD_LENGTH = 0xffff
+   };
+public:
+   static int packArguments(const char* format, va_list& args, uint8_t* buffer,
+                            int bufferSize);
+   static QByteArray unpackArguments(const char* format, const uint8_t* data,
+                                     int length);
+public:
+   /// the first bytes of a binary log file
+   static const char m_magic[8];
+};
+
+/**
+ * Puts the messages with their unformatted arguments into a memory mapped file.
+ */
+class ReBinaryFileAppender: public ReAppender {
+public:
+   ReBinaryFileAppender(const QByteArray& prefix, int maxSize, int maxCount,
+                        const char* appenderName = "BinaryFileAppender");
+   virtual ~ReBinaryFileAppender();
+public:
+   void close();
+   virtual void log(ReLoggerLevel level, int location, const char* message,
+                    ReLogger* logger);
+   virtual void logArguments(ReLoggerLevel level, int location,
+                             const char* format, va_list& args, ReLogger* logger);
+   void open();
+   /** Returns the name of the current log file.
+    * @return the current filename
+    */
+   QString filename() const {
+      return m_file.fileName();
+   }
+private:
+   void putRecord(ReLoggerLevel level, int location, uint8_t type,
+                  const uint8_t* data, int length, va_list* args = NULL);
+private:
+   // prefix of the log file name. Will be appended by ".<no>.rlog"
+   QByteArray m_prefix;
+   // maximal size of a logging file:
+   int m_maxSize;
+   // maximal count of logging files. If neccessary the oldest file will be deleted.
+   int m_maxCount;
+   // the number of the current log file:
+   int m_currentNo;
+   // the current log file:
+   QFile m_file;
+   // NULL or the mapped content of the current log file:
+   uint8_t* m_memory;
+   // the offset of the next record in m_memory:
+   int m_position;
+};
+
+/**
+ * Reads a binary log file written by <code>ReBinaryFileAppender</code>.
+ */
+class ReBinaryLogReader {
+public:
+   ReBinaryLogReader(const QMap<int, QByteArray>* formats = NULL);
+public:
+   static int loadFormats(const char* filename, QMap<int, QByteArray>& formats);
+   QByteArray asText(const ReBinaryLogRecord_t* record) const;
+   const ReBinaryLogRecord_t* nextRecord();
+   bool open(const char* filename);
+private:
+   // NULL or the format table: location -> format
+   const QMap<int, QByteArray>* m_formats;
+   QByteArray m_content;
+   int m_position;
+};
+
+#endif // REBINARYLOGGER_HPP
@@ -35,6 +35,12 @@
  * buffer will be allocated and linked into the buffer list.
  * One buffer can store dozens or hundreds of blocks. Therefore allocation and
  * freeing is much cheeper than allocation by <code>new()</code>.
+ *
+ * Blocks larger than a quarter of the buffer size get a buffer of their own.
+ * Therefore the rest of the current buffer is not lost.
+ *
+ * <code>reset()</code> frees all blocks at once. The buffers are kept
+ * and will be reused by the following allocations.
  */
 
 /**
@@ -45,54 +51,123 @@
 ReByteStorage::ReByteStorage(int bufferSize) :
    m_bufferSize(bufferSize),
    m_buffer(NULL),
+   m_lastBuffer(NULL),
+   m_freeBuffers(NULL),
+   m_largeBuffers(NULL),
    m_rest(0),
    m_freePosition(NULL),
    m_summarySize(0),
-   m_buffers(0) {
+   m_buffers(0),
+   m_wasted(0),
+   m_allocated(0) {
 }
 
 /**
  * @brief Destructor.
  */
 ReByteStorage::~ReByteStorage() {
-   const uint8_t* ptr = m_buffer;
-   while (ptr != NULL) {
-      const uint8_t* old = ptr;
-      ptr = *(const uint8_t**) (ptr);
-      delete[] old;
-      m_buffers--;
-   }
-   assert(m_buffers == 0);
+   freeChain(m_buffer);
+   freeChain(m_freeBuffers);
+   freeChain(m_largeBuffers);
 }
 
 /**
  * @brief Allocates a block in a new allocated buffer.
  *
  * This method will be called if the buffer has too little space.
- * A new buffer will be allocated and the block will be allocated
- * in this new block.
- *
- * @note The block address is returned, but the allocation must be done outside!
+ * Large blocks get a buffer of their own, the current buffer remains.
+ * Otherwise a new buffer (or a buffer released by <code>reset()</code>)
+ * becomes the current buffer and the block is allocated in it.
  *
  * @param   size of the new block (inclusive the trailing '\0')
  * @return  a new block with the <code>size</code> bytes
  */
 char* ReByteStorage::allocBuffer(int size) {
-   m_rest =
-      size + sizeof(uint8_t*) <= (size_t) m_bufferSize ?
-      m_bufferSize : size + sizeof(uint8_t*);
-   m_summarySize += m_rest;
-   m_buffers++;
-   uint8_t* rc = new uint8_t[m_rest];
+   uint8_t* rc;
+   if (size > m_bufferSize / 4
+         || size + sizeof(uint8_t*) > (size_t) m_bufferSize) {
+      int length = size + sizeof(uint8_t*);
+      rc = new uint8_t[length];
+      m_summarySize += length;
+      m_buffers++;
+      *(uint8_t**) rc = m_largeBuffers;
+      m_largeBuffers = rc;
+      m_allocated += size;
+      return reinterpret_cast<char*>(rc + sizeof(uint8_t*));
+   }
+   if (m_buffer != NULL) {
+      m_wasted += m_rest;
+      m_allocated += m_freePosition - m_buffer - sizeof(uint8_t*);
+   }
+   if (m_freeBuffers != NULL) {
+      rc = m_freeBuffers;
+      m_freeBuffers = *(uint8_t**) rc;
+   } else {
+      rc = new uint8_t[m_bufferSize];
+      m_summarySize += m_bufferSize;
+      m_buffers++;
+   }
    *(uint8_t**) rc = m_buffer;
+   if (m_buffer == NULL)
+      m_lastBuffer = rc;
    m_buffer = rc;
    rc += sizeof(uint8_t*);
-   // the block allocation will be done outside!
-   m_freePosition = rc;
-   m_rest -= sizeof(uint8_t*);
+   m_freePosition = rc + size;
+   m_rest = m_bufferSize - sizeof(uint8_t*) - size;
    return reinterpret_cast<char*>(rc);
 }
 
+/**
+ * @brief Frees a chain of buffers.
+ *
+ * @param buffer    NULL or the first buffer of the chain
+ */
+void ReByteStorage::freeChain(uint8_t* buffer) {
+   while (buffer != NULL) {
+      uint8_t* old = buffer;
+      buffer = *(uint8_t**) (buffer);
+      delete[] old;
+   }
+}
+
+/**
+ * @brief Frees all blocks.
+ *
+ * The buffers are not freed but reused by the following allocations.
+ * Only the buffers of large blocks are returned to the system.
+ *
+ * @note All blocks allocated before are invalid after this call!
+ */
+void ReByteStorage::reset() {
+   if (m_buffer != NULL) {
+      *(uint8_t**) m_lastBuffer = m_freeBuffers;
+      m_freeBuffers = m_buffer;
+      m_buffer = m_lastBuffer = NULL;
+   }
+   for (uint8_t* ptr = m_largeBuffers; ptr != NULL; ptr = *(uint8_t**) ptr)
+      m_buffers--;
+   freeChain(m_largeBuffers);
+   m_largeBuffers = NULL;
+   m_summarySize = int64_t(m_buffers) * m_bufferSize;
+   m_rest = 0;
+   m_freePosition = NULL;
+   m_wasted = m_allocated = 0;
+}
+
+/**
+ * @brief Returns the allocation statistics.
+ *
+ * @param statistics    OUT: the statistics (m_recycled is not set)
+ */
+void ReByteStorage::statistics(ReAllocStatistics_t& statistics) const {
+   statistics.m_allocated = m_allocated;
+   if (m_buffer != NULL)
+      statistics.m_allocated += m_freePosition - m_buffer - sizeof(uint8_t*);
+   statistics.m_reserved = m_summarySize;
+   statistics.m_wasted = m_wasted;
+   statistics.m_buffers = m_buffers;
+}
+
 /**
  * @brief Duplicates a string into a new allocated block.
  *
@@ -131,12 +206,7 @@ const char* ReByteStorage::allocUtf8(const ReString& source) {
  * @return  a byte block (without a trailing '\0')
  */
 uint8_t* ReByteStorage::allocateBytes(int size) {
-   uint8_t* rc =
-      size <= m_rest ?
-      m_freePosition : reinterpret_cast<uint8_t*>(allocBuffer(size));
-   m_freePosition += size;
-   m_rest -= size;
-   return rc;
+   return reinterpret_cast<uint8_t*>(allocateChars(size));
 }
 
 /**
@@ -12,6 +12,22 @@
 #ifndef RECHARSTORAGE_HPP
 #define RECHARSTORAGE_HPP
 
+/**
+ * Statistics of an allocator.
+ */
+typedef struct {
+   /// the bytes handed out by the allocator
+   int64_t m_allocated;
+   /// the bytes of all buffers (inclusive management data)
+   int64_t m_reserved;
+   /// the bytes lost at the end of the buffers
+   int64_t m_wasted;
+   /// the count of blocks served from a free list
+   int64_t m_recycled;
+   /// the count of buffers
+   int m_buffers;
+} ReAllocStatistics_t;
+
 class ReByteStorage {
 public:
    ReByteStorage(int blockSize);
@@ -24,7 +40,9 @@ public:
     * @return a new block
     */
    inline char* allocateChars(int size) {
-      char* rc = size <= m_rest ? (char*) m_freePosition : allocBuffer(size);
+      if (size > m_rest)
+         return allocBuffer(size);
+      char* rc = (char*) m_freePosition;
       m_freePosition += size;
       m_rest -= size;
       return rc;
@@ -34,13 +52,28 @@ public:
    uint8_t* allocateBytes(int size);
    uint8_t* allocateZeros(int size);
    uint8_t* allocateBytes(void* source, int size);
+   void reset();
+   void statistics(ReAllocStatistics_t& statistics) const;
+private:
+   static void freeChain(uint8_t* buffer);
 private:
    int m_bufferSize;
+   // the current buffer, linked to the older buffers:
    uint8_t* m_buffer;
+   // the oldest buffer of the chain m_buffer:
+   uint8_t* m_lastBuffer;
+   // buffers released by reset(), reused by allocBuffer():
+   uint8_t* m_freeBuffers;
+   // buffers containing only one (large) block:
+   uint8_t* m_largeBuffers;
    int m_rest;
    uint8_t* m_freePosition;
    int64_t m_summarySize;
    int m_buffers;
+   // bytes lost at the end of the buffers:
+   int64_t m_wasted;
+   // bytes handed out since the last reset():
+   int64_t m_allocated;
 };
 
 #endif // RECHARSTORAGE_HPP
@@ -34,12 +34,39 @@ ReKeyCharPtr::ReKeyCharPtr(const char* ptr) :
    m_ptr(ptr) {
 }
 
+/**
+ * @brief Calculates the hash value of a key (FNV-1a).
+ *
+ * @param key   the key
+ * @return      the hash value
+ */
+uint32_t ReKeyCharPtr::hash(const char* key) {
+   uint32_t rc = 2166136261U;
+   uint8_t cc;
+   while ((cc = (uint8_t) * key++) != '\0') {
+      rc ^= cc;
+      rc *= 16777619U;
+   }
+   // the lowest 7 bits are stored in the control bytes: mix the high bits in
+   return rc ^ (rc >> 15);
+}
+
 /** @class ReCharPtrMap ReCharPtrMap.hpp "base/ReCharPtrMap.hpp"
  *
  * @brief A template for a map using const char* as keys.
  *
  * The value type is dynamic (a parameter type of the template).
  *
+ * The map is a hash table with open addressing: the entries are stored in
+ * one array, a second array contains one control byte per entry.
+ * The control bytes of 8 neighboured entries are tested with one 64 bit
+ * operation. The full hash value is stored in the entry: <code>strcmp()</code>
+ * is called only if the hash values are equal.
+ *
+ * The interface is compatible with the used part of <code>QMap</code>, but
+ * the iteration order is not sorted. Use <code>sortedKeys()</code> for an
+ * ordered iteration.
+ *
  * <b>Usage:</b>
  * <pre><code>
  * ReCharPtrMap<int> ids;
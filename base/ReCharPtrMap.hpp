@@ -16,6 +16,24 @@ class ReKeyCharPtr {
    friend bool operator <(ReKeyCharPtr const& op1, ReKeyCharPtr const& op2);
 public:
    ReKeyCharPtr(const char* ptr);
+public:
+   static uint32_t hash(const char* key);
+   /** Returns the position of the first set high bit in a control word.
+    * @param mask  a mask with bits only at 0x80 positions, not 0
+    * @return      the index of the byte (0..7)
+    */
+   inline static int firstByte(uint64_t mask) {
+#if defined __GNUC__
+      return __builtin_ctzll(mask) >> 3;
+#else
+      int rc = 0;
+      while ((mask & 0x80) == 0) {
+         mask >>= 8;
+         rc++;
+      }
+      return rc;
+#endif
+   }
 private:
    const char* m_ptr;
 };
@@ -31,8 +49,333 @@ inline bool operator <(ReKeyCharPtr const& op1, ReKeyCharPtr const& op2) {
    return rc;
 }
 
+/**
+ * A hash map with <code>const char*</code> keys (open addressing).
+ *
+ * The interface is a subset of <code>QMap</code>.
+ * The map stores only the key pointers, not the key contents.
+ */
 template<class ValueType>
-class ReCharPtrMap: public QMap<ReKeyCharPtr, ValueType> {
+class ReCharPtrMap {
+public:
+   enum {
+      /// count of slots tested by one probe
+      GROUP_WIDTH = 8,
+      /// control byte of a never used slot
+      CTRL_EMPTY = 0x80,
+      /// control byte of a removed entry
+      CTRL_DELETED = 0xfe
+   };
+   typedef struct {
+      const char* m_key;
+      uint32_t m_hash;
+      ValueType m_value;
+   } Entry;
+   /**
+    * Iterates over the entries. The order is not defined.
+    */
+   class iterator {
+      friend class ReCharPtrMap;
+   public:
+      iterator() :
+         m_map(NULL),
+         m_index(0) {
+      }
+      iterator(const ReCharPtrMap* map, int index) :
+         m_map(const_cast<ReCharPtrMap*>(map)),
+         m_index(index) {
+         skipFree();
+      }
+   public:
+      inline const char* key() const {
+         return m_map->m_entries[m_index].m_key;
+      }
+      inline ValueType& value() const {
+         return m_map->m_entries[m_index].m_value;
+      }
+      inline ValueType& operator *() const {
+         return value();
+      }
+      inline ValueType* operator ->() const {
+         return &value();
+      }
+      inline iterator& operator ++() {
+         m_index++;
+         skipFree();
+         return *this;
+      }
+      inline iterator operator ++(int) {
+         iterator rc = *this;
+         ++*this;
+         return rc;
+      }
+      inline bool operator ==(const iterator& other) const {
+         return m_index == other.m_index;
+      }
+      inline bool operator !=(const iterator& other) const {
+         return m_index != other.m_index;
+      }
+   private:
+      inline void skipFree() {
+         while (m_index < m_map->m_capacity
+                && (m_map->m_control[m_index] & 0x80) != 0)
+            m_index++;
+      }
+   private:
+      ReCharPtrMap* m_map;
+      int m_index;
+   };
+   typedef iterator const_iterator;
+public:
+   ReCharPtrMap() :
+      m_control(NULL),
+      m_entries(NULL),
+      m_capacity(0),
+      m_count(0),
+      m_deleted(0) {
+   }
+   ReCharPtrMap(const ReCharPtrMap& source) :
+      m_control(NULL),
+      m_entries(NULL),
+      m_capacity(0),
+      m_count(0),
+      m_deleted(0) {
+      operator =(source);
+   }
+   ~ReCharPtrMap() {
+      delete[] m_control;
+      delete[] m_entries;
+   }
+   ReCharPtrMap& operator =(const ReCharPtrMap& source) {
+      if (this != &source) {
+         clear();
+         for (iterator it = source.begin(); it != source.end(); ++it)
+            insert(it.key(), it.value());
+      }
+      return *this;
+   }
+public:
+   iterator begin() const {
+      return iterator(this, 0);
+   }
+   iterator end() const {
+      return iterator(this, m_capacity);
+   }
+   iterator constBegin() const {
+      return begin();
+   }
+   iterator constEnd() const {
+      return end();
+   }
+   void clear() {
+      delete[] m_control;
+      delete[] m_entries;
+      m_control = NULL;
+      m_entries = NULL;
+      m_capacity = m_count = m_deleted = 0;
+   }
+   bool contains(const char* key) const {
+      return indexOf(key, ReKeyCharPtr::hash(key)) >= 0;
+   }
+   bool contains(const QByteArray& key) const {
+      return contains(key.constData());
+   }
+   ValueType value(const QByteArray& key,
+                   const ValueType& defaultValue = ValueType()) const {
+      return value(key.constData(), defaultValue);
+   }
+   int count() const {
+      return m_count;
+   }
+   iterator find(const char* key) const {
+      int ix = indexOf(key, ReKeyCharPtr::hash(key));
+      return ix < 0 ? end() : iterator(this, ix);
+   }
+   iterator insert(const char* key, const ValueType& value) {
+      int ix = findOrInsert(key);
+      m_entries[ix].m_value = value;
+      return iterator(this, ix);
+   }
+   /** Inserts an entry. The hint is ignored (compatibility with QMap).
+    * @param hint  not used
+    * @param key   the key. Must live as long as the map
+    * @param value the value
+    * @return      an iterator pointing to the entry
+    */
+   iterator insert(const_iterator hint, const char* key,
+                   const ValueType& value) {
+      (void) hint;
+      return insert(key, value);
+   }
+   bool isEmpty() const {
+      return m_count == 0;
+   }
+   QList<const char*> keys() const {
+      QList<const char*> rc;
+      for (iterator it = begin(); it != end(); ++it)
+         rc.append(it.key());
+      return rc;
+   }
+   int remove(const char* key) {
+      int ix = indexOf(key, ReKeyCharPtr::hash(key));
+      if (ix < 0)
+         return 0;
+      m_control[ix] = CTRL_DELETED;
+      m_entries[ix].m_value = ValueType();
+      m_count--;
+      m_deleted++;
+      return 1;
+   }
+   int size() const {
+      return m_count;
+   }
+   /** Returns the keys sorted by <code>strcmp()</code>, like a QMap would
+    * iterate.
+    * @return  the sorted keys
+    */
+   QList<const char*> sortedKeys() const {
+      QList<const char*> rc = keys();
+      std::sort(rc.begin(), rc.end(), lessThan);
+      return rc;
+   }
+   ValueType value(const char* key,
+                   const ValueType& defaultValue = ValueType()) const {
+      int ix = indexOf(key, ReKeyCharPtr::hash(key));
+      return ix < 0 ? defaultValue : m_entries[ix].m_value;
+   }
+   QList<ValueType> values() const {
+      QList<ValueType> rc;
+      for (iterator it = begin(); it != end(); ++it)
+         rc.append(it.value());
+      return rc;
+   }
+   ValueType& operator [](const char* key) {
+      // findOrInsert() may reallocate m_entries:
+      int ix = findOrInsert(key);
+      return m_entries[ix].m_value;
+   }
+   const ValueType operator [](const char* key) const {
+      return value(key);
+   }
+private:
+   static bool lessThan(const char* key1, const char* key2) {
+      return strcmp(key1, key2) < 0;
+   }
+   /**
+    * Returns the slot of a key.
+    *
+    * The control bytes of a group are tested together (SWAR): a control byte
+    * contains the lowest 7 bits of the hash or a CTRL_... value.
+    *
+    * @param key   the key to search
+    * @param hash  the hash of the key
+    * @return      -1: not found<br>
+    *              otherwise: the index of the slot
+    */
+   int indexOf(const char* key, uint32_t hash) const {
+      if (m_count == 0)
+         return -1;
+      const uint64_t ones = 0x0101010101010101ULL;
+      const uint64_t highs = 0x8080808080808080ULL;
+      uint64_t pattern = ones * (hash & 0x7f);
+      int mask = m_capacity - 1;
+      int ix = (hash >> 7) & mask & ~(GROUP_WIDTH - 1);
+      for (int probe = 0; probe < m_capacity; probe += GROUP_WIDTH) {
+         uint64_t group;
+         memcpy(&group, m_control + ix, sizeof group);
+         uint64_t equal = group ^ pattern;
+         uint64_t matches = (equal - ones) & ~equal & highs;
+         while (matches != 0) {
+            int index = ix + ReKeyCharPtr::firstByte(matches);
+            const Entry& entry = m_entries[index];
+            if (entry.m_hash == hash && strcmp(entry.m_key, key) == 0)
+               return index;
+            matches &= matches - 1;
+         }
+         // an empty slot ends the search:
+         if ((group & ~(group << 6) & highs) != 0)
+            return -1;
+         ix = (ix + GROUP_WIDTH) & mask;
+      }
+      return -1;
+   }
+   /**
+    * Returns the slot of a key. If not found a new entry is created.
+    *
+    * @param key   the key to search
+    * @return      the index of the slot
+    */
+   int findOrInsert(const char* key) {
+      uint32_t hash = ReKeyCharPtr::hash(key);
+      int rc = indexOf(key, hash);
+      if (rc < 0) {
+         // load factor maximal 7/8:
+         if ((m_count + m_deleted + 1) * 8 > m_capacity * 7)
+            rehash(m_count * 2 + 2 > m_capacity / 2 ? m_capacity * 2 : m_capacity);
+         rc = freeSlot(hash);
+         if (m_control[rc] == CTRL_DELETED)
+            m_deleted--;
+         m_control[rc] = uint8_t(hash & 0x7f);
+         m_entries[rc].m_key = key;
+         m_entries[rc].m_hash = hash;
+         m_count++;
+      }
+      return rc;
+   }
+   /**
+    * Returns the first free slot for a hash.
+    *
+    * @param hash  the hash of the key
+    * @return      the index of an empty or deleted slot
+    */
+   int freeSlot(uint32_t hash) const {
+      const uint64_t highs = 0x8080808080808080ULL;
+      int mask = m_capacity - 1;
+      int ix = (hash >> 7) & mask & ~(GROUP_WIDTH - 1);
+      for (;;) {
+         uint64_t group;
+         memcpy(&group, m_control + ix, sizeof group);
+         uint64_t free = group & highs;
+         if (free != 0)
+            return ix + ReKeyCharPtr::firstByte(free);
+         ix = (ix + GROUP_WIDTH) & mask;
+      }
+   }
+   /**
+    * Builds the table with a new capacity.
+    *
+    * @param capacity  the new count of slots, a power of 2
+    */
+   void rehash(int capacity) {
+      if (capacity < 2 * GROUP_WIDTH)
+         capacity = 2 * GROUP_WIDTH;
+      uint8_t* oldControl = m_control;
+      Entry* oldEntries = m_entries;
+      int oldCapacity = m_capacity;
+      m_control = new uint8_t[capacity];
+      memset(m_control, CTRL_EMPTY, capacity);
+      m_entries = new Entry[capacity];
+      m_capacity = capacity;
+      m_deleted = 0;
+      for (int ix = 0; ix < oldCapacity; ix++) {
+         if ((oldControl[ix] & 0x80) == 0) {
+            Entry& entry = oldEntries[ix];
+            int slot = freeSlot(entry.m_hash);
+            m_control[slot] = oldControl[ix];
+            m_entries[slot] = entry;
+         }
+      }
+      delete[] oldControl;
+      delete[] oldEntries;
+   }
+private:
+   // a byte per slot: CTRL_EMPTY, CTRL_DELETED or the lowest 7 bits of the hash
+   uint8_t* m_control;
+   Entry* m_entries;
+   // count of slots: a power of 2
+   int m_capacity;
+   int m_count;
+   int m_deleted;
 };
 
 #endif // RECHARPTRMAP_HPP
@@ -44,6 +44,22 @@
  * </pre>
  * magic header: Rpl&1 length: 09h data length: 46h bag count: 2 item types: char int string
  *
+ * Version 2 (binary, created with <code>ReContainer(size, VERSION_2)</code>):
+ * container2 ::= "Rpl&2" bag_count type_count bag_types bag_size1 bag_size2 ... list_of_bags<br>
+ * bag_count, type_count, bag_sizeN: varints<br>
+ * integer ::= varint(zigzag(value))<br>
+ * string ::= varint(length) bytes '\0'<br>
+ * data ::= varint(length) bytes (bag type 'd' for all sizes)<br>
+ * A varint is stored in LEB128: 7 bits per byte, the lowest bits first,
+ * the highest bit is set if more bytes follow.
+ * The bag sizes allow <code>seekBag()</code> without reading the items.
+ * Strings and binary data can be read without copying (views into the
+ * container data).
+ *
+ * Both versions are sent via <code>ReTCPPeer::send()</code> as data.
+ * <code>fill()</code> recognizes the version by the magic, so the receiver
+ * can pass the data of <code>ReTCPPeer::receive()</code> unchanged
+ * (<code>QByteArray</code> is implicitly shared: no copy).
  */
 
 enum {
@@ -57,22 +73,48 @@ enum {
    LOC_NEXT_INT_1,
    LOC_NEXT_ITEM_3,
    LOC_NEXT_BAG_2,
+   LOC_FILL_4,
+   LOC_NEXT_VAR_INT_1, // 11010
+   LOC_SEEK_BAG_1,
+   LOC_NEXT_ITEM_4,
 };
 
 const char* ReContainer::MAGIC_1 = "Rpl&1";
+const char* ReContainer::MAGIC_2 = "Rpl&2";
+
+/**
+ * Appends an unsigned integer as varint (LEB128).
+ *
+ * @param data		IN/OUT: the buffer to extend
+ * @param value		the value to store
+ */
+static inline void appendVarInt(QByteArray& data, uint64_t value) {
+   char buffer[10];
+   int length = 0;
+   while (value >= 0x80) {
+      buffer[length++] = char(value | 0x80);
+      value >>= 7;
+   }
+   buffer[length++] = char(value);
+   data.append(buffer, length);
+}
 
 /**
  * @brief Constructor.
  *
  * @param sizeHint      Probable length of the container
+ * @param version       the format for building: VERSION_1 or VERSION_2
  */
-ReContainer::ReContainer(size_t sizeHint) :
+ReContainer::ReContainer(size_t sizeHint, int version) :
    m_data(""),
    m_countBags(0),
    m_typeList(""),
    m_ixItem(0),
    m_ixBag(0),
-   m_readPosition(NULL) {
+   m_readPosition(NULL),
+   m_version(version),
+   m_bagOffsets(),
+   m_payload(NULL) {
    if (sizeHint > 0)
       m_data.reserve(sizeHint);
 }
@@ -101,6 +143,8 @@ void ReContainer::addType(type_tag_t tag) {
 void ReContainer::startBag() {
    m_countBags++;
    m_ixBag = 0;
+   if (m_version >= VERSION_2)
+      m_bagOffsets.append(m_data.length());
 }
 /**
  * @brief Adds a character to the current bag.
@@ -119,6 +163,10 @@ void ReContainer::addChar(char value) {
  * @param value    value to add
  */
 void ReContainer::addInt(int value) {
+   if (m_version >= VERSION_2) {
+      addInt((int64_t) value);
+      return;
+   }
    addType(TAG_INT);
    char buffer[64];
    char* ptr = buffer;
@@ -136,6 +184,11 @@ void ReContainer::addInt(int value) {
  */
 void ReContainer::addInt(int64_t value) {
    addType(TAG_INT);
+   if (m_version >= VERSION_2) {
+      // zigzag: small negative numbers get short varints too
+      appendVarInt(m_data, (uint64_t(value) << 1) ^ uint64_t(value >> 63));
+      return;
+   }
    char buffer[128];
    qsnprintf(buffer, sizeof buffer, "%llx ", value);
    m_data.append(buffer);
@@ -148,8 +201,11 @@ void ReContainer::addInt(int64_t value) {
  */
 void ReContainer::addString(const char* value) {
    addType(TAG_STRING);
+   size_t length = strlen(value);
+   if (m_version >= VERSION_2)
+      appendVarInt(m_data, length);
    // store with trailing '\0'
-   m_data.append(value, strlen(value) + 1);
+   m_data.append(value, length + 1);
 }
 /**
  * @brief Adds binary data to the current bag.
@@ -158,9 +214,14 @@ void ReContainer::addString(const char* value) {
  * @param size      size of the binary data in bytes
  */
 void ReContainer::addData(uint8_t* value, size_t size) {
-   if (size <= 255) {
+   if (m_version >= VERSION_2) {
+      addType(TAG_DATA255);
+      appendVarInt(m_data, size);
+      m_data.append((const char*) value, size);
+   } else if (size <= 255) {
       addType(TAG_DATA255);
       m_data.append((char) size);
+      m_data.append((const char*) value, size);
    } else if (size <= 0xffff) {
       addType(TAG_DATA64K);
       m_data.append((char) (size / 256));
@@ -174,7 +235,6 @@ void ReContainer::addData(uint8_t* value, size_t size) {
       m_data.append((char) (size % 256));
       m_data.append((const char*) value, size);
    }
-   addType(TAG_DATA255);
 }
 
 /**
@@ -183,7 +243,18 @@ void ReContainer::addData(uint8_t* value, size_t size) {
  * @return the container as a byte array
  */
 const QByteArray& ReContainer::getData() {
-   if (m_typeList.length() != 0) {
+   if (m_typeList.length() != 0 && m_version >= VERSION_2) {
+      QByteArray header(MAGIC_2);
+      header.reserve(16 + m_typeList.length() + 3 * m_countBags);
+      appendVarInt(header, m_countBags);
+      appendVarInt(header, m_typeList.length());
+      header.append(m_typeList);
+      for (int ix = 0; ix < m_countBags; ix++) {
+         int end = ix + 1 < m_countBags ? m_bagOffsets.at(ix + 1) : m_data.length();
+         appendVarInt(header, end - m_bagOffsets.at(ix));
+      }
+      m_data.insert(0, header);
+   } else if (m_typeList.length() != 0) {
       char buffer[128];
       // RPL&1 0a b5[2]cis: !12
       qsnprintf(buffer, sizeof buffer, "%x[%d]%s:",
@@ -203,7 +274,12 @@ const QByteArray& ReContainer::getData() {
  */
 void ReContainer::fill(const QByteArray& data) {
    m_data = data;
-   const char* ptr = m_data.data();
+   const char* ptr = m_data.constData();
+   if (strncmp(ptr, MAGIC_2, strlen(MAGIC_2)) == 0) {
+      fill2();
+      return;
+   }
+   m_version = VERSION_1;
    if (strncmp(ptr, MAGIC_1, strlen(MAGIC_1)) != 0)
       throw RplInvalidDataException(LOG_ERROR, LOC_FILL_1,
                                     "container has no magic", data.data(), data.length());
@@ -228,8 +304,56 @@ void ReContainer::fill(const QByteArray& data) {
    m_typeList.clear();
    m_typeList.append(ptr, end - ptr);
    m_ixBag = -1;
+   m_ixItem = 0;
    m_readPosition = (uint8_t*) end + 1;
 }
+
+/**
+ * @brief Reads the header of a container with the format VERSION_2.
+ *
+ * The bag offsets are computed here, so <code>seekBag()</code> needs no
+ * parsing of the items.
+ */
+void ReContainer::fill2() {
+   m_version = VERSION_2;
+   m_readPosition = (const uint8_t*) m_data.constData() + strlen(MAGIC_2);
+   const uint8_t* end = (const uint8_t*) m_data.constData() + m_data.length();
+   // the values are untrusted: they are tested before they are used.
+   // each bag needs at least one byte for its size:
+   uint64_t countBags = nextVarInt();
+   if (countBags > uint64_t(end - m_readPosition))
+      throw RplInvalidDataException(LOG_ERROR, LOC_FILL_4,
+                                    "container has an invalid bag count", m_readPosition, 16);
+   m_countBags = (int) countBags;
+   uint64_t typeLength = nextVarInt();
+   if (typeLength > uint64_t(end - m_readPosition)
+         || strspn((const char*) m_readPosition, "cisd!") < typeLength)
+      throw RplInvalidDataException(LOG_ERROR, LOC_FILL_4,
+                                    "container has no valid typelist", m_readPosition, 16);
+   m_typeList.clear();
+   m_typeList.append((const char*) m_readPosition, (int) typeLength);
+   m_readPosition += typeLength;
+   m_bagOffsets.resize(m_countBags);
+   // the sizes are limited by the data size: the sum can not overflow
+   int64_t offset = 0;
+   for (int ix = 0; ix < m_countBags; ix++) {
+      m_bagOffsets[ix] = (int) offset;
+      uint64_t size = nextVarInt();
+      if (size > uint64_t(end - m_readPosition))
+         throw RplInvalidDataException(LOG_ERROR, LOC_FILL_4,
+                                       "container has an invalid bag size", m_readPosition, 16);
+      offset += size;
+      if (offset > end - m_readPosition)
+         throw RplInvalidDataException(LOG_ERROR, LOC_FILL_4,
+                                       "container too small", m_readPosition, 16);
+   }
+   m_payload = m_readPosition;
+   if (offset > end - m_payload)
+      throw RplInvalidDataException(LOG_ERROR, LOC_FILL_4,
+                                    "container too small", m_payload, 16);
+   m_ixBag = -1;
+   m_ixItem = 0;
+}
 /**
  * @brief Returns the number of bags in the container.
  *
@@ -242,7 +366,8 @@ int ReContainer::getCountBags() const {
  * @brief Sets the begin of the new bag.
  */
 void ReContainer::nextBag() {
-   if (m_ixItem < m_typeList.length() && m_ixItem != -1)
+   if (m_version < VERSION_2 && m_ixItem < m_typeList.length()
+         && m_ixItem != -1)
       throw ReException(LOG_ERROR, LOC_NEXT_BAG_1, NULL,
                         "end of bag not reached: remaining items: %s",
                         m_typeList.data() + m_ixItem);
@@ -251,6 +376,25 @@ void ReContainer::nextBag() {
    if (m_ixBag >= m_countBags)
       throw ReException(LOG_ERROR, LOC_NEXT_BAG_2, NULL, "no more bags: %d",
                         m_ixBag);
+   if (m_version >= VERSION_2)
+      m_readPosition = m_payload + m_bagOffsets.at(m_ixBag);
+}
+
+/**
+ * @brief Sets the read position to the begin of a given bag.
+ *
+ * Only available for containers with the format VERSION_2.
+ *
+ * @param ixBag     the index of the bag (0..getCountBags()-1)
+ */
+void ReContainer::seekBag(int ixBag) {
+   if (m_version < VERSION_2 || ixBag < 0 || ixBag >= m_countBags)
+      throw ReException(LOG_ERROR, LOC_SEEK_BAG_1, NULL,
+                        "cannot seek bag %d of %d (version %d)", ixBag, m_countBags,
+                        m_version);
+   m_ixBag = ixBag;
+   m_ixItem = 0;
+   m_readPosition = m_payload + m_bagOffsets.at(ixBag);
 }
 /**
  * @brief Sets the next item.
@@ -261,6 +405,8 @@ void ReContainer::nextItem(type_tag_t expected) {
    if (m_ixBag < 0) {
       m_ixBag = 0;
       m_ixItem = 0;
+      if (m_version >= VERSION_2)
+         m_readPosition = m_payload;
    }
    if (m_ixItem >= m_typeList.length())
       throw ReException(LOG_ERROR, LOC_NEXT_ITEM_1, ReLogger::globalLogger(),
@@ -274,7 +420,7 @@ void ReContainer::nextItem(type_tag_t expected) {
                         "current item is a %c, not a %c", (char) m_typeList.at(m_ixItem),
                         (char) expected);
    m_ixItem++;
-   if (m_readPosition > (uint8_t*) (m_data.data() + m_data.length()))
+   if (m_readPosition >= (uint8_t*) (m_data.constData() + m_data.length()))
       throw ReException(LOG_ERROR, LOC_NEXT_ITEM_3, NULL,
                         "container size too small. Bag: %d of %d Item: %d of %d",
                         1 + m_ixBag, m_countBags, 1 + m_ixItem, m_typeList.length());
@@ -297,6 +443,8 @@ char ReContainer::nextChar() {
  * @return  the next integer from the container
  */
 int ReContainer::nextInt() {
+   if (m_version >= VERSION_2)
+      return (int) nextInt64();
    nextItem(TAG_INT);
    bool isNegativ = *m_readPosition == '-';
    if (isNegativ)
@@ -317,6 +465,10 @@ int ReContainer::nextInt() {
  */
 int64_t ReContainer::nextInt64() {
    nextItem(TAG_INT);
+   if (m_version >= VERSION_2) {
+      uint64_t value = nextVarInt();
+      return int64_t(value >> 1) ^ -int64_t(value & 1);
+   }
    bool isNegativ = *m_readPosition == '-';
    if (isNegativ)
       m_readPosition++;
@@ -336,9 +488,33 @@ int64_t ReContainer::nextInt64() {
  * @return  the next '\0' delimited string from the container
  */
 const char* ReContainer::nextString() {
+   size_t length;
+   return nextString(length);
+}
+
+/**
+ * @brief Reads the next string from the current item in the current bag.
+ *
+ * No data will be copied: the result points into the container data.
+ *
+ * @param length    OUT: the length of the string
+ * @return          the next '\0' delimited string from the container
+ */
+const char* ReContainer::nextString(size_t& length) {
    nextItem(TAG_STRING);
+   uint64_t length2 = 0;
+   if (m_version >= VERSION_2)
+      length2 = nextVarInt();
    const char* rc = (const char*) m_readPosition;
-   m_readPosition += strlen(rc) + 1;
+   if (m_version < VERSION_2)
+      length2 = strlen(rc);
+   // the string and its trailing '\0' must be inside the data:
+   const char* end = m_data.constData() + m_data.length();
+   if (length2 >= uint64_t(end - rc) || rc[length2] != '\0')
+      throw ReException(LOG_ERROR, LOC_NEXT_ITEM_4, NULL,
+                        "string item too large: %lld", (long long) length2);
+   length = (size_t) length2;
+   m_readPosition += length + 1;
    return rc;
 }
 
@@ -351,10 +527,29 @@ const char* ReContainer::nextString() {
  * @return          the size of the read data
  */
 size_t ReContainer::nextData(QByteArray& data, bool append) {
+   size_t length = 0;
+   const uint8_t* content = nextData(length);
+   if (!append)
+      data.clear();
+   data.append((const char*) content, length);
+   return length;
+}
+
+/**
+ * @brief Reads the next binary data from the current item in the current bag.
+ *
+ * No data will be copied: the result points into the container data.
+ *
+ * @param length    OUT: the size of the read data
+ * @return          the begin of the data
+ */
+const uint8_t* ReContainer::nextData(size_t& length) {
    nextItem(TAG_DATA255);
    type_tag_t tag = (type_tag_t) m_typeList.at(m_ixItem - 1);
-   size_t length = 0;
-   switch (tag) {
+   length = 0;
+   if (m_version >= VERSION_2)
+      length = nextVarInt();
+   else switch (tag) {
    case TAG_DATA4G:
       for (int ix = 3; ix >= 0; ix--) {
          length = 256 * length + m_readPosition[ix];
@@ -371,11 +566,34 @@ size_t ReContainer::nextData(QByteArray& data, bool append) {
    default:
       break;
    }
-   if (!append)
-      data.clear();
-   data.append((const char*) m_readPosition, length);
+   const uint8_t* rc = m_readPosition;
+   if (length > size_t((const uint8_t*) m_data.constData() + m_data.length()
+                       - rc))
+      throw ReException(LOG_ERROR, LOC_NEXT_ITEM_4, NULL,
+                        "data item too large: %d", (int) length);
    m_readPosition += length;
-   return length;
+   return rc;
+}
+
+/**
+ * @brief Reads a varint (LEB128) at the current read position.
+ *
+ * @return  the read value
+ */
+uint64_t ReContainer::nextVarInt() {
+   const uint8_t* end = (const uint8_t*) m_data.constData() + m_data.length();
+   uint64_t rc = 0;
+   int shift = 0;
+   uint8_t cc;
+   do {
+      if (m_readPosition >= end || shift > 63)
+         throw RplInvalidDataException(LOG_ERROR, LOC_NEXT_VAR_INT_1,
+                                       "invalid varint", m_readPosition - shift / 7, 10);
+      cc = *m_readPosition++;
+      rc |= uint64_t(cc & 0x7f) << shift;
+      shift += 7;
+   } while ((cc & 0x80) != 0);
+   return rc;
 }
 
 /**
@@ -15,6 +15,7 @@
 #ifndef RPLCORE_HPP
 #include <QByteArray>
 #include <QDataStream>
+#include <QVector>
 #endif
 class ReContainer {
 public:
@@ -28,9 +29,14 @@ public:
       TAG_DATA4G = 'X',   ///< binary data, up to 4 GiBytes long
       TAG_CONTAINER = '!' ///< a container (recursion)
    } type_tag_t;
+   enum {
+      VERSION_1 = 1,	///< text format: hex numbers, '\\0' terminated strings
+      VERSION_2			///< binary format: varints, length prefixes, bag index
+   };
    static const char* MAGIC_1;
+   static const char* MAGIC_2;
 public:
-   ReContainer(size_t sizeHint);
+   ReContainer(size_t sizeHint, int version = VERSION_1);
    virtual ~ReContainer();
 private:
    // No copy constructor: no implementation!
@@ -47,6 +53,12 @@ public:
    void addString(const char* value);
    void addData(uint8_t* value, size_t size);
    const QByteArray& getData();
+   /** Returns the format version of the container.
+    * @return	VERSION_1 or VERSION_2
+    */
+   inline int getVersion() const {
+      return m_version;
+   }
 
    // Getting data from the container:
    void fill(const QByteArray& data);
@@ -57,12 +69,17 @@ public:
    int nextInt();
    int64_t nextInt64();
    const char* nextString();
+   const char* nextString(size_t& length);
    size_t nextData(QByteArray& data, bool append = false);
+   const uint8_t* nextData(size_t& length);
+   void seekBag(int ixBag);
 
    QByteArray dump(const char* title, int maxBags, int maxStringLength = 80,
                    int maxBlobLength = 16, char separatorItems = '\n');
 private:
+   void fill2();
    void nextItem(type_tag_t expected);
+   uint64_t nextVarInt();
 private:
    // the complete data of the container
    QByteArray m_data;
@@ -79,6 +96,12 @@ private:
    int m_ixBag;
    // read position in m_data:
    const uint8_t* m_readPosition;
+   // VERSION_1 or VERSION_2
+   int m_version;
+   // VERSION_2: the offsets of the bags (relative to the payload start)
+   QVector<int> m_bagOffsets;
+   // VERSION_2: the start of the bags in m_data
+   const uint8_t* m_payload;
 };
 
 #endif // RECONTAINER_HPP
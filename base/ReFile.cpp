@@ -51,7 +51,9 @@ int memicmp(const void* str1, const void* str2, size_t length) {
  */
 ReLines::ReLines() :
    QStringList(),
-   m_empty() {
+   m_empty(),
+   m_revision(0),
+   m_changes() {
 }
 /**
  * Destructor.
@@ -82,11 +84,51 @@ bool ReUndoList::checkSummarySize(qint64 stringSize) {
    return stringSize + sizeStruct < m_maxUndoSize;
 }
 
+/**
+ * Registers a change of the lines.
+ *
+ * @param lineNo    the first changed line (0..N-1)
+ * @param oldCount  the number of lines before the change
+ * @param newCount  the number of lines replacing the <code>oldCount</code> lines
+ */
+void ReLines::changed(int lineNo, int oldCount, int newCount) {
+   // the views need only the recent history:
+   static const int MAX_CHANGES = 64;
+   if (m_changes.length() >= MAX_CHANGES)
+      m_changes.removeFirst();
+   ReLineChange change;
+   change.m_lineNo = lineNo;
+   change.m_oldCount = oldCount;
+   change.m_newCount = newCount;
+   m_changes.append(change);
+   m_revision++;
+}
+
+/**
+ * Returns the changes made after a given revision.
+ *
+ * @param revision  the revision known by the caller
+ * @param changes   OUT: the changes in chronological order
+ * @return          <code>true</code>: <code>changes</code> is complete<br>
+ *                  <code>false</code>: the history is too short: all lines
+ *                  must be treated as changed
+ */
+bool ReLines::changesSince(int revision, QList<ReLineChange>& changes) const {
+   changes.clear();
+   int count = m_revision - revision;
+   bool rc = count >= 0 && count <= m_changes.length();
+   if (rc)
+      changes = m_changes.mid(m_changes.length() - count);
+   return rc;
+}
+
 /**
  * Removes all lines.
  */
 void ReLines::clear() {
+   int count = length();
    QStringList::clear();
+   changed(0, count, 0);
 }
 
 /**
@@ -164,6 +206,8 @@ void ReLines::insertLines(int lineNo, const QString& text, bool withUndo) {
          storeInsertLines(lineNo, count);
       int start = 0;
       int end;
+      int oldCount = length();
+      int first = min(lineNo, oldCount);
       if (lineNo >= length()) {
          while ((end = text.indexOf('\n', start)) >= 0) {
             append(text.mid(start, end - start));
@@ -179,6 +223,7 @@ void ReLines::insertLines(int lineNo, const QString& text, bool withUndo) {
          if (start < text.length())
             insert(lineNo, text.mid(start));
       }
+      changed(first, 0, length() - oldCount);
    }
 }
 /**
@@ -204,6 +249,7 @@ void ReLines::insertPart(int lineNo, int col, const QString& text,
          replace(lineNo, current.left(col) + text + current.mid(col));
       else
          replace(lineNo, current.left(col) + text);
+      changed(lineNo, 1, 1);
    }
 }
 
@@ -259,6 +305,7 @@ bool ReLines::joinLines(int first) {
    if (first >= 0 && first < length() - 1) {
       replace(first, at(first) + at(first + 1));
       removeAt(first + 1);
+      changed(first, 2, 1);
       rc = true;
    }
    return rc;
@@ -302,6 +349,7 @@ bool ReLines::removePart(int lineNo, int col, int count, bool withUndo) {
             replace(lineNo, current.left(col));
          else
             replace(lineNo, current.left(col) + current.mid(col + count));
+         changed(lineNo, 1, 1);
       }
    }
    return rc;
@@ -325,8 +373,11 @@ void ReLines::removeLines(int start, int count, bool withUndo) {
          storeRemoveLines(start, count, *this);
       for (int ix = start + count - 1; ix >= start; ix--)
          removeAt(ix);
-      if (length() == 0)
+      changed(start, count, 0);
+      if (length() == 0) {
          append(m_empty);
+         changed(0, 0, 1);
+      }
    }
 }
 
@@ -359,6 +410,7 @@ void ReLines::splitLine(int lineNo, int col, bool withUndo) {
          x = current.left(col);
          replace(lineNo, current.left(col));
       }
+      changed(lineNo, 1, 2);
    }
 }
 /**
@@ -625,6 +677,7 @@ bool ReFile::read(const QString& filename) {
    bool rc = false;
    if (inputFile.open(QIODevice::ReadOnly)) {
       rc = true;
+      int oldCount = lineCount();
       m_filesize = inputFile.size();
       reserve(m_filesize / 80 * 11 / 10);
       QTextStream in(&inputFile);
@@ -642,6 +695,7 @@ bool ReFile::read(const QString& filename) {
          }
          append(QString::fromUtf8(line));
       }
+      changed(oldCount, 0, lineCount() - oldCount);
       if (countCR > lineCount() / 2)
          setEndOfLine("\r\n");
       else
@@ -59,16 +59,33 @@ protected:
    qint64 m_currentUndoSize;
 };
 
+/**
+ * Describes one change of a <code>ReLines</code> instance.
+ *
+ * The lines [m_lineNo, m_lineNo + m_oldCount) have been replaced by
+ * m_newCount lines.
+ */
+class ReLineChange {
+public:
+   int m_lineNo;
+   int m_oldCount;
+   int m_newCount;
+};
+
 /**
  * Manages a list of lines.
  *
  * The lines will be stored without line terminators, e.g. '\n'.
+ *
+ * Each change increments the revision. The last changes are stored, so a
+ * view (e.g. a paragraph cache) can update only the touched lines.
  */
 class ReLines: public ReUndoList, protected QStringList {
 public:
    ReLines();
    virtual ~ReLines();
 public:
+   bool changesSince(int revision, QList<ReLineChange>& changes) const;
    void clear();
    void insertLines(int lineNo, const QString& text, bool withUndo);
    void insertPart(int lineNo, int col, const QString& text, bool withUndo);
@@ -91,11 +108,29 @@ public:
    }
    virtual bool removePart(int lineNo, int pos, int count, bool withUndo);
    virtual void removeLines(int start, int count, bool withUndo);
+   /** Returns the number of changes since the creation of the instance.
+    * @return the current revision
+    */
+   inline int revision() const {
+      return m_revision;
+   }
+   /** Returns a copy of the lines.
+    *
+    * The copy is cheap (implicitly shared) and can be used in another thread.
+    * @return the current lines
+    */
+   inline QStringList snapshot() const {
+      return *this;
+   }
    void splitLine(int lineNo, int col, bool withUndo);
    virtual void undo(int& lineNo, int& col);
-
+protected:
+   void changed(int lineNo, int oldCount, int newCount);
 protected:
    QString m_empty;
+   int m_revision;
+   /// the last changes: m_changes.last() belongs to m_revision
+   QList<ReLineChange> m_changes;
 };
 
 class ReLineSource {
@@ -61,6 +61,7 @@ void ReLogger::destroyGlobalLogger() {
  * @param name		identifies the logger. Useful for ReLogger::findLogger()
  */
 ReAppender::ReAppender(const QByteArray& name) :
+   m_withRawArguments(false),
    m_name(name),
    m_level(LOG_INFO),
    m_autoDelete(false) {
@@ -71,6 +72,26 @@ ReAppender::ReAppender(const QByteArray& name) :
 ReAppender::~ReAppender() {
 }
 
+/**
+ * @brief Logs a message given as format and the unformatted arguments.
+ *
+ * This default implementation formats the message and calls <code>log()</code>.
+ * Appenders setting <code>m_withRawArguments</code> overwrite this method
+ * to store the arguments without formatting.
+ *
+ * @param level		the level of the location
+ * @param location	an unique identifier of the location
+ * @param format	the logging message with placeholders (like printf)
+ * @param args		the values of the placeholders
+ * @param logger    the calling logger
+ */
+void ReAppender::logArguments(ReLoggerLevel level, int location,
+                              const char* format, va_list& args, ReLogger* logger) {
+   char buffer[64000];
+   qvsnprintf(buffer, sizeof buffer, format, args);
+   log(level, location, buffer, logger);
+}
+
 /**
  * Returns the name.
  *
@@ -178,7 +199,7 @@ ReLogger::~ReLogger() {
  * @param level		the level to "convert"
  * @return 			the assigned prefix char
  */
-char ReLogger::getPrefixOfLevel(ReLoggerLevel level) const {
+char ReLogger::getPrefixOfLevel(ReLoggerLevel level) {
    char rc = ' ';
    switch (level) {
    case LOG_ERROR:
@@ -266,16 +287,18 @@ const QByteArray& ReLogger::getStdPrefix(ReLoggerLevel level, int location) {
  */
 bool ReLogger::log(ReLoggerLevel level, int location, const char* message) {
    m_stdPrefix = "";
-   bool first = true;
+   bool locked = false;
    for (size_t ix = 0; ix < m_countAppenders; ix++) {
       ReAppender* appender = m_appenders[ix];
       if (appender->isActive(level)) {
-         if (first && m_withLocking)
+         if (!locked && m_withLocking) {
             m_mutex.lock();
+            locked = true;
+         }
          appender->log(level, location, message, this);
       }
    }
-   if (!first && m_withLocking)
+   if (locked)
       m_mutex.unlock();
    return true;
 }
@@ -315,12 +338,11 @@ bool ReLogger::log(ReLoggerLevel level, int location, const ReString& message) {
  */
 bool ReLogger::logv(ReLoggerLevel level, int location, const char* format,
                     ...) {
-   char buffer[64000];
    va_list ap;
    va_start(ap, format);
-   qvsnprintf(buffer, sizeof buffer, format, ap);
+   log(level, location, format, ap);
    va_end(ap);
-   return log(level, location, buffer);
+   return true;
 }
 
 /**
@@ -334,17 +356,20 @@ bool ReLogger::logv(ReLoggerLevel level, int location, const char* format,
  */
 bool ReLogger::logv(ReLoggerLevel level, int location, const QByteArray& format,
                     ...) {
-   char buffer[64000];
    va_list ap;
    va_start(ap, format);
-   qvsnprintf(buffer, sizeof buffer, format, ap);
+   log(level, location, format.constData(), ap);
    va_end(ap);
-   return log(level, location, buffer);
+   return true;
 }
 
 /**
  * @brief Logs (or not) the calling location.
  *
+ * The message will be formatted only if at least one active appender
+ * needs the text. Appenders with raw arguments (e.g.
+ * <code>ReBinaryFileAppender</code>) get the format and the arguments.
+ *
  * @param level		the level of the location
  * @param location	an unique identifier of the location
  * @param format	the logging message with placeholders (like printf).
@@ -353,9 +378,38 @@ bool ReLogger::logv(ReLoggerLevel level, int location, const QByteArray& format,
  */
 bool ReLogger::log(ReLoggerLevel level, int location, const char* format,
                    va_list& varlist) {
-   char buffer[64000];
-   qvsnprintf(buffer, sizeof buffer, format, varlist);
-   return log(level, location, buffer);
+   m_stdPrefix = "";
+   bool locked = false;
+   bool needsText = false;
+   for (size_t ix = 0; ix < m_countAppenders; ix++) {
+      ReAppender* appender = m_appenders[ix];
+      if (appender->isActive(level)) {
+         if (!locked && m_withLocking) {
+            m_mutex.lock();
+            locked = true;
+         }
+         if (!appender->withRawArguments())
+            needsText = true;
+         else {
+            va_list args;
+            va_copy(args, varlist);
+            appender->logArguments(level, location, format, args, this);
+            va_end(args);
+         }
+      }
+   }
+   if (needsText) {
+      char buffer[64000];
+      qvsnprintf(buffer, sizeof buffer, format, varlist);
+      for (size_t ix = 0; ix < m_countAppenders; ix++) {
+         ReAppender* appender = m_appenders[ix];
+         if (appender->isActive(level) && !appender->withRawArguments())
+            appender->log(level, location, buffer, this);
+      }
+   }
+   if (locked)
+      m_mutex.unlock();
+   return true;
 }
 
 /**
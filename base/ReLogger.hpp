@@ -62,13 +62,24 @@ private:
 public:
    virtual void log(ReLoggerLevel level, int location, const char* message,
                     ReLogger* logger) = 0;
+   virtual void logArguments(ReLoggerLevel level, int location,
+                             const char* format, va_list& args, ReLogger* logger);
    bool isActive(ReLoggerLevel level);
    void setLevel(ReLoggerLevel level);
    void setAutoDelete(bool onNotOff);
    bool isAutoDelete() const;
    ReLoggerLevel getLevel() const;
    const char* getName() const;
-
+   /** Returns whether the appender takes the unformatted arguments.
+    * @return	<code>true</code>: <code>logArguments()</code> will be called
+    *			instead of <code>log()</code> for messages with placeholders
+    */
+   inline bool withRawArguments() const {
+      return m_withRawArguments;
+   }
+protected:
+   // true: the appender stores the unformatted arguments (see logArguments())
+   bool m_withRawArguments;
 private:
    // Name of the appender. Used to find the appender in a list of appenders
    QByteArray m_name;
@@ -104,7 +115,7 @@ public:
                               int maxSize = 10 * 1024 * 1024, int maxCount = 5);
    QByteArray buildStdPrefix(ReLoggerLevel level, int location);
    const QByteArray& getStdPrefix(ReLoggerLevel level, int location);
-   char getPrefixOfLevel(ReLoggerLevel level) const;
+   static char getPrefixOfLevel(ReLoggerLevel level);
    bool isActive(ReLoggerLevel level) const;
    void setLevel(ReLoggerLevel level);
    void setWithLocking(bool onNotOff);
@@ -19,6 +19,7 @@
  * @brief Efficient pattern matching.
  */
 #include "base/rebase.hpp"
+#include <QVarLengthArray>
 
 QStringList* ReListMatcher::m_allMatchingList = NULL;
 ReListMatcher* ReListMatcher::m_allMatcher = NULL;
@@ -156,6 +157,358 @@ void ReMatcher::setCaseSensivitiy(const Qt::CaseSensitivity& caseSensivitiy) {
    m_caseSensivitiy = caseSensivitiy;
 }
 
+/** @class RePatternAutomaton ReMatcher.hpp "base/ReMatcher.hpp"
+ *
+ * @brief A pattern list compiled for fast matching.
+ *
+ * The patterns are divided into groups:
+ * <ul><li>patterns without wildcards (anchored): found by a hash lookup</li>
+ * <li>"*.ext" (anchored): the extension of the text is found by a hash lookup</li>
+ * <li>patterns with one literal part (e.g. "abc" not anchored):
+ * recognized by an Aho-Corasick automaton</li>
+ * <li>all other patterns: the longest literal part is recognized by the
+ * automaton, only then the whole pattern is verified</li>
+ * </ul>
+ * The case folding of the patterns is done once at compile time.
+ * Therefore the text must be folded too: for ASCII texts this is done
+ * without <code>QString</code> conversion.
+ */
+
+/**
+ * Constructor.
+ */
+RePatternAutomaton::RePatternAutomaton() :
+   m_anchored(false),
+   m_caseSensitive(true),
+   m_allMatching(false),
+   m_empty(true),
+   m_literals(),
+   m_extensions(),
+   m_complexPatterns(),
+   m_complexKeys(),
+   m_finalKeywords(),
+   m_countClasses(0),
+   m_transitions(),
+   m_outputs() {
+   memset(m_classOf, 0, sizeof m_classOf);
+}
+
+/**
+ * Stores a keyword for the automaton.
+ *
+ * @param keyword	the keyword to store
+ * @param isFinal	<code>true</code>: if the keyword is found the text matches
+ * @param keywords	IN/OUT: the known keywords: keyword -> index
+ * @return			the index of the keyword
+ */
+int RePatternAutomaton::addKeyword(const QByteArray& keyword, bool isFinal,
+                                   QMap<QByteArray, int>& keywords) {
+   int rc;
+   if (keywords.contains(keyword))
+      rc = keywords.value(keyword);
+   else {
+      rc = keywords.size();
+      keywords.insert(keyword, rc);
+      m_finalKeywords.append(false);
+   }
+   if (isFinal)
+      m_finalKeywords[rc] = true;
+   return rc;
+}
+
+/**
+ * Builds the transition table of the Aho-Corasick automaton.
+ *
+ * Only bytes used in keywords get their own character class: this keeps
+ * the table small.
+ *
+ * @param keywords	the keywords to recognize, ordered by their index
+ */
+void RePatternAutomaton::buildTransitions(const QList<QByteArray>& keywords) {
+   memset(m_classOf, 0, sizeof m_classOf);
+   m_countClasses = 1;
+   QList<QByteArray>::const_iterator it;
+   for (it = keywords.cbegin(); it != keywords.cend(); ++it) {
+      for (int ix = 0; ix < it->length(); ix++) {
+         uint8_t cc = (uint8_t) it->at(ix);
+         if (m_classOf[cc] == 0)
+            m_classOf[cc] = m_countClasses++;
+      }
+   }
+   int classes = m_countClasses;
+   m_transitions.fill(-1, classes);
+   m_outputs.resize(1);
+   // the trie:
+   for (int keyword = 0; keyword < keywords.size(); keyword++) {
+      const QByteArray& current = keywords.at(keyword);
+      int state = 0;
+      for (int ix = 0; ix < current.length(); ix++) {
+         int cls = m_classOf[(uint8_t) current.at(ix)];
+         int next = m_transitions[state * classes + cls];
+         if (next < 0) {
+            next = m_outputs.size();
+            m_outputs.resize(next + 1);
+            m_transitions.resize((next + 1) * classes);
+            for (int ix2 = next * classes; ix2 < (next + 1) * classes; ix2++)
+               m_transitions[ix2] = -1;
+            m_transitions[state * classes + cls] = next;
+         }
+         state = next;
+      }
+      m_outputs[state].append(keyword);
+   }
+   // failure links (breadth first), completed to a deterministic automaton:
+   QVector<int> fail(m_outputs.size(), 0);
+   QVector<int> queue;
+   for (int cls = 0; cls < classes; cls++) {
+      int state = m_transitions[cls];
+      if (state < 0)
+         m_transitions[cls] = 0;
+      else
+         queue.append(state);
+   }
+   for (int head = 0; head < queue.size(); head++) {
+      int state = queue.at(head);
+      for (int cls = 0; cls < classes; cls++) {
+         int next = m_transitions[state * classes + cls];
+         int fallback = m_transitions[fail[state] * classes + cls];
+         if (next < 0)
+            m_transitions[state * classes + cls] = fallback;
+         else {
+            queue.append(next);
+            fail[next] = fallback;
+            m_outputs[next] += m_outputs[fallback];
+         }
+      }
+   }
+}
+
+/**
+ * Compiles a pattern list.
+ *
+ * @param patterns			a list of patterns with wildcards '*' (any string)
+ * @param caseSensivity		caseSensitive or caseInsensitive
+ * @param anchored			<code>true</code>: the pattern starts at the strings
+ *							start<br>
+ *							<code>false</code>: the pattern can start anywhere in
+ *							the string
+ */
+void RePatternAutomaton::compile(const QStringList& patterns,
+                                 Qt::CaseSensitivity caseSensivity, bool anchored) {
+   m_anchored = anchored;
+   m_caseSensitive = caseSensivity == Qt::CaseSensitive;
+   m_allMatching = false;
+   m_empty = patterns.isEmpty();
+   m_literals.clear();
+   m_extensions.clear();
+   m_complexPatterns.clear();
+   m_complexKeys.clear();
+   m_finalKeywords.clear();
+   m_transitions.clear();
+   m_outputs.clear();
+   m_countClasses = 0;
+   QMap<QByteArray, int> keywords;
+   QStringList::const_iterator it;
+   for (it = patterns.cbegin(); !m_allMatching && it != patterns.cend(); ++it) {
+      QByteArray pattern = (m_caseSensitive ? *it : it->toLower()).toUtf8();
+      QList<QByteArray> needles = pattern.split('*');
+      // Eliminate empty entries but not first and last:
+      for (int ix = needles.size() - 2; ix > 0; ix--) {
+         if (needles.at(ix).isEmpty())
+            needles.removeAt(ix);
+      }
+      int longest = 0;
+      int countNonEmpty = 0;
+      for (int ix = 0; ix < needles.size(); ix++) {
+         int length = needles.at(ix).length();
+         if (length > 0)
+            countNonEmpty++;
+         if (length > needles.at(longest).length())
+            longest = ix;
+      }
+      const QByteArray& last = needles.last();
+      if (countNonEmpty == 0)
+         m_allMatching = true;
+      else if (anchored && needles.size() == 1)
+         m_literals.insert(pattern);
+      else if (anchored && needles.size() == 2 && needles.at(0).isEmpty()
+               && last.startsWith('.') && last.indexOf('.', 1) < 0)
+         m_extensions.insert(last);
+      else if (countNonEmpty == 1
+               && (!anchored || (needles.at(0).isEmpty() && last.isEmpty())))
+         addKeyword(needles.at(longest), true, keywords);
+      else {
+         m_complexKeys.append(addKeyword(needles.at(longest), false, keywords));
+         m_complexPatterns.append(needles);
+      }
+   }
+   if (!m_allMatching && keywords.size() > 0) {
+      QList<QByteArray> list;
+      for (int ix = 0; ix < keywords.size(); ix++)
+         list.append(QByteArray());
+      QMap<QByteArray, int>::const_iterator it2;
+      for (it2 = keywords.cbegin(); it2 != keywords.cend(); ++it2)
+         list[it2.value()] = it2.key();
+      buildTransitions(list);
+   }
+}
+
+/**
+ * Searches a byte sequence in a text.
+ *
+ * @param needle		the bytes to search
+ * @param needleLength	the length of <code>needle</code>
+ * @param text			the text to inspect
+ * @param start			the first index to inspect
+ * @param end			the index behind the last byte to inspect
+ * @return				-1: not found<br>
+ *						otherwise: the index of the needle in the text
+ */
+static int findBytes(const char* needle, int needleLength, const char* text,
+                     int start, int end) {
+   int rc = -1;
+   char first = needle[0];
+   int last = end - needleLength;
+   for (int ix = start; ix <= last; ix++) {
+      const char* ptr = (const char*) memchr(text + ix, first, last - ix + 1);
+      if (ptr == NULL)
+         break;
+      ix = ptr - text;
+      if (memcmp(ptr + 1, needle + 1, needleLength - 1) == 0) {
+         rc = ix;
+         break;
+      }
+   }
+   return rc;
+}
+
+/**
+ * Tests whether a text matches a pattern given as list of literal parts.
+ *
+ * @param needles	the parts of the pattern between the wildcards '*'
+ * @param anchored	<code>true</code>: the pattern must match the whole text
+ * @param text		the text to test (already folded)
+ * @param length	the length of <code>text</code>
+ * @return			<code>true</code>: the pattern matches
+ */
+bool RePatternAutomaton::globMatches(const QList<QByteArray>& needles,
+                                     bool anchored, const char* text, int length) {
+   bool rc = true;
+   int start = 0;
+   int end = length;
+   int first = 0;
+   int last = needles.size() - 1;
+   if (anchored) {
+      const QByteArray& head = needles.at(0);
+      const QByteArray& tail = needles.at(last);
+      if (last == 0)
+         rc = head.length() == length && memcmp(text, head.constData(),
+                                                length) == 0;
+      else
+         rc = head.length() + tail.length() <= length
+              && memcmp(text, head.constData(), head.length()) == 0
+              && memcmp(text + length - tail.length(), tail.constData(),
+                        tail.length()) == 0;
+      start = head.length();
+      end = length - tail.length();
+      first++;
+      last--;
+   }
+   for (int ix = first; rc && ix <= last; ix++) {
+      const QByteArray& needle = needles.at(ix);
+      if (needle.length() > 0) {
+         int pos = findBytes(needle.constData(), needle.length(), text, start,
+                             end);
+         if (pos < 0)
+            rc = false;
+         else
+            start = pos + needle.length();
+      }
+   }
+   return rc;
+}
+
+/**
+ * Tests whether a text matches at least one of the patterns.
+ *
+ * @param text		the text to test (UTF-8)
+ * @param length	the length of <code>text</code>. -1: <code>strlen(text)</code>
+ * @return			<code>true</code>: the pattern list is empty or one of
+ *					the patterns matches
+ */
+bool RePatternAutomaton::matches(const char* text, int length) const {
+   bool rc = m_empty || m_allMatching;
+   if (!rc) {
+      if (length < 0)
+         length = strlen(text);
+      if (m_caseSensitive)
+         rc = matchesFolded(text, length);
+      else {
+         QVarLengthArray<char, 512> buffer(length);
+         bool ascii = true;
+         for (int ix = 0; ascii && ix < length; ix++) {
+            char cc = text[ix];
+            if ((uint8_t) cc >= 0x80)
+               ascii = false;
+            buffer[ix] = cc >= 'A' && cc <= 'Z' ? cc + 'a' - 'A' : cc;
+         }
+         if (ascii)
+            rc = matchesFolded(buffer.constData(), length);
+         else {
+            QByteArray folded = QString::fromUtf8(text, length).toLower().toUtf8();
+            rc = matchesFolded(folded.constData(), folded.length());
+         }
+      }
+   }
+   return rc;
+}
+
+/**
+ * Tests whether a folded text matches at least one of the patterns.
+ *
+ * @param text		the text to test, already case folded if needed
+ * @param length	the length of <code>text</code>
+ * @return			<code>true</code>: one of the patterns matches
+ */
+bool RePatternAutomaton::matchesFolded(const char* text, int length) const {
+   bool rc = false;
+   if (m_literals.size() > 0)
+      rc = m_literals.contains(QByteArray::fromRawData(text, length));
+   if (!rc && m_extensions.size() > 0) {
+      int ix = length - 1;
+      while (ix >= 0 && text[ix] != '.')
+         ix--;
+      if (ix >= 0)
+         rc = m_extensions.contains(QByteArray::fromRawData(text + ix,
+                                    length - ix));
+   }
+   if (!rc && m_countClasses > 0) {
+      QVarLengthArray<bool, 64> found(m_finalKeywords.size());
+      if (m_complexPatterns.size() > 0)
+         memset(found.data(), 0, found.size() * sizeof(bool));
+      const int* transitions = m_transitions.constData();
+      int classes = m_countClasses;
+      int state = 0;
+      for (int ix = 0; !rc && ix < length; ix++) {
+         state = transitions[state * classes + m_classOf[(uint8_t) text[ix]]];
+         const QVector<int>& outputs = m_outputs.at(state);
+         for (int ix2 = 0; ix2 < outputs.size(); ix2++) {
+            int keyword = outputs.at(ix2);
+            if (m_finalKeywords.at(keyword)) {
+               rc = true;
+               break;
+            }
+            found[keyword] = true;
+         }
+      }
+      for (int ix = 0; !rc && ix < m_complexPatterns.size(); ix++) {
+         if (found[m_complexKeys.at(ix)])
+            rc = globMatches(m_complexPatterns.at(ix), m_anchored, text, length);
+      }
+   }
+   return rc;
+}
+
 /**
  * Constructor.
  *
@@ -169,7 +522,9 @@ void ReMatcher::setCaseSensivitiy(const Qt::CaseSensitivity& caseSensivitiy) {
 ReListMatcher::ReListMatcher(const QStringList& patterns,
                              Qt::CaseSensitivity caseSensivity, bool anchored) :
    m_patterns(patterns),
-   m_list(),
+   m_caseSensivity(caseSensivity),
+   m_anchored(anchored),
+   m_automaton(),
    m_empty(false),
    m_allMatching(false) {
    setPatterns(patterns, caseSensivity, anchored);
@@ -178,7 +533,6 @@ ReListMatcher::ReListMatcher(const QStringList& patterns,
  * Destructor.
  */
 ReListMatcher::~ReListMatcher() {
-   destroy();
 }
 
 /**
@@ -209,7 +563,7 @@ const QStringList& ReListMatcher::allMatchingList() {
  * @return	<code>true</code>: the character case is relevant
  */
 bool ReListMatcher::anchored() const {
-   return m_list.length() <= 0 ? true : m_list.at(0)->anchored();
+   return m_anchored;
 }
 
 /**
@@ -218,19 +572,7 @@ bool ReListMatcher::anchored() const {
  * @return	<code>true</code>: the character case is relevant
  */
 Qt::CaseSensitivity ReListMatcher::caseSensivitiy() const {
-   return m_list.length() <= 0 ? Qt::CaseSensitive
-          : m_list.at(0)->caseSensivitiy();
-}
-
-/**
- * Frees the resources.
- */
-void ReListMatcher::destroy() {
-   QList<ReMatcher*>::const_iterator it;
-   for (it = m_list.constBegin(); it != m_list.cend(); ++it) {
-      delete *it;
-   }
-   m_list.clear();
+   return m_caseSensivity;
 }
 
 /**
@@ -272,12 +614,21 @@ bool ReListMatcher::empty() const {
  *				<code>false</code>: none of the patterns matches
  */
 bool ReListMatcher::matches(const QString& text) const {
-   QList<ReMatcher*>::const_iterator it;
-   bool rc = m_list.size() == 0;
-   for (it = m_list.cbegin(); !rc && it != m_list.cend(); ++it) {
-      rc = (*it)->matches(text);
-   }
-   return rc;
+   QByteArray text2 = text.toUtf8();
+   return m_automaton.matches(text2.constData(), text2.length());
+}
+
+/**
+ * Tests whether at least one pattern of the list matches the given text
+ *
+ * @param text		text to test (UTF-8)
+ * @param length	the length of <code>text</code>. -1: <code>strlen(text)</code>
+ * @return			<code>true</code>: empty list or one of the stored patterns
+ *					matches the text<br>
+ *					<code>false</code>: none of the patterns matches
+ */
+bool ReListMatcher::matches(const char* text, int length) const {
+   return m_automaton.matches(text, length);
 }
 
 /**
@@ -287,10 +638,8 @@ bool ReListMatcher::matches(const QString& text) const {
  */
 void ReListMatcher::setCaseSensivitiy(
    const Qt::CaseSensitivity& caseSensivitiy) {
-   QList<ReMatcher*>::const_iterator it;
-   for (it = m_list.begin(); it != m_list.end(); ++it) {
-      (*it)->setCaseSensivitiy(caseSensivitiy);
-   }
+   m_caseSensivity = caseSensivitiy;
+   m_automaton.compile(m_patterns, caseSensivitiy, m_anchored);
 }
 
 /**
@@ -303,18 +652,12 @@ void ReListMatcher::setCaseSensivitiy(
  */
 void ReListMatcher::setPatterns(const QStringList& patterns,
                                 Qt::CaseSensitivity caseSensivity, bool anchored) {
-   destroy();
    m_patterns = patterns;
-   m_empty = true;
-   m_allMatching = false;
-   QStringList::const_iterator it;
-   for (it = patterns.constBegin(); it != patterns.cend(); ++it) {
-      ReMatcher* matcher = new ReMatcher(*it, caseSensivity, anchored);
-      m_list.append(matcher);
-      if (matcher->allMatching())
-         m_allMatching = true;
-      m_empty = false;
-   }
+   m_caseSensivity = caseSensivity;
+   m_anchored = anchored;
+   m_empty = patterns.isEmpty();
+   m_automaton.compile(patterns, caseSensivity, anchored);
+   m_allMatching = m_automaton.allMatching();
 }
 
 /**
@@ -409,6 +752,24 @@ bool ReIncludeExcludeMatcher::matches(const QString& text, bool excludeToo) cons
    return rc;
 }
 
+/**
+ * Tests whether a text matches the include patterns and does not match the
+ * exclude patterns.
+ *
+ * @param text			text to test (UTF-8)
+ * @param length		the length of <code>text</code>. -1: <code>strlen(text)</code>
+ * @param excludeToo	<code>true</code>: the exclude patterns will be tested
+ * @return				<code>true</code>: at least one of the include patterns
+ *						matches and none of the exclude patterns matches
+ */
+bool ReIncludeExcludeMatcher::matches(const char* text, int length,
+                                      bool excludeToo) const {
+   bool rc = m_includes.matches(text, length);
+   if (rc && excludeToo && !m_excludes.empty())
+      rc = !m_excludes.matches(text, length);
+   return rc;
+}
+
 /**
  * Sets the case sensitivity of the pattern matching.
  *
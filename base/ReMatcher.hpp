@@ -40,6 +40,57 @@ protected:
    bool m_allMatching;
 };
 
+/**
+ * A list of patterns compiled into hash sets and an Aho-Corasick automaton.
+ *
+ * The matching is done on (UTF-8) bytes.
+ */
+class RePatternAutomaton {
+public:
+   RePatternAutomaton();
+public:
+   /** Returns whether the automaton accepts all strings.
+    * @return	<code>true</code>: the automaton accepts all strings
+    */
+   inline bool allMatching() const {
+      return m_allMatching;
+   }
+   void compile(const QStringList& patterns, Qt::CaseSensitivity caseSensivity,
+                bool anchored);
+   bool matches(const char* text, int length = -1) const;
+protected:
+   int addKeyword(const QByteArray& keyword, bool isFinal,
+                  QMap<QByteArray, int>& keywords);
+   void buildTransitions(const QList<QByteArray>& keywords);
+   bool matchesFolded(const char* text, int length) const;
+public:
+   static bool globMatches(const QList<QByteArray>& needles, bool anchored,
+                           const char* text, int length);
+protected:
+   bool m_anchored;
+   bool m_caseSensitive;
+   bool m_allMatching;
+   // true: no pattern is given: all strings are accepted
+   bool m_empty;
+   // (folded) patterns without wildcards (only if anchored)
+   QSet<QByteArray> m_literals;
+   // extensions (with '.') of the patterns "*.ext" (only if anchored)
+   QSet<QByteArray> m_extensions;
+   // the needles of the patterns which must be verified by globMatches()
+   QList<QList<QByteArray> > m_complexPatterns;
+   // m_complexKeys[ix]: the keyword which must be found for m_complexPatterns[ix]
+   QVector<int> m_complexKeys;
+   // m_finalKeywords[ix]: true: if found the text matches
+   QVector<bool> m_finalKeywords;
+   // m_classOf[byte]: the character class of a byte in the automaton
+   uint16_t m_classOf[256];
+   int m_countClasses;
+   // the transitions of the automaton: m_countClasses entries per state
+   QVector<int> m_transitions;
+   // m_outputs[state]: the indexes of the keywords recognized in this state
+   QVector<QVector<int> > m_outputs;
+};
+
 /**
  * Processor for efficient test whether a text matches a list of patterns.
  */
@@ -54,6 +105,7 @@ public:
    Qt::CaseSensitivity caseSensivitiy() const;
    bool empty() const;
    bool matches(const QString& text) const;
+   bool matches(const char* text, int length = -1) const;
    const QStringList& patterns() const;
    void setCaseSensivitiy(const Qt::CaseSensitivity& caseSensivitiy);
    void setPatterns(const QStringList& patterns,
@@ -63,14 +115,14 @@ public:
    bool anchored() const;
    static const ReListMatcher& allMatcher();
    static const QStringList& allMatchingList();
-protected:
-   void destroy();
 private:
    static QStringList* m_allMatchingList;
    static ReListMatcher* m_allMatcher;
 protected:
    QStringList m_patterns;
-   QList<ReMatcher*> m_list;
+   Qt::CaseSensitivity m_caseSensivity;
+   bool m_anchored;
+   RePatternAutomaton m_automaton;
    bool m_empty;
    bool m_allMatching;
 };
@@ -90,6 +142,7 @@ public:
 public:
    Qt::CaseSensitivity caseSensivitiy() const;
    bool matches(const QString& text, bool excludeToo = true) const;
+   bool matches(const char* text, int length, bool excludeToo = true) const;
    const ReListMatcher& includes() const;
    const ReListMatcher& excludes() const;
    void setCaseSensivitiy(const Qt::CaseSensitivity& caseSensivitiy);
@@ -0,0 +1,352 @@
+/*
+ * RePool.cpp
+ *
+ * (Un)License: Public Domain
+ * You can use and modify this file without any restriction.
+ * Do what you want.
+ * No warranties and disclaimer of any damages.
+ * More info: http://unlicense.org
+ * The latest sources: https://github.com/republib
+ */
+
+/** @file
+ * @brief Pools for objects: size classes and an arena per thread.
+ */
+/** @file base/RePool.hpp
+ *
+ * @brief Definitions for pools for objects: size classes and an arena per thread.
+ */
+#include "base/rebase.hpp"
+
+/** @class ReSizeClassPool RePool.hpp "base/RePool.hpp"
+ *
+ * @brief Implements an arena with free lists for some size classes.
+ *
+ * The blocks are allocated in the buffers of the base class
+ * <code>ReByteStorage</code>. Unlike the base class a block can be freed
+ * separately: it is put into the free list of its size class and will be
+ * reused by the next allocation of this class.
+ *
+ * Allocation and freeing of a block needs only a few instructions and
+ * no lock. Blocks larger than <code>MAX_CLASSED_SIZE</code> are managed
+ * by the system.
+ *
+ * Usage for the objects of a class:
+ * <pre>
+ * static void* operator new(size_t size) {
+ *    return ReConcurrentPool::global().allocate(size);
+ * }
+ * static void operator delete(void* block, size_t size) {
+ *    ReConcurrentPool::global().free(block, size);
+ * }
+ * </pre>
+ */
+
+/**
+ * Constructor.
+ *
+ * @param bufferSize    the size of the buffers of the arena
+ */
+ReSizeClassPool::ReSizeClassPool(int bufferSize) :
+   ReByteStorage(bufferSize),
+   m_recycled(0),
+   m_largeBytes(0) {
+   memset(m_freeLists, 0, sizeof m_freeLists);
+}
+
+/**
+ * Allocates a block which is too large for the size classes.
+ *
+ * @param size  the size of the block
+ * @return      the new block
+ */
+void* ReSizeClassPool::allocateLarge(size_t size) {
+   m_largeBytes += size;
+   return ::operator new(size);
+}
+
+/**
+ * Frees a block which is too large for the size classes.
+ *
+ * @param block the block to free
+ * @param size  the size given at the allocation
+ */
+void ReSizeClassPool::freeLarge(void* block, size_t size) {
+   if (block != NULL) {
+      m_largeBytes -= size;
+      ::operator delete(block);
+   }
+}
+
+/**
+ * @brief Frees all blocks of the size classes at once.
+ *
+ * The buffers are kept for the following allocations.
+ *
+ * @note All blocks allocated before are invalid after this call!
+ * Blocks larger than <code>MAX_CLASSED_SIZE</code> must be freed separately.
+ */
+void ReSizeClassPool::reset() {
+   ReByteStorage::reset();
+   memset(m_freeLists, 0, sizeof m_freeLists);
+}
+
+/**
+ * @brief Returns the allocation statistics.
+ *
+ * @param statistics    OUT: the statistics
+ */
+void ReSizeClassPool::statistics(ReAllocStatistics_t& statistics) const {
+   ReByteStorage::statistics(statistics);
+   statistics.m_allocated += m_largeBytes;
+   statistics.m_reserved += m_largeBytes;
+   statistics.m_recycled = m_recycled;
+}
+
+/** @class ReThreadArena RePool.hpp "base/RePool.hpp"
+ *
+ * @brief Implements the arena of one thread of a <code>ReConcurrentPool</code>.
+ *
+ * Only the owning thread allocates and frees locally. Other threads put the
+ * blocks into a lock free list: only the owner takes them out (all at once),
+ * so there is no ABA problem.
+ */
+
+/**
+ * Constructor.
+ *
+ * @param bufferSize    the size of the buffers of the arena
+ */
+ReThreadArena::ReThreadArena(int bufferSize) :
+   ReSizeClassPool(bufferSize),
+   m_live(0),
+   m_remoteFrees(NULL) {
+}
+
+/**
+ * @brief Frees a block in another thread than the owner.
+ *
+ * The block is put into a list which is taken over by the owner later.
+ *
+ * @param block the block to free. At least 16 bytes
+ * @param size  the size given at the allocation
+ */
+void ReThreadArena::freeRemote(void* block, size_t size) {
+   // the first pointer is the link, the size follows:
+   ((size_t*) block)[1] = size;
+   void* head;
+   do {
+      head = m_remoteFrees.loadAcquire();
+      *(void**) block = head;
+   } while (!m_remoteFrees.testAndSetRelease(head, block));
+}
+
+/**
+ * @brief Frees all blocks of the size classes at once.
+ *
+ * @note All blocks allocated before are invalid after this call!
+ */
+void ReThreadArena::reset() {
+   ReSizeClassPool::reset();
+   m_remoteFrees.storeRelease(NULL);
+   m_live = 0;
+}
+
+/**
+ * @brief Puts the blocks freed by other threads into the free lists.
+ *
+ * Must be called by the owning thread (or under the lock of the pool if
+ * the arena has no owner).
+ */
+void ReThreadArena::takeRemoteFrees() {
+   void* block = m_remoteFrees.fetchAndStoreAcquire(NULL);
+   while (block != NULL) {
+      void* next = *(void**) block;
+      size_t size = ((size_t*) block)[1];
+      ReSizeClassPool::free(block, size);
+      m_live--;
+      block = next;
+   }
+}
+
+/** @class ReArenaHandle RePool.hpp "base/RePool.hpp"
+ *
+ * @brief Assigns an arena to a thread.
+ *
+ * The handle is stored in the thread local storage of the pool.
+ */
+
+/**
+ * Constructor.
+ *
+ * @param pool  the owner of the arena
+ * @param arena the arena of the current thread
+ */
+ReArenaHandle::ReArenaHandle(ReConcurrentPool* pool, ReThreadArena* arena) :
+   m_pool(pool),
+   m_arena(arena) {
+}
+
+/**
+ * Destructor.
+ *
+ * Called at the end of the thread: the arena can be used by another thread
+ * or it is freed if none of its blocks is in use.
+ * The blocks of the arena remain valid.
+ */
+ReArenaHandle::~ReArenaHandle() {
+   m_pool->releaseArena(m_arena);
+}
+
+/** @class ReConcurrentPool RePool.hpp "base/RePool.hpp"
+ *
+ * @brief Implements a thread safe allocator with an arena for each thread.
+ *
+ * Each thread allocates from its own <code>ReSizeClassPool</code>, therefore
+ * no lock is needed for allocation and freeing. Only the first allocation of
+ * a thread locks the pool for assigning an arena. The arena of a finished
+ * thread is reused by the next new thread.
+ *
+ * A block may be freed by another thread than the allocating thread:
+ * then it is returned to the arena of the allocation (see the header in
+ * front of each block). So a producer/consumer pair does not grow the
+ * consumer's arena.
+ *
+ * The arena of a finished thread is given back to the system as soon as
+ * all of its blocks are freed.
+ */
+
+/**
+ * Constructor.
+ *
+ * @param bufferSize    the size of the buffers of the arenas
+ */
+ReConcurrentPool::ReConcurrentPool(int bufferSize) :
+   m_bufferSize(bufferSize),
+   m_mutex(),
+   m_arenas(),
+   m_idleArenas(),
+   m_recycledOfFreed(0),
+   m_handles() {
+}
+
+/**
+ * Destructor.
+ *
+ * @note The pool must be destroyed after all threads using it are finished.
+ */
+ReConcurrentPool::~ReConcurrentPool() {
+   if (m_handles.hasLocalData())
+      m_handles.setLocalData(NULL);
+   for (int ix = 0; ix < m_arenas.size(); ix++)
+      delete m_arenas.at(ix);
+   m_arenas.clear();
+}
+
+/**
+ * Returns the pool shared by all modules.
+ *
+ * @return the global pool
+ */
+ReConcurrentPool& ReConcurrentPool::global() {
+   // never destroyed: handles of threads may be deleted after exit()
+   static ReConcurrentPool* s_global = new ReConcurrentPool();
+   return *s_global;
+}
+
+/**
+ * Assigns an arena to the current thread.
+ *
+ * @return the arena of the current thread
+ */
+ReThreadArena& ReConcurrentPool::newArena() {
+   ReThreadArena* arena;
+   m_mutex.lock();
+   trimIdleArenas();
+   if (!m_idleArenas.isEmpty())
+      arena = m_idleArenas.takeLast();
+   else {
+      arena = new ReThreadArena(m_bufferSize);
+      m_arenas.append(arena);
+   }
+   m_mutex.unlock();
+   m_handles.setLocalData(new ReArenaHandle(this, arena));
+   return *arena;
+}
+
+/**
+ * Marks an arena as unused (its thread is finished).
+ *
+ * @param arena the arena to release
+ */
+void ReConcurrentPool::releaseArena(ReThreadArena* arena) {
+   QMutexLocker locker(&m_mutex);
+   m_idleArenas.append(arena);
+   trimIdleArenas();
+}
+
+/**
+ * @brief Frees all blocks of all arenas.
+ *
+ * @note All blocks allocated before are invalid after this call!
+ * No other thread may use the pool during the call.
+ */
+void ReConcurrentPool::reset() {
+   QMutexLocker locker(&m_mutex);
+   for (int ix = 0; ix < m_arenas.size(); ix++)
+      m_arenas.at(ix)->reset();
+}
+
+/**
+ * @brief Gives the memory of unused arenas back to the system.
+ *
+ * An arena of a finished thread is freed when all its blocks are freed.
+ * This is done automatically at the start and the end of a thread using
+ * the pool.
+ */
+void ReConcurrentPool::trim() {
+   QMutexLocker locker(&m_mutex);
+   trimIdleArenas();
+}
+
+/**
+ * @brief Frees the idle arenas without blocks in use.
+ *
+ * @pre the pool is locked
+ */
+void ReConcurrentPool::trimIdleArenas() {
+   for (int ix = m_idleArenas.size() - 1; ix >= 0; ix--) {
+      ReThreadArena* arena = m_idleArenas.at(ix);
+      arena->takeRemoteFrees();
+      if (arena->live() <= 0) {
+         ReAllocStatistics_t stat;
+         arena->statistics(stat);
+         m_recycledOfFreed += stat.m_recycled;
+         m_idleArenas.removeAt(ix);
+         m_arenas.removeOne(arena);
+         delete arena;
+      }
+   }
+}
+
+/**
+ * @brief Returns the summarized statistics of all arenas.
+ *
+ * The values of arenas used by other threads are not exact.
+ *
+ * @param statistics    OUT: the statistics
+ */
+void ReConcurrentPool::statistics(ReAllocStatistics_t& statistics) {
+   memset(&statistics, 0, sizeof statistics);
+   QMutexLocker locker(&m_mutex);
+   statistics.m_recycled = m_recycledOfFreed;
+   for (int ix = 0; ix < m_arenas.size(); ix++) {
+      ReAllocStatistics_t current;
+      m_arenas.at(ix)->statistics(current);
+      statistics.m_allocated += current.m_allocated;
+      statistics.m_reserved += current.m_reserved;
+      statistics.m_wasted += current.m_wasted;
+      statistics.m_recycled += current.m_recycled;
+      statistics.m_buffers += current.m_buffers;
+   }
+}
@@ -0,0 +1,231 @@
+/*
+ * RePool.hpp
+ *
+ * (Un)License: Public Domain
+ * You can use and modify this file without any restriction.
+ * Do what you want.
+ * No warranties and disclaimer of any damages.
+ * More info: http://unlicense.org
+ * The latest sources: https://github.com/republib
+ */
+
+#ifndef REPOOL_HPP
+#define REPOOL_HPP
+
+/**
+ * An arena for objects of different sizes with recycling of freed blocks.
+ *
+ * Not thread safe: each thread should use its own instance
+ * (see <code>ReConcurrentPool</code>).
+ */
+class ReSizeClassPool: public ReByteStorage {
+public:
+   enum {
+      /// the sizes of the classes are multiples of this value
+      GRANULARITY = 16,
+      /// larger blocks are allocated by the system
+      MAX_CLASSED_SIZE = 1024,
+      CLASS_COUNT = MAX_CLASSED_SIZE / GRANULARITY
+   };
+public:
+   ReSizeClassPool(int bufferSize = 64 * 1024);
+public:
+   /**
+    * @brief Allocates a block aligned to 8 bytes.
+    *
+    * @param size  the size of the block
+    * @return      the new block
+    */
+   inline void* allocate(size_t size) {
+      if (size > MAX_CLASSED_SIZE)
+         return allocateLarge(size);
+      int ix = size == 0 ? 0 : int(size - 1) / GRANULARITY;
+      void* rc = m_freeLists[ix];
+      if (rc == NULL)
+         return allocateBytes((ix + 1) * GRANULARITY);
+      m_freeLists[ix] = *(void**) rc;
+      m_recycled++;
+      return rc;
+   }
+   /**
+    * @brief Puts a block into the free list of its size class.
+    *
+    * @param block the block to free. Must be allocated by a pool
+    * @param size  the size given at the allocation
+    */
+   inline void free(void* block, size_t size) {
+      if (size > MAX_CLASSED_SIZE)
+         freeLarge(block, size);
+      else if (block != NULL) {
+         int ix = size == 0 ? 0 : int(size - 1) / GRANULARITY;
+         *(void**) block = m_freeLists[ix];
+         m_freeLists[ix] = block;
+      }
+   }
+   void reset();
+   void statistics(ReAllocStatistics_t& statistics) const;
+private:
+   void* allocateLarge(size_t size);
+   void freeLarge(void* block, size_t size);
+private:
+   // the heads of the free lists, one per size class:
+   void* m_freeLists[CLASS_COUNT];
+   // count of blocks served from the free lists:
+   int64_t m_recycled;
+   // bytes allocated by the system (larger than MAX_CLASSED_SIZE):
+   int64_t m_largeBytes;
+};
+
+/**
+ * The arena of one thread in a <code>ReConcurrentPool</code>.
+ *
+ * Blocks freed by other threads are collected in a lock free list and
+ * taken over by the owner at its next allocation.
+ */
+class ReThreadArena: public ReSizeClassPool {
+public:
+   ReThreadArena(int bufferSize);
+public:
+   /**
+    * @brief Allocates a block aligned to 8 bytes.
+    *
+    * @param size  the size of the block
+    * @return      the new block
+    */
+   inline void* allocate(size_t size) {
+      if (m_remoteFrees.loadAcquire() != NULL)
+         takeRemoteFrees();
+      if (size <= MAX_CLASSED_SIZE)
+         m_live++;
+      return ReSizeClassPool::allocate(size);
+   }
+   /**
+    * @brief Frees a block allocated by this arena (in the owning thread).
+    *
+    * @param block the block to free
+    * @param size  the size given at the allocation
+    */
+   inline void free(void* block, size_t size) {
+      if (block != NULL && size <= MAX_CLASSED_SIZE)
+         m_live--;
+      ReSizeClassPool::free(block, size);
+   }
+   void freeRemote(void* block, size_t size);
+   /** Returns the number of blocks in use.
+    * @return the number of allocated and not freed blocks
+    */
+   inline int64_t live() const {
+      return m_live;
+   }
+   void reset();
+   void takeRemoteFrees();
+private:
+   // blocks of the size classes in use:
+   int64_t m_live;
+   // the blocks freed by other threads: linked by the first pointer
+   QAtomicPointer<void> m_remoteFrees;
+};
+
+class ReConcurrentPool;
+/**
+ * Connects a thread with its arena.
+ *
+ * Will be deleted at the end of the thread: then the arena is free
+ * for the next thread.
+ */
+class ReArenaHandle {
+public:
+   ReArenaHandle(ReConcurrentPool* pool, ReThreadArena* arena);
+   ~ReArenaHandle();
+public:
+   ReConcurrentPool* m_pool;
+   ReThreadArena* m_arena;
+};
+
+/**
+ * A thread safe allocator with an arena for each thread.
+ */
+class ReConcurrentPool {
+   friend class ReArenaHandle;
+public:
+   ReConcurrentPool(int bufferSize = 64 * 1024);
+   ~ReConcurrentPool();
+private:
+   // No copy constructor: no implementation!
+   ReConcurrentPool(const ReConcurrentPool& source);
+   // No assignment operator: no implementation!
+   ReConcurrentPool& operator =(const ReConcurrentPool& source);
+public:
+   /**
+    * @brief Allocates a block in the arena of the current thread.
+    *
+    * @param size  the size of the block
+    * @return      a block aligned to 8 bytes
+    */
+   inline void* allocate(size_t size) {
+      ReThreadArena& current = arena();
+      void** block = (void**) current.allocate(size + HEADER_SIZE);
+      // the header: the owner of the block
+      *block = &current;
+      return block + 1;
+   }
+   /**
+    * @brief Frees a block.
+    *
+    * A block freed by another thread than the allocating thread is returned
+    * to the arena of the allocation.
+    *
+    * @param block the block to free
+    * @param size  the size given at the allocation
+    */
+   inline void free(void* block, size_t size) {
+      if (block != NULL) {
+         void** raw = (void**) block - 1;
+         ReThreadArena* owner = (ReThreadArena*) *raw;
+         size += HEADER_SIZE;
+         ReArenaHandle* handle = m_handles.localData();
+         if (size > ReSizeClassPool::MAX_CLASSED_SIZE)
+            // large blocks are owned by the system:
+            arena().free(raw, size);
+         else if (handle != NULL && handle->m_arena == owner)
+            owner->free(raw, size);
+         else
+            owner->freeRemote(raw, size);
+      }
+   }
+   void reset();
+   void statistics(ReAllocStatistics_t& statistics);
+   void trim();
+public:
+   static ReConcurrentPool& global();
+private:
+   enum {
+      /// the owner of a block is stored in front of the block
+      HEADER_SIZE = sizeof(void*)
+   };
+private:
+   /**
+    * Returns the arena of the current thread.
+    *
+    * @return the arena of the current thread
+    */
+   inline ReThreadArena& arena() {
+      ReArenaHandle* handle = m_handles.localData();
+      return handle != NULL ? *handle->m_arena : newArena();
+   }
+   ReThreadArena& newArena();
+   void releaseArena(ReThreadArena* arena);
+   void trimIdleArenas();
+private:
+   int m_bufferSize;
+   QMutex m_mutex;
+   // all arenas of the pool:
+   QList<ReThreadArena*> m_arenas;
+   // arenas of terminated threads with blocks in use:
+   QList<ReThreadArena*> m_idleArenas;
+   // the recycled blocks of the freed arenas (for the statistics):
+   int64_t m_recycledOfFreed;
+   QThreadStorage<ReArenaHandle*> m_handles;
+};
+
+#endif // REPOOL_HPP
@@ -31,6 +31,20 @@ public:
       else
          return source.toLocal8Bit();
    }
+   /** Converts a byte string into a <code>QString</code>.
+    * The character set is a global setting: <code>m_standardCharSet</code>.
+    * @param source	the string to convert
+    * @param length	the length of <code>source</code>. -1: <code>strlen(source)</code>
+    * @return	the converted string
+    */
+   inline static QString b2s(const char* source, int length = -1) {
+      if (m_standardCharSet == UTF8)
+         return QString::fromUtf8(source, length);
+      else if (m_standardCharSet == LATIN)
+         return QString::fromLatin1(source, length);
+      else
+         return QString::fromLocal8Bit(source, length);
+   }
 public:
    static CharSet m_standardCharSet;
 };
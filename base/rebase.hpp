@@ -28,13 +28,16 @@
 #include <io.h>
 #include <direct.h>
 #endif
+#include <algorithm>
 #include <QThread>
 #include <QIODevice>
 #include <QTextStream>
 #include <QMap>
+#include <QSet>
 #include <QVector>
 #include <QDataStream>
 #include <QMutex>
+#include <QThreadStorage>
 #include <QRegularExpression>
 #include <QDateTime>
 #include <QtCore/qmath.h>
@@ -172,9 +175,11 @@ public:
 #include "remodules.hpp"
 #include "base/ReProcess.hpp"
 #include "base/ReByteStorage.hpp"
+#include "base/RePool.hpp"
 #include "base/ReCharPtrMap.hpp"
 #include "base/ReWriter.hpp"
 #include "base/ReLogger.hpp"
+#include "base/ReBinaryLogger.hpp"
 #include "base/ReException.hpp"
 #include "base/ReContainer.hpp"
 #include "base/ReStringUtils.hpp"
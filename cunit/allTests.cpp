@@ -24,7 +24,9 @@ static void testGui() {
    void testReStateStorage();
    void testReEdit();
    void testReSettings();
+   void testReFileTableModel();
    testReSettings();
+   testReFileTableModel();
    testReStateStorage();
    testReEdit();
 }
@@ -44,11 +46,13 @@ static void testBase() {
    void testReWriter();
    void testReFile();
    void testReMatcher();
+   void testReBinaryLogger();
    testReProgArgs();
    testReProcess();
    testReRandomizer();
    testReFileUtils();
    testReMatcher();
+   testReBinaryLogger();
    testReQStringUtil();
    testReFile();
    if (s_allTest) {
@@ -65,47 +69,58 @@ static void testBase() {
    }
 }
 static void testMath() {
+   void testReMatrix();
+   testReMatrix();
 }
 static void testExpr() {
-   extern void testReMFParser();
-   extern void testRplBenchmark();
    extern void testReVM();
    extern void testReSource();
    extern void testReLexer();
    extern void testReMFParser();
    extern void testReASTree();
-   extern void testReVM();
-   testReLexer();
-   /*
-   //testRplBenchmark();
-   if (s_allTest){
-   testReVM();
    testReSource();
    testReLexer();
-   testReMFParser();
    testReASTree();
+   testReMFParser();
    testReVM();
-   }
-   */
 }
 static void testNet() {
 }
 static void testOs() {
    void testReFileSystem();
    void testReCryptFileSystem();
+   void testReTraverser();
+   void testReFileIndex();
    testReFileSystem();
    testReCryptFileSystem();
+   testReTraverser();
+   testReFileIndex();
+}
+/**
+ * @brief Runs the time consuming benchmarks: not part of the normal unit run.
+ */
+static void benchmarks() {
+   void benchmarkReMatcher();
+   benchmarkReMatcher();
+   void benchmarkReCharPtrMap();
+   benchmarkReCharPtrMap();
+   void benchmarkReFileTableModel();
+   benchmarkReFileTableModel();
+   void benchmarkReVM();
+   benchmarkReVM();
 }
 void allTests() {
    testOs();
    testExpr();
    testBase();
+   testMath();
    testGui();
    if (s_allTest) {
       testBase();
       testMath();
       testNet();
       testOs();
+      benchmarks();
    }
 }
 
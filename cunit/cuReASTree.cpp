@@ -29,6 +29,7 @@ public:
       m_reader(m_source),
       m_unit("<main>", "", &m_reader),
       m_tree() {
+      doIt();
    }
 public:
    void testReASException() {
@@ -70,6 +71,135 @@ public:
       ReASVariant val3(val1);
       checkEqu("Bye", *val3.asString());
    }
+   void testCopyOnWrite() {
+      ReASVariant val1;
+      val1.setString("abc");
+      ReASVariant val2(val1);
+      // the copy shares the string:
+      checkT(val1.isShared());
+      checkT(val1.asString() == val2.asString());
+      QByteArray* string = static_cast<QByteArray*>(val2.asWritableObject(
+                              NULL));
+      string->append("d");
+      checkF(val1.isShared());
+      checkF(val2.isShared());
+      checkEqu("abc", *val1.asString());
+      checkEqu("abcd", *val2.asString());
+      // the copy constructor holds exactly one reference:
+      {
+         ReASVariant val4(val1);
+         checkT(val1.isShared());
+      }
+      checkF(val1.isShared());
+      // a list:
+      ReASVariant list1;
+      list1.setObject(ReASList::m_instance->newValueInstance(),
+                      ReASList::m_instance);
+      ReASListOfVariants* elements = static_cast<ReASListOfVariants*>(
+                                        list1.asWritableObject(NULL));
+      elements->append(val1);
+      ReASVariant number;
+      number.setInt(3);
+      elements->append(number);
+      ReASVariant list2;
+      list2 = list1;
+      checkT(list1.isShared());
+      elements = static_cast<ReASListOfVariants*>(list2.asWritableObject(NULL));
+      checkEqu(2, elements->size());
+      number.setInt(4);
+      elements->set(1, number);
+      checkEqu("['abc',3]", list1.toString());
+      checkEqu("['abc',4]", list2.toString());
+      // the elements of the copied list share their values:
+      checkT(elements->variantAt(0).asString() == val1.asString());
+      list1 = list1;
+      checkEqu("['abc',3]", list1.toString());
+   }
+   void testListStorage() {
+      ReASListOfVariants list;
+      checkT(list.isEmpty());
+      checkEqu(ReASListOfVariants::ST_EMPTY, list.storageType());
+      ReASVariant value;
+      for (int ix = 0; ix < 3; ix++) {
+         value.setInt(ix * 10);
+         list.append(value);
+      }
+      checkEqu(ReASListOfVariants::ST_INT, list.storageType());
+      checkEqu(3, list.size());
+      checkEqu(20, list.intAt(2));
+      list.at(1, value);
+      checkEqu(ReASVariant::VT_INTEGER, value.variantType());
+      checkEqu(10, value.asInt());
+      // the copy shares the packed array until a change:
+      ReASListOfVariants copy(list);
+      value.setInt(99);
+      copy.set(0, value);
+      checkEqu(0, list.intAt(0));
+      checkEqu(99, copy.intAt(0));
+      // a mixed insert converts the storage:
+      value.setString("x");
+      list.append(value);
+      checkEqu(ReASListOfVariants::ST_VARIANT, list.storageType());
+      checkEqu(4, list.size());
+      checkEqu(20, list.variantAt(2).asInt());
+      checkEqu("x", *list.variantAt(3).asString());
+      checkEqu(ReASListOfVariants::ST_INT, copy.storageType());
+      // floats and booleans:
+      ReASListOfVariants floats;
+      value.setFloat(0.5);
+      floats.append(value);
+      checkEqu(ReASListOfVariants::ST_FLOAT, floats.storageType());
+      checkEqu(0.5, floats.floatAt(0));
+      value.setBool(true);
+      floats.set(0, value);
+      checkEqu(ReASListOfVariants::ST_VARIANT, floats.storageType());
+      checkT(floats.variantAt(0).asBool());
+      floats.clear();
+      checkT(floats.isEmpty());
+      value.setBool(false);
+      floats.append(value);
+      checkEqu(ReASListOfVariants::ST_BOOL, floats.storageType());
+      checkF(floats.boolAt(0));
+   }
+   void testMapStorage() {
+      ReASMapOfVariants map;
+      checkT(map.isEmpty());
+      checkT(map.find("a") == NULL);
+      ReASVariant value;
+      char key[16];
+      for (int ix = 0; ix < 100; ix++) {
+         qsnprintf(key, sizeof key, "k%d", ix);
+         value.setInt(ix);
+         map.insert(key, value);
+         value.setInt(-ix);
+         map.insert(ix, value);
+      }
+      checkEqu(200, map.size());
+      checkEqu(17, map.find("k17")->asInt());
+      checkEqu(-17, map.find(17)->asInt());
+      checkT(map.find("k100") == NULL);
+      checkT(map.find(100) == NULL);
+      // replacing keeps the insertion order:
+      value.setString("x");
+      map.insert("k0", value);
+      checkEqu(200, map.size());
+      checkEqu("x", *map.entryAt(0).m_value.asString());
+      checkEqu("k0", map.entryAt(0).m_key);
+      checkT(map.entryAt(1).m_isIntKey);
+      // interned keys share the buffer:
+      const QByteArray& key1 = m_tree.intern(QByteArray("name"));
+      const QByteArray& key2 = m_tree.intern(QByteArray("na") + "me");
+      checkT(key1.constData() == key2.constData());
+      // the copy shares the entries until a change:
+      ReASMapOfVariants copy(map);
+      value.setInt(4711);
+      copy.insert("k1", value);
+      checkEqu(1, map.find("k1")->asInt());
+      checkEqu(4711, copy.find("k1")->asInt());
+      map.clear();
+      checkT(map.isEmpty());
+      checkT(map.find(3) == NULL);
+   }
    void testReASConstant() {
       ReASConstant constant;
       //constant.value().setString("Jonny");
@@ -82,11 +212,14 @@ public:
                            ReASNamedValue::A_GLOBAL);
       checkEqu("gugo", value.name());
    }
-   virtual void run() {
+   virtual void runTests(void) {
       testReASNamedValue();
       testReASConstant();
       testReASException();
       testReASVariant();
+      testCopyOnWrite();
+      testListStorage();
+      testMapStorage();
    }
 };
 void testReASTree() {
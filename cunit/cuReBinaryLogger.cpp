@@ -0,0 +1,81 @@
+/*
+ * cuReBinaryLogger.cpp
+ *
+ * (Un)License: Public Domain
+ * You can use and modify this file without any restriction.
+ * Do what you want.
+ * No warranties and disclaimer of any damages.
+ * More info: http://unlicense.org
+ * The latest sources: https://github.com/republib
+ */
+/** @file
+ * @brief Unit test of the binary log appender.
+ */
+
+#include "base/rebase.hpp"
+
+class TestReBinaryLogger: public ReTest {
+public:
+   TestReBinaryLogger() :
+      ReTest("ReBinaryLogger") {
+      doIt();
+   }
+private:
+   QByteArray pack(const char* format, ...) {
+      uint8_t buffer[1024];
+      va_list ap;
+      va_start(ap, format);
+      int length = ReBinaryLogFormat::packArguments(format, ap, buffer,
+                   sizeof buffer);
+      va_end(ap);
+      return ReBinaryLogFormat::unpackArguments(format, buffer, length);
+   }
+   void testFormat() {
+      checkEqu("x=-3 y=12345678901 z=ff", pack("x=%d y=%lld z=%x", -3,
+               12345678901LL, 255));
+      checkEqu("[  abc|Hi ] 100%", pack("[%5s|%-3s] %d%%", "abc", "Hi", 100));
+      checkEqu("3.14 |   7|c", pack("%.2f |%*d|%c", 3.14159, 4, 7, 'c'));
+      checkEqu("(null)", pack("%s", (const char*) NULL));
+      checkEqu("no args", pack("no args"));
+   }
+   void testAppender() {
+      QByteArray prefix = getTempFile("binlog", "cuReBinaryLogger");
+      ReLogger logger(false);
+      ReBinaryFileAppender* appender = new ReBinaryFileAppender(prefix,
+            0, 2);
+      appender->setAutoDelete(true);
+      logger.addAppender(appender);
+      QByteArray filename = I18N::s2b(appender->filename());
+      logger.logv(LOG_ERROR, 4711, "file %s has %d lines", "abc.txt", 22);
+      logger.log(LOG_INFO, 4712, "plain text");
+      logger.logv(LOG_DEBUG, 4713, "not active: %d", 1);
+      appender->close();
+      QMap<int, QByteArray> formats;
+      formats[4711] = "file %s has %d lines";
+      ReBinaryLogReader reader(&formats);
+      checkT(reader.open(filename.constData()));
+      const ReBinaryLogRecord_t* record = reader.nextRecord();
+      checkNN(record);
+      if (record != NULL) {
+         checkEqu(LOG_ERROR, (int) record->m_level);
+         checkEqu(4711, record->m_location);
+         QByteArray line = reader.asText(record);
+         checkT(line.startsWith("!"));
+         checkT(line.endsWith("(4711): file abc.txt has 22 lines"));
+      }
+      record = reader.nextRecord();
+      checkNN(record);
+      if (record != NULL)
+         checkT(reader.asText(record).endsWith("(4712): plain text"));
+      checkN(reader.nextRecord());
+   }
+public:
+   virtual void runTests() {
+      testFormat();
+      testAppender();
+   }
+};
+void testReBinaryLogger() {
+   TestReBinaryLogger test;
+}
+
@@ -13,6 +13,7 @@
  */
 
 #include "base/rebase.hpp"
+#include <QSemaphore>
 
 class TestReByteStorage: public ReTest {
 public:
@@ -63,11 +64,180 @@ private:
       }
    }
 
+   void testLargeBlock() {
+      ReByteStorage store(100);
+      const char* s1 = store.allocateChars("abc");
+      store.allocateBytes(50);
+      // too large for the rest and larger than a quarter of the buffer:
+      // the block gets its own buffer, the rest remains usable
+      uint8_t* large = store.allocateZeros(60);
+      const char* s2 = store.allocateChars("def");
+      checkT(s1 + 4 + 50 == s2);
+      checkT(large != NULL);
+      ReAllocStatistics_t stat;
+      store.statistics(stat);
+      checkEqu(4 + 50 + 60 + 4, (int) stat.m_allocated);
+      checkEqu(2, stat.m_buffers);
+      checkEqu(0, (int) stat.m_wasted);
+   }
+   void testReset() {
+      ReByteStorage store(100);
+      const char* first = store.allocateChars("12345678901234567890");
+      for (int ii = 0; ii < 20; ii++)
+         store.allocateChars("12345678901234567890");
+      store.allocateBytes(500);
+      ReAllocStatistics_t stat;
+      store.statistics(stat);
+      checkEqu(21 * 21 + 500, (int) stat.m_allocated);
+      int buffers = stat.m_buffers;
+      checkT(stat.m_wasted > 0);
+      store.reset();
+      store.statistics(stat);
+      checkEqu(0, (int) stat.m_allocated);
+      // the large buffer is freed, the others are kept:
+      checkEqu(buffers - 1, stat.m_buffers);
+      for (int ii = 0; ii < 21; ii++)
+         store.allocateChars("12345678901234567890");
+      store.statistics(stat);
+      // no new buffer:
+      checkEqu(buffers - 1, stat.m_buffers);
+      checkT(first != NULL);
+   }
+   void testSizeClassPool() {
+      ReSizeClassPool pool(1024);
+      void* b1 = pool.allocate(10);
+      void* b2 = pool.allocate(16);
+      void* b3 = pool.allocate(17);
+      checkEqu(0, int((size_t) b1 % 8));
+      checkT((uint8_t*) b1 + 16 == b2);
+      checkT((uint8_t*) b2 + 16 == b3);
+      pool.free(b1, 10);
+      // same size class: recycled
+      checkT(pool.allocate(3) == b1);
+      pool.free(b3, 17);
+      checkT(pool.allocate(32) == b3);
+      void* large = pool.allocate(5000);
+      memset(large, 0, 5000);
+      pool.free(large, 5000);
+      ReAllocStatistics_t stat;
+      pool.statistics(stat);
+      checkEqu(2, (int) stat.m_recycled);
+      checkEqu(16 + 16 + 32, (int) stat.m_allocated);
+      pool.reset();
+      pool.statistics(stat);
+      checkEqu(0, (int) stat.m_allocated);
+      checkEqu(1, stat.m_buffers);
+   }
+   class PoolThread: public QThread {
+   public:
+      PoolThread(ReConcurrentPool& pool) :
+         m_pool(pool),
+         m_errors(0) {
+      }
+      virtual void run() {
+         void* blocks[100];
+         for (int loop = 0; loop < 1000; loop++) {
+            for (int ix = 0; ix < 100; ix++) {
+               int size = 8 + ix * 4;
+               blocks[ix] = m_pool.allocate(size);
+               memset(blocks[ix], ix, size);
+            }
+            for (int ix = 0; ix < 100; ix++) {
+               if (((uint8_t*) blocks[ix])[7 + ix * 4] != ix)
+                  m_errors++;
+               m_pool.free(blocks[ix], 8 + ix * 4);
+            }
+         }
+      }
+   public:
+      ReConcurrentPool& m_pool;
+      int m_errors;
+   };
+   void testConcurrentPool() {
+      ReConcurrentPool pool(4096);
+      PoolThread* threads[4];
+      for (int ix = 0; ix < 4; ix++) {
+         threads[ix] = new PoolThread(pool);
+         threads[ix]->start();
+      }
+      for (int ix = 0; ix < 4; ix++) {
+         threads[ix]->wait();
+         checkEqu(0, threads[ix]->m_errors);
+         delete threads[ix];
+      }
+      ReAllocStatistics_t stat;
+      pool.statistics(stat);
+      checkT(stat.m_recycled >= 4 * 999 * 100);
+   }
+   class ProducerThread: public QThread {
+   public:
+      ProducerThread(ReConcurrentPool& pool, int rounds) :
+         m_pool(pool),
+         m_rounds(rounds),
+         m_filled(),
+         m_freed() {
+      }
+      virtual void run() {
+         for (int round = 0; round < m_rounds; round++) {
+            if (round > 0)
+               m_freed.acquire();
+            for (int ix = 0; ix < 100; ix++)
+               m_blocks[ix] = m_pool.allocate(16 + ix * 8);
+            m_filled.release();
+         }
+      }
+   public:
+      ReConcurrentPool& m_pool;
+      int m_rounds;
+      void* m_blocks[100];
+      QSemaphore m_filled;
+      QSemaphore m_freed;
+   };
+   void testRemoteFree() {
+      ReConcurrentPool pool(4096);
+      // the consumer (this thread) frees the blocks of the producer:
+      ProducerThread producer(pool, 50);
+      producer.start();
+      ReAllocStatistics_t stat;
+      for (int round = 0; round < 50; round++) {
+         producer.m_filled.acquire();
+         if (round == 49)
+            pool.statistics(stat);
+         for (int ix = 0; ix < 100; ix++)
+            pool.free(producer.m_blocks[ix], 16 + ix * 8);
+         producer.m_freed.release();
+      }
+      producer.wait();
+      // the blocks are returned to the producer's arena and reused there:
+      checkT(stat.m_recycled >= 49 * 100);
+      checkT(stat.m_buffers > 0);
+      // the arena of the finished producer has no blocks in use: freed
+      pool.trim();
+      pool.statistics(stat);
+      checkEqu(0, stat.m_buffers);
+      // short living producers: the memory use does not grow
+      for (int loop = 0; loop < 10; loop++) {
+         ProducerThread producer2(pool, 1);
+         producer2.start();
+         producer2.wait();
+         for (int ix = 0; ix < 100; ix++)
+            pool.free(producer2.m_blocks[ix], 16 + ix * 8);
+         pool.trim();
+         pool.statistics(stat);
+         checkEqu(0, stat.m_buffers);
+      }
+   }
+
 public:
    virtual void runTests() {
       testBufferChange();
       testChars();
       testBytes();
+      testLargeBlock();
+      testReset();
+      testSizeClassPool();
+      testConcurrentPool();
+      testRemoteFree();
    }
 };
 void testReByteStorage() {
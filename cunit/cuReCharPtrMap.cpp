@@ -13,10 +13,14 @@
 
 class TestReCharPtrMap: public ReTest {
 public:
-   TestReCharPtrMap() :
-      ReTest("ReCharPtrMap") {
+   TestReCharPtrMap(bool benchmark = false) :
+      ReTest("ReCharPtrMap"),
+      m_benchmark(benchmark) {
       doIt();
    }
+private:
+   /// true: only the benchmark is done
+   bool m_benchmark;
 protected:
    void testBasic() {
       ReCharPtrMap<const char*> map;
@@ -25,11 +29,118 @@ protected:
       checkF(map.contains("y"));
       checkEqu("x1", map["x"]);
    }
+   void testMany() {
+      ReCharPtrMap<int> map;
+      ReByteStorage store(4096);
+      QList<const char*> keys;
+      char buffer[32];
+      for (int ix = 0; ix < 1000; ix++) {
+         qsnprintf(buffer, sizeof buffer, "key%d", ix);
+         keys.append(store.allocateChars(buffer));
+         map[keys.last()] = ix;
+      }
+      checkEqu(1000, map.size());
+      for (int ix = 0; ix < 1000; ix++) {
+         qsnprintf(buffer, sizeof buffer, "key%d", ix);
+         // other pointer, same content:
+         checkEqu(ix, map.value(buffer, -1));
+      }
+      checkEqu(-1, map.value("key1000", -1));
+      for (int ix = 0; ix < 1000; ix += 2)
+         checkEqu(1, map.remove(keys.at(ix)));
+      checkEqu(0, map.remove("key0"));
+      checkEqu(500, map.size());
+      int sum = 0;
+      ReCharPtrMap<int>::iterator it;
+      for (it = map.begin(); it != map.end(); it++) {
+         checkEqu(1, *it % 2);
+         sum += it.value();
+      }
+      checkEqu(500 * 500, sum);
+      // reuse of deleted slots:
+      for (int ix = 0; ix < 1000; ix += 2)
+         map.insert(keys.at(ix), -ix);
+      checkEqu(1000, map.count());
+      checkEqu(-998, *map.find("key998"));
+      checkT(map.find("x") == map.end());
+      checkEqu(1000, map.keys().size());
+      map.clear();
+      checkT(map.isEmpty());
+      checkF(map.contains("key1"));
+   }
+   void testSorted() {
+      ReCharPtrMap<int> map;
+      map["delta"] = 4;
+      map["alpha"] = 1;
+      map.insert(map.begin(), "charly", 3);
+      map["bravo"] = 2;
+      QList<const char*> keys = map.sortedKeys();
+      checkEqu(4, keys.size());
+      checkEqu("alpha", keys.at(0));
+      checkEqu("bravo", keys.at(1));
+      checkEqu("charly", keys.at(2));
+      checkEqu("delta", keys.at(3));
+      checkT(map.contains(QByteArray("charly")));
+      checkEqu(3, map.value(QByteArray("charly")));
+   }
+   /**
+    * Compares the hash map with the former implementation (QMap).
+    *
+    * @param maxKeys   the key count of the last round. 10 million needs
+    *                  some GiByte of memory
+    */
+   void benchmark(int maxKeys) {
+      char buffer[32];
+      for (int count = 1000; count <= maxKeys; count *= 10) {
+         ReByteStorage store(1024 * 1024);
+         QList<const char*> keys;
+         keys.reserve(count);
+         for (int ix = 0; ix < count; ix++) {
+            qsnprintf(buffer, sizeof buffer, "/usr/src/unit%d.mf", ix * 7919);
+            keys.append(store.allocateChars(buffer));
+         }
+         int lookups = 10 * 1000 * 1000 / count;
+         if (lookups < 1)
+            lookups = 1;
+         clock_t start = clock();
+         QMap<ReKeyCharPtr, int> qmap;
+         for (int ix = 0; ix < count; ix++)
+            qmap.insert(keys.at(ix), ix);
+         int64_t sum = 0;
+         for (int loop = 0; loop < lookups; loop++)
+            for (int ix = 0; ix < count; ix++)
+               sum += qmap.value(keys.at(ix));
+         clock_t middle = clock();
+         ReCharPtrMap<int> map;
+         for (int ix = 0; ix < count; ix++)
+            map.insert(keys.at(ix), ix);
+         for (int loop = 0; loop < lookups; loop++)
+            for (int ix = 0; ix < count; ix++)
+               sum -= map.value(keys.at(ix));
+         clock_t end = clock();
+         checkEqu((int64_t) 0, sum);
+         log(QByteArray("keys: ").append(QByteArray::number(count))
+             .append(" QMap: ").append(QByteArray::number(double(middle - start)
+                   / CLOCKS_PER_SEC)).append(" sec hash: ")
+             .append(QByteArray::number(double(end - middle) / CLOCKS_PER_SEC))
+             .append(" sec").constData());
+      }
+   }
+
 public:
    virtual void runTests(void) {
-      testBasic();
+      if (m_benchmark)
+         benchmark(10 * 1000 * 1000);
+      else {
+         testBasic();
+         testMany();
+         testSorted();
+      }
    }
 };
 void testReCharPtrMap() {
    TestReCharPtrMap test;
 }
+void benchmarkReCharPtrMap() {
+   TestReCharPtrMap test(true);
+}
@@ -45,8 +45,142 @@ public:
       log(("Example: " + data).constData());
    }
 
+   void testVersion2() {
+      ReContainer container(256, ReContainer::VERSION_2);
+      uint8_t blob[300];
+      for (size_t ix = 0; ix < sizeof blob; ix++)
+         blob[ix] = (uint8_t) ix;
+      container.startBag();
+      container.addChar('!');
+      container.addInt(123);
+      container.addString("Nirwana");
+      container.addData(blob, sizeof blob);
+      container.startBag();
+      container.addChar('Y');
+      container.addInt(-0xab34);
+      container.addString("");
+      container.addData(blob, 3);
+      container.startBag();
+      container.addChar('Z');
+      container.addInt(0x7fffffff);
+      container.addString("last");
+      container.addData(blob, 0);
+      QByteArray data = container.getData();
+      checkT(data.startsWith(ReContainer::MAGIC_2));
+      ReContainer container2(256);
+      container2.fill(data);
+      checkEqu(ReContainer::VERSION_2, container2.getVersion());
+      checkEqu(3, container2.getCountBags());
+      checkEqu('!', container2.nextChar());
+      checkEqu(123, container2.nextInt());
+      size_t length = 0;
+      checkEqu("Nirwana", container2.nextString(length));
+      checkEqu(7, (int) length);
+      const uint8_t* view = container2.nextData(length);
+      checkEqu(300, (int) length);
+      checkEqu(0, memcmp(view, blob, length));
+      // the view points into the container data: no copy
+      checkT((const char*) view > data.constData()
+             && (const char*) view < data.constData() + data.length());
+      // skip a bag without reading its items:
+      container2.seekBag(2);
+      checkEqu('Z', container2.nextChar());
+      checkEqu(0x7fffffff, container2.nextInt());
+      checkEqu("last", container2.nextString());
+      QByteArray blob2;
+      checkEqu(0, (int) container2.nextData(blob2));
+      container2.seekBag(1);
+      checkEqu('Y', container2.nextChar());
+      checkEqu((int64_t) -0xab34, container2.nextInt64());
+      checkEqu("", container2.nextString());
+      checkEqu(3, (int) container2.nextData(blob2));
+      checkEqu(2, (int) blob2.at(2));
+   }
+   void testVersion2Size() {
+      const int countBags = 1000;
+      QByteArray data[2];
+      for (int version = ReContainer::VERSION_1;
+            version <= ReContainer::VERSION_2; version++) {
+         ReContainer container(countBags * 32, version);
+         for (int ix = 0; ix < countBags; ix++) {
+            container.startBag();
+            container.addInt(ix * 17 - 1000);
+            container.addInt((int64_t) ix << 20);
+            container.addString("/home/data/file.txt");
+         }
+         data[version - ReContainer::VERSION_1] = container.getData();
+      }
+      // the varints are shorter than the hex numbers of version 1:
+      checkT(data[1].length() < data[0].length());
+      ReContainer container2(0);
+      container2.fill(data[1]);
+      size_t length;
+      for (int ix = 0; ix < countBags; ix++) {
+         if (ix > 0)
+            container2.nextBag();
+         checkEqu(ix * 17 - 1000, container2.nextInt());
+         checkEqu((int64_t) ix << 20, container2.nextInt64());
+         container2.nextString(length);
+         checkEqu(19, (int) length);
+      }
+   }
+
+   /**
+    * @brief Tests whether the container data can be read.
+    *
+    * @param data  the container data
+    * @return      <code>true</code>: fill() and all string reads succeeded
+    */
+   bool isReadable(const QByteArray& data) {
+      bool rc = true;
+      try {
+         ReContainer container(0);
+         container.fill(data);
+         for (int ix = 0; ix < container.getCountBags(); ix++) {
+            if (ix > 0)
+               container.nextBag();
+            container.nextString();
+         }
+      } catch (ReException&) {
+         rc = false;
+      }
+      return rc;
+   }
+   void testInvalidVersion2() {
+      ReContainer container(0, ReContainer::VERSION_2);
+      container.startBag();
+      container.addString("abc");
+      QByteArray data = container.getData();
+      checkT(isReadable(data));
+      int header = strlen(ReContainer::MAGIC_2);
+      // bag count 0xffffffff:
+      QByteArray data2 = data.left(header) + "\xff\xff\xff\xff\x0f"
+                         + data.mid(header + 1);
+      checkF(isReadable(data2));
+      // type list longer than the data:
+      data2 = data;
+      data2[header + 1] = 0x7f;
+      checkF(isReadable(data2));
+      // bag size larger than the data:
+      data2 = data;
+      data2[header + 3] = 0x7f;
+      checkF(isReadable(data2));
+      // string length behind the end of the data:
+      int posLength = data.length() - 5;
+      checkEqu(3, (int) data.at(posLength));
+      data2 = data;
+      data2[posLength] = 0x7f;
+      checkF(isReadable(data2));
+      // string length not ending at the '\0':
+      data2[posLength] = 2;
+      checkF(isReadable(data2));
+   }
+
    virtual void runTests() {
       testBasic();
+      testVersion2();
+      testVersion2Size();
+      testInvalidVersion2();
    }
 };
 
@@ -328,7 +328,82 @@ public:
       checkEqu(4, ReParagraphs::indexToColumn(4, tabWidth, "123\tx"));
    }
 
+   void testLayoutCache() {
+      init("abc\n1234\nxy\nline4\nline5");
+      m_firstLine = 0;
+      m_firstCol = 0;
+      m_cursorLineNo = 4;
+      load(0, 3, 10, this);
+      ReParagraph* para1 = m_list.at(1);
+      checkEqu(1, para1->m_lineNo);
+      checkEqu("1234", para1->at(0)->text());
+      // scrolling reuses the paragraphs still on the screen:
+      load(1, 3, 10, this);
+      checkT(para1 == m_list.at(0));
+      // an insertion in front of the screen moves the cached paragraphs:
+      m_lines.insertLines(0, "new\n", false);
+      load(2, 3, 10, this);
+      checkT(para1 == m_list.at(0));
+      checkEqu(2, para1->m_lineNo);
+      // a changed line is built again:
+      m_lines.insertPart(2, 0, "x", false);
+      load(2, 3, 10, this);
+      checkEqu(2, m_list.at(0)->m_lineNo);
+      checkEqu("x1234", m_list.at(0)->at(0)->text());
+      checkEqu("xy", m_list.at(1)->at(0)->text());
+      // the cursor line is built again with another look:
+      checkEqu(ReLook::FG_STANDARD, m_list.at(1)->at(0)->look()->m_foreground);
+      m_cursorLineNo = 3;
+      load(2, 3, 10, this);
+      checkEqu(ReLook::FG_CURRENT_LINE,
+               m_list.at(1)->at(0)->look()->m_foreground);
+      // horizontal scrolling invalidates all paragraphs:
+      m_firstCol = 1;
+      load(2, 3, 10, this);
+      checkEqu("1234", m_list.at(0)->at(0)->text());
+      checkEqu("ine4", m_list.at(2)->at(0)->text());
+      m_firstCol = 0;
+   }
+
+   void checkText(ReParagraph* paragraph, int index, const char* text,
+                  ReLook::ForeGround foreground) {
+      checkT(index < paragraph->length());
+      if (index < paragraph->length()) {
+         checkEqu(text, paragraph->at(index)->text());
+         checkEqu(foreground, paragraph->at(index)->look()->m_foreground);
+      }
+   }
+   void testHighlighter() {
+      ReHighlighter* highlighter = new ReHighlighter(this,
+            ReHighlighter::createLexer("x.mf"));
+      insertBuilder(1, highlighter);
+      highlighter->start();
+      init("if x then\n/* a\nb */ 12\n'str'\nfi");
+      m_firstCol = 0;
+      m_cursorLineNo = 4;
+      // the highlighting is done asynchronously:
+      for (int count = 0; count < 200; count++) {
+         load(0, 4, 80, this);
+         if (m_list.at(3)->at(0)->look()->m_foreground
+               == ReLook::FG_MAGENTA_DARK)
+            break;
+         QThread::msleep(10);
+      }
+      checkText(m_list.at(0), 0, "if", ReLook::FG_BLUE_DARK);
+      checkText(m_list.at(0), 1, " x ", ReLook::FG_STANDARD);
+      checkText(m_list.at(0), 2, "then", ReLook::FG_BLUE_DARK);
+      checkText(m_list.at(1), 0, "/* a", ReLook::FG_GREEN_DARK);
+      checkText(m_list.at(2), 0, "b */", ReLook::FG_GREEN_DARK);
+      checkText(m_list.at(2), 1, " ", ReLook::FG_STANDARD);
+      checkText(m_list.at(2), 2, "12", ReLook::FG_CYAN_DARK);
+      checkText(m_list.at(3), 0, "'str'", ReLook::FG_MAGENTA_DARK);
+      removeBuilder(highlighter);
+      delete highlighter;
+   }
+
    virtual void runTests() {
+      testHighlighter();
+      testLayoutCache();
       testIndexToColumn();
       testDeleteLine();
       testDeleteText();
@@ -349,7 +349,43 @@ public:
       checkEqu("2", lines.lineAt(1));
       checkEqu("", lines.lineAt(2));
    }
+   void checkChange(const ReLineChange& change, int lineNo, int oldCount,
+                    int newCount) {
+      checkEqu(lineNo, change.m_lineNo);
+      checkEqu(oldCount, change.m_oldCount);
+      checkEqu(newCount, change.m_newCount);
+   }
+   void testReLinesChanges() {
+      ReLines lines;
+      QList<ReLineChange> changes;
+      int revision = lines.revision();
+      lines.insertLines(0, "123\nabc\nxyz", false);
+      lines.insertPart(1, 1, "-", false);
+      lines.splitLine(2, 1, false);
+      lines.joinLines(0);
+      lines.removeLines(1, 2, false);
+      checkT(lines.changesSince(revision, changes));
+      checkEqu(5, changes.length());
+      checkChange(changes.at(0), 0, 0, 3);
+      checkChange(changes.at(1), 1, 1, 1);
+      checkChange(changes.at(2), 2, 1, 2);
+      checkChange(changes.at(3), 0, 2, 1);
+      checkChange(changes.at(4), 1, 2, 0);
+      checkEqu(1, lines.lineCount());
+      checkEqu("123a-bc", lines.lineAt(0));
+      revision = lines.revision();
+      checkT(lines.changesSince(revision, changes));
+      checkEqu(0, changes.length());
+      // the history is limited:
+      for (int ix = 0; ix < 100; ix++)
+         lines.insertPart(0, 0, "x", false);
+      checkF(lines.changesSince(revision, changes));
+      checkT(lines.changesSince(lines.revision() - 3, changes));
+      checkEqu(3, changes.length());
+      checkChange(changes.at(2), 0, 1, 1);
+   }
    virtual void runTests() {
+      testReLinesChanges();
       testReLinesInsert();
       testReLinesSplitLine();
       testRelLinesjoinLines();
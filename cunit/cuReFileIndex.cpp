@@ -0,0 +1,262 @@
+/*
+ * cuReFileIndex.cpp
+ *
+ * (Un)License: Public Domain
+ * You can use and modify this file without any restriction.
+ * Do what you want.
+ * No warranties and disclaimer of any damages.
+ * More info: http://unlicense.org
+ * The latest sources: https://github.com/republib
+ */
+
+#include "base/rebase.hpp"
+#include "os/reos.hpp"
+/** @file
+ * @brief Unit test of the persistent file name index.
+ */
+
+/**
+ * Collects the full names of the entries found by a query.
+ */
+class TestCollector: public ReFileIndexVisitor {
+public:
+   virtual bool visit(const QByteArray& path, const char* node,
+                      const ReIndexEntry_t& entry) {
+      QByteArray name(path);
+      name.append(node);
+      m_names.append(name);
+      m_sizes += entry.m_size;
+      return true;
+   }
+public:
+   QList<QByteArray> m_names;
+   int64_t m_sizes;
+};
+
+/**
+ * Gives the tests access to the internal state of the index.
+ */
+class TestIndex: public ReFileIndex {
+public:
+   TestIndex(const QByteArray& base, ReLogger* logger) :
+      ReFileIndex(base, logger) {
+   }
+public:
+   /** Simulates a full watch table of the system. */
+   void forceWatchLimit() {
+      m_watchLimit = true;
+   }
+   /** Sets the parent of a directory slot.
+    * @param dir    the index of the slot
+    * @param parent the new parent
+    */
+   void setParent(int dir, int parent) {
+      m_dirs[dir].m_parent = parent;
+   }
+};
+
+class TestReFileIndex: public ReTest {
+public:
+   TestReFileIndex() :
+      ReTest("ReFileIndex"),
+      m_base() {
+      doIt();
+   }
+private:
+   QByteArray m_base;
+private:
+   void makeDir(const char* relPath) {
+      QByteArray path(m_base);
+      path.append(relPath);
+      _mkdir(ReFileUtils::nativePath(path).constData());
+   }
+   void makeFile(const char* relPath) {
+      QByteArray path(m_base);
+      path.append(relPath);
+      ReFileUtils::writeToFile(ReFileUtils::nativePath(path).constData(),
+                               relPath);
+   }
+   void initTree() {
+      m_base = ReFileUtils::tempDirEmpty("fileindex", "cuReFileIndex");
+      makeFile("1.txt");
+      makeDir("dir1");
+      makeDir("dir2");
+      makeDir("dir1/dir1_1");
+      makeDir("dir1/dir1_2");
+      makeDir("dir1/dir1_2/dir1_2_1");
+      makeDir("dir1/cache");
+      makeFile("dir1/dir1_2/dir1_2_1/x1.txt");
+      makeFile("dir1/dir1_2/dir1_2_1/x2.txt");
+      makeFile("dir2/2.x");
+      makeFile("dir1/cache/cache.txt");
+   }
+   /** Returns the number of entries found by a query.
+    * @param index      the index to search
+    * @param patterns   the node patterns, e.g. "*.txt,-x2*"
+    * @param dirs       NULL or the directory patterns
+    * @param relPath    the start directory relative to the base
+    * @param sizes      NULL or OUT: the sum of the file sizes
+    */
+   int count(ReFileIndex& index, const char* patterns,
+             const char* dirs = NULL, const char* relPath = "",
+             int64_t* sizes = NULL) {
+      ReDirEntryFilter filter;
+      ReIncludeExcludeMatcher nodes(patterns, Qt::CaseSensitive, true);
+      ReIncludeExcludeMatcher dirPatterns(dirs == NULL ? "*" : dirs);
+      filter.m_nodePatterns = &nodes;
+      filter.m_pathPatterns = dirs == NULL ? NULL : &dirPatterns;
+      filter.m_types = ReDirStatus_t::TF_REGULAR;
+      TestCollector collector;
+      collector.m_sizes = 0;
+      QByteArray path(m_base);
+      path.append(relPath);
+      int rc = index.query(ReFileUtils::nativePath(path), filter, collector);
+      checkEqu(rc < 0 ? 0 : rc, collector.m_names.size());
+      if (sizes != NULL)
+         *sizes = collector.m_sizes;
+      return rc;
+   }
+   void testQuery() {
+      ReFileIndex index(m_base, &m_logger);
+      // the base + dir1 dir2 dir1_1 dir1_2 dir1_2_1 cache
+      checkEqu(7, index.refresh());
+      // 1.txt dir1 dir2 dir1_1 dir1_2 cache dir1_2_1 x1.txt x2.txt 2.x cache.txt
+      checkEqu(11, index.entries());
+      int64_t sizes = 0;
+      checkEqu(4, count(index, "*.txt", NULL, "", &sizes));
+      // the content of a file is its relative path:
+      checkEqu((int64_t)(5 + 27 + 27 + 20), sizes);
+      checkEqu(3, count(index, "*.txt", "*,-cache"));
+      checkEqu(2, count(index, "x*", NULL, "dir1"));
+      checkEqu(1, count(index, "*.txt,-x2*", NULL, "dir1/dir1_2"));
+      checkEqu(1, count(index, "2.x"));
+      checkEqu(0, count(index, "nothing*"));
+      checkEqu(-1, count(index, "*", NULL, "dir3"));
+
+      ReDirEntryFilter filter;
+      filter.m_minDepth = 1;
+      filter.m_maxDepth = 1;
+      TestCollector collector;
+      // dir1_1 dir1_2 cache 2.x
+      checkEqu(4, index.query(m_base, filter, collector));
+   }
+   void testPersistence() {
+      QByteArray filename = ReFileUtils::tempFile("test.reindex",
+                            "cuReFileIndex");
+      ReFileIndex index(m_base, &m_logger);
+      index.refresh();
+      checkT(index.isDirty());
+      checkT(index.save(filename));
+      checkF(index.isDirty());
+      QByteArray base(m_base);
+      base.chop(1);
+      checkEqu(base, ReFileIndex::baseOf(filename));
+
+      ReFileIndex index2(m_base, &m_logger);
+      checkT(index2.load(filename));
+      checkEqu(11, index2.entries());
+      checkEqu(4, count(index2, "*.txt"));
+      // the tree is too young to be trusted: all directories are read again
+      checkEqu(7, index2.refresh());
+      makeFile("dir2/new.txt");
+      checkT(index2.refresh() >= 1);
+      checkEqu(5, count(index2, "*.txt"));
+      ReFileIndex index3(m_base, &m_logger);
+      checkF(index3.load(m_base + "1.txt"));
+      unlink(filename.constData());
+      QByteArray path(m_base);
+      path.append("dir2/new.txt");
+      unlink(path.constData());
+   }
+   void testWatching() {
+#if defined __linux__
+      ReFileIndex index(m_base, &m_logger);
+      checkT(index.startWatching());
+      index.refresh();
+      checkEqu(4, count(index, "*.txt"));
+      makeDir("dir2/sub");
+      makeFile("dir2/sub/watched.txt");
+      makeFile("dir2/watched2.txt");
+      checkT(index.processEvents() > 0);
+      checkEqu(6, count(index, "*.txt"));
+      QByteArray path(m_base);
+      path.append("dir2/watched2.txt");
+      unlink(path.constData());
+      checkT(index.processEvents() > 0);
+      checkEqu(5, count(index, "*.txt"));
+      ReFileUtils::deleteTree(m_base + "dir2/sub", true, NULL);
+      index.processEvents();
+      checkEqu(4, count(index, "*.txt"));
+      checkF(index.contains(m_base + "dir2/sub"));
+      index.stopWatching();
+#endif
+   }
+   void testWatchLimit() {
+#if defined __linux__
+      TestIndex index(m_base, &m_logger);
+      // not watching:
+      checkT(index.needsPolling());
+      checkT(index.startWatching());
+      checkF(index.needsPolling());
+      index.forceWatchLimit();
+      checkT(index.needsPolling());
+      // no directory gets a watch:
+      index.refresh();
+      checkEqu(4, count(index, "*.txt"));
+      makeDir("dir2/unwatched");
+      makeFile("dir2/unwatched/unwatched.txt");
+      checkEqu(0, index.processEvents());
+      checkEqu(4, count(index, "*.txt"));
+      // found by polling:
+      checkT(index.refresh() >= 2);
+      checkEqu(5, count(index, "*.txt"));
+      ReFileUtils::deleteTree(m_base + "dir2/unwatched", true, NULL);
+      index.stopWatching();
+#endif
+   }
+   void testStop() {
+      ReFileIndex index(m_base, &m_logger);
+      QAtomicInt stop(1);
+      checkEqu(0, index.refresh(&stop));
+      checkEqu(0, index.entries());
+      stop.store(0);
+      checkEqu(7, index.refresh(&stop));
+   }
+   void testInvalidParent() {
+      QByteArray filename = ReFileUtils::tempFile("parent.reindex",
+                            "cuReFileIndex");
+      TestIndex index(m_base, &m_logger);
+      index.refresh();
+      checkT(index.save(filename));
+      ReFileIndex index2(m_base, &m_logger);
+      checkT(index2.load(filename));
+      // a cycle: the parent behind the child
+      index.setParent(1, 2);
+      checkT(index.save(filename));
+      checkF(index2.load(filename));
+      // the old content is kept:
+      checkEqu(11, index2.entries());
+      // out of range:
+      index.setParent(1, 1000);
+      checkT(index.save(filename));
+      checkF(index2.load(filename));
+      index.setParent(1, 0);
+      checkT(index.save(filename));
+      checkT(index2.load(filename));
+      unlink(filename.constData());
+   }
+public:
+   virtual void runTests() {
+      initTree();
+      testQuery();
+      testPersistence();
+      testWatching();
+      testWatchLimit();
+      testStop();
+      testInvalidParent();
+      ReFileUtils::deleteTree(m_base, true, NULL);
+   }
+};
+void testReFileIndex() {
+   TestReFileIndex test;
+}
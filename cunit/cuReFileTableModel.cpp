@@ -0,0 +1,189 @@
+/*
+ * cuReFileTableModel.cpp
+ *
+ * (Un)License: Public Domain
+ * You can use and modify this file without any restriction.
+ * Do what you want.
+ * No warranties and disclaimer of any damages.
+ * More info: http://unlicense.org
+ * The latest sources: https://github.com/republib
+ */
+#include "base/rebase.hpp"
+#include "gui/regui.hpp"
+/** @file
+ * @brief Unit test of the file table model.
+ */
+
+class TestReFileTableModel: public ReTest {
+public:
+   TestReFileTableModel(bool benchmark = false) :
+      ReTest("ReFileTableModel"),
+      m_benchmark(benchmark) {
+      doIt();
+   }
+private:
+   /// true: only the benchmark is done
+   bool m_benchmark;
+protected:
+   ReFileTableModel* buildModel() {
+      QList<ReFileTableModel::Column> columns;
+      columns << ReFileTableModel::COL_NODE << ReFileTableModel::COL_EXT
+              << ReFileTableModel::COL_SIZE << ReFileTableModel::COL_TYPE
+              << ReFileTableModel::COL_PATH << ReFileTableModel::COL_EXT_OR_DIR;
+      return new ReFileTableModel(columns);
+   }
+   void testStore() {
+      ReFileResultStore store;
+      store.add("abc.txt", "/tmp", 20, 1000, ReFileResultStore::FT_FILE);
+      store.add("sub", "/tmp", 0, 2000, ReFileResultStore::FT_DIR);
+      store.add("x\xc3\xa4.cpp", "/usr", 30, 3000, ReFileResultStore::FT_LINK_FILE);
+      checkEqu(3, store.count());
+      checkEqu(2, store.paths().size());
+      checkEqu("abc.txt", store.node(0));
+      checkEqu("/usr", store.path(2));
+      checkEqu(QString::fromUtf8("x\xc3\xa4.cpp"), store.node(2));
+      checkT(store.isDir(1));
+      checkF(store.isDir(2));
+      checkEqu((int64_t) 30, store.size(2));
+      checkEqu((int64_t) 2000, store.modified(1));
+      ReFileResultStore store2;
+      store2.add("new.txt", "/usr", 40, 4000, ReFileResultStore::FT_FILE);
+      store2.add("y", "/var", 50, 5000, ReFileResultStore::FT_FILE);
+      store.append(store2);
+      checkEqu(5, store.count());
+      checkEqu(3, store.paths().size());
+      checkEqu("new.txt", store.node(3));
+      checkEqu("/usr", store.path(3));
+      checkEqu("/var", store.path(4));
+      checkEqu(store.pathIndex(2), store.pathIndex(3));
+      store.clear();
+      checkEqu(0, store.count());
+      checkEqu(0, store.paths().size());
+   }
+   void testFormat() {
+      ReFileTableModel* model = buildModel();
+      model->add("Abc.TXT", "/tmp", 1234, 0, ReFileResultStore::FT_FILE);
+      model->add("dir", "/tmp", 4096, 0, ReFileResultStore::FT_DIR);
+      checkEqu(0, model->rowCount());
+      checkEqu(2, model->flushPending());
+      checkEqu(0, model->flushPending());
+      checkEqu(2, model->rowCount());
+      checkEqu(6, model->columnCount());
+      checkEqu("Abc.TXT", model->cellText(0, 0));
+      checkEqu("txt", model->cellText(0, 1));
+      checkEqu("1234", model->cellText(0, 2));
+      checkEqu("file", model->cellText(0, 3));
+      checkEqu("/tmp", model->cellText(0, 4));
+      checkEqu(".TXT", model->cellText(0, 5));
+      checkEqu("", model->cellText(1, 2));
+      checkEqu("dir", model->cellText(1, 3));
+      checkEqu("<dir>", model->cellText(1, 5));
+      checkEqu("", model->cellText(2, 0));
+      checkEqu("", model->cellText(0, 6));
+      checkEqu("Abc.TXT", model->data(model->index(0, 0)).toString());
+      model->clear();
+      checkEqu(0, model->rowCount());
+      // pending rows are discarded too:
+      model->add("x.txt", "/tmp", 1, 0, ReFileResultStore::FT_FILE);
+      model->clear();
+      checkEqu(0, model->flushPending());
+      checkEqu(0, model->rowCount());
+      delete model;
+   }
+   void testSort() {
+      ReFileTableModel* model = buildModel();
+      ReFileResultStore store;
+      store.add("b.c", "/z", 3, 0, ReFileResultStore::FT_FILE);
+      store.add("a.B", "/y", 1, 0, ReFileResultStore::FT_FILE);
+      store.add("d", "/x", 0, 0, ReFileResultStore::FT_DIR);
+      store.add("c.a", "/z", 2, 0, ReFileResultStore::FT_FILE);
+      model->setStore(store);
+      model->sort(0, Qt::AscendingOrder);
+      checkEqu("a.B", model->cellText(0, 0));
+      checkEqu("b.c", model->cellText(1, 0));
+      checkEqu("c.a", model->cellText(2, 0));
+      checkEqu("d", model->cellText(3, 0));
+      // the extension ignoring case:
+      model->sort(1, Qt::AscendingOrder);
+      checkEqu("d", model->cellText(0, 0));
+      checkEqu("c.a", model->cellText(1, 0));
+      checkEqu("a.B", model->cellText(2, 0));
+      checkEqu("b.c", model->cellText(3, 0));
+      // the directories are the smallest:
+      model->sort(2, Qt::DescendingOrder);
+      checkEqu("b.c", model->cellText(0, 0));
+      checkEqu("c.a", model->cellText(1, 0));
+      checkEqu("a.B", model->cellText(2, 0));
+      checkEqu("d", model->cellText(3, 0));
+      // stable: same path keeps the order of the size sort:
+      model->sort(4, Qt::AscendingOrder);
+      checkEqu("d", model->cellText(0, 0));
+      checkEqu("a.B", model->cellText(1, 0));
+      checkEqu("b.c", model->cellText(2, 0));
+      checkEqu("c.a", model->cellText(3, 0));
+      checkEqu(3, model->record(2) + model->record(3));
+      delete model;
+   }
+   /**
+    * Puts records with short names into a store.
+    *
+    * @param store  OUT: the store to fill
+    * @param count  the number of records
+    */
+   void fillStore(ReFileResultStore& store, int count) {
+      char buffer[64];
+      for (int ix = 0; ix < count; ix++) {
+         qsnprintf(buffer, sizeof buffer, "file%d.txt", ix * 7919 % count);
+         store.add(buffer, QString("/home/user/dir%1").arg(ix / 1000), ix,
+                   ix * 1000LL, ReFileResultStore::FT_FILE);
+      }
+   }
+   void testMemory() {
+      const int count = 10 * 1000;
+      ReFileResultStore store;
+      fillStore(store, count);
+      checkEqu(count, store.count());
+      checkEqu(10, store.paths().size());
+      checkEqu("file7919.txt", store.node(1));
+      checkEqu("/home/user/dir9", store.path(count - 1));
+      // the columns are stored without an object per record:
+      checkT(store.memoryUsage() / count < 100);
+   }
+   void benchmark(int count) {
+      clock_t start = clock();
+      ReFileResultStore store;
+      fillStore(store, count);
+      clock_t middle = clock();
+      ReFileTableModel* model = buildModel();
+      model->setStore(store);
+      model->sort(0, Qt::AscendingOrder);
+      clock_t end = clock();
+      checkEqu("file0.txt", model->cellText(0, 0));
+      size_t perRecord = store.memoryUsage() / count;
+      checkT(perRecord < 100);
+      log(QByteArray("records: ").append(QByteArray::number(count))
+          .append(" bytes/record: ").append(QByteArray::number(int(perRecord)))
+          .append(" add: ").append(QByteArray::number(double(middle - start)
+                / CLOCKS_PER_SEC)).append(" sec sort: ")
+          .append(QByteArray::number(double(end - middle) / CLOCKS_PER_SEC))
+          .append(" sec").constData());
+      delete model;
+   }
+public:
+   virtual void runTests(void) {
+      if (m_benchmark)
+         benchmark(1000 * 1000);
+      else {
+         testStore();
+         testFormat();
+         testSort();
+         testMemory();
+      }
+   }
+};
+void testReFileTableModel() {
+   TestReFileTableModel test;
+}
+void benchmarkReFileTableModel() {
+   TestReFileTableModel test(true);
+}
@@ -268,7 +268,50 @@ public:
       checkEqu(lex.prioOfOp(O_TIMES), lex.prioOfOp(O_DIV));
    }
 
+   void checkSpan(const ReTokenSpan& span, RplTokenType type, int start,
+                  int length) {
+      checkEqu(type, span.m_type);
+      checkEqu(start, span.m_start);
+      checkEqu(length, span.m_length);
+   }
+   void testScanLine() {
+      enum {
+         COMMENT_UNDEF,
+         COMMENT_MULTILINE,
+         COMMENT_1
+      };
+      // line mode: no source
+      ReLexer lex(NULL, KEYWORDS, OPERATORS, "=", COMMENTS, "A-Za-z_",
+                  "A-Za-z0-9_", ReLexer::NUMTYPE_ALL, ReLexer::SF_LIKE_C);
+      QVector<ReTokenSpan> spans;
+      checkEqu(0, lex.scanLine("if x>12 then 'a' // c", 0, spans));
+      checkEqu(7, spans.size());
+      checkSpan(spans.at(0), TOKEN_KEYWORD, 0, 2);
+      checkSpan(spans.at(1), TOKEN_ID, 3, 1);
+      checkSpan(spans.at(2), TOKEN_OPERATOR, 4, 1);
+      checkSpan(spans.at(3), TOKEN_NUMBER, 5, 2);
+      checkSpan(spans.at(4), TOKEN_KEYWORD, 8, 4);
+      checkSpan(spans.at(5), TOKEN_STRING, 13, 3);
+      checkSpan(spans.at(6), TOKEN_COMMENT_START, 17, 4);
+      // a multi line comment:
+      checkEqu(COMMENT_MULTILINE, lex.scanLine("fi /* a", 0, spans));
+      checkEqu(2, spans.size());
+      checkSpan(spans.at(1), TOKEN_COMMENT_START, 3, 4);
+      checkEqu(COMMENT_MULTILINE, lex.scanLine("b", COMMENT_MULTILINE, spans));
+      checkEqu(1, spans.size());
+      checkSpan(spans.at(0), TOKEN_COMMENT_START, 0, 1);
+      checkEqu(0, lex.scanLine("c */ else", COMMENT_MULTILINE, spans));
+      checkEqu(2, spans.size());
+      checkSpan(spans.at(0), TOKEN_COMMENT_START, 0, 4);
+      checkSpan(spans.at(1), TOKEN_KEYWORD, 5, 4);
+      // a lexical error is no exception:
+      checkEqu(0, lex.scanLine("x $$ y", 0, spans));
+      checkEqu(2, spans.size());
+      checkSpan(spans.at(1), TOKEN_UNDEF, 2, 4);
+   }
+
    virtual void runTests(void) {
+      testScanLine();
       testPrio();
       testBasic();
       testIds();
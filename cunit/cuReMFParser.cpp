@@ -206,7 +206,65 @@ public:
       checkAST("main1.txt", __LINE__);
    }
 
-   virtual void run(void) {
+   void incrementalTest() {
+      ReASTree tree;
+      ReMFIncrementalParser parser(tree, "<inc>");
+      QStringList lines;
+      lines << "Int a = 1;"
+            << "func Int inc(Int x):"
+            << "x + 1"
+            << "endf"
+            << "func Int dec(Int x):"
+            << "x - 1"
+            << "endf"
+            << "a = dec(inc(a));";
+      parser.update(lines);
+      checkEqu(4, parser.regions().size());
+      checkEqu(4, parser.parsedRegions());
+      checkEqu(0, parser.messages().size());
+      ReSymbolSpace* module = tree.findmodule("<inc>");
+      checkNN(module);
+      checkNN(module->body());
+      // a change inside a method: only the method is parsed again
+      lines[5] = "x - 2";
+      parser.update(lines);
+      checkEqu(1, parser.parsedRegions());
+      checkEqu(0, parser.messages().size());
+      checkNN(module->findMethod("inc"));
+      checkNN(module->findMethod("dec"));
+      checkT(module->findMethod("dec")->sibling() == NULL);
+      checkEqu(1, parser.retiredMethods());
+      // the line numbers are counted from the start of the module:
+      lines[5] = "x -";
+      parser.update(lines);
+      checkEqu(1, parser.parsedRegions());
+      checkT(parser.messages().size() > 0);
+      QByteArray message = parser.messages().at(0);
+      // the error is found at "endf" in line 7:
+      checkT(message.indexOf("<inc>:7-") > 0);
+      lines[5] = "x - 1";
+      parser.update(lines);
+      checkEqu(0, parser.messages().size());
+      // the following regions are moved only:
+      lines.insert(3, "+ 0");
+      parser.update(lines);
+      checkEqu(1, parser.parsedRegions());
+      checkEqu(6, module->findMethod("dec")->position()->lineNo());
+      // the methods retired by the former updates are freed:
+      checkEqu(1, parser.retiredMethods());
+      parser.freeRetired();
+      checkEqu(0, parser.retiredMethods());
+      // a changed statement: all regions are parsed again
+      lines[0] = "Int a = 2;";
+      parser.update(lines);
+      checkEqu(4, parser.parsedRegions());
+      module = tree.findmodule("<inc>");
+      checkNN(module);
+      checkEqu(6, module->findMethod("dec")->position()->lineNo());
+   }
+
+   virtual void runTests(void) {
+      incrementalTest();
       mainTest();
       varDefTest();
       repeatTest();
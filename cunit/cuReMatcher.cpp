@@ -16,10 +16,14 @@
 
 class TestReMatcher: public ReTest {
 public:
-   TestReMatcher() :
-      ReTest("ReMatcher") {
+   TestReMatcher(bool benchmark = false) :
+      ReTest("ReMatcher"),
+      m_benchmark(benchmark) {
       doIt();
    }
+private:
+   /// true: only the benchmark is done
+   bool m_benchmark;
 
 public:
    void testBasics() {
@@ -148,14 +152,99 @@ public:
       checkT(matcher2.matches("abc"));
    }
 
+   void testListCompiled() {
+      QStringList patterns;
+      patterns << "abc" << "x*y*z" << "*.tar.gz" << "pre*";
+      ReListMatcher matcher(patterns, Qt::CaseSensitive, true);
+      checkT(matcher.matches("abc"));
+      checkF(matcher.matches("abcabc"));
+      checkT(matcher.matches("x12y34z"));
+      checkF(matcher.matches("xzy"));
+      checkT(matcher.matches("a.tar.gz"));
+      checkF(matcher.matches("a.tar.gzz"));
+      checkT(matcher.matches("prefix"));
+      checkF(matcher.matches("apre"));
+      patterns.clear();
+      patterns << "abc" << "a*a" << "he*lo";
+      matcher.setPatterns(patterns, Qt::CaseInsensitive, false);
+      checkT(matcher.matches("xxABcxx"));
+      checkF(matcher.matches("A"));
+      checkT(matcher.matches("aBa"));
+      checkT(matcher.matches("_HeLLo_"));
+      checkF(matcher.matches("olhe"));
+      checkT(matcher.matches(QString::fromUtf8("\xc3\x96HELLO")));
+      QStringList excludes;
+      excludes << "*.bak";
+      ReIncludeExcludeMatcher matcher2(ReListMatcher::allMatchingList(),
+                                       excludes, Qt::CaseInsensitive, true);
+      checkT(matcher2.matches("x.txt", 5));
+      checkF(matcher2.matches("x.BAK", 5));
+      checkT(matcher2.matches("x.BAK", 5, false));
+   }
+   void benchmark() {
+      QStringList patterns;
+      patterns << "*.cpp" << "*.hpp" << "*.c" << "*.h" << "*.java" << "*.py"
+               << "*.txt" << "makefile" << "*.pro" << "*.ui" << "test*.dat"
+               << "*.o" << "*.so" << "*.tar.gz" << "*old*";
+      QStringList names;
+      QList<QByteArray> names2;
+      const char* extensions[] = { ".cpp", ".bak", ".png", ".log", ".h" };
+      for (int ix = 0; ix < 1000; ix++) {
+         QString name = QString("file_%1_name%2").arg(ix).arg(
+                           extensions[ix % (sizeof extensions / sizeof extensions[0])]);
+         names.append(name);
+         names2.append(name.toUtf8());
+      }
+      QList<ReMatcher*> list;
+      for (int ix = 0; ix < patterns.size(); ix++)
+         list.append(new ReMatcher(patterns.at(ix), Qt::CaseInsensitive, true));
+      ReListMatcher matcher(patterns, Qt::CaseInsensitive, true);
+      int loops = 200;
+      int hits = 0;
+      clock_t start = clock();
+      for (int loop = 0; loop < loops; loop++) {
+         for (int ix = 0; ix < names.size(); ix++) {
+            for (int ix2 = 0; ix2 < list.size(); ix2++) {
+               if (list.at(ix2)->matches(names.at(ix))) {
+                  hits++;
+                  break;
+               }
+            }
+         }
+      }
+      double duration = double(clock() - start) / CLOCKS_PER_SEC;
+      int hits2 = 0;
+      start = clock();
+      for (int loop = 0; loop < loops; loop++) {
+         for (int ix = 0; ix < names2.size(); ix++) {
+            const QByteArray& name = names2.at(ix);
+            if (matcher.matches(name.constData(), name.length()))
+               hits2++;
+         }
+      }
+      double duration2 = double(clock() - start) / CLOCKS_PER_SEC;
+      checkEqu(hits, hits2);
+      printf("matching %d names with %d patterns: list of ReMatcher: %.3f sec"
+             " compiled: %.3f sec\n", loops * names.size(), patterns.size(),
+             duration, duration2);
+      qDeleteAll(list);
+   }
    virtual void runTests(void) {
-      testBasics();
-      test0Star();
-      test1Star();
-      testList();
+      if (m_benchmark)
+         benchmark();
+      else {
+         testListCompiled();
+         testBasics();
+         test0Star();
+         test1Star();
+         testList();
+      }
    }
 };
 void testReMatcher() {
    TestReMatcher test;
 }
+void benchmarkReMatcher() {
+   TestReMatcher test(true);
+}
 
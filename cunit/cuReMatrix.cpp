@@ -281,6 +281,75 @@ public:
       }
       checkEqu(73 * 35, count);
    }
+   void checkProduct(int rows, int inner, int cols) {
+      RplMatrix m1(rows, inner, "m1");
+      RplMatrix m2(inner, cols, "m2");
+      fillMatrix(m1);
+      fillMatrix(m2, -50);
+      RplMatrix m3(m1 * m2);
+      checkEqu(rows, m3.getRows());
+      checkEqu(cols, m3.getCols());
+      // integral values: the result is exact
+      for (int row = 0; row < rows; row++) {
+         for (int col = 0; col < cols; col++) {
+            MatVal sum = 0;
+            for (int ix = 0; ix < inner; ix++)
+               sum += m1.get(row, ix) * m2.get(ix, col);
+            if (sum != m3.get(row, col)) {
+               checkEqu(sum, m3.get(row, col));
+               return;
+            }
+         }
+      }
+   }
+   void testMultiply() {
+      RplMatrix m1(2, 3, "m1");
+      RplMatrix m2(3, 2, "m2");
+      MatVal values1[] = { 1, 2, 3, 4, 5, 6 };
+      MatVal values2[] = { 7, 8, 9, 10, 11, 12 };
+      m1.resize(2, 3, values1);
+      m2.resize(3, 2, values2);
+      RplMatrix m3(m1 * m2);
+      checkEqu(2, m3.getRows());
+      checkEqu(2, m3.getCols());
+      checkEqu(58.0, m3.get(0, 0));
+      checkEqu(64.0, m3.get(0, 1));
+      checkEqu(139.0, m3.get(1, 0));
+      checkEqu(154.0, m3.get(1, 1));
+      try {
+         RplMatrix m4(m1 * m1);
+         checkT(false);
+      } catch (RplMatrixException exc) {
+         checkEqu("m1: m1 has a wrong row count: 2 instead of 3",
+                  exc.getMessage());
+      }
+      // not multiples of the block size:
+      checkProduct(130, 70, 67);
+      // large enough for the thread pool:
+      checkProduct(200, 150, 170);
+   }
+   void testFusedOperations() {
+      RplMatrix m1(3, 4, "m1");
+      RplMatrix m2(3, 4, "m2");
+      fillMatrix(m1);
+      fillConst(m2, 2.0);
+      m1.addScaled(m2, -0.5);
+      checkMatrix(m1, -1);
+      m1.scaleAndShift(2.0, 2.0);
+      m1 *= 0.5;
+      checkMatrix(m1);
+      RplMatrix m3(m1 * 3.0);
+      checkEqu(3.0 * 201, m3.get(2, 1));
+   }
+   void testRow() {
+      RplMatrix m1(3, 4, "m1");
+      fillMatrix(m1);
+      const MatVal* row = m1.row(2);
+      checkEqu(200.0, row[0]);
+      checkEqu(203.0, row[3]);
+      m1.row(1)[2] = -1.0;
+      checkEqu(-1.0, m1.get(1, 2));
+   }
    void testToString() {
       RplMatrix m1(1, 1, "m1");
       m1.set(0, 0, 2.34);
@@ -305,7 +374,7 @@ public:
                 "element2,7,-22.3,44\n"
                 "\n"
                 "2 Elements, 3, Ports";
-      ReStringUtil::write(fn, content);
+      ReStringUtils::write(fn, content);
       m1.readFromCvs(fn, 256);
       checkEqu(2, m1.getRows());
       checkEqu(3, m1.getCols());
@@ -318,7 +387,7 @@ public:
       fillMatrix(m1);
       content = "Port0,Port1,Port2\n"
                 "5,  -3E-99  , 0.5\n";
-      ReStringUtil::write(fn, content);
+      ReStringUtils::write(fn, content);
       m1.readFromCvs(fn, 256);
       checkEqu(1, m1.getRows());
       checkEqu(3, m1.getCols());
@@ -332,7 +401,7 @@ public:
        int maxLineLength = 1024*1024);
        */
    }
-   virtual void run(void) {
+   virtual void runTests(void) {
       testBasic();
       testAddOperators();
       testCompareOperators();
@@ -342,10 +411,13 @@ public:
       testResize();
       testMinMax();
       testTranspose();
+      testMultiply();
+      testFusedOperations();
+      testRow();
       testToString();
       testReadCsv();
    }
 };
-void testRplMatrix() {
+void testReMatrix() {
    TestRplMatrix test;
 }
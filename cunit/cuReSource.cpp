@@ -97,9 +97,79 @@ protected:
       checkF(hasMore);
    }
 
+   void testPositionTable() {
+      ReStringReader reader(m_source);
+      ReStringSourceUnit unit1("unit1", "", &reader);
+      ReStringSourceUnit unit2("unit2", "", &reader);
+      ReSourcePositionTable table;
+      QVector<ReSourcePositionHandle> handles;
+      int lineNo = 1;
+      int column = 0;
+      for (int ix = 0; ix < 10000; ix++) {
+         if (ix % 7 == 0) {
+            lineNo += ix % 13 == 0 ? 1000 : 1;
+            column = ix % 5;
+         } else
+            column += 1 + ix % 9;
+         ReSourceUnit* unit = ix < 5000 ? &unit1 : &unit2;
+         handles.append(table.add(unit, lineNo, column, NULL));
+      }
+      checkEqu(10000, table.count());
+      // 32 bytes per entry in the old position blocks:
+      checkT(table.encodedSize() < 10000 * 3);
+      lineNo = 1;
+      for (int ix = 0; ix < 10000; ix++) {
+         if (ix % 7 == 0) {
+            lineNo += ix % 13 == 0 ? 1000 : 1;
+            column = ix % 5;
+         } else
+            column += 1 + ix % 9;
+         const ReSourcePosition* position = ReSourcePositionTable::find(
+                                               handles[ix]);
+         checkNN(position);
+         checkEqu(lineNo, position->lineNo());
+         checkEqu(column, position->column());
+         checkT(handles[ix] == position->handle());
+         checkEqu(ix < 5000 ? "unit1" : "unit2",
+                  position->sourceUnit()->name());
+      }
+      checkT(table.position(handles[1]) == ReSourcePositionTable::find(
+                handles[1]));
+      checkT(ReSourcePositionTable::find(0) == NULL);
+      table.clear();
+      checkT(ReSourcePositionTable::find(handles[1]) == NULL);
+      // a new table does not get the handles of the cleared chunks:
+      ReSourcePositionTable table2;
+      ReSourcePositionHandle handle = table2.add(&unit1, 1, 0, NULL);
+      checkNN(ReSourcePositionTable::find(handle));
+      checkT(ReSourcePositionTable::find(handles[0]) == NULL);
+      checkT(ReSourcePositionTable::find(handles[9999]) == NULL);
+      checkT(table2.position(handles[0]) == NULL);
+   }
+   void testManyPositionTables() {
+      ReStringReader reader(m_source);
+      ReStringSourceUnit unit("unit", "", &reader);
+      // more tables than chunk numbers: the numbers must be reused
+      int count = 2 * ReSourcePositionTable::MAX_CHUNKS;
+      ReSourcePositionHandle previous = 0;
+      for (int ix = 0; ix < count; ix++) {
+         ReSourcePositionTable* table = new ReSourcePositionTable();
+         ReSourcePositionHandle handle = table->add(&unit, ix, 1, NULL);
+         checkEqu(ix, ReSourcePositionTable::find(handle)->lineNo());
+         // the slot of the previous table is reused with another generation:
+         checkT(handle != previous);
+         checkT(ReSourcePositionTable::find(previous) == NULL);
+         previous = handle;
+         delete table;
+      }
+      checkT(ReSourcePositionTable::find(previous) == NULL);
+   }
+
 public:
-   void run(void) {
+   virtual void runTests(void) {
       init();
+      testPositionTable();
+      testManyPositionTables();
       testReStringSourceUnit();
       testReStringReader();
    }
@@ -11,48 +11,33 @@
 
 #include "base/rebase.hpp"
 #include "os/reos.hpp"
+/** @file
+ * @brief Unit test of the directory tree traverser.
+ */
 
-class TestReTraverser: public ReTestUnit {
+class TestReTraverser: public ReTest {
 public:
    TestReTraverser() :
-      ReTestUnit("ReTraverser", __FILE__),
-      m_base(),
-      m_buffer(),
-      m_logger(ReLogger::globalLogger()) {
-      m_base = testDir();
-      m_base.append("traverser");
-      _mkdir(m_base.str(), ALLPERMS);
-      m_base.append(OS_SEPARATOR, -1);
-      run();
-      ReDirectory::deleteTree(m_base.str(), true);
+      ReTest("ReTraverser"),
+      m_base() {
+      doIt();
    }
 private:
-   ReByteBuffer m_base;
-   ReByteBuffer m_buffer;
-   ReLogger* m_logger;
+   QByteArray m_base;
 private:
-   const char* makeDir(const char* relPath) {
-      m_buffer = m_base;
-      m_buffer.append(relPath);
-      m_buffer.replaceAll("/", 1, OS_SEPARATOR, -1);
-      _mkdir(m_buffer.str(), ALLPERMS);
-      struct stat info;
-      if (stat(m_buffer.str(), &info) != 0) {
-         logF(true, "cannot create dir %1$s", m_buffer.str());
-      }
-      return m_buffer.str();
+   void makeDir(const char* relPath) {
+      QByteArray path(m_base);
+      path.append(relPath);
+      _mkdir(ReFileUtils::nativePath(path).constData());
    }
    void makeFile(const char* relPath) {
-      ReByteBuffer path(m_base);
-      path.append("/").append(relPath);
-      path.replaceAll("/", 1, OS_SEPARATOR, -1);
-      createFile(path.str(), relPath);
-      struct stat info;
-      if (stat(path.str(), &info) != 0) {
-         logF(true, "cannot create file %1$s", path.str());
-      }
+      QByteArray path(m_base);
+      path.append(relPath);
+      ReFileUtils::writeToFile(ReFileUtils::nativePath(path).constData(),
+                               relPath);
    }
    void initTree() {
+      m_base = ReFileUtils::tempDirEmpty("traverser", "cuReTraverser");
       makeFile("1.txt");
       makeDir("dir1");
       makeDir("dir2");
@@ -65,89 +50,90 @@ private:
       makeFile("dir2/2.x");
       makeFile("dir1/cache/cache.txt");
    }
-   void run() {
-      testFilter();
-      initTree();
-      testBasic();
-      testList();
-   }
-   void testFilter() {
-      ReDirEntryFilter filter;
-   }
-   void testList() {
-      const char* argv[] = { "list", m_base.str(), NULL };
-      ReDirList(m_logger).run(2, argv);
-   }
-   void testCopyFile() {
-#if defined __linux__
-      ReByteBuffer src(m_base);
-      src.append("dir1/dir1_2/dir1_2_1/x1.txt");
-      ReByteBuffer trg(testDir());
-      trg.append("copy_x1.txt");
-      ReByteBuffer buffer;
-      buffer.ensureSize(5);
-      ReDirSync::copyFile(src.str(), NULL, trg.str(), buffer,
-                          ReLogger::globalLogger());
-      checkFileEqu(src.str(), trg.str());
-#else
-      log(false, "testCopyFile not implemented");
-#endif
-   }
-
-   void checkRelDate(time_t absTime, int relTime) {
-      int diff = int(time(NULL) - relTime - absTime);
-      if (diff < 0)
-         diff = -diff;
-      checkT(diff < 2);
-   }
-
    void checkOneFile(const char* node, const char* parent,
-                     const ReHashList& hash) {
-      ReByteBuffer path, expected;
-      checkT(hash.get(ReByteBuffer(node), path));
-      expected.set(parent, -1);
-      if (!expected.endsWith(OS_SEPARATOR))
-         expected.append(OS_SEPARATOR);
-      if (!path.endsWith(expected.str(), -1))
-         checkT(false);
+                     const QMap<QByteArray, QByteArray>& paths) {
+      checkT(paths.contains(node));
+      QByteArray expected(parent);
+      expected.append(OS_SEPARATOR);
+      checkT(paths.value(node).endsWith(expected));
    }
-   void testBasic() {
-      ReTraverser traverser(m_base.str());
-      RePatternList patterns;
+   void testBasic(bool depthFirst) {
+      ReTraverser traverser(m_base.constData());
+      traverser.setDepthFirst(depthFirst);
       // exclude */cache/*
-      ReByteBuffer buffer(";*;-cache");
-      patterns.set(buffer.str());
+      ReIncludeExcludeMatcher patterns("*,-cache");
       traverser.setDirPattern(&patterns);
       int level = 0;
       ReDirStatus_t* entry;
-      ReHashList hashPath;
-      ReSeqArray listChanged;
+      QMap<QByteArray, QByteArray> paths;
+      QMap<QByteArray, int> levels;
+      QList<QByteArray> changed;
       int state = 0;
       while ((entry = traverser.rawNextFile(level)) != NULL) {
-         const char* node = entry->node();
-         hashPath.put(ReByteBuffer(node, -1), entry->m_path);
+         QByteArray node(entry->node());
+         checkF(paths.contains(node));
+         paths.insert(node, entry->m_path);
+         levels.insert(node, level);
          if (traverser.hasChangedPath(state))
-            listChanged.add(-1, node);
-         logF(false, "%d: %-12s %2d %s", level, node, int(entry->fileSize()),
-              entry->m_path.str());
+            changed.append(node);
       }
-      checkOneFile("x1.txt", "dir1_2_1", hashPath);
-      checkOneFile("x2.txt", "dir1_2_1", hashPath);
-      bool changed1 = listChanged.find("x1.txt") != (ReSeqArray::Index) - 1;
-      bool changed2 = listChanged.find("x2.txt") != (ReSeqArray::Index) - 1;
-      checkT(changed1 != changed2);
-      checkOneFile("dir1_2_1", "dir1_2", hashPath);
-      checkT(listChanged.find("dir1_2_1") >= 0);
-      checkOneFile("dir1_1", "dir1", hashPath);
-      checkOneFile("dir1_2", "dir1", hashPath);
-      changed1 = listChanged.find("dir1_1") != (ReSeqArray::Index) - 1;
-      changed2 = listChanged.find("dir1_2") != (ReSeqArray::Index) - 1;
-      checkT(changed1 != changed2);
-      checkF(hashPath.get("cache.txt", buffer));
+      checkEqu(10, paths.size());
+      checkOneFile("x1.txt", "dir1_2_1", paths);
+      checkOneFile("x2.txt", "dir1_2_1", paths);
+      checkT(changed.contains("x1.txt") != changed.contains("x2.txt"));
+      checkOneFile("dir1_2_1", "dir1_2", paths);
+      checkOneFile("dir1_1", "dir1", paths);
+      checkOneFile("dir1_2", "dir1", paths);
+      checkOneFile("cache", "dir1", paths);
+      checkF(paths.contains("cache.txt"));
+      checkEqu(0, levels.value("1.txt"));
+      checkEqu(3, levels.value("x1.txt"));
+      // the base + dir1 dir1_1 dir1_2 dir1_2_1 dir2
+      checkEqu(6, traverser.directories());
+   }
+   void testFilter() {
+      ReTraverser traverser(m_base.constData());
+      ReDirEntryFilter filter;
+      ReIncludeExcludeMatcher nodes("*.txt,-X2*", Qt::CaseInsensitive, true);
+      filter.m_nodePatterns = &nodes;
+      filter.m_types = ReDirStatus_t::TF_REGULAR;
+      filter.m_minSize = 7;
+      traverser.setMinLevel(1);
+      int level = 0;
+      ReDirStatus_t* entry;
+      QList<QByteArray> found;
+      while ((entry = traverser.nextFile(level, &filter)) != NULL)
+         found.append(entry->node());
+      // 1.txt: level 0, x2.txt and 2.x: patterns
+      checkEqu(2, found.size());
+      checkT(found.contains("x1.txt"));
+      checkT(found.contains("cache.txt"));
+      checkEqu(2, traverser.files());
+      // the content of a file is its relative path:
+      checkEqu((int64_t) (27 + 20), traverser.sizes());
+   }
+   void testMaxLevel() {
+      ReTraverser traverser(m_base.constData());
+      traverser.setMaxLevel(1);
+      int level = 0;
+      int count = 0;
+      while (traverser.rawNextFile(level) != NULL) {
+         checkT(level <= 1);
+         count++;
+      }
+      // 1.txt dir1 dir2 dir1_1 dir1_2 cache 2.x
+      checkEqu(7, count);
+   }
+public:
+   virtual void runTests() {
+      initTree();
+      testBasic(false);
+      testBasic(true);
+      testFilter();
+      testMaxLevel();
+      ReFileUtils::deleteTree(m_base, true, NULL);
    }
 };
-extern void testReTraverser(void);
-
-void testReTraverser(void) {
-   TestReTraverser unit;
+void testReTraverser() {
+   TestReTraverser test;
 }
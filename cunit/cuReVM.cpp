@@ -18,12 +18,15 @@ private:
    ReASTree m_tree;
    ReStringReader m_reader;
    const char* m_currentSource;
+   /// true: only the benchmarks are done
+   bool m_benchmark;
 public:
-   TestReVM() :
+   TestReVM(bool benchmark = false) :
       ReTest("ReVM"),
       m_source(),
       m_tree(),
-      m_reader(m_source) {
+      m_reader(m_source),
+      m_benchmark(benchmark) {
       m_source.addReader(&m_reader);
       doIt();
    }
@@ -40,34 +43,328 @@ protected:
    }
 
 private:
-   void checkAST(const char* fileExpected, int lineNo) {
-      QByteArray fnExpected = "test";
-      fnExpected += QDir::separator().toLatin1();
-      fnExpected += "ReVM";
-      fnExpected += (char) QDir::separator().toLatin1();
-      fnExpected += fileExpected;
-      QByteArray fnCurrent = getTempFile(fileExpected, "ReVM");
+   /**
+    * Executes the module "<test>" with a trace writer.
+    *
+    * @param node  the node of the trace file
+    * @return      the content of the trace file
+    */
+   QByteArray executeWithTrace(const char* node) {
+      QByteArray fnTrace = getTempFile(node, "ReVM");
       ReMFParser parser(m_source, m_tree);
       parser.parse();
       ReVirtualMachine vm(m_tree, m_source);
       vm.setFlag(ReVirtualMachine::VF_TRACE_STATEMENTS);
-      ReFileWriter writer(fnCurrent);
+      ReFileWriter writer(fnTrace);
       vm.setTraceWriter(&writer);
       writer.write(m_currentSource);
       vm.executeModule("<test>");
-      assertEqualFiles(fnExpected.constData(), fnCurrent.constData(),
-                       __FILE__, lineNo);
+      writer.close();
+      QByteArray rc;
+      ReFile::readFromFile(fnTrace.constData(), rc);
+      return rc;
+   }
+   /**
+    * Executes the module "<test>" and returns the value of a module variable.
+    *
+    * @param variable  the name of the variable
+    * @return          the value of the variable
+    */
+   int executeAndGet(const char* variable) {
+      ReMFParser parser(m_source, m_tree);
+      parser.parse();
+      ReVirtualMachine vm(m_tree, m_source);
+      ReVMThread thread(1024, &vm);
+      ReSymbolSpace* module = m_tree.findmodule("<test>");
+      thread.execute(dynamic_cast<ReASNode1*>(module->body()), module);
+      ReASVarDefinition* definition = module->findVariable(variable);
+      ReASNamedValue* var = dynamic_cast<ReASNamedValue*>(
+                               definition->child2());
+      return thread.valueOfVariable(module, var->variableNo()).asInt();
+   }
+   /**
+    * Executes the module "<test>" and returns the value of a string variable.
+    *
+    * @param variable  the name of the variable
+    * @return          the value of the variable
+    */
+   QByteArray executeAndGetString(const char* variable) {
+      ReMFParser parser(m_source, m_tree);
+      parser.parse();
+      ReVirtualMachine vm(m_tree, m_source);
+      ReVMThread thread(1024, &vm);
+      ReSymbolSpace* module = m_tree.findmodule("<test>");
+      thread.execute(dynamic_cast<ReASNode1*>(module->body()), module);
+      ReASVarDefinition* definition = module->findVariable(variable);
+      ReASNamedValue* var = dynamic_cast<ReASNamedValue*>(
+                               definition->child2());
+      return *thread.valueOfVariable(module, var->variableNo()).asString();
    }
 public:
+   void testCalls() {
+      setSource("func Int fib(Int n):\n"
+                "Int rc = n;\n"
+                "if n > 1 then rc = fib(n - 1) + fib(n - 2); fi\n"
+                "rc\n"
+                "endf\n"
+                "Int result = fib(15);\n");
+      checkEqu(610, executeAndGet("result"));
+      setSource("func Int ack(Int m, Int n):\n"
+                "Int rc = n + 1;\n"
+                "if m > 0 then\n"
+                "if n == 0 then rc = ack(m - 1, 1);\n"
+                "else rc = ack(m - 1, ack(m, n - 1)); fi\n"
+                "fi\n"
+                "rc\n"
+                "endf\n"
+                "Int result = ack(2, 3);\n");
+      checkEqu(9, executeAndGet("result"));
+   }
+   void testParallelFor() {
+      setSource("Int sum = 0;\n"
+                "for i from 1 to 10 do sum = sum + i; od\n");
+      checkEqu(55, executeAndGet("sum"));
+      setSource("parallel for i from 1 to 100 do\n"
+                "send(\"squares\", i * i);\n"
+                "od\n"
+                "Int sum = 0;\n"
+                "for j from 1 to 100 do sum = sum + receive(\"squares\"); od\n");
+      checkEqu(338350, executeAndGet("sum"));
+   }
+   /**
+    * Executes the module "<test>" with 4 threads for a parallel loop.
+    *
+    * @param variable  NULL or the name of the variable to return
+    * @return          "!" + the error message or the value of the variable
+    */
+   QByteArray executeParallel(const char* variable) {
+      QByteArray rc;
+      ReMFParser parser(m_source, m_tree);
+      parser.parse();
+      ReVirtualMachine vm(m_tree, m_source);
+      vm.setParallelism(4);
+      ReVMThread thread(1024, &vm);
+      ReSymbolSpace* module = m_tree.findmodule("<test>");
+      try {
+         thread.execute(dynamic_cast<ReASNode1*>(module->body()), module);
+         if (variable != NULL) {
+            ReASVarDefinition* definition = module->findVariable(variable);
+            ReASNamedValue* var = dynamic_cast<ReASNamedValue*>(
+                                     definition->child2());
+            rc = thread.valueOfVariable(module, var->variableNo()).toString();
+         }
+      } catch (ReVMException& exc) {
+         rc = "!" + exc.getMessage();
+      }
+      return rc;
+   }
+   void testParallelReadOnly() {
+      // the parts may not change the shared variables:
+      setSource("Int total = 0;\n"
+                "func Int sum():\n"
+                "parallel for i from 1 to 100 do total = total + i; od\n"
+                "total\n"
+                "endf\n"
+                "Int result = sum();\n");
+      checkT(executeParallel(NULL).contains("read-only"));
+      // not even in the frame containing the loop variable:
+      setSource("Int total = 0;\n"
+                "parallel for i from 1 to 100 do total = total + i; od\n");
+      checkT(executeParallel(NULL).contains("read-only"));
+      // the loop variables and the variables of the body are private:
+      setSource("Int total = 7;\n"
+                "parallel for i from 1 to 100 do\n"
+                "Int square = i * i;\n"
+                "for k from 1 to 2 do square = square + 0; od\n"
+                "send(\"squares\", square + total - 7);\n"
+                "od\n"
+                "Int sum = 0;\n"
+                "for j from 1 to 100 do sum = sum + receive(\"squares\"); od\n");
+      checkEqu("338350", executeParallel("sum"));
+   }
+   void benchmarkCalls() {
+      setSource("func Int fib(Int n):\n"
+                "Int rc = n;\n"
+                "if n > 1 then rc = fib(n - 1) + fib(n - 2); fi\n"
+                "rc\n"
+                "endf\n"
+                "Int result = fib(25);\n");
+      clock_t start = clock();
+      checkEqu(75025, executeAndGet("result"));
+      // fib(25) needs 242785 calls:
+      printf("fib(25): %.3f sec\n", double(clock() - start) / CLOCKS_PER_SEC);
+      setSource("func Int ack(Int m, Int n):\n"
+                "Int rc = n + 1;\n"
+                "if m > 0 then\n"
+                "if n == 0 then rc = ack(m - 1, 1);\n"
+                "else rc = ack(m - 1, ack(m, n - 1)); fi\n"
+                "fi\n"
+                "rc\n"
+                "endf\n"
+                "Int result = ack(2, 200);\n");
+      start = clock();
+      checkEqu(403, executeAndGet("result"));
+      printf("ack(2, 200): %.3f sec\n",
+             double(clock() - start) / CLOCKS_PER_SEC);
+   }
+   void testChannel() {
+      ReVMChannel channel(4);
+      ReASVariant value;
+      value.setInt(3);
+      channel.put(value);
+      value.setString("abc");
+      channel.put(value);
+      channel.close();
+      checkT(channel.take(value));
+      checkEqu(3, value.asInt());
+      checkT(channel.take(value));
+      checkEqu("abc", *value.asString());
+      checkF(channel.take(value));
+      checkT(value.variantType() == ReASVariant::VT_UNDEF);
+   }
+   void testProfiler() {
+      setSource("func Int fib(Int n):\n"
+                "Int rc = n;\n"
+                "if n > 1 then rc = fib(n - 1) + fib(n - 2); fi\n"
+                "rc\n"
+                "endf\n"
+                "Int result = fib(12);\n");
+      ReMFParser parser(m_source, m_tree);
+      parser.parse();
+      ReVirtualMachine vm(m_tree, m_source);
+      vm.profiler().start(ReVMProfiler::PM_COUNT);
+      ReVMThread thread(1024, &vm);
+      ReSymbolSpace* module = m_tree.findmodule("<test>");
+      thread.execute(dynamic_cast<ReASNode1*>(module->body()), module);
+      vm.profiler().stop();
+      QByteArray fnReport = getTempFile("report.txt", "ReVM");
+      ReFileWriter report(fnReport.constData());
+      vm.profiler().writeReport(report);
+      report.close();
+      QByteArray content;
+      ReFile::readFromFile(fnReport.constData(), content);
+      checkT(content.startsWith("       count"));
+      checkT(content.contains("exprStatement"));
+      QByteArray fnStacks = getTempFile("stacks.txt", "ReVM");
+      ReFileWriter stacks(fnStacks.constData());
+      vm.profiler().writeCollapsedStacks(stacks);
+      stacks.close();
+      ReFile::readFromFile(fnStacks.constData(), content);
+      checkT(content.startsWith("vm;fib "));
+      checkT(content.contains("\nvm;fib;fib "));
+   }
+   void testAssignOperators() {
+      setSource("Int n = 1;\nn += 4;\nn *= 3;\nn -= 1;\nn /= 2;\nn %= 4;\n");
+      checkEqu(3, executeAndGet("n"));
+      setSource("Str s = \"a\" + \"b\" + \"c\";\n"
+                "for i from 1 to 3 do s += \"-\" + \"x\"; od\n");
+      checkEqu("abc-x-x-x", executeAndGetString("s"));
+   }
+   void benchmarkStringBuilder() {
+      // 1 MI lines with 100 bytes: a report with 100 MByte
+      setSource("Str line = \"0123456789012345678901234567890123456789\""
+                " + \"0123456789012345678901234567890123456789\""
+                " + \"0123456789012345678\\n\";\n"
+                "Str report = \"\";\n"
+                "for i from 1 to 1048576 do report += line; od\n");
+      clock_t start = clock();
+      QByteArray report = executeAndGetString("report");
+      printf("report with %d bytes: %.3f sec\n", report.size(),
+             double(clock() - start) / CLOCKS_PER_SEC);
+      checkEqu(100 * 1024 * 1024, report.size());
+   }
+   void testStringBuilder() {
+      // the report is built by appending to the same string:
+      setSource("Str line = \"01234\" + \"5678\" + \"\\n\";\n"
+                "Str report = \"\";\n"
+                "for i from 1 to 1000 do report += line; od\n");
+      QByteArray report = executeAndGetString("report");
+      checkEqu(10 * 1000, report.size());
+      checkEqu("012345678\n012345678\n", report.left(20));
+      checkEqu("012345678\n", report.right(10));
+   }
+   void testBatch() {
+      const int rows = 3000;
+      QVector<qint64> counts(rows);
+      QVector<double> prices(rows);
+      QVector<ReVMBatch::StringView> names(rows);
+      const char* texts[] = { "apple", "banana", "cherry" };
+      for (int ix = 0; ix < rows; ix++) {
+         counts[ix] = ix % 10;
+         prices[ix] = ix * 0.5;
+         names[ix].m_data = texts[ix % 3];
+         names[ix].m_length = strlen(texts[ix % 3]);
+      }
+      ReVMBatch batch;
+      batch.bindInt("count", counts.constData());
+      batch.bindFloat("price", prices.constData());
+      batch.bindString("name", names.constData());
+      // projection: Int * Float is a Float
+      checkT(batch.compile("count * price + 1"));
+      checkEqu(ReVMBatch::CT_FLOAT, batch.resultType());
+      QVector<double> values(rows);
+      batch.evaluate(rows, values.data());
+      for (int ix = 0; ix < rows; ix++)
+         checkT(values[ix] == (ix % 10) * (ix * 0.5) + 1);
+      checkT(batch.compile("-count % 4"));
+      QVector<qint64> ints(rows);
+      batch.evaluate(rows, ints.data());
+      checkT(ints[2999] == -(9 % 4));
+      // filter:
+      checkT(batch.compile("count >= 5 && name != 'banana' || price < 1.0"));
+      QVector<bool> mask(rows);
+      bool* bits = mask.data();
+      int expected = 0;
+      for (int ix = 0; ix < rows; ix++)
+         if ((ix % 10 >= 5 && ix % 3 != 1) || ix * 0.5 < 1.0)
+            expected++;
+      checkEqu(expected, batch.select(rows, bits));
+      checkT(bits[5]);
+      checkF(bits[7]);
+      checkT(batch.compile("!(name < 'b')"));
+      checkEqu(2000, batch.select(rows, bits));
+      // the minimum divided by -1 does not trap:
+      QVector<qint64> bigs(rows, Q_INT64_C(-9223372036854775807) - 1);
+      batch.bindInt("big", bigs.constData());
+      checkT(batch.compile("big / -1"));
+      batch.evaluate(rows, ints.data());
+      checkT(ints[0] == bigs[0]);
+      checkT(batch.compile("big % -1"));
+      batch.evaluate(rows, ints.data());
+      checkT(ints[0] == 0);
+      // errors:
+      checkF(batch.compile("count + unknown"));
+      checkT(batch.messages().last().indexOf("unbound") >= 0);
+      checkF(batch.compile("name * 2"));
+   }
    void baseTest() {
-      setSource("Int a=2+3*4;\nfunc Void main():\na;\nendf");
-      checkAST("baseTest.txt", __LINE__);
+      const char* source = "Int a=2+3*4;\nfunc Void main():\na;\nendf";
+      setSource(source);
+      checkT(executeWithTrace("baseTest.txt").startsWith(source));
+      setSource(source);
+      checkEqu(14, executeAndGet("a"));
    }
-   virtual void run(void) {
-      baseTest();
+   virtual void runTests(void) {
+      if (m_benchmark) {
+         benchmarkCalls();
+         benchmarkStringBuilder();
+      } else {
+         testCalls();
+         testChannel();
+         testParallelFor();
+         testParallelReadOnly();
+         testProfiler();
+         testAssignOperators();
+         testStringBuilder();
+         testBatch();
+         baseTest();
+      }
    }
 };
 void testReVM() {
    TestReVM test;
 }
+void benchmarkReVM() {
+   TestReVM test(true);
+}
 
@@ -29,7 +29,13 @@ SOURCES += main.cpp \
 	 cuReException.cpp \
 	../expr/ReSource.cpp \
 	../expr/ReLexer.cpp \
+	../expr/ReASTree.cpp \
+	../expr/ReASClasses.cpp \
+	../expr/ReParser.cpp \
+	../expr/ReMFParser.cpp \
+	../expr/ReVM.cpp \
 	 ../base/ReByteStorage.cpp \
+	 ../base/RePool.cpp \
 	 ../base/ReCharPtrMap.cpp \
 	 ../base/ReConfig.cpp \
 	 ../base/ReContainer.cpp \
@@ -38,6 +44,7 @@ SOURCES += main.cpp \
 	 ../base/ReFileUtils.cpp \
 	 ../base/ReQStringUtils.cpp \
 	 ../base/ReLogger.cpp \
+	 ../base/ReBinaryLogger.cpp \
 	 ../base/ReStringUtils.cpp \
 	 ../base/ReTerminator.cpp \
 	 ../base/ReMatcher.cpp \
@@ -47,16 +54,30 @@ SOURCES += main.cpp \
 	 ../gui/ReStateStorage.cpp \
 	 ../gui/ReSettings.cpp \
 	../gui/ReEdit.cpp \
+	../gui/ReHighlighter.cpp \
+	../gui/ReFileTableModel.cpp \
 	../os/ReFileSystem.cpp \
 	../os/ReCryptFileSystem.cpp \
+	../os/ReTraverser.cpp \
+	../os/ReFileIndex.cpp \
+	../math/ReMatrix.cpp \
 	 cuReConfig.cpp \
 	 cuReContainer.cpp \
 	 cuReWriter.cpp \
 	 cuReCharPtrMap.cpp \
 	cuReEdit.cpp \
+	cuReFileTableModel.cpp \
 	cuReStateStorage.cpp \
 	cuReSettings.cpp \
 	cuReMatcher.cpp \
+	cuReBinaryLogger.cpp \
+	cuReTraverser.cpp \
+	cuReFileIndex.cpp \
+	cuReMatrix.cpp \
+	cuReSource.cpp \
+	cuReASTree.cpp \
+	cuReMFParser.cpp \
+	cuReVM.cpp \
 	 allTests.cpp \
 	../base/ReProcess.cpp \
 	cuReProcess.cpp \
@@ -31,6 +31,7 @@ SOURCES += main.cpp \
 	 ../base/ReFile.cpp \
 	 ../expr/ReASClasses.cpp \
 	 ../base/ReByteStorage.cpp \
+	 ../base/RePool.cpp \
 	 ../expr/ReVM.cpp \
 	 ../base/ReWriter.cpp \
 	 rplmatrix_test.cpp \
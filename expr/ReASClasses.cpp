@@ -98,7 +98,12 @@ ReSymbolSpace::~ReSymbolSpace() {
    }
    MethodMap::iterator it2;
    for (it2 = m_methods.begin(); it2 != m_methods.end(); it2++) {
-      delete it2.value();
+      ReASMethod* method = it2.value();
+      while (method != NULL) {
+         ReASMethod* sibling = method->sibling();
+         delete method;
+         method = sibling;
+      }
    }
 }
 
@@ -388,12 +393,52 @@ ReASItem* ReSymbolSpace::addMethod(ReASMethod* method) {
             oldMethod = oldMethod->sibling();
       } while (rc == NULL && oldMethod != NULL);
       if (rc == NULL) {
-         method->setChild(first);
+         method->setSibling(first);
          m_methods[name] = method;
       }
    }
    return rc;
 }
+
+/**
+ * @brief Removes a method from the symbol space.
+ *
+ * The method is not freed: the caller is the new owner.
+ *
+ * @param method    the method to remove
+ * @return          <code>true</code>: the method has been found
+ */
+bool ReSymbolSpace::removeMethod(ReASMethod* method) {
+   bool rc = false;
+   const QByteArray& name = method->name();
+   ReASMethod* current = findMethod(name);
+   if (current == method) {
+      rc = true;
+      if (method->sibling() == NULL)
+         m_methods.remove(name);
+      else
+         m_methods[name] = method->sibling();
+   } else {
+      while (current != NULL && current->sibling() != method)
+         current = current->sibling();
+      if (current != NULL) {
+         rc = true;
+         current->setSibling(method->sibling());
+      }
+   }
+   if (rc)
+      method->setSibling(NULL);
+   return rc;
+}
+
+/**
+ * @brief Returns the methods of the symbol space.
+ *
+ * @return  the map name -> first of the overloaded methods
+ */
+const ReSymbolSpace::MethodMap& ReSymbolSpace::methods() const {
+   return m_methods;
+}
 /**
  * @brief Adds a class to the instance.
  *
@@ -586,6 +631,10 @@ QByteArray ReASInteger::toString(void* object, int maxLength) const {
  * @brief Implements the class of a string.
  *
  * A string is a mutable character sequence.
+ *
+ * A string which is the target of repeated appends (<code>+=</code>) works
+ * as a string builder: it is changed in place and its capacity is doubled
+ * if it is too small. So building a long string in a loop costs linear time.
  */
 /**
  * @brief Constructor.
@@ -606,6 +655,29 @@ void* ReASString::newValueInstance(void* source) const {
    return (void*) rc;
 }
 
+/**
+ * @brief Appends a string to a string value in place.
+ *
+ * If the string is shared with other variants it will be copied first
+ * (copy on write).
+ *
+ * @param target    IN/OUT: a string value
+ * @param tail      the string to append
+ */
+void ReASString::append(ReASVariant& target, const QByteArray& tail) {
+   const ReASClass* clazz = NULL;
+   QByteArray* string = static_cast<QByteArray*>(target.asWritableObject(
+                           &clazz));
+   if (clazz != m_instance)
+      throw ReException("ReASString::append: not a string: %s",
+                        clazz->name().constData());
+   int needed = string->size() + tail.size();
+   // amortized constant time for each appended byte:
+   if (needed > string->capacity())
+      string->reserve(qMax(needed, 2 * string->capacity()));
+   string->append(tail);
+}
+
 /**
  * @brief Destroys the given object.
  *
@@ -682,16 +754,12 @@ ReASList::ReASList(ReASTree& tree) :
  * @return          a new value object (specific for the class)
  */
 void* ReASList::newValueInstance(void* source) const {
-   ReASListOfVariants* rc = new ReASListOfVariants();
-   if (source != NULL) {
-      ReASListOfVariants* source2 = (ReASListOfVariants*) source;
-      rc->reserve(source2->size());
-      ReASListOfVariants::iterator it;
-      for (it = source2->begin(); it != source2->end(); it++) {
-         // deleting in destroyValue():
-         rc->append(new ReASVariant(*(*it)));
-      }
-   }
+   ReASListOfVariants* rc;
+   if (source == NULL)
+      rc = new ReASListOfVariants();
+   else
+      // the packed arrays are implicitly shared until the first change:
+      rc = new ReASListOfVariants(*static_cast<ReASListOfVariants*>(source));
    return (void*) rc;
 }
 
@@ -719,7 +787,7 @@ bool ReASList::boolValueOf(void* object) const {
       ReASListOfVariants* list = static_cast<ReASListOfVariants*>(object);
       if (list == NULL)
          throw ReException("ReASList.boolValueOf(): not a list");
-      rc = !list->empty();
+      rc = !list->isEmpty();
    }
    return rc;
 }
@@ -736,14 +804,12 @@ QByteArray ReASList::toString(void* object, int maxLength) const {
    rc.reserve(maxLength);
    rc += "[";
    ReASListOfVariants* list = reinterpret_cast<ReASListOfVariants*>(object);
-   ReASListOfVariants::iterator it;
-   bool first = true;
-   for (it = list->begin(); it != list->end(); it++) {
-      if (first)
-         first = false;
-      else
+   ReASVariant element;
+   for (int ix = 0; ix < list->size(); ix++) {
+      if (ix > 0)
          rc += ",";
-      QByteArray part = (*it)->toString(maxLength - rc.size() - 5);
+      list->at(ix, element);
+      QByteArray part = element.toString(maxLength - rc.size() - 5);
       if (maxLength - rc.size() - 5 - part.size() <= 0) {
          rc += "...";
          break;
@@ -775,18 +841,12 @@ ReASMap::ReASMap(ReASTree& tree) :
  * @return          a new value object (specific for the class)
  */
 void* ReASMap::newValueInstance(void* source) const {
-   ReASMapOfVariants* rc = new ReASMapOfVariants();
-   if (source != NULL) {
-      ReASMapOfVariants* source2 = static_cast<ReASMapOfVariants*>(source);
-      // rc->reserve(source2->size());
-      ReASMapOfVariants::iterator it;
-      for (it = source2->begin(); it != source2->end(); it++) {
-         // deleting in destroyValue():
-         const QByteArray& key = it.key();
-         ReASVariant* value = new ReASVariant(*it.value());
-         (*rc)[key] = value;
-      }
-   }
+   ReASMapOfVariants* rc;
+   if (source == NULL)
+      rc = new ReASMapOfVariants();
+   else
+      // the entries are implicitly shared until the first change:
+      rc = new ReASMapOfVariants(*static_cast<ReASMapOfVariants*>(source));
    return (void*) rc;
 }
 
@@ -798,13 +858,13 @@ void* ReASMap::newValueInstance(void* source) const {
  * @param object    object to destroy
  */
 void ReASMap::destroyValueInstance(void* object) const {
-   delete (ReASMapOfVariants*) object;
+   delete static_cast<ReASMapOfVariants*>(object);
 }
 
 /**
  * @brief Calculates the boolean value of an class specific object.
  *
- * @param object    the object to test (with type QMap*)
+ * @param object    the object to test (with type ReASMapOfVariants*)
  * @return
  */
 bool ReASMap::boolValueOf(void* object) const {
@@ -813,7 +873,7 @@ bool ReASMap::boolValueOf(void* object) const {
       ReASMapOfVariants* map = reinterpret_cast<ReASMapOfVariants*>(object);
       if (map == NULL)
          throw ReException("ReASMap.boolValueOf(): not a map");
-      rc = map->empty() > 0;
+      rc = !map->isEmpty();
    }
    return rc;
 }
@@ -830,22 +890,20 @@ QByteArray ReASMap::toString(void* object, int maxLength) const {
    rc.reserve(maxLength);
    rc += "[";
    ReASMapOfVariants* map = reinterpret_cast<ReASMapOfVariants*>(object);
-   ReASMapOfVariants::iterator it;
-   bool first = true;
-   for (it = map->begin(); it != map->end(); it++) {
-      if (first)
-         first = false;
-      else
+   for (int ix = 0; ix < map->size(); ix++) {
+      const ReASMapOfVariants::Entry& entry = map->entryAt(ix);
+      if (ix > 0)
          rc += ",";
-      if (maxLength - rc.size() - 5 - 2 - it.key().size() <= 0) {
+      QByteArray key = entry.m_isIntKey ? QByteArray::number(entry.m_intKey)
+                       : "'" + entry.m_key + "'";
+      if (maxLength - rc.size() - 5 - key.size() <= 0) {
          rc += "...";
          break;
       } else {
-         rc += "'";
-         rc += it.key();
-         rc += "':";
+         rc += key;
+         rc += ":";
       }
-      QByteArray part = it.value()->toString(maxLength - rc.size() - 5);
+      QByteArray part = entry.m_value.toString(maxLength - rc.size() - 5);
       if (maxLength - rc.size() - 5 - part.size() <= 0) {
          rc += "...";
          break;
@@ -1034,7 +1092,7 @@ QByteArray ReASFormula::toString(void* object, int) const {
 ReASUserClass::ReASUserClass(const QByteArray& name,
                              const ReSourcePosition* position, ReASTree& tree) :
    ReASClass(name, tree),
-   m_position(position) {
+   m_position(position == NULL ? 0 : position->handle()) {
 }
 
 /**
@@ -1081,7 +1139,7 @@ QByteArray ReASUserClass::toString(void*, int) const {
  * @return  the source position
  */
 const ReSourcePosition* ReASUserClass::position() const {
-   return m_position;
+   return ReSourcePositionTable::find(m_position);
 }
 
 /** @class ReASUserObject ReASClasses.hpp "expr/ReASClasses.hpp"
@@ -72,6 +72,8 @@ public:
    void setBody(ReASItem* body);
    ReASItem* addVariable(ReASVarDefinition* variable, int& varNo);
    ReASItem* addMethod(ReASMethod* method);
+   bool removeMethod(ReASMethod* method);
+   const MethodMap& methods() const;
    ReASUserClass* addClass(ReASUserClass* clazz);
    ReSymbolSpace* parent() const;
    VariableList listOfVars() const;
@@ -133,6 +135,8 @@ public:
    void destroyValueInstance(void* object) const;
    virtual bool boolValueOf(void* object) const;
    virtual QByteArray toString(void* object, int maxLength = 80) const;
+public:
+   static void append(ReASVariant& target, const QByteArray& tail);
 public:
    static ReASString* m_instance;
 };
@@ -197,7 +201,7 @@ public:
    const ReSourcePosition* position() const;
 
 private:
-   const ReSourcePosition* m_position;
+   ReSourcePositionHandle m_position;
 };
 
 class ReASUserObject {
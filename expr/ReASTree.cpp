@@ -59,6 +59,11 @@ enum {
    LOC_MEHTOD_CALL_CHECK_2,
    LOC_MEHTOD_CALL_CHECK_3,    // 11035
    LOC_MEHTOD_CALL_CHECK_4,
+   LOC_FORIT_CHECK_1,
+   LOC_FORIT_CHECK_2,
+   LOC_METHOD_CALL_CHECK_5,
+   LOC_BINOP_CALC_13,
+   LOC_BINOP_ASSIGN_1,
    LOC_COUNT
 };
 
@@ -79,19 +84,18 @@ unsigned int ReASItem::m_nextId = 1;
  * @param withEndOfLine true: '\n' will be written at the end
  */
 void dumpMap(ReWriter& writer, ReASMapOfVariants& map, bool withEndOfLine) {
-   QList < QByteArray > sorted;
-   sorted.reserve(map.size());
-   ReASMapOfVariants::iterator it;
-   for (it = map.begin(); it != map.end(); it++) {
-      sorted.append(it.key());
-   }
-   qSort(sorted.begin(), sorted.end(), qLess<QByteArray>());
-   QList<QByteArray>::iterator it2;
+   QMap<QByteArray, const ReASVariant*> sorted;
+   for (int ix = 0; ix < map.size(); ix++) {
+      const ReASMapOfVariants::Entry& entry = map.entryAt(ix);
+      sorted.insert(
+         entry.m_isIntKey ? QByteArray::number(entry.m_intKey) : entry.m_key,
+         &entry.m_value);
+   }
+   QMap<QByteArray, const ReASVariant*>::const_iterator it;
    bool first = true;
-   for (it2 = sorted.begin(); it2 != sorted.end(); it2++) {
-      ReASVariant* value = map[*it2];
-      writer.format("%c'%s':%s", first ? '{' : ',', (*it2).constData(),
-                    value->toString().constData());
+   for (it = sorted.constBegin(); it != sorted.constEnd(); ++it) {
+      writer.format("%c'%s':%s", first ? '{' : ',', it.key().constData(),
+                    it.value()->toString().constData());
       first = false;
    }
    if (first)
@@ -153,6 +157,12 @@ ReASException::ReASException() :
  *
  * The VM uses some tricks (performance): Therefore this class
  * must not be virtual!
+ *
+ * Object values (strings, lists, maps ...) are shared between the copies of
+ * a variant: a copy costs only the increment of a reference counter.
+ * A holder which wants to change the object must call
+ * <code>asWritableObject()</code>: this makes its own copy if the object is
+ * shared.
  */
 /**
  * @brief Constructor.
@@ -176,10 +186,11 @@ ReASVariant::~ReASVariant() {
  * @param source    the source to copy
  */
 ReASVariant::ReASVariant(const ReASVariant& source) :
-   m_variantType(source.m_variantType),
-   m_flags(source.m_flags),
+   // copyValue() destroys the old value: the new instance must be empty
+   m_variantType(VT_UNDEF),
+   m_flags(VF_UNDEF),
    // m_value
-   m_class(source.m_class) {
+   m_class(NULL) {
    copyValue(source);
 }
 
@@ -190,19 +201,20 @@ ReASVariant::ReASVariant(const ReASVariant& source) :
  * @return          the instance itself
  */
 ReASVariant& ReASVariant::operator=(const ReASVariant& source) {
-   destroyValue();
-   m_variantType = source.m_variantType;
-   m_flags = source.m_flags;
-   m_class = source.m_class;
    copyValue(source);
    return *this;
 }
 
 /**
  * @brief Copies the value.
+ *
+ * An object value is not copied but shared with the source.
+ *
  * @param source    the source to copy
  */
 void ReASVariant::copyValue(const ReASVariant& source) {
+   if (this == &source)
+      return;
    destroyValue();
    m_variantType = source.m_variantType;
    m_class = source.m_class;
@@ -219,10 +231,11 @@ void ReASVariant::copyValue(const ReASVariant& source) {
    case VT_UNDEF:
       break;
    default:
-      m_value.m_object = m_class->newValueInstance(source.m_value.m_object);
+      m_value.m_shared = source.m_value.m_shared;
+      m_value.m_shared->m_refCount.ref();
       break;
    }
-   m_flags = source.m_flags;
+   m_flags = source.m_flags & ~VF_IS_COPY;
 }
 
 /**
@@ -236,9 +249,12 @@ void ReASVariant::destroyValue() {
    case VT_UNDEF:
       break;
    default:
-      if ((m_flags & VF_IS_COPY) == 0)
-         m_class->destroyValueInstance(m_value.m_object);
-      m_value.m_object = NULL;
+      // the last user of a shared object frees it:
+      if ((m_flags & VF_IS_COPY) == 0 && !m_value.m_shared->m_refCount.deref()) {
+         m_class->destroyValueInstance(m_value.m_shared->m_object);
+         delete m_value.m_shared;
+      }
+      m_value.m_shared = NULL;
       break;
    }
    m_variantType = VT_UNDEF;
@@ -334,6 +350,9 @@ bool ReASVariant::asBool() const {
 /**
  * @brief Returns the class specific value.
  *
+ * The value may be shared with other variants: it must not be changed.
+ * Use <code>asWritableObject()</code> for changes.
+ *
  * @param clazz         OUT: the class of the instance. May be NULL
  * @return              the class specific value
  * @throw RplException  the instance is not a boolean value
@@ -345,7 +364,45 @@ void* ReASVariant::asObject(const ReASClass** clazz) const {
                         m_variantType);
    if (clazz != NULL)
       *clazz = m_class;
-   return m_value.m_object;
+   return m_value.m_shared->m_object;
+}
+
+/**
+ * @brief Returns the class specific value for a change.
+ *
+ * If the value is shared with other variants the instance gets its own copy
+ * (copy on write).
+ *
+ * @param clazz         OUT: the class of the instance. May be NULL
+ * @return              the class specific value, owned by the instance only
+ * @throw RplException  the instance is not an object
+ */
+void* ReASVariant::asWritableObject(const ReASClass** clazz) {
+   void* rc = asObject(clazz);
+   if (isShared()) {
+      ReASSharedObject* shared = new ReASSharedObject(
+         m_class->newValueInstance(rc));
+      ReASSharedObject* old = m_value.m_shared;
+      // the other users may have released the object in the meantime:
+      if ((m_flags & VF_IS_COPY) == 0 && !old->m_refCount.deref()) {
+         m_class->destroyValueInstance(old->m_object);
+         delete old;
+      }
+      m_value.m_shared = shared;
+      m_flags &= ~VF_IS_COPY;
+      rc = shared->m_object;
+   }
+   return rc;
+}
+
+/**
+ * @brief Tests whether the object value is used by other variants too.
+ *
+ * @return  <code>true</code>: the value is an object used by other variants
+ */
+bool ReASVariant::isShared() const {
+   return m_variantType == VT_OBJECT
+          && m_value.m_shared->m_refCount.load() > 1;
 }
 
 /**
@@ -429,11 +486,11 @@ QByteArray ReASVariant::toString(int maxLength) const {
       rc = buffer;
       break;
    case VT_INTEGER:
-      qsnprintf(buffer, sizeof buffer, "%lld", m_value.m_int);
+      qsnprintf(buffer, sizeof buffer, "%d", m_value.m_int);
       rc = buffer;
       break;
    case VT_OBJECT:
-      rc = m_class->toString(m_value.m_object, maxLength);
+      rc = m_class->toString(m_value.m_shared->m_object, maxLength);
       break;
    default:
    case VT_UNDEF:
@@ -452,10 +509,396 @@ QByteArray ReASVariant::toString(int maxLength) const {
 void ReASVariant::setObject(void* object, const ReASClass* clazz) {
    destroyValue();
    m_variantType = VT_OBJECT;
-   m_value.m_object = object;
+   // deletion in destroyValue():
+   m_value.m_shared = new ReASSharedObject(object);
    m_class = clazz;
 }
 
+/** @class ReASListOfVariants ReASTree.hpp "expr/ReASTree.hpp"
+ *
+ * @brief Implements the element storage of a list.
+ *
+ * Lists of integers, floats or booleans are stored without the overhead of
+ * a variant per element. Iterations and index accesses on such a list
+ * read a packed array.
+ */
+
+/**
+ * @brief Constructor.
+ */
+ReASListOfVariants::ReASListOfVariants() :
+   m_storageType(ST_EMPTY),
+   m_count(0),
+   m_ints(),
+   m_floats(),
+   m_bools(),
+   m_variants() {
+}
+
+/**
+ * @brief Appends an element to the list.
+ *
+ * If the type of the value does not match the storage type the storage
+ * will be converted into a vector of variants.
+ *
+ * @param value the value to append
+ */
+void ReASListOfVariants::append(const ReASVariant& value) {
+   StorageType type = storageTypeOf(value);
+   if (m_storageType == ST_EMPTY)
+      m_storageType = type;
+   else if (type != m_storageType && m_storageType != ST_VARIANT)
+      promote();
+   switch (m_storageType) {
+   case ST_INT:
+      m_ints.append(value.asInt());
+      break;
+   case ST_FLOAT:
+      m_floats.append(value.asFloat());
+      break;
+   case ST_BOOL:
+      m_bools.append(value.asBool());
+      break;
+   default:
+      m_variants.append(value);
+      break;
+   }
+   m_count++;
+}
+
+/**
+ * @brief Returns an element of the list.
+ *
+ * @param index     the index of the element: 0..N-1
+ * @param value     OUT: the value of the element
+ */
+void ReASListOfVariants::at(int index, ReASVariant& value) const {
+   switch (m_storageType) {
+   case ST_INT:
+      value.setInt(m_ints.at(index));
+      break;
+   case ST_FLOAT:
+      value.setFloat(m_floats.at(index));
+      break;
+   case ST_BOOL:
+      value.setBool(m_bools.at(index));
+      break;
+   default:
+      value.copyValue(m_variants.at(index));
+      break;
+   }
+}
+
+/**
+ * @brief Removes all elements.
+ */
+void ReASListOfVariants::clear() {
+   m_storageType = ST_EMPTY;
+   m_count = 0;
+   m_ints.clear();
+   m_floats.clear();
+   m_bools.clear();
+   m_variants.clear();
+}
+
+/**
+ * @brief Converts the packed storage into a vector of variants.
+ */
+void ReASListOfVariants::promote() {
+   m_variants.resize(m_count);
+   for (int ix = 0; ix < m_count; ix++)
+      at(ix, m_variants[ix]);
+   m_ints.clear();
+   m_floats.clear();
+   m_bools.clear();
+   m_storageType = ST_VARIANT;
+}
+
+/**
+ * @brief Reserves space for a given number of elements.
+ *
+ * @param size  the expected number of elements
+ */
+void ReASListOfVariants::reserve(int size) {
+   switch (m_storageType) {
+   case ST_INT:
+      m_ints.reserve(size);
+      break;
+   case ST_FLOAT:
+      m_floats.reserve(size);
+      break;
+   case ST_BOOL:
+      m_bools.reserve(size);
+      break;
+   default:
+      m_variants.reserve(size);
+      break;
+   }
+}
+
+/**
+ * @brief Replaces an element of the list.
+ *
+ * @param index     the index of the element: 0..N-1
+ * @param value     the new value
+ */
+void ReASListOfVariants::set(int index, const ReASVariant& value) {
+   if (storageTypeOf(value) != m_storageType && m_storageType != ST_VARIANT)
+      promote();
+   switch (m_storageType) {
+   case ST_INT:
+      m_ints[index] = value.asInt();
+      break;
+   case ST_FLOAT:
+      m_floats[index] = value.asFloat();
+      break;
+   case ST_BOOL:
+      m_bools[index] = value.asBool();
+      break;
+   default:
+      m_variants[index].copyValue(value);
+      break;
+   }
+}
+
+/**
+ * @brief Returns the storage type which can store a given value.
+ *
+ * @param value the value to inspect
+ * @return      the storage type fitting to the value
+ */
+ReASListOfVariants::StorageType ReASListOfVariants::storageTypeOf(
+   const ReASVariant& value) {
+   StorageType rc;
+   switch (value.variantType()) {
+   case ReASVariant::VT_INTEGER:
+      rc = ST_INT;
+      break;
+   case ReASVariant::VT_FLOAT:
+      rc = ST_FLOAT;
+      break;
+   case ReASVariant::VT_BOOL:
+      rc = ST_BOOL;
+      break;
+   default:
+      rc = ST_VARIANT;
+      break;
+   }
+   return rc;
+}
+
+/** @class ReASMapOfVariants ReASTree.hpp "expr/ReASTree.hpp"
+ *
+ * @brief Implements the entry storage of a map.
+ *
+ * A lookup costs one hash calculation and mostly one key comparison.
+ * Interned keys (see <code>ReASTree::intern()</code>) are compared by
+ * their buffer address. The values are stored inside the entries.
+ */
+
+/**
+ * @brief Constructor.
+ */
+ReASMapOfVariants::ReASMapOfVariants() :
+   m_entries(),
+   m_slots(),
+   m_mask(0) {
+}
+
+/**
+ * @brief Removes all entries.
+ */
+void ReASMapOfVariants::clear() {
+   m_entries.clear();
+   m_slots.clear();
+   m_mask = 0;
+}
+
+/**
+ * @brief Returns the value of a string key.
+ *
+ * @param key   the key to search
+ * @return      NULL: not found<br>
+ *              otherwise: the value belonging to the key
+ */
+const ReASVariant* ReASMapOfVariants::find(const QByteArray& key) const {
+   int ix = indexOf(key, qHash(key));
+   return ix < 0 ? NULL : &m_entries.at(ix).m_value;
+}
+
+/**
+ * @brief Returns the value of an integer key.
+ *
+ * @param key   the key to search
+ * @return      NULL: not found<br>
+ *              otherwise: the value belonging to the key
+ */
+const ReASVariant* ReASMapOfVariants::find(int key) const {
+   int ix = indexOf(key, hashOf(key));
+   return ix < 0 ? NULL : &m_entries.at(ix).m_value;
+}
+
+/**
+ * @brief Returns the hash value of an integer key.
+ *
+ * @param key   the key
+ * @return      the hash value: the bits of the key are spread
+ */
+uint ReASMapOfVariants::hashOf(int key) {
+   uint rc = uint(key) * 0x9E3779B1u;
+   return rc ^ (rc >> 15);
+}
+
+/**
+ * @brief Returns the entry index of a string key.
+ *
+ * @param key   the key to search
+ * @param hash  the hash value of the key
+ * @return      -1: not found<br>
+ *              otherwise: the index in <code>m_entries</code>
+ */
+int ReASMapOfVariants::indexOf(const QByteArray& key, uint hash) const {
+   int rc = -1;
+   if (m_mask != 0) {
+      uint slot = hash & m_mask;
+      int ix;
+      while ((ix = m_slots.at(slot)) >= 0) {
+         const Entry& entry = m_entries.at(ix);
+         if (entry.m_hash == hash && !entry.m_isIntKey
+               && (entry.m_key.constData() == key.constData()
+                   || entry.m_key == key)) {
+            rc = ix;
+            break;
+         }
+         slot = (slot + 1) & m_mask;
+      }
+   }
+   return rc;
+}
+
+/**
+ * @brief Returns the entry index of an integer key.
+ *
+ * @param key   the key to search
+ * @param hash  the hash value of the key
+ * @return      -1: not found<br>
+ *              otherwise: the index in <code>m_entries</code>
+ */
+int ReASMapOfVariants::indexOf(int key, uint hash) const {
+   int rc = -1;
+   if (m_mask != 0) {
+      uint slot = hash & m_mask;
+      int ix;
+      while ((ix = m_slots.at(slot)) >= 0) {
+         const Entry& entry = m_entries.at(ix);
+         if (entry.m_isIntKey && entry.m_intKey == key) {
+            rc = ix;
+            break;
+         }
+         slot = (slot + 1) & m_mask;
+      }
+   }
+   return rc;
+}
+
+/**
+ * @brief Sets the value of a string key.
+ *
+ * @param key   the key. Should be interned (see <code>ReASTree::intern()</code>)
+ * @param value the value to store
+ * @return      the stored value
+ */
+ReASVariant& ReASMapOfVariants::insert(const QByteArray& key,
+                                       const ReASVariant& value) {
+   uint hash = qHash(key);
+   int ix = indexOf(key, hash);
+   if (ix < 0) {
+      ix = m_entries.size();
+      m_entries.resize(ix + 1);
+      Entry& entry = m_entries[ix];
+      entry.m_key = key;
+      entry.m_intKey = 0;
+      entry.m_hash = hash;
+      entry.m_isIntKey = false;
+      storeIndex(ix);
+   }
+   ReASVariant& rc = m_entries[ix].m_value;
+   rc.copyValue(value);
+   return rc;
+}
+
+/**
+ * @brief Sets the value of an integer key.
+ *
+ * @param key   the key
+ * @param value the value to store
+ * @return      the stored value
+ */
+ReASVariant& ReASMapOfVariants::insert(int key, const ReASVariant& value) {
+   uint hash = hashOf(key);
+   int ix = indexOf(key, hash);
+   if (ix < 0) {
+      ix = m_entries.size();
+      m_entries.resize(ix + 1);
+      Entry& entry = m_entries[ix];
+      entry.m_intKey = key;
+      entry.m_hash = hash;
+      entry.m_isIntKey = true;
+      storeIndex(ix);
+   }
+   ReASVariant& rc = m_entries[ix].m_value;
+   rc.copyValue(value);
+   return rc;
+}
+
+/**
+ * @brief Builds the hash table with a given capacity.
+ *
+ * @param capacity  the number of slots: a power of 2
+ */
+void ReASMapOfVariants::rehash(int capacity) {
+   m_slots.fill(-1, capacity);
+   m_mask = uint(capacity - 1);
+   for (int ix = 0; ix < m_entries.size(); ix++) {
+      uint slot = m_entries.at(ix).m_hash & m_mask;
+      while (m_slots.at(slot) >= 0)
+         slot = (slot + 1) & m_mask;
+      m_slots[slot] = ix;
+   }
+}
+
+/**
+ * @brief Reserves space for a given number of entries.
+ *
+ * @param size  the expected number of entries
+ */
+void ReASMapOfVariants::reserve(int size) {
+   m_entries.reserve(size);
+   int capacity = 8;
+   while (capacity < 2 * size)
+      capacity *= 2;
+   if (capacity > m_slots.size())
+      rehash(capacity);
+}
+
+/**
+ * @brief Stores the index of a new entry into the hash table.
+ *
+ * The table is at most half filled: probe sequences stay short.
+ *
+ * @param index the index of the new entry in <code>m_entries</code>
+ */
+void ReASMapOfVariants::storeIndex(int index) {
+   if (2 * m_entries.size() > m_slots.size())
+      rehash(m_slots.isEmpty() ? 8 : 2 * m_slots.size());
+   else {
+      uint slot = m_entries.at(index).m_hash & m_mask;
+      while (m_slots.at(slot) >= 0)
+         slot = (slot + 1) & m_mask;
+      m_slots[slot] = index;
+   }
+}
+
 /** @class ReASItem ReASTree.hpp "expr/ReASTree.hpp"
  *
  * @brief Implements the abstract base class of all entries of an AST.
@@ -471,7 +914,7 @@ ReASItem::ReASItem(ReASItemType type) :
    m_id(m_nextId++),
    m_nodeType(type),
    m_flags(0),
-   m_position(NULL) {
+   m_position(0) {
 }
 /**
  * @brief Destructor.
@@ -480,6 +923,28 @@ ReASItem::ReASItem(ReASItemType type) :
 ReASItem::~ReASItem() {
 }
 
+/**
+ * @brief Allocates the memory of a node.
+ *
+ * The nodes are small and numerous: a pool is much faster than the heap.
+ *
+ * @param size  the size of the instance
+ * @return      the memory for the instance
+ */
+void* ReASItem::operator new(size_t size) {
+   return ReConcurrentPool::global().allocate(size);
+}
+
+/**
+ * @brief Frees the memory of a node.
+ *
+ * @param block the memory of the instance
+ * @param size  the size of the instance
+ */
+void ReASItem::operator delete(void* block, size_t size) {
+   ReConcurrentPool::global().free(block, size);
+}
+
 /**
  * @brief Checks a calculable node for correctness.
  *
@@ -511,10 +976,13 @@ bool ReASItem::checkAsCalculable(const char* description,
 /**
  * @brief Returns the position of the item in the source code.
  *
- * @return the position of the item
+ * The position is decoded from the position table of the source.
+ *
+ * @return  NULL: unknown position<br>
+ *          otherwise: the position of the item
  */
 const ReSourcePosition* ReASItem::position() const {
-   return m_position;
+   return ReSourcePositionTable::find(m_position);
 }
 
 /**
@@ -523,6 +991,15 @@ const ReSourcePosition* ReASItem::position() const {
  * @param position  the position to store
  */
 void ReASItem::setPosition(const ReSourcePosition* position) {
+   m_position = position == NULL ? 0 : position->handle();
+}
+
+/**
+ * @brief Stores the position in the source code.
+ *
+ * @param position  the handle of the position to store
+ */
+void ReASItem::setPosition(ReSourcePositionHandle position) {
    m_position = position;
 }
 
@@ -544,8 +1021,9 @@ unsigned int ReASItem::id() const {
  */
 char* ReASItem::positionStr(char buffer[], size_t bufferSize) const {
    char* rc = (char*) "";
-   if (m_position != NULL)
-      rc = m_position->utf8(buffer, bufferSize);
+   const ReSourcePosition* position = this->position();
+   if (position != NULL)
+      rc = position->utf8(buffer, bufferSize);
    return rc;
 }
 
@@ -778,7 +1256,7 @@ bool ReASItem::typeCheck(ReASClass* class1, ReASClass* class2) {
 bool ReASItem::error(int location, ReParser& parser, const char* format, ...) {
    va_list varList;
    va_start(varList, format);
-   parser.addMessage(ReParser::LT_ERROR, location, m_position, format,
+   parser.addMessage(ReParser::LT_ERROR, location, position(), format,
                      varList);
    va_end(varList);
    return false;
@@ -917,8 +1395,8 @@ ReASListConstant::ReASListConstant() :
  * @return  the list
  */
 ReASListOfVariants* ReASListConstant::list() {
-   ReASListOfVariants* rc = static_cast<ReASListOfVariants*>(m_value.asObject(
-                               NULL));
+   ReASListOfVariants* rc = static_cast<ReASListOfVariants*>(
+                               m_value.asWritableObject(NULL));
    return rc;
 }
 
@@ -1035,8 +1513,8 @@ ReASVariant& ReASMapConstant::value() {
  * @return  the map of the constant
  */
 ReASMapOfVariants* ReASMapConstant::map() {
-   ReASMapOfVariants* rc = static_cast<ReASMapOfVariants*>(m_value.asObject(
-                              NULL));
+   ReASMapOfVariants* rc = static_cast<ReASMapOfVariants*>(
+                              m_value.asWritableObject(NULL));
    return rc;
 }
 
@@ -1089,8 +1567,8 @@ void ReASNamedValue::setSymbolSpace(ReSymbolSpace* space, int variableNo) {
 void ReASNamedValue::calc(ReVMThread& thread) {
    thread.valueToTop(m_symbolSpace, m_variableNo);
    if (thread.tracing())
-      thread.vm()->traceWriter()->format("nVal %s=%.80s", m_name.constData(),
-                                         thread.topOfValues().toString().constData());
+      thread.vm()->trace("nVal %s=%.80s", m_name.constData(),
+                         thread.topOfValues().toString().constData());
 }
 
 /**
@@ -1158,7 +1636,7 @@ ReASConversion::ReASConversion(ReASItem* expression) :
    ReASNode1(AST_CONVERSION),
    m_conversion(C_UNDEF) {
    m_child = expression;
-   m_position = expression->position();
+   m_position = expression->positionHandle();
 }
 
 /**
@@ -1189,8 +1667,8 @@ void ReASConversion::calc(ReVMThread& thread) {
       break;
    }
    if (thread.tracing())
-      thread.vm()->traceWriter()->format("(%s): %s",
-                                         m_class->name().constData(), value.toString().constData());
+      thread.vm()->trace("(%s): %s",
+                         m_class->name().constData(), value.toString().constData());
 }
 
 /**
@@ -1325,11 +1803,21 @@ void ReASIndexedValue::calc(ReVMThread& thread) {
    int ix = ixValue.asInt();
    ReASCalculable* list = dynamic_cast<ReASCalculable*>(m_child);
    list->calc(thread);
-   ReASVariant& listValue = thread.popValue();
-   //@ToDo: access to the lists element: assignment or to stack
+   // reserveValue() reuses the popped entry: the copy shares the list only
+   ReASVariant listValue(thread.popValue());
+   const ReASClass* clazz = NULL;
+   ReASListOfVariants* elements = static_cast<ReASListOfVariants*>(
+                                     listValue.asObject(&clazz));
+   if (clazz != ReASList::m_instance)
+      throw ReASException(position(), "not a list: %s",
+                          listValue.nameOfType());
+   if (ix < 0 || ix >= elements->size())
+      throw ReASException(position(), "index out of range: %d / %d", ix,
+                          elements->size());
+   elements->at(ix, thread.reserveValue());
    if (thread.tracing())
-      thread.vm()->traceWriter()->format("[%d]: %.80s", ix,
-                                         thread.topOfValues().toString().constData());
+      thread.vm()->trace("[%d]: %.80s", ix,
+                         thread.topOfValues().toString().constData());
 }
 
 /**
@@ -1505,12 +1993,12 @@ int ReASVarDefinition::execute(ReVMThread& thread) {
       ReASCalculable* expr = dynamic_cast<ReASCalculable*>(m_child3);
       expr->calc(thread);
       ReASVariant& value = thread.popValue();
-      ReASVariant& destination = thread.valueOfVariable(var->m_symbolSpace,
+      ReASVariant& destination = thread.writableVariable(var->m_symbolSpace,
                                  var->m_variableNo);
       if (thread.tracing())
-         thread.vm()->traceWriter()->format("%s = %.80s [%.80s]",
-                                            var->m_name.constData(), value.toString().constData(),
-                                            destination.toString().constData());
+         thread.vm()->trace("%s = %.80s [%.80s]",
+                            var->m_name.constData(), value.toString().constData(),
+                            destination.toString().constData());
       destination.copyValue(value);
    }
    return 0;
@@ -1556,11 +2044,15 @@ bool ReASExprStatement::check(ReParser& parser) {
  */
 int ReASExprStatement::execute(ReVMThread& thread) {
    ReASCalculable* expr = dynamic_cast<ReASCalculable*>(m_child2);
+   // the old result must not share a string which is appended now (+=):
+   thread.lastValue().destroyValue();
    expr->calc(thread);
    ReASVariant& value = thread.popValue();
    if (thread.tracing())
-      thread.vm()->traceWriter()->format("expr: %s",
-                                         value.toString().constData());
+      thread.vm()->trace("expr: %s",
+                         value.toString().constData());
+   // the last expression of a method body is its result:
+   thread.lastValue().copyValue(value);
    value.destroyValue();
    return 0;
 }
@@ -1886,8 +2378,8 @@ void ReASUnaryOp::calc(ReVMThread& thread) {
       break;
    }
    if (thread.tracing())
-      thread.vm()->traceWriter()->format("unary %s: %s", nameOfOp(m_operator),
-                                         value.toString().constData());
+      thread.vm()->trace("unary %s: %s", nameOfOp(m_operator),
+                         value.toString().constData());
 }
 
 /**
@@ -2029,9 +2521,18 @@ ReASStatement::ReASStatement() {
  */
 int ReASStatement::executeStatementList(ReASItem* list, ReVMThread& thread) {
    int rc = 0;
+   ReVMProfile* profile = thread.profile();
    while (rc == 0 && list != NULL) {
       ReASStatement* statement = dynamic_cast<ReASStatement*>(list);
-      rc = statement->execute(thread);
+      if (profile == NULL)
+         rc = statement->execute(thread);
+      else {
+         ReVMProfile::Mark mark;
+         profile->enter(list, mark);
+         rc = statement->execute(thread);
+         profile->leave(mark);
+      }
+      list = dynamic_cast<ReASNode1*>(list)->child();
    }
    return rc;
 }
@@ -2087,8 +2588,8 @@ int ReASIf::execute(ReVMThread& thread) {
    int rc = 0;
    bool condition = calcAsBoolean(m_child2, thread);
    if (thread.tracing())
-      thread.vm()->traceWriter()->format("if %s",
-                                         condition ? "true" : "false");
+      thread.vm()->trace("if %s",
+                         condition ? "true" : "false");
    ReASItem* list = condition ? m_child3 : m_child4;
    if (list != NULL) {
       if ((rc = executeStatementList(list, thread)) != 0) {
@@ -2159,8 +2660,20 @@ ReASForIterated::ReASForIterated(ReASVarDefinition* variable) :
  *                  <code>false</code>: otherwise
  */
 bool ReASForIterated::check(ReParser& parser) {
-   RE_UNUSED(&parser);
-   return false;
+   bool rc = true;
+   if (m_child3 == NULL || dynamic_cast<ReASNamedValue*>(m_child3) == NULL)
+      rc = error(LOC_FORIT_CHECK_1, parser, "not a variable: %s",
+                 m_child3 == NULL ? "<none>" : m_child3->nameOfItemType());
+   else if (!m_child3->check(parser))
+      rc = false;
+   if (m_child4 == NULL || dynamic_cast<ReASCalculable*>(m_child4) == NULL)
+      rc = error(LOC_FORIT_CHECK_2, parser, "container not calculable: %s",
+                 m_child4 == NULL ? "<none>" : m_child4->nameOfItemType());
+   else if (!m_child4->check(parser))
+      rc = false;
+   if (m_child2 != NULL && !checkStatementList(m_child2, parser))
+      rc = false;
+   return rc;
 }
 
 /**
@@ -2171,8 +2684,62 @@ bool ReASForIterated::check(ReParser& parser) {
  *          n < 0: stop the -n most inner statement lists (initialized by continue)
  */
 int ReASForIterated::execute(ReVMThread& thread) {
-   RE_UNUSED(&thread);
-   return 0;
+   int rc = 0;
+   ReASStatement* body = dynamic_cast<ReASStatement*>(m_child2);
+   if (body == NULL)
+      throw ReASException(
+         m_child2 == NULL ? position() : m_child2->position(),
+         "for statement: body is not a statement");
+   ReASNamedValue* var = dynamic_cast<ReASNamedValue*>(m_child3);
+   ReASCalculable* container = dynamic_cast<ReASCalculable*>(m_child4);
+   container->calc(thread);
+   // the copy shares the elements: changes in the body do not disturb us
+   ReASVariant listValue(thread.popValue());
+   const ReASClass* clazz = NULL;
+   ReASListOfVariants* elements = static_cast<ReASListOfVariants*>(
+                                     listValue.asObject(&clazz));
+   if (clazz != ReASList::m_instance)
+      throw ReASException(position(), "for statement: not a list: %s",
+                          listValue.nameOfType());
+   ReASVariant& current = thread.writableVariable(var->symbolSpace(),
+                          var->variableNo());
+   ReASListOfVariants::StorageType type = elements->storageType();
+   int count = elements->size();
+   if (thread.tracing())
+      thread.vm()->trace("for %s in %d elements",
+                         var->name().constData(), count);
+   for (int ix = 0; ix < count; ix++) {
+      // the packed arrays are read without building an element variant:
+      switch (type) {
+      case ReASListOfVariants::ST_INT:
+         current.setInt(elements->intAt(ix));
+         break;
+      case ReASListOfVariants::ST_FLOAT:
+         current.setFloat(elements->floatAt(ix));
+         break;
+      case ReASListOfVariants::ST_BOOL:
+         current.setBool(elements->boolAt(ix));
+         break;
+      default:
+         current.copyValue(elements->variantAt(ix));
+         break;
+      }
+      int rc2 = body->execute(thread);
+      if (rc2 != 0) {
+         if (rc2 > 0) {
+            // rc comes from "break";
+            rc = rc2 - 1;
+         } else {
+            // rc comes from "continue";
+            if (rc2 == -1)
+               continue;
+            else
+               rc = rc2 + 1;
+         }
+         break;
+      }
+   }
+   return rc;
 }
 
 /**
@@ -2272,22 +2839,46 @@ bool ReASForCounted::check(ReParser& parser) {
  */
 int ReASForCounted::execute(ReVMThread& thread) {
    int rc = 0;
-   ReASStatement* body = dynamic_cast<ReASStatement*>(m_child2);
-   if (body == NULL)
-      throw ReASException(
-         m_child2 == NULL ? m_position : m_child2->position(),
-         "forc statement: body is not a statement");
    int start = m_child4 == NULL ? 1 : calcAsInteger(m_child4, thread);
    int end = m_child5 == NULL ? 0 : calcAsInteger(m_child5, thread);
    int step = m_child6 == NULL ? 1 : calcAsInteger(m_child6, thread);
    ReASNamedValue* var =
       m_child3 == NULL ? NULL : dynamic_cast<ReASNamedValue*>(m_child3);
    if (thread.tracing())
-      thread.vm()->traceWriter()->format("for %s from %d to %d step %d",
-                                         var == NULL ? "?" : var->name().constData(), start, end, step);
+      thread.vm()->trace("for %s from %d to %d step %d%s",
+                         var == NULL ? "?" : var->name().constData(), start, end, step,
+                         (m_flags & NF_PARALLEL) != 0 ? " parallel" : "");
+   if ((m_flags & NF_PARALLEL) != 0)
+      rc = thread.vm()->parallelFor(thread, this, start, end, step);
+   else
+      rc = executeRange(thread, start, end, step);
+   return rc;
+}
+
+/**
+ * @brief Executes the body for a given range of the loop variable.
+ *
+ * @param thread    the execution unit
+ * @param start     the first value of the loop variable
+ * @param end       the last value of the loop variable
+ * @param step      the distance between two values of the loop variable
+ * @return          0: continue the current statement list<br>
+ *                  otherwise: see <code>execute()</code>
+ */
+int ReASForCounted::executeRange(ReVMThread& thread, int start, int end,
+                                 int step) {
+   int rc = 0;
+   if (m_child2 != NULL && dynamic_cast<ReASStatement*>(m_child2) == NULL)
+      throw ReASException(m_child2->position(),
+                          "forc statement: body is not a statement");
+   ReASNamedValue* var =
+      m_child3 == NULL ? NULL : dynamic_cast<ReASNamedValue*>(m_child3);
+   ReASVariant* counter = var == NULL ? NULL
+                          : &thread.writableVariable(var->symbolSpace(), var->variableNo());
    for (int ii = start; ii <= end; ii += step) {
-      //@ToDo: assign to the variable
-      int rc2 = body->execute(thread);
+      if (counter != NULL)
+         counter->setInt(ii);
+      int rc2 = executeStatementList(m_child2, thread);
       if (rc2 != 0) {
          if (rc2 > 0) {
             // rc comes from "break";
@@ -2305,6 +2896,75 @@ int ReASForCounted::execute(ReVMThread& thread) {
    return rc;
 }
 
+/**
+ * @brief Returns the variables owned by each part of a parallel loop.
+ *
+ * These are the loop variable and the variables defined in the body. All
+ * other variables of the same symbol space are shared by the parts.
+ *
+ * @param isPrivate OUT: isPrivate[n] is <code>true</code> if the variable
+ *                  with the number n in the symbol space of the loop
+ *                  variable is private
+ */
+void ReASForCounted::privateVariables(QVector<bool>& isPrivate) const {
+   ReASNamedValue* var = dynamic_cast<ReASNamedValue*>(m_child3);
+   isPrivate.fill(false, var == NULL ? 0
+                  : var->symbolSpace()->listOfVars().size());
+   if (var != NULL) {
+      isPrivate[var->variableNo()] = true;
+      markDefinitions(m_child2, var->symbolSpace(), isPrivate);
+   }
+}
+
+/**
+ * @brief Marks the variables defined in a subtree.
+ *
+ * @param item      NULL or the subtree, e.g. a statement list
+ * @param space     only variables of this symbol space are marked
+ * @param isPrivate IN/OUT: the flags indexed by the variable number
+ */
+void ReASForCounted::markDefinitions(ReASItem* item, ReSymbolSpace* space,
+                                     QVector<bool>& isPrivate) {
+   // the statements are chained by m_child: no recursion for them
+   while (item != NULL) {
+      ReASNamedValue* var = NULL;
+      switch (item->nodeType()) {
+      case AST_VAR_DEFINITION:
+         var = dynamic_cast<ReASNamedValue*>(
+                  dynamic_cast<ReASVarDefinition*>(item)->child2());
+         break;
+      case AST_ITERATED_FOR:
+      case AST_COUNTED_FOR:
+         // the loop variables have no definition node:
+         var = dynamic_cast<ReASNamedValue*>(
+                  dynamic_cast<ReASNode3*>(item)->child3());
+         break;
+      default:
+         break;
+      }
+      if (var != NULL && var->symbolSpace() == space
+            && var->variableNo() >= 0 && var->variableNo() < isPrivate.size())
+         isPrivate[var->variableNo()] = true;
+      ReASNode2* node2 = dynamic_cast<ReASNode2*>(item);
+      if (node2 != NULL)
+         markDefinitions(node2->child2(), space, isPrivate);
+      ReASNode3* node3 = dynamic_cast<ReASNode3*>(item);
+      if (node3 != NULL)
+         markDefinitions(node3->child3(), space, isPrivate);
+      ReASNode4* node4 = dynamic_cast<ReASNode4*>(item);
+      if (node4 != NULL)
+         markDefinitions(node4->child4(), space, isPrivate);
+      ReASNode5* node5 = dynamic_cast<ReASNode5*>(item);
+      if (node5 != NULL)
+         markDefinitions(node5->child5(), space, isPrivate);
+      ReASNode6* node6 = dynamic_cast<ReASNode6*>(item);
+      if (node6 != NULL)
+         markDefinitions(node6->child6(), space, isPrivate);
+      ReASNode1* node1 = dynamic_cast<ReASNode1*>(item);
+      item = node1 == NULL ? NULL : node1->child();
+   }
+}
+
 /**
  * @brief Writes the internals into a file.
  *
@@ -2381,7 +3041,7 @@ int ReASWhile::execute(ReVMThread& thread) {
    int rc = 0;
    ReASStatement* body = dynamic_cast<ReASStatement*>(m_child3);
    if (thread.tracing())
-      thread.vm()->traceWriter()->write("while");
+      thread.vm()->trace("while");
    while (calcAsBoolean(m_child2, thread)) {
       int rc2 = body->execute(thread);
       if (rc2 != 0) {
@@ -2468,7 +3128,7 @@ int ReASRepeat::execute(ReVMThread& thread) {
    int rc = 0;
    ReASStatement* body = dynamic_cast<ReASStatement*>(m_child3);
    if (thread.tracing())
-      thread.vm()->traceWriter()->write("repeat");
+      thread.vm()->trace("repeat");
    do {
       int rc2 = body->execute(thread);
       if (rc2 != 0) {
@@ -2575,7 +3235,9 @@ ReASTree::ReASTree() :
    m_modules(),
    m_symbolSpaces(),
    m_currentSpace(NULL),
-   m_store(128 * 1024) {
+   m_replacedSpaces(),
+   m_store(128 * 1024),
+   m_strings() {
    init();
 }
 
@@ -2606,7 +3268,29 @@ void ReASTree::destroy() {
       delete it.value();
    }
    m_symbolSpaceHeap.clear();
+   for (int ix = 0; ix < m_replacedSpaces.size(); ix++)
+      delete m_replacedSpaces.at(ix);
+   m_replacedSpaces.clear();
+   m_strings.clear();
 }
+
+/**
+ * @brief Returns the shared instance of a string.
+ *
+ * Identifiers and map keys are stored only once: copies of the result
+ * share the buffer. Therefore comparisons of interned strings are mostly
+ * pointer comparisons.
+ *
+ * @param string    the string to intern
+ * @return          the interned string with the same content
+ */
+const QByteArray& ReASTree::intern(const QByteArray& string) {
+   QSet<QByteArray>::const_iterator it = m_strings.constFind(string);
+   if (it == m_strings.constEnd())
+      it = m_strings.insert(string);
+   return *it;
+}
+
 /**
  * @brief Returns the string storage of the instance.
  *
@@ -2619,21 +3303,26 @@ ReByteStorage& ReASTree::store() {
 /**
  * @brief Handles the start of a new module.
  *
+ * A known module becomes the current symbol space again (incremental
+ * parsing of a part of the module).
+ *
  * @param name  the module's name
- * @return      true: the module is new<br>
- *              false: the module is yet known
+ * @return      false: the module is new<br>
+ *              true: the module is yet known
  */
 bool ReASTree::startModule(ReSourceUnitName name) {
    bool rc = m_modules.contains(name);
-   if (!rc) {
+   ReSymbolSpace* space;
+   if (rc)
+      space = m_modules[name];
+   else {
       // freed in ~ReASTree()
-      ReSymbolSpace* space = new ReSymbolSpace(ReSymbolSpace::SST_MODULE,
-            name, m_global);
+      space = new ReSymbolSpace(ReSymbolSpace::SST_MODULE, name, m_global);
       m_symbolSpaceHeap[name] = space;
       m_modules[name] = space;
-      m_symbolSpaces.append(space);
-      m_currentSpace = space;
    }
+   m_symbolSpaces.append(space);
+   m_currentSpace = space;
    return rc;
 }
 /**
@@ -2677,6 +3366,9 @@ ReSymbolSpace* ReASTree::startClassOrMethod(const QByteArray& name,
    QByteArray fullName = parent->name() + "." + name;
    // freed in ~ReASTree()
    ReSymbolSpace* space = new ReSymbolSpace(type, fullName, parent);
+   // overloaded or parsed again: the old space may be in use
+   if (m_symbolSpaceHeap.contains(fullName))
+      m_replacedSpaces.append(m_symbolSpaceHeap[fullName]);
    m_symbolSpaceHeap[fullName] = space;
    m_symbolSpaces.append(space);
    m_currentSpace = space;
@@ -2763,6 +3455,10 @@ void ReASTree::dump(const char* filename, int flags, const char* header) {
  *
  * @brief Implements a method or function call for the Abstract Syntax Tree.
  *
+ * The call site caches the resolved method, the frame size and the
+ * argument expressions (inline cache). A call calculates the arguments
+ * directly into the frame window of the callee on the value stack.
+ *
  * <code>m_child</code>: next statement<br>
  * <code>m_child2</code>: argument list<br>
  * <code>m_child3</code>: parent (variable, field ...)
@@ -2775,15 +3471,112 @@ void ReASTree::dump(const char* filename, int flags, const char* header) {
  *                  otherwise: the parent (variable, field ...)
  */
 
+QMutex ReASMethodCall::m_resolveMutex;
+QAtomicInt ReASMethodCall::m_generation(0);
+
 ReASMethodCall::ReASMethodCall(const QByteArray& name, ReASItem* parent) :
    ReASNode3(AST_METHOD_CALL),
    ReASStatement(),
+   ReASCalculable(),
    m_name(name),
-   m_method(NULL) {
-   m_flags |= NF_STATEMENT;
+   m_method(NULL),
+   m_builtin(BI_NONE),
+   m_symbolSpace(NULL),
+   m_cacheGeneration(-1),
+   m_frameSize(0),
+   m_args(),
+   m_firstDefault(NULL) {
+   m_flags |= NF_STATEMENT | NF_CALCULABLE;
    m_child3 = parent;
 }
 
+/**
+ * @brief Calls the method and puts the result to the top of the value stack.
+ *
+ * @param thread    IN/OUT: the execution unit, a VM thread
+ */
+void ReASMethodCall::calc(ReVMThread& thread) {
+   // acquire: the cache fields are published by the release in resolve()
+   if (m_cacheGeneration.loadAcquire() != m_generation.load()) {
+      // the threads of a parallel loop may reach the call at the same time:
+      QMutexLocker locker(&m_resolveMutex);
+      const char* message =
+         m_cacheGeneration.loadAcquire() != m_generation.load()
+         ? resolve() : NULL;
+      if (message != NULL)
+         throw ReASException(position(), "%s(): %s", m_name.constData(),
+                             message);
+   }
+   if (m_builtin != BI_NONE)
+      calcBuiltin(thread);
+   else {
+      // the values are the first variables of the callee's frame:
+      int count = m_args.size();
+      for (int ix = 0; ix < count; ix++)
+         m_args.at(ix)->calc(thread);
+      ReSymbolSpace* symbols = m_method->symbols();
+      thread.pushFrame(this, symbols, m_frameSize, count);
+      for (ReASVarDefinition* param = m_firstDefault; param != NULL;
+            param = dynamic_cast<ReASVarDefinition*>(param->child())) {
+         ReASCalculable* expr = dynamic_cast<ReASCalculable*>(
+                                   param->child3());
+         if (expr != NULL) {
+            ReASNamedValue* var = dynamic_cast<ReASNamedValue*>(
+                                     param->child2());
+            expr->calc(thread);
+            thread.valueOfVariable(symbols, var->variableNo()).copyValue(
+               thread.popValue());
+         }
+      }
+      thread.lastValue().destroyValue();
+      if (thread.tracing())
+         thread.vm()->trace("call %s", m_name.constData());
+      ReVMProfile* profile = thread.profile();
+      if (profile == NULL)
+         m_method->execute(thread);
+      else {
+         ReVMProfile::Mark mark;
+         profile->enterCall(m_name, mark);
+         m_method->execute(thread);
+         profile->leaveCall(mark);
+      }
+      thread.popFrame();
+      thread.reserveValue().copyValue(thread.lastValue());
+   }
+}
+
+/**
+ * @brief Calls a method implemented by the VM.
+ *
+ * The channels are the only way to exchange data between the threads of a
+ * parallel loop (see <code>ReVMChannel</code>).
+ *
+ * @param thread    IN/OUT: the execution unit, a VM thread
+ */
+void ReASMethodCall::calcBuiltin(ReVMThread& thread) {
+   m_args.at(0)->calc(thread);
+   // the stack entry will be reused by the next calc():
+   QByteArray name = *thread.popValue().asString();
+   ReVMChannel* channel = thread.vm()->channel(name);
+   if (thread.tracing())
+      thread.vm()->trace("call %s(%s)", m_name.constData(), name.constData());
+   switch (m_builtin) {
+   case BI_SEND:
+      m_args.at(1)->calc(thread);
+      // the result is the sent value:
+      channel->put(thread.topOfValues());
+      break;
+   case BI_RECEIVE:
+      channel->take(thread.reserveValue());
+      break;
+   case BI_CLOSE:
+   default:
+      channel->close();
+      thread.reserveValue();
+      break;
+   }
+}
+
 /**
  * @brief Checks the correctness of the instance.
  *
@@ -2793,11 +3586,15 @@ ReASMethodCall::ReASMethodCall(const QByteArray& name, ReASItem* parent) :
  */
 bool ReASMethodCall::check(ReParser& parser) {
    bool rc = true;
+   const char* message =
+      m_cacheGeneration.load() != m_generation.load() ? resolve() : NULL;
+   if (message != NULL)
+      rc = error(LOC_METHOD_CALL_CHECK_5, parser, "%s(): %s",
+                 m_name.constData(), message);
    ReASExprStatement* args = dynamic_cast<ReASExprStatement*>(m_child2);
    int argCount = 0;
-   ReASMethod* method = m_method;
-   ReASVarDefinition* params =
-      dynamic_cast<ReASVarDefinition*>(method->child2());
+   ReASVarDefinition* params = m_method == NULL ? NULL
+                               : dynamic_cast<ReASVarDefinition*>(m_method->child2());
    while (args != NULL && params != NULL) {
       argCount++;
       ReASCalculable* argExpr = dynamic_cast<ReASCalculable*>(args->child2());
@@ -2816,17 +3613,22 @@ bool ReASMethodCall::check(ReParser& parser) {
             // tryConversion() calls args->args->child2()->check()!
             ReASConversion* converter = ReASConversion::tryConversion(
                                            var->clazz(), args->child2(), parser, rc);
-            if (rc && converter != NULL)
+            if (rc && converter != NULL) {
                args->setChild2(converter);
+               // the cache must contain the converter:
+               m_args[argCount - 1] = converter;
+            }
          }
       }
       args = dynamic_cast<ReASExprStatement*>(args->child());
       params = dynamic_cast<ReASVarDefinition*>(params->child());
    }
-   if (args != NULL && params == NULL)
+   // resolve() has already tested the argument count:
+   if (m_method != NULL && args != NULL && params == NULL)
       rc = error(LOC_MEHTOD_CALL_CHECK_3, parser,
                  "too many arguments: %d are enough", argCount);
-   else if (args == NULL && params != NULL && params->child3() != NULL)
+   else if (m_method != NULL && args == NULL && params != NULL
+            && params->child3() == NULL)
       rc = error(LOC_MEHTOD_CALL_CHECK_4, parser,
                  "too few arguments: %d are not enough", argCount);
    return rc;
@@ -2853,25 +3655,88 @@ void ReASMethodCall::dump(ReWriter& writer, int indent) {
 }
 
 /**
- * @brief Executes the method call.
+ * @brief Executes the method call as a statement.
  *
  * @return  0: continue the current statement list
  */
 int ReASMethodCall::execute(ReVMThread& thread) {
-   int rc = 0;
-   ReStackFrame frame(this, m_method->symbols());
-   thread.pushFrame(&frame);
-   ReASExprStatement* args = dynamic_cast<ReASExprStatement*>(m_child2);
-   int ixArg = -1;
-   while (args != NULL) {
-      ixArg++;
-      ReASCalculable* argExpr = dynamic_cast<ReASCalculable*>(args->child2());
-      argExpr->calc(thread);
-      ReASVariant& value = thread.popValue();
-      ReASVariant& varValue = frame.valueOfVariable(ixArg);
-      varValue.copyValue(value);
+   calc(thread);
+   // the result is not used:
+   thread.popValue();
+   return 0;
+}
+
+/**
+ * @brief Fills the inline cache of the call site.
+ *
+ * Searches the method in the symbol space of the call and its parents. The
+ * first overloaded method accepting the number of arguments will be used.
+ * If no method is found the builtin methods are tested.
+ *
+ * @return  NULL: success<br>
+ *          otherwise: the error message
+ */
+const char* ReASMethodCall::resolve() {
+   const char* rc = NULL;
+   m_method = NULL;
+   m_builtin = BI_NONE;
+   QVector<ReASCalculable*> args;
+   for (ReASExprStatement* arg = dynamic_cast<ReASExprStatement*>(m_child2);
+         arg != NULL; arg = dynamic_cast<ReASExprStatement*>(arg->child())) {
+      ReASCalculable* expr = dynamic_cast<ReASCalculable*>(arg->child2());
+      if (expr == NULL)
+         return "argument is not calculable";
+      args.append(expr);
+   }
+   ReASMethod* method = NULL;
+   for (ReSymbolSpace* space = m_symbolSpace; method == NULL && space != NULL;
+         space = space->parent())
+      method = space->findMethod(m_name);
+   if (method == NULL) {
+      Builtin builtin = BI_NONE;
+      if (m_name == "send")
+         builtin = args.size() == 2 ? BI_SEND : BI_NONE;
+      else if (m_name == "receive")
+         builtin = args.size() == 1 ? BI_RECEIVE : BI_NONE;
+      else if (m_name == "close")
+         builtin = args.size() == 1 ? BI_CLOSE : BI_NONE;
+      if (builtin == BI_NONE)
+         rc = "unknown method";
+      else {
+         m_args = args;
+         m_builtin = builtin;
+         // the last assignment: publishes the cache to calc()
+         m_cacheGeneration.storeRelease(m_generation.load());
+      }
+   }
+   for (; method != NULL; method = method->sibling()) {
+      // the parameters are the first variables of the method's symbol space:
+      ReASVarDefinition* param =
+         dynamic_cast<ReASVarDefinition*>(method->child2());
+      int ix = 0;
+      bool ok = true;
+      for (; ok && param != NULL && ix < args.size(); ix++) {
+         ReASNamedValue* var = dynamic_cast<ReASNamedValue*>(param->child2());
+         ok = var != NULL && var->variableNo() == ix;
+         param = dynamic_cast<ReASVarDefinition*>(param->child());
+      }
+      if (!ok)
+         rc = "unexpected parameter layout";
+      else if (ix < args.size())
+         rc = "too many arguments";
+      else if (param != NULL && param->child3() == NULL)
+         rc = "too few arguments";
+      else {
+         rc = NULL;
+         m_frameSize = method->symbols()->listOfVars().size();
+         m_args = args;
+         m_firstDefault = param;
+         m_method = method;
+         // the last assignment: publishes the cache to calc()
+         m_cacheGeneration.storeRelease(m_generation.load());
+         break;
+      }
    }
-   thread.popFrame();
    return rc;
 }
 
@@ -2881,10 +3746,28 @@ ReASMethod* ReASMethodCall::method() const {
 
 /**
  * @brief Sets the method.
+ *
+ * The inline cache will be filled by the next <code>check()</code> or call.
+ *
  * @param method    method to set
  */
 void ReASMethodCall::setMethod(ReASMethod* method) {
-   m_method = method;
+   m_method = NULL;
+   m_builtin = BI_NONE;
+   m_cacheGeneration.store(-1);
+   if (method != NULL) {
+      m_name = method->name();
+      m_symbolSpace = method->symbols()->parent();
+   }
+}
+
+/**
+ * @brief Sets the symbol space containing the call.
+ *
+ * @param space     the start of the method search
+ */
+void ReASMethodCall::setSymbolSpace(ReSymbolSpace* space) {
+   m_symbolSpace = space;
 }
 
 /**
@@ -2896,6 +3779,19 @@ ReASExprStatement* ReASMethodCall::arg1() const {
    return dynamic_cast<ReASExprStatement*>(m_child2);
 }
 
+/**
+ * @brief Invalidates the inline caches of all call sites.
+ *
+ * Must be called if methods are removed from a symbol space, e.g. by the
+ * incremental parser. Each call site resolves its method again on the next
+ * <code>check()</code> or call.
+ *
+ * Note: no virtual machine may run at the same time.
+ */
+void ReASMethodCall::invalidateCaches() {
+   m_generation.fetchAndAddOrdered(1);
+}
+
 /** @class ReASException ReASTree.hpp "expr/ReASTree.hpp"
  *
  * @brief Implements a call of a method or function.
@@ -2948,11 +3844,14 @@ void ReASBinaryOp::calc(ReVMThread& thread) {
             case ReASVariant::VT_INTEGER:
                val1.setInt(val1.asInt() + val2.asInt());
                break;
-            case ReASVariant::VT_OBJECT:
-            //if (val1.getClass() == ReASString::m_instance)
             default:
-               error(thread.logger(), LOC_BINOP_CALC_2,
-                     "invalid type for '+': %s", val1.nameOfType());
+               if (val1.getClass() == ReASString::m_instance
+                     && val2.getClass() == ReASString::m_instance)
+                  // val1 is a temporary: a chain a + b + c builds one string
+                  ReASString::append(val1, *val2.asString());
+               else
+                  error(thread.logger(), LOC_BINOP_CALC_2,
+                        "invalid type for '+': %s", val1.nameOfType());
                break;
             }
             break;
@@ -3089,6 +3988,14 @@ void ReASBinaryOp::calc(ReVMThread& thread) {
                break;
             }
             break;
+         case BOP_EQ:
+         case BOP_NE:
+         case BOP_LE:
+         case BOP_LT:
+         case BOP_GE:
+         case BOP_GT:
+            val1.setBool(compare(thread, val1, val2));
+            break;
          default:
             break;
          }
@@ -3149,27 +4056,32 @@ void ReASBinaryOp::dump(ReWriter& writer, int indent) {
 /**
  * @brief Does an assignment.
  *
- * @param thread
+ * The assigned value remains on the value stack: it is the value of the
+ * expression.
+ *
+ * @param thread    IN/OUT: the execution unit, a VM thread
  */
 void ReASBinaryOp::assign(ReVMThread& thread) {
-   ReASVariant& rValue = thread.lValue(m_child);
    ReASCalculable* expr = dynamic_cast<ReASCalculable*>(m_child2);
-   if (expr == NULL)
+   if (expr == NULL) {
       error(thread.logger(), LOC_BINOP_1, "not a calculable: id: %d",
             m_child2 == NULL ? 0 : m_child2->id());
-   else {
-      ReASVariant& value = thread.popValue();
+      thread.reserveValue();
+   } else {
+      expr->calc(thread);
+      ReASVariant& value = thread.topOfValues();
+      ReASVariant& rValue = thread.lValue(m_child);
+      bool done = false;
       switch (m_operator) {
       case BOP_ASSIGN:
          break;
       case BOP_PLUS_ASSIGN:
-         //switch(value.variantType()){
-         //}
-         break;
       case BOP_MINUS_ASSIGN:
       case BOP_TIMES_ASSIGN:
       case BOP_DIV_ASSIGN:
       case BOP_MOD_ASSIGN:
+         done = assignArithmetic(thread, rValue, value);
+         break;
       case BOP_POWER_ASSIGN:
       case BOP_LOG_OR_ASSIGN:
       case BOP_LOG_AND_ASSIGN:
@@ -3181,8 +4093,157 @@ void ReASBinaryOp::assign(ReVMThread& thread) {
       default:
          break;
       }
-      rValue.copyValue(value);
+      // the value of the expression is the new value of the variable:
+      if (done)
+         value.copyValue(rValue);
+      else
+         rValue.copyValue(value);
+   }
+}
+
+/**
+ * @brief Does an assignment combined with an arithmetic operator.
+ *
+ * The variable is changed in place: a string which is the target of
+ * repeated <code>+=</code> is appended without a copy (string builder).
+ *
+ * @param thread    the execution unit (for error logging)
+ * @param target    IN/OUT: the variable
+ * @param operand   the right operand
+ * @return          <code>true</code>: the variable has been changed<br>
+ *                  <code>false</code>: invalid operand types
+ */
+bool ReASBinaryOp::assignArithmetic(ReVMThread& thread, ReASVariant& target,
+                                    const ReASVariant& operand) {
+   bool rc = true;
+   switch (target.variantType()) {
+   case ReASVariant::VT_INTEGER: {
+      int value = target.asInt();
+      int value2 = operand.asInt();
+      switch (m_operator) {
+      case BOP_PLUS_ASSIGN:
+         value += value2;
+         break;
+      case BOP_MINUS_ASSIGN:
+         value -= value2;
+         break;
+      case BOP_TIMES_ASSIGN:
+         value *= value2;
+         break;
+      case BOP_DIV_ASSIGN:
+         value /= value2;
+         break;
+      default:
+         value %= value2;
+         break;
+      }
+      target.setInt(value);
+      break;
+   }
+   case ReASVariant::VT_FLOAT: {
+      qreal value = target.asFloat();
+      qreal value2 = operand.asFloat();
+      switch (m_operator) {
+      case BOP_PLUS_ASSIGN:
+         value += value2;
+         break;
+      case BOP_MINUS_ASSIGN:
+         value -= value2;
+         break;
+      case BOP_TIMES_ASSIGN:
+         value *= value2;
+         break;
+      case BOP_DIV_ASSIGN:
+         value /= value2;
+         break;
+      default:
+         value = fmod(value, value2);
+         break;
+      }
+      target.setFloat(value);
+      break;
+   }
+   case ReASVariant::VT_OBJECT:
+      rc = m_operator == BOP_PLUS_ASSIGN
+           && target.getClass() == ReASString::m_instance;
+      if (rc)
+         ReASString::append(target, *operand.asString());
+      break;
+   default:
+      rc = false;
+      break;
+   }
+   if (!rc)
+      error(thread.logger(), LOC_BINOP_ASSIGN_1, "invalid type for '%s': %s",
+            nameOfOp(m_operator), target.nameOfType());
+   return rc;
+}
+
+/**
+ * @brief Compares two values with the comparison operator of the instance.
+ *
+ * @param thread    the execution unit (for error logging)
+ * @param val1      the left operand
+ * @param val2      the right operand
+ * @return          the result of the comparison
+ */
+bool ReASBinaryOp::compare(ReVMThread& thread, const ReASVariant& val1,
+                           const ReASVariant& val2) {
+   int diff = 0;
+   switch (val1.variantType()) {
+   case ReASVariant::VT_INTEGER: {
+      int int1 = val1.asInt();
+      int int2 = val2.asInt();
+      diff = int1 < int2 ? -1 : (int1 > int2 ? 1 : 0);
+      break;
+   }
+   case ReASVariant::VT_FLOAT: {
+      qreal float1 = val1.asFloat();
+      qreal float2 = val2.asFloat();
+      diff = float1 < float2 ? -1 : (float1 > float2 ? 1 : 0);
+      break;
+   }
+   case ReASVariant::VT_BOOL:
+      diff = int(val1.asBool()) - int(val2.asBool());
+      break;
+   case ReASVariant::VT_OBJECT:
+      if (val1.getClass() == ReASString::m_instance
+            && val2.getClass() == ReASString::m_instance) {
+         const QByteArray& string1 = *val1.asString();
+         const QByteArray& string2 = *val2.asString();
+         diff = string1 < string2 ? -1 : (string1 == string2 ? 0 : 1);
+         break;
+      }
+   // no break: other objects cannot be compared
+   default:
+      error(thread.logger(), LOC_BINOP_CALC_13,
+            "invalid type for '%s': %s", nameOfOp(m_operator),
+            val1.nameOfType());
+      break;
    }
+   bool rc;
+   switch (m_operator) {
+   case BOP_EQ:
+      rc = diff == 0;
+      break;
+   case BOP_NE:
+      rc = diff != 0;
+      break;
+   case BOP_LE:
+      rc = diff <= 0;
+      break;
+   case BOP_LT:
+      rc = diff < 0;
+      break;
+   case BOP_GE:
+      rc = diff >= 0;
+      break;
+   case BOP_GT:
+   default:
+      rc = diff > 0;
+      break;
+   }
+   return rc;
 }
 /**
  * @brief Returns the name (a string) of a binary operator.
@@ -3349,12 +4410,16 @@ bool ReASMethod::check(ReParser& parser) {
 }
 
 /**
- * @brief Executes the statement.
+ * @brief Executes the body of the method.
+ *
+ * The frame of the method must be created by the caller
+ * (see <code>ReASMethodCall::calc()</code>).
  *
- * This method will be never called. Must exit: Otherwise the class is abstract.
+ * @param thread    the execution unit
+ * @return          0: continue the current statement list
  */
 int ReASMethod::execute(ReVMThread& thread) {
-   RE_UNUSED(&thread);
+   ReASStatement::executeStatementList(m_child, thread);
    return 0;
 }
 
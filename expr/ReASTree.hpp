@@ -57,6 +57,25 @@ class ReASNamedValue;
 class ReASItem;
 class ReASCondition;
 
+/**
+ * The payload of an object value of a <code>ReASVariant</code>.
+ *
+ * Copies of a variant share the payload. It is copied only if a holder
+ * wants to change it (copy on write).
+ */
+class ReASSharedObject {
+public:
+   ReASSharedObject(void* object) :
+      m_refCount(1),
+      m_object(object) {
+   }
+public:
+   /// the count of variants using the payload
+   QAtomicInt m_refCount;
+   /// the class specific value object
+   void* m_object;
+};
+
 class ReASVariant {
    /* The VM uses some tricks (performance): Therefore this class
     * must not be virtual!
@@ -88,6 +107,8 @@ public:
    bool asBool() const;
    void* asObject(const ReASClass** clazz) const;
    const QByteArray* asString() const;
+   void* asWritableObject(const ReASClass** clazz);
+   bool isShared() const;
    void setFloat(qreal number);
    void setInt(int integer);
    void setBool(bool value);
@@ -107,11 +128,155 @@ private:
       qreal m_float;
       int m_int;
       bool m_bool;
-      void* m_object;
+      ReASSharedObject* m_shared;
    } m_value;
    const ReASClass* m_class;
 };
 
+/**
+ * The elements of a list.
+ *
+ * As long as all elements have the same simple type they are stored in a
+ * packed array of that type. The first element of another type converts
+ * the storage into a vector of variants.
+ */
+class ReASListOfVariants {
+public:
+   enum StorageType {
+      ST_EMPTY,
+      ST_INT,
+      ST_FLOAT,
+      ST_BOOL,
+      ST_VARIANT
+   };
+public:
+   ReASListOfVariants();
+public:
+   void append(const ReASVariant& value);
+   void at(int index, ReASVariant& value) const;
+   /** Returns an element of a list with storage type ST_BOOL.
+    * @param index  the index of the element: 0..N-1
+    * @return       the element
+    */
+   inline bool boolAt(int index) const {
+      return m_bools.at(index);
+   }
+   void clear();
+   /** Returns an element of a list with storage type ST_FLOAT.
+    * @param index  the index of the element: 0..N-1
+    * @return       the element
+    */
+   inline qreal floatAt(int index) const {
+      return m_floats.at(index);
+   }
+   /** Returns an element of a list with storage type ST_INT.
+    * @param index  the index of the element: 0..N-1
+    * @return       the element
+    */
+   inline int intAt(int index) const {
+      return m_ints.at(index);
+   }
+   /** Tests whether the list has no elements.
+    * @return  <code>true</code>: the list is empty
+    */
+   inline bool isEmpty() const {
+      return m_count == 0;
+   }
+   void reserve(int size);
+   void set(int index, const ReASVariant& value);
+   /** Returns the number of elements.
+    * @return  the number of elements
+    */
+   inline int size() const {
+      return m_count;
+   }
+   /** Returns the kind of the storage.
+    * @return  the storage type, e.g. ST_INT
+    */
+   inline StorageType storageType() const {
+      return m_storageType;
+   }
+   /** Returns an element of a list with storage type ST_VARIANT.
+    * @param index  the index of the element: 0..N-1
+    * @return       the element
+    */
+   inline const ReASVariant& variantAt(int index) const {
+      return m_variants.at(index);
+   }
+private:
+   void promote();
+   static StorageType storageTypeOf(const ReASVariant& value);
+private:
+   StorageType m_storageType;
+   int m_count;
+   // only the vector belonging to m_storageType is used:
+   QVector<int> m_ints;
+   QVector<qreal> m_floats;
+   QVector<bool> m_bools;
+   QVector<ReASVariant> m_variants;
+};
+
+/**
+ * The (key, value) pairs of a map.
+ *
+ * The entries are stored in insertion order. An open addressing hash table
+ * (linear probing) contains the indexes of the entries. Keys are strings or
+ * integers.
+ */
+class ReASMapOfVariants {
+public:
+   class Entry {
+   public:
+      /// the key if <code>m_isIntKey</code> is false
+      QByteArray m_key;
+      int m_intKey;
+      uint m_hash;
+      bool m_isIntKey;
+      ReASVariant m_value;
+   };
+public:
+   ReASMapOfVariants();
+public:
+   void clear();
+   /** Returns an entry given by the insertion order.
+    * @param index  the index of the entry: 0..N-1
+    * @return       the entry
+    */
+   inline const Entry& entryAt(int index) const {
+      return m_entries.at(index);
+   }
+   const ReASVariant* find(const QByteArray& key) const;
+   const ReASVariant* find(int key) const;
+   ReASVariant& insert(const QByteArray& key, const ReASVariant& value);
+   ReASVariant& insert(int key, const ReASVariant& value);
+   /** Tests whether the map has no entries.
+    * @return  <code>true</code>: the map is empty
+    */
+   inline bool isEmpty() const {
+      return m_entries.isEmpty();
+   }
+   void reserve(int size);
+   /** Returns the number of entries.
+    * @return  the number of entries
+    */
+   inline int size() const {
+      return m_entries.size();
+   }
+private:
+   int indexOf(const QByteArray& key, uint hash) const;
+   int indexOf(int key, uint hash) const;
+   void rehash(int capacity);
+   void storeIndex(int index);
+public:
+   static uint hashOf(int key);
+private:
+   QVector<Entry> m_entries;
+   /// -1: empty slot. Otherwise: the index in m_entries
+   QVector<int> m_slots;
+   /// m_slots.size() - 1, the size is a power of 2
+   uint m_mask;
+};
+
 class ReASTree;
 class ReParser;
 class ReVMThread;
@@ -127,20 +292,33 @@ public:
       /// the tree under this node is complete checked for data type correctness
       NF_TYPECHECK_COMPLETE = 1 << 3,
       /// debugger: this node is a breakpoint
-      NF_BREAKPOINT = 1 << 5
+      NF_BREAKPOINT = 1 << 5,
+      /// the loop is executed by many threads ("parallel for")
+      NF_PARALLEL = 1 << 6
    };
 
 public:
    friend class ReASTree;
    ReASItem(ReASItemType type);
    virtual ~ReASItem();
+public:
+   static void* operator new(size_t size);
+   static void operator delete(void* block, size_t size);
 public:
    virtual bool check(ReParser& parser) = 0;
 public:
    bool checkAsCalculable(const char* description, ReASClass* expectedClass,
                           ReParser& parser);
    const ReSourcePosition* position() const;
+   /** Returns the handle of the position in the source position table.
+    * @return  0: no position<br>
+    *          otherwise: the handle of the position
+    */
+   inline ReSourcePositionHandle positionHandle() const {
+      return m_position;
+   }
    void setPosition(const ReSourcePosition* position);
+   void setPosition(ReSourcePositionHandle position);
    unsigned int id() const;
    char* positionStr(char buffer[], size_t bufferSize) const;
    void error(ReLogger* logger, int location, const char* format, ...);
@@ -170,9 +348,11 @@ public:
 protected:
    unsigned int m_id :16;
    ReASItemType m_nodeType :8;
-   int m_flags :5;
+   /// bitmap of NF_... flags:
+   int m_flags :8;
    int m_dataType :3;
-   const ReSourcePosition* m_position;
+   /// the handle in the source position table (see ReSourcePositionTable)
+   ReSourcePositionHandle m_position;
 private:
    static unsigned int m_nextId;
 };
@@ -278,8 +458,6 @@ protected:
    ReASItem* m_child6;
 };
 
-typedef QList<ReASVariant*> ReASListOfVariants;
-typedef QMap<QByteArray, ReASVariant*> ReASMapOfVariants;
 
 class ReASListConstant: public ReASNode1, public ReASCalculable {
 public:
@@ -504,6 +682,10 @@ public:
    void dump(ReWriter& writer, int indent);
 private:
    void assign(ReVMThread& thread);
+   bool assignArithmetic(ReVMThread& thread, ReASVariant& target,
+                         const ReASVariant& operand);
+   bool compare(ReVMThread& thread, const ReASVariant& val1,
+                const ReASVariant& val2);
 public:
    static const char* nameOfOp(BinOperator op);
 private:
@@ -535,6 +717,12 @@ public:
    virtual bool check(ReParser& parser);
    virtual int execute(ReVMThread& thread);
    virtual void dump(ReWriter& writer, int indent);
+public:
+   int executeRange(ReVMThread& thread, int start, int end, int step);
+   void privateVariables(QVector<bool>& isPrivate) const;
+protected:
+   static void markDefinitions(ReASItem* item, ReSymbolSpace* space,
+                               QVector<bool>& isPrivate);
 };
 
 class ReASWhile: public ReASNode3, public ReASStatement {
@@ -556,10 +744,24 @@ public:
 };
 
 class ReASMethod;
-class ReASMethodCall: public ReASNode3, public ReASStatement {
+class ReASMethodCall: public ReASNode3,
+   public ReASStatement,
+   public ReASCalculable {
+public:
+   /// the methods implemented by the VM
+   enum Builtin {
+      BI_NONE,
+      /// send(channel, value): appends the value to the channel
+      BI_SEND,
+      /// receive(channel): returns the next value of the channel
+      BI_RECEIVE,
+      /// close(channel): receive() returns none if the channel is empty
+      BI_CLOSE
+   };
 public:
    ReASMethodCall(const QByteArray& name, ReASItem* parent);
 public:
+   virtual void calc(ReVMThread& thread);
    virtual bool check(ReParser& parser);
    virtual int execute(ReVMThread& thread);
 public:
@@ -568,11 +770,35 @@ public:
 public:
    ReASMethod* method() const;
    void setMethod(ReASMethod* method);
+   void setSymbolSpace(ReSymbolSpace* space);
 
    ReASExprStatement* arg1() const;
+public:
+   static void invalidateCaches();
+protected:
+   void calcBuiltin(ReVMThread& thread);
+   const char* resolve();
 private:
    QByteArray m_name;
    ReASMethod* m_method;
+   /// BI_NONE or the builtin method called instead of m_method
+   Builtin m_builtin;
+   /// the symbol space containing the call: the search for the method starts here
+   ReSymbolSpace* m_symbolSpace;
+   // the inline cache, filled by check() or by the first call:
+   /// the cache is valid if this is equal to m_generation.
+   /// Written with release semantics after the other cache fields
+   QAtomicInt m_cacheGeneration;
+   /// the number of variables of the method: the size of the frame window
+   int m_frameSize;
+   /// the expressions of the arguments: argument n is stored in variable n
+   QVector<ReASCalculable*> m_args;
+   /// NULL or the first parameter without argument (it has a default value)
+   ReASVarDefinition* m_firstDefault;
+   /// serializes the filling of the inline caches
+   static QMutex m_resolveMutex;
+   /// incremented when methods are replaced (see invalidateCaches())
+   static QAtomicInt m_generation;
 };
 
 class RplParameter: ReASItem {
@@ -710,6 +936,7 @@ public:
                 NULL);
    ReSymbolSpace* findmodule(const QByteArray& name);
    ReSourcePosition* copyPosition();
+   const QByteArray& intern(const QByteArray& string);
    ReByteStorage& store();
 
 protected:
@@ -726,7 +953,11 @@ private:
    ReSymbolSpace* m_currentSpace;
    // contain all ever built symbol spaces:
    SymbolSpaceMap m_symbolSpaceHeap;
+   // spaces with the same name as a newer one (overloaded or parsed again):
+   QList<ReSymbolSpace*> m_replacedSpaces;
    ReByteStorage m_store;
+   // identifiers and map keys: equal strings share their buffer
+   QSet<QByteArray> m_strings;
 };
 
 #endif // RPLASTREE_HPP
@@ -393,7 +393,8 @@ static void charClassToCharInfo(const char* charClass, int flag,
 /**
  * @brief Constructor.
  *
- * @param source        the input source handler
+ * @param source        the input source handler. NULL: line mode, see
+ *                      <code>scanLine()</code>
  * @param keywords      a string with all keywords delimited by " ".
  *                      Example: "if then else fi while do done"
  * @param operators     a string with the operators separated by blank or "\n".
@@ -443,6 +444,8 @@ ReLexer::ReLexer(ReSource* source, const char* keywords, const char* operators,
    m_hasMoreInput(false),
    m_stringFeatures(stringFeatures),
    m_storageFlags(storageFlags),
+   m_openComment(0),
+   m_linePosition(),
    // m_prioOfOp
    // m_assocOfOp
 #if defined (RPL_LEXER_TRACE)
@@ -628,7 +631,8 @@ bool ReLexer::fillInput() {
                                                m_hasMoreInput);
       }
    }
-   while (m_input.size() == 0 && m_source->currentReader() != NULL) {
+   while (m_input.size() == 0 && m_source != NULL
+          && m_source->currentReader() != NULL) {
       if (m_source->currentReader()->nextLine(m_maxTokenLength, m_input,
                                               m_hasMoreInput)) {
          m_currentCol = 0;
@@ -871,6 +875,13 @@ void ReLexer::scanComment() {
       while ((ix = m_input.indexOf(commentEnd)) < 0) {
          if (m_storageFlags & STORE_COMMENT)
             m_currentToken->m_string.append(m_input);
+         if (m_source == NULL) {
+            // line mode: the comment will be continued in the next line
+            m_openComment = m_currentToken->id();
+            m_currentCol += m_input.size();
+            m_input.clear();
+            return;
+         }
          m_input.clear();
          if (!fillInput())
             throw ReLexException(*m_currentPosition,
@@ -910,6 +921,82 @@ const ReSourcePosition* ReLexer::currentPosition() const {
    return m_currentPosition;
 }
 
+/**
+ * @brief Scans the next token from the input buffer.
+ *
+ * precondition: the input buffer is not empty, the current token is cleared
+ *
+ * @return  NULL: no token found<br>
+ *          otherwise: the token
+ */
+ReToken* ReLexer::scanToken() {
+   ReToken* rc = NULL;
+   int ix;
+   int cc = m_input.at(0);
+   if (isspace(cc)) {
+      //waitingPosition = m_currentPosition;
+      m_currentToken->m_tokenType = TOKEN_SPACE;
+      ix = 1;
+      while (ix < m_input.size() && isspace(m_input.at(ix)))
+         ix++;
+      if (m_storageFlags & STORE_BLANK) {
+         m_currentToken->m_string.append(m_input.mid(0, ix));
+      }
+      m_currentCol += ix;
+      m_input.remove(0, ix);
+      rc = m_currentToken;
+   } else if (isdigit(cc)) {
+      rc = scanNumber();
+   } else if ((cc == '"' && (m_stringFeatures & SF_QUOTE) != 0)
+              || (cc == '\'' && (m_stringFeatures & SF_TICK) != 0)) {
+      rc = scanString();
+   } else {
+      if (cc >= CHAR_INFO_SIZE)
+         throw ReLexException(*m_currentPosition,
+                              "no lexical symbol can start with this char: %lc",
+                              cc);
+      else {
+         if (rc == NULL
+               && (m_charInfo[cc] & CC_FIRST_COMMENT_START)) {
+            rc = findTokenWithId(TOKEN_COMMENT_START,
+                                 CC_2nd_COMMENT_START, m_commentStarts);
+            if (rc != NULL)
+               scanComment();
+            //waitingPosition = m_currentPosition;
+         }
+         if (rc == NULL && (m_charInfo[cc] & CC_FIRST_OP)) {
+            if ((m_charInfo[cc] & CC_OP_1_ONLY) == 0) {
+               rc = findTokenWithId(TOKEN_OPERATOR, CC_2nd_OP,
+                                    m_operators);
+            } else {
+               rc = m_currentToken;
+               rc->m_tokenType = TOKEN_OPERATOR;
+               rc->m_value.m_id = findInVector(1, m_operators);
+               m_input.remove(0, 1);
+               m_currentCol += 1;
+            }
+         }
+         if (rc == NULL && (m_charInfo[cc] & CC_FIRST_KEYWORD)) {
+            rc = findTokenWithId(TOKEN_KEYWORD, CC_2nd_KEYWORD,
+                                 m_keywords);
+         }
+         if (rc == NULL && (m_charInfo[cc] & CC_FIRST_ID)) {
+            int length = 1;
+            while (length < m_input.size() && (cc =
+                                                  m_input[length]) < CHAR_INFO_SIZE
+                   && (m_charInfo[cc] & CC_REST_ID) != 0)
+               length++;
+            rc = m_currentToken;
+            rc->m_tokenType = TOKEN_ID;
+            rc->m_string.append(m_input.mid(0, length));
+            m_input.remove(0, length);
+            m_currentCol += length;
+         }
+      }
+   }
+   return rc;
+}
+
 /**
  * @brief Returns the next token.
  *
@@ -917,7 +1004,6 @@ const ReSourcePosition* ReLexer::currentPosition() const {
  */
 ReToken* ReLexer::nextToken() {
    ReToken* rc = NULL;
-   int ix;
    if (m_waitingToken != NULL) {
       rc = m_currentToken = m_waitingToken;
       m_waitingToken = m_waitingToken2;
@@ -937,68 +1023,7 @@ ReToken* ReLexer::nextToken() {
          if (!fillInput()) {
             m_currentToken->m_tokenType = TOKEN_END_OF_SOURCE;
          } else {
-            int cc = m_input.at(0);
-            if (isspace(cc)) {
-               //waitingPosition = m_currentPosition;
-               m_currentToken->m_tokenType = TOKEN_SPACE;
-               ix = 1;
-               while (ix < m_input.size() && isspace(m_input.at(ix)))
-                  ix++;
-               if (m_storageFlags & STORE_BLANK) {
-                  m_currentToken->m_string.append(m_input.mid(0, ix));
-               }
-               m_currentCol += ix;
-               m_input.remove(0, ix);
-               rc = m_currentToken;
-            } else if (isdigit(cc)) {
-               rc = scanNumber();
-            } else if ((cc == '"' && (m_stringFeatures & SF_QUOTE) != 0)
-                       || (cc == '\'' && (m_stringFeatures & SF_TICK) != 0)) {
-               rc = scanString();
-            } else {
-               if (cc >= CHAR_INFO_SIZE)
-                  throw ReLexException(*m_currentPosition,
-                                       "no lexical symbol can start with this char: %lc",
-                                       cc);
-               else {
-                  if (rc == NULL
-                        && (m_charInfo[cc] & CC_FIRST_COMMENT_START)) {
-                     rc = findTokenWithId(TOKEN_COMMENT_START,
-                                          CC_2nd_COMMENT_START, m_commentStarts);
-                     if (rc != NULL)
-                        scanComment();
-                     //waitingPosition = m_currentPosition;
-                  }
-                  if (rc == NULL && (m_charInfo[cc] & CC_FIRST_OP)) {
-                     if ((m_charInfo[cc] & CC_OP_1_ONLY) == 0) {
-                        rc = findTokenWithId(TOKEN_OPERATOR, CC_2nd_OP,
-                                             m_operators);
-                     } else {
-                        rc = m_currentToken;
-                        rc->m_tokenType = TOKEN_OPERATOR;
-                        rc->m_value.m_id = findInVector(1, m_operators);
-                        m_input.remove(0, 1);
-                        m_currentCol += 1;
-                     }
-                  }
-                  if (rc == NULL && (m_charInfo[cc] & CC_FIRST_KEYWORD)) {
-                     rc = findTokenWithId(TOKEN_KEYWORD, CC_2nd_KEYWORD,
-                                          m_keywords);
-                  }
-                  if (rc == NULL && (m_charInfo[cc] & CC_FIRST_ID)) {
-                     int length = 1;
-                     while (length < m_input.size() && (cc =
-                                                           m_input[length]) < CHAR_INFO_SIZE
-                            && (m_charInfo[cc] & CC_REST_ID) != 0)
-                        length++;
-                     rc = m_currentToken;
-                     rc->m_tokenType = TOKEN_ID;
-                     rc->m_string.append(m_input.mid(0, length));
-                     m_input.remove(0, length);
-                     m_currentCol += length;
-                  }
-               }
-            }
+            rc = scanToken();
          }
       }
    }
@@ -1023,6 +1048,70 @@ ReToken* ReLexer::nextToken() {
 #endif
    return rc;
 }
+/**
+ * @brief Scans one line without a source, e.g. for syntax highlighting.
+ *
+ * The lexer works in line mode if it is created without source (NULL).
+ * A multi line comment is not an error: its id is returned as state and
+ * must be given for the next line.
+ * Lexical errors are no exceptions: the rest of the line gets the type
+ * <code>TOKEN_UNDEF</code>.
+ *
+ * @param line      the line to scan
+ * @param state     0 or the id of the comment open at the start of the line
+ * @param spans     OUT: the positions of the tokens (without spaces)
+ * @return          0 or the id of the comment open at the end of the line
+ */
+int ReLexer::scanLine(const QByteArray& line, int state,
+                      QVector<ReTokenSpan>& spans) {
+   spans.clear();
+   m_input = line;
+   m_currentCol = 0;
+   m_hasMoreInput = false;
+   m_openComment = 0;
+   m_currentPosition = &m_linePosition;
+   ReTokenSpan span;
+   if (state > 0 && state < m_commentEnds.size()) {
+      const QByteArray& commentEnd = m_commentEnds.at(state);
+      int ix = m_input.indexOf(commentEnd);
+      span.m_start = 0;
+      span.m_length = ix < 0 ? m_input.size() : ix + commentEnd.size();
+      span.m_type = TOKEN_COMMENT_START;
+      spans.append(span);
+      if (ix < 0) {
+         m_openComment = state;
+         m_input.clear();
+      } else {
+         m_input.remove(0, span.m_length);
+         m_currentCol = span.m_length;
+      }
+   }
+   while (m_input.size() > 0) {
+      span.m_start = m_currentCol;
+      m_currentToken->clear();
+      ReToken* token = NULL;
+      try {
+         token = scanToken();
+      } catch (ReException exc) {
+         // the rest of the line will be marked as unknown:
+         token = NULL;
+      }
+      if (token == NULL || token->tokenType() == TOKEN_UNDEF) {
+         span.m_start = line.size() - m_input.size();
+         span.m_length = m_input.size();
+         span.m_type = TOKEN_UNDEF;
+         spans.append(span);
+         m_input.clear();
+      } else if (token->tokenType() != TOKEN_SPACE) {
+         span.m_length = m_currentCol - span.m_start;
+         span.m_type = token->tokenType();
+         spans.append(span);
+      }
+   }
+   m_currentPosition = NULL;
+   return m_openComment;
+}
+
 /**
  * @brief Reverses the last <code>nextToken()</code>.
  *
@@ -74,6 +74,16 @@ protected:
    } m_value;
 };
 
+/**
+ * The position of a token in a line: see <code>ReLexer::scanLine()</code>.
+ */
+class ReTokenSpan {
+public:
+   int m_start;
+   int m_length;
+   RplTokenType m_type;
+};
+
 class ReSource;
 class ReLexer {
 public:
@@ -171,6 +181,8 @@ public:
    virtual ~ReLexer();
 public:
    ReToken* nextToken();
+   int scanLine(const QByteArray& line, int state,
+                QVector<ReTokenSpan>& spans);
    void undoLastToken();
    void undoLastToken2();
    void saveLastToken();
@@ -199,6 +211,7 @@ private:
    ReToken* scanNumber();
    ReToken* scanString();
    void scanComment();
+   ReToken* scanToken();
 protected:
    ReSource* m_source;
    /// sorted, string ends with the id of the keyword
@@ -232,6 +245,10 @@ protected:
    bool m_hasMoreInput;
    int m_stringFeatures;
    int m_storageFlags;
+   /// line mode: the id of the comment which is not closed in the line
+   int m_openComment;
+   /// line mode: the position used for the (caught) exceptions
+   ReSourcePosition m_linePosition;
    /// priority of the operators: index: id of the operator. content: prio
    char m_prioOfOp[128];
    char m_assocOfOp[128];
@@ -70,7 +70,8 @@ enum MFLocations {
    L_PARSE_CLASS_NO_NAME,
    L_PARSE_CLASS_LOWERCASE = 2050,
    L_PARSE_CLASS_ALREADY_DEFINED,
-   L_PARSE_CLASS_ALREADY_DEFINED2
+   L_PARSE_CLASS_ALREADY_DEFINED2,
+   L_PARSE_PARALLEL_NO_FOR
 
 };
 
@@ -157,7 +158,7 @@ ReASItem* ReMFParser::parseRepeat() {
  */
 ReASVarDefinition* ReMFParser::buildVarDef(ReASNamedValue* var) {
    ReASVarDefinition* rc = new ReASVarDefinition();
-   rc->setPosition(var->position());
+   rc->setPosition(var->positionHandle());
    rc->setChild2(var);
    ReSymbolSpace* symbols = m_tree.currentSpace();
    int varNo;
@@ -181,12 +182,12 @@ ReASVarDefinition* ReMFParser::buildVarDef(ReASNamedValue* var) {
 ReASItem* ReMFParser::parseFor() {
    int builtinVars = 1;
    ReASNode2* rc = NULL;
-   const ReSourcePosition* startPosition = m_lexer.currentPosition();
+   ReSourcePositionHandle startPosition = m_lexer.currentPosition()->handle();
    ReToken* token = m_lexer.nextNonSpaceToken();
    ReASNamedValue* var = NULL;
    if (token->isTokenType(TOKEN_ID)) {
       var = new ReASNamedValue(ReASInteger::m_instance, m_tree.currentSpace(),
-                               token->toString(), ReASNamedValue::A_LOOP);
+                               m_tree.intern(token->toString()), ReASNamedValue::A_LOOP);
       var->setPosition(m_lexer.currentPosition());
       token = m_lexer.nextNonSpaceToken();
    }
@@ -201,9 +202,11 @@ ReASItem* ReMFParser::parseFor() {
    } else {
       if (var == NULL) {
          char name[32];
+         const ReSourcePosition* position = ReSourcePositionTable::find(
+                                               startPosition);
          // Build a unique name inside the scope:
-         qsnprintf(name, sizeof name, "$%d_%d", startPosition->lineNo(),
-                   startPosition->column());
+         qsnprintf(name, sizeof name, "$%d_%d", position->lineNo(),
+                   position->column());
          var = new ReASNamedValue(ReASInteger::m_instance,
                                   m_tree.currentSpace(), name, ReASNamedValue::A_LOOP);
          var->setPosition(startPosition);
@@ -231,6 +234,32 @@ ReASItem* ReMFParser::parseFor() {
    return rc;
 }
 
+/**
+ * @brief Parses a parallel for statement.
+ *
+ * Syntax:
+ * parallel for [ VAR ] [ from START_EXPR ] to END_EXPR [ step STEP_EXPR ] do
+ * BODY od
+ *
+ * The iterations are distributed to many threads: the body must not depend
+ * on other iterations. Results are exchanged by channels, e.g.
+ * <code>send("sum", x)</code> and <code>receive("sum")</code>.
+ *
+ * @post            the token behind the do is read
+ * @return          the abstract syntax tree of the for statement
+ */
+ReASItem* ReMFParser::parseParallel() {
+   ReToken* token = m_lexer.nextNonSpaceToken();
+   if (!token->isKeyword(K_FOR))
+      syntaxError(L_PARSE_PARALLEL_NO_FOR, "'for' expected");
+   ReASItem* rc = parseFor();
+   if (dynamic_cast<ReASForCounted*>(rc) == NULL)
+      syntaxError(L_PARSE_PARALLEL_NO_FOR,
+                  "parallel: only a counted for loop is allowed");
+   rc->setFlags(rc->flags() | ReASItem::NF_PARALLEL);
+   return rc;
+}
+
 /**
  * @brief Parses a variable definition.
  *
@@ -274,7 +303,7 @@ ReASVarDefinition* ReMFParser::parseVarDefinition(
    ReSymbolSpace* symbols = m_tree.currentSpace();
    // freed in the destructor of the nodes:
    ReASNamedValue* namedValue = new ReASNamedValue(clazz, symbols,
-         token->toString(), attributes);
+         m_tree.intern(token->toString()), attributes);
    namedValue->setPosition(m_lexer.currentPosition());
    ReASVarDefinition* rc = new ReASVarDefinition();
    rc->setPosition(m_lexer.currentPosition());
@@ -390,7 +419,7 @@ ReASItem* ReMFParser::parseList() {
    ReASListConstant* rc = new ReASListConstant();
    ReASVariant& varList = rc->value();
    ReASListOfVariants* list =
-      static_cast<ReASListOfVariants*>(varList.asObject(NULL));
+      static_cast<ReASListOfVariants*>(varList.asWritableObject(NULL));
    rc->setPosition(m_lexer.currentPosition());
    ReASVariant* variant;
    bool again = true;
@@ -413,8 +442,10 @@ ReASItem* ReMFParser::parseList() {
             syntaxError(L_PARSE_LIST_NO_COMMA, "',' or ']' expected");
          // read token behind ',' or ']'
          token = m_lexer.nextNonSpaceToken();
-         if (variant != NULL)
-            list->append(variant);
+         if (variant != NULL) {
+            list->append(*variant);
+            delete variant;
+         }
       }
    }
    return rc;
@@ -433,8 +464,8 @@ ReASItem* ReMFParser::parseList() {
 ReASItem* ReMFParser::parseMap() {
    ReASMapConstant* rc = new ReASMapConstant();
    ReASVariant& varMap = rc->value();
-   ReASMapOfVariants* map = static_cast<ReASMapOfVariants*>(varMap.asObject(
-                               NULL));
+   ReASMapOfVariants* map = static_cast<ReASMapOfVariants*>(
+                               varMap.asWritableObject(NULL));
    rc->setPosition(m_lexer.currentPosition());
    ReASVariant* variant;
    bool again = true;
@@ -450,7 +481,7 @@ ReASItem* ReMFParser::parseMap() {
          switch (token->tokenType()) {
          case TOKEN_STRING:
             // freed in the destructor of varList (~ReASVariant()):
-            key = token->toString();
+            key = m_tree.intern(token->toString());
             break;
          case TOKEN_KEYWORD:
             switch (token->id()) {
@@ -488,8 +519,11 @@ ReASItem* ReMFParser::parseMap() {
             token2 = m_lexer.nextNonSpaceToken();
             variant = tokenToVariant(token, token2->isOperator(O_COMMA),
                                      rc);
-            (*map)[key] = variant;
-            variant = NULL;
+            if (variant != NULL) {
+               map->insert(key, *variant);
+               delete variant;
+               variant = NULL;
+            }
             token = m_lexer.currentToken();
             if (token->isOperator(O_RBRACE))
                again = false;
@@ -513,7 +547,7 @@ ReASItem* ReMFParser::parseMap() {
  *                  <code>ReASNamedValue</code> instance
  */
 ReASItem* ReMFParser::buildVarOrField(const QByteArray& name,
-                                      const ReSourcePosition* position, ReASItem* parent) {
+                                      ReSourcePositionHandle position, ReASItem* parent) {
    ReASItem* rc = NULL;
    if (parent == NULL) {
       ReSymbolSpace* space = m_tree.currentSpace();
@@ -521,9 +555,15 @@ ReASItem* ReMFParser::buildVarOrField(const QByteArray& name,
       ReASClass* clazz = NULL;
       if (var != NULL)
          clazz = var->clazz();
-      ReASNamedValue* var2 = new ReASNamedValue(clazz, space, name,
-            ReASNamedValue::A_NONE);
+      ReASNamedValue* var2 = new ReASNamedValue(clazz, space,
+            m_tree.intern(name), ReASNamedValue::A_NONE);
       var2->setPosition(position);
+      ReASNamedValue* definition =
+         var == NULL ? NULL : dynamic_cast<ReASNamedValue*>(var->child2());
+      // the variable may be defined in a parent space (module, global):
+      if (definition != NULL)
+         var2->setSymbolSpace(definition->symbolSpace(),
+                              definition->variableNo());
       rc = var2;
    } else {
       ReASField* field = new ReASField(name);
@@ -579,7 +619,7 @@ ReASUnaryOp::UnaryOp ReMFParser::convertUnaryOp(int op) {
  */
 ReASItem* ReMFParser::parseOperand(int level, ReASItem* parent) {
    ReToken* token = m_lexer.nextNonSpaceToken();
-   const ReSourcePosition* startPosition = m_lexer.currentPosition();
+   ReSourcePositionHandle startPosition = m_lexer.currentPosition()->handle();
    ReASItem* rc = NULL;
    bool readNext = true;
    switch (token->tokenType()) {
@@ -610,7 +650,7 @@ ReASItem* ReMFParser::parseOperand(int level, ReASItem* parent) {
          if (!token->isOperator(O_RPARENTH)) {
             // this call never comes back (exception!)
             syntaxError(L_PARSE_OPERAND_RPARENTH, "')' expected", "(",
-                        startPosition);
+                        ReSourcePositionTable::find(startPosition));
          }
       } else if (IS_UNARY_OP(opId)) {
          ReASUnaryOp* op = new ReASUnaryOp(convertUnaryOp(token->id()),
@@ -653,7 +693,7 @@ ReASItem* ReMFParser::parseOperand(int level, ReASItem* parent) {
       if (name == "a")
          name = "a";
       token = m_lexer.nextNonSpaceToken();
-      startPosition = m_lexer.currentPosition();
+      startPosition = m_lexer.currentPosition()->handle();
       if (token->tokenType() != TOKEN_OPERATOR) {
          rc = buildVarOrField(name, startPosition, parent);
          readNext = false;
@@ -661,6 +701,7 @@ ReASItem* ReMFParser::parseOperand(int level, ReASItem* parent) {
          if (token->id() == O_LPARENTH) {
             ReASMethodCall* call = new ReASMethodCall(name, parent);
             call->setPosition(startPosition);
+            call->setSymbolSpace(m_tree.currentSpace());
             rc = call;
             token = m_lexer.nextNonSpaceToken();
             if (!token->isOperator(O_RPARENTH)) {
@@ -906,7 +947,7 @@ ReASItem* ReMFParser::parseExprStatement(bool eatSemicolon) {
    ReASExprStatement* statement = NULL;
    if (item != NULL) {
       statement = new ReASExprStatement();
-      statement->setPosition(item->position());
+      statement->setPosition(item->positionHandle());
       statement->setChild2(item);
    }
    if (eatSemicolon && m_lexer.currentToken()->isOperator(O_SEMICOLON))
@@ -944,13 +985,13 @@ ReASItem* ReMFParser::parseBody(Keyword keywordStop, Keyword keywordStop2,
    m_tree.currentSpace()->startScope(scope);
    scope.m_builtInVars = builtinVars;
    bool again = true;
-   const ReSourcePosition* lastPos = NULL;
+   ReSourcePositionHandle lastPos = 0;
    do {
       token = m_lexer.currentToken();
-      if (lastPos == m_lexer.currentPosition())
+      if (lastPos == m_lexer.currentPosition()->handle())
          syntaxError(L_PARSE_BODY_NO_START,
                      "no statement starts with this symbol");
-      lastPos = m_lexer.currentPosition();
+      lastPos = m_lexer.currentPosition()->handle();
       // eat a superflous ';'
       if (token->isOperator(O_SEMICOLON))
          token = m_lexer.nextNonSpaceToken();
@@ -977,6 +1018,9 @@ ReASItem* ReMFParser::parseBody(Keyword keywordStop, Keyword keywordStop2,
             case K_FOR:
                item = parseFor();
                break;
+            case K_PARALLEL:
+               item = parseParallel();
+               break;
             case K_CLASS:
                parseClass();
                item = NULL;
@@ -1074,7 +1118,7 @@ ReASItem* ReMFParser::parseBody(Keyword keywordStop, Keyword keywordStop2,
 ReASVarDefinition* ReMFParser::parseParameterList() {
    ReASVarDefinition* rc = NULL;
    ReASVarDefinition* last = NULL;
-   const ReSourcePosition* startPos = m_lexer.currentPosition();
+   ReSourcePositionHandle startPos = m_lexer.currentPosition()->handle();
    ReASItem* definition = NULL;
    do {
       if (definition != NULL)
@@ -1089,7 +1133,8 @@ ReASVarDefinition* ReMFParser::parseParameterList() {
       last = current;
    } while (m_lexer.currentToken()->isOperator(O_COMMA));
    if (!m_lexer.currentToken()->isOperator(O_RPARENTH))
-      syntaxError(L_PARSE_PARAMLIST_NO_PARENTH, ") expected", ")", startPos);
+      syntaxError(L_PARSE_PARAMLIST_NO_PARENTH, ") expected", ")",
+                  ReSourcePositionTable::find(startPos));
    m_lexer.nextNonSpaceToken();
    return rc;
 }
@@ -1105,7 +1150,7 @@ ReASVarDefinition* ReMFParser::parseParameterList() {
  */
 void ReMFParser::parseMethod() {
    ReASMethod* method = NULL;
-   const ReSourcePosition* startPos = m_lexer.currentPosition();
+   ReSourcePositionHandle startPos = m_lexer.currentPosition()->handle();
    ReToken* token = m_lexer.nextNonSpaceToken();
    if (!token->isTokenType(TOKEN_ID))
       syntaxError(L_PARSE_METH_NO_CLASS, "type name expected");
@@ -1144,7 +1189,7 @@ void ReMFParser::parseMethod() {
    method->setChild(parseBody(K_ENDF));
    if (!m_lexer.currentToken()->isKeyword(K_ENDF))
       syntaxError(L_PARSE_METH_NO_END, "end of function not found", "endf",
-                  startPos);
+                  ReSourcePositionTable::find(startPos));
    m_lexer.nextNonSpaceToken();
    m_tree.finishClassOrMethod(name);
 }
@@ -1231,7 +1276,7 @@ ReASExprStatement* ReMFParser::parseArguments() {
          syntaxError(L_PARSE_ARGS_NO_COMMA_OR_PARENT, "',' or ')' expected");
       again = m_lexer.currentToken()->isOperator(O_COMMA);
       ReASExprStatement* current = new ReASExprStatement();
-      current->setPosition(expr->position());
+      current->setPosition(expr->positionHandle());
       current->setChild2(expr);
       if (first == NULL)
          first = last = current;
@@ -1245,3 +1290,419 @@ ReASExprStatement* ReMFParser::parseArguments() {
    return first;
 }
 
+
+/** @class ReMFIncrementalParser ReMFParser.hpp "expr/ReMFParser.hpp"
+ *
+ * @brief Parses only the changed parts of a module again.
+ */
+
+/**
+ * @brief Constructor.
+ *
+ * @param type      the type of the region
+ * @param firstLine the index of the first line of the region
+ */
+ReMFIncrementalParser::Region::Region(RegionType type, int firstLine) :
+   m_type(type),
+   m_name(),
+   m_firstLine(firstLine),
+   m_lineCount(0),
+   m_text(),
+   m_hash(0),
+   m_empty(true),
+   m_source(NULL),
+   m_reader(NULL),
+   m_methods(),
+   m_messages() {
+}
+
+/**
+ * @brief Destructor.
+ */
+ReMFIncrementalParser::Region::~Region() {
+   delete m_reader;
+   m_reader = NULL;
+   delete m_source;
+   m_source = NULL;
+}
+
+/**
+ * @brief Constructor.
+ *
+ * @param tree          the abstract syntax tree to fill
+ * @param moduleName    the name of the module
+ */
+ReMFIncrementalParser::ReMFIncrementalParser(ReASTree& tree,
+      const QByteArray& moduleName) :
+   m_tree(tree),
+   m_moduleName(moduleName),
+   m_regions(),
+   m_retiredMethods(),
+   m_retiredReaders(),
+   m_retiredSources(),
+   m_parsedRegions(0),
+   m_lexer(NULL,
+           MF_KEYWORDS, MF_OPERATORS, MF_RIGHT_ASSOCIATIVES, "/* */ // \n",
+           "a-zA-Z_", "a-zA-Z0-9_", ReLexer::NUMTYPE_ALL, ReLexer::SF_LIKE_C) {
+}
+
+/**
+ * @brief Destructor.
+ *
+ * The tree is not cleared: but its positions are invalid after that.
+ */
+ReMFIncrementalParser::~ReMFIncrementalParser() {
+   freeRetired();
+   for (int ix = 0; ix < m_regions.size(); ix++)
+      delete m_regions.at(ix);
+}
+
+/**
+ * @brief Tests whether the regions differ in number or kind from the current.
+ *
+ * @param regions   the regions of the new text
+ * @return          <code>true</code>: the total module must be parsed
+ */
+bool ReMFIncrementalParser::changesStructure(const QList<Region*>& regions)
+const {
+   bool rc = regions.size() != m_regions.size();
+   for (int ix = 0; !rc && ix < regions.size(); ix++) {
+      const Region* current = m_regions.at(ix);
+      const Region* region = regions.at(ix);
+      rc = current->m_type != region->m_type
+           || current->m_name != region->m_name;
+   }
+   return rc;
+}
+
+/**
+ * @brief Splits the lines into regions.
+ *
+ * A method or class starts with its keyword outside of any other block and
+ * ends with the matching "endf" or "endc". Keywords in comments or strings
+ * are ignored because the lexer scans the lines.
+ *
+ * @param lines     the lines of the module
+ * @param regions   OUT: the regions. The caller must free them
+ */
+void ReMFIncrementalParser::findRegions(const QStringList& lines,
+                                        QList<Region*>& regions) {
+   QVector<ReTokenSpan> spans;
+   int state = 0;
+   // the nesting of "if", "while"... outside of declarations:
+   int blocks = 0;
+   // the nesting of methods and classes:
+   int declarations = 0;
+   Region* region = NULL;
+   for (int lineNo = 0; lineNo < lines.size(); lineNo++) {
+      QByteArray line = lines.at(lineNo).toUtf8();
+      state = m_lexer.scanLine(line, state, spans);
+      if (region == NULL)
+         region = new Region(RT_STATEMENTS, lineNo);
+      bool empty = true;
+      bool endsRegion = false;
+      // 0: no declaration, 1: name of a class, 2: type of a method, 3: name
+      int nameState = 0;
+      for (int ix = 0; ix < spans.size(); ix++) {
+         const ReTokenSpan& span = spans.at(ix);
+         switch (span.m_type) {
+         case TOKEN_SPACE:
+         case TOKEN_COMMENT_REST_OF_LINE:
+         case TOKEN_COMMENT_START:
+         case TOKEN_COMMENT_END:
+            break;
+         case TOKEN_ID:
+            empty = false;
+            if (nameState == 1 || nameState == 3) {
+               region->m_name = line.mid(span.m_start, span.m_length);
+               nameState = 0;
+            } else if (nameState == 2)
+               nameState = 3;
+            break;
+         case TOKEN_KEYWORD: {
+            QByteArray word = line.mid(span.m_start, span.m_length);
+            bool isClass = word == "class";
+            if (isClass || word == "func" || word == "generator") {
+               if (declarations++ == 0 && blocks == 0) {
+                  if (!empty) {
+                     // more than one part in a line: no incremental parse
+                     region->m_type = RT_STATEMENTS;
+                     region->m_name.clear();
+                  } else {
+                     if (region->m_lineCount > 0)
+                        regions.append(region);
+                     else
+                        delete region;
+                     region = new Region(isClass ? RT_CLASS : RT_METHOD,
+                                         lineNo);
+                     nameState = isClass ? 1 : 2;
+                  }
+               }
+            } else if (word == "endf" || word == "endc") {
+               if (declarations > 0 && --declarations == 0
+                     && region->m_type != RT_STATEMENTS)
+                  endsRegion = true;
+            } else if (declarations == 0) {
+               if (word == "if" || word == "while" || word == "for"
+                     || word == "repeat" || word == "case")
+                  blocks++;
+               else if (blocks > 0 && (word == "fi" || word == "od"
+                                       || word == "until" || word == "esac"))
+                  blocks--;
+            }
+            empty = false;
+            break;
+         }
+         default:
+            empty = false;
+            break;
+         }
+      }
+      region->m_text += line;
+      region->m_text += '\n';
+      region->m_lineCount++;
+      if (!empty)
+         region->m_empty = false;
+      if (endsRegion) {
+         regions.append(region);
+         region = NULL;
+      }
+   }
+   if (region != NULL)
+      regions.append(region);
+   for (int ix = 0; ix < regions.size(); ix++)
+      regions.at(ix)->m_hash = qHash(regions.at(ix)->m_text);
+}
+
+/**
+ * @brief Frees the methods replaced by partial parses and their sources.
+ *
+ * Called by <code>update()</code>. The caller may call it earlier if no VM
+ * refers to the retired methods.
+ */
+void ReMFIncrementalParser::freeRetired() {
+   for (int ix = 0; ix < m_retiredMethods.size(); ix++)
+      delete m_retiredMethods.at(ix);
+   m_retiredMethods.clear();
+   // the positions of the methods refer to the sources:
+   for (int ix = 0; ix < m_retiredReaders.size(); ix++)
+      delete m_retiredReaders.at(ix);
+   m_retiredReaders.clear();
+   for (int ix = 0; ix < m_retiredSources.size(); ix++)
+      delete m_retiredSources.at(ix);
+   m_retiredSources.clear();
+}
+
+/**
+ * @brief Returns the messages of all regions.
+ *
+ * @return  the errors and warnings in the order of the regions
+ */
+ReParser::MessageList ReMFIncrementalParser::messages() const {
+   ReParser::MessageList rc;
+   for (int ix = 0; ix < m_regions.size(); ix++)
+      rc += m_regions.at(ix)->m_messages;
+   return rc;
+}
+
+/**
+ * @brief Returns the number of regions parsed by the last update.
+ *
+ * @return  the number of parsed regions
+ */
+int ReMFIncrementalParser::parsedRegions() const {
+   return m_parsedRegions;
+}
+
+/**
+ * @brief Parses the total module.
+ *
+ * @param regions   the new regions. The instance becomes the owner
+ */
+void ReMFIncrementalParser::parseAll(QList<Region*>& regions) {
+   ReSymbolSpace* module = m_tree.findmodule(m_moduleName);
+   if (module != NULL) {
+      delete module->body();
+      module->setBody(NULL);
+   }
+   m_tree.clear();
+   freeRetired();
+   // the old sources are freed after the tree: the AST refers to them
+   for (int ix = 0; ix < m_regions.size(); ix++)
+      delete m_regions.at(ix);
+   m_regions = regions;
+   regions.clear();
+   ReASItem* first = NULL;
+   ReASNode1* last = NULL;
+   for (int ix = 0; ix < m_regions.size(); ix++) {
+      ReASItem* body = parseRegion(m_regions.at(ix));
+      if (body != NULL) {
+         if (first == NULL)
+            first = body;
+         else
+            last->setChild(body);
+         last = dynamic_cast<ReASNode1*>(body);
+         while (last->child() != NULL)
+            last = dynamic_cast<ReASNode1*>(last->child());
+      }
+   }
+   module = m_tree.findmodule(m_moduleName);
+   if (module != NULL)
+      module->setBody(first);
+}
+
+/**
+ * @brief Parses one region into the module.
+ *
+ * The line numbers of the positions are counted from the start of the module.
+ *
+ * @param region    the region to parse
+ * @return          NULL or the statements of the region
+ */
+ReASItem* ReMFIncrementalParser::parseRegion(Region* region) {
+   ReASItem* rc = NULL;
+   // the retired methods still refer to the old source:
+   if (region->m_reader != NULL)
+      m_retiredReaders.append(region->m_reader);
+   if (region->m_source != NULL)
+      m_retiredSources.append(region->m_source);
+   region->m_source = new ReSource();
+   region->m_reader = new ReStringReader(*region->m_source);
+   region->m_reader->addSource(m_moduleName.constData(),
+                               region->m_text.constData());
+   region->m_source->addReader(region->m_reader);
+   ReSourceUnit* unit = region->m_reader->currentSourceUnit();
+   region->m_source->addSourceUnit(unit);
+   // the reader increments the line number before each line:
+   unit->setLineNo(region->m_firstLine);
+   region->m_messages.clear();
+   region->m_methods.clear();
+   ReASTree::SymbolSpaceStack& stack = m_tree.symbolSpaces();
+   int depth = stack.size();
+   ReMFParser parser(*region->m_source, m_tree);
+   try {
+      rc = parser.parseModule(m_moduleName.constData());
+   } catch (ReSyntaxError exc) {
+      // the reason is stored in the messages
+   } catch (ReException exc) {
+      region->m_messages.append(exc.getMessage());
+   }
+   // an aborted parse leaves its spaces on the stack:
+   if (stack.size() > depth) {
+      while (stack.size() > depth + 1)
+         stack.removeLast();
+      m_tree.finishModule(m_moduleName.constData());
+   }
+   region->m_messages += parser.messages();
+   ReSymbolSpace* module = m_tree.findmodule(m_moduleName);
+   if (region->m_type == RT_METHOD && module != NULL) {
+      // a new method is the first of its overloads:
+      ReASMethod* method = module->findMethod(region->m_name);
+      ReSourcePositionTable& table = region->m_source->positionTable();
+      while (method != NULL && table.position(method->positionHandle()) != NULL) {
+         region->m_methods.append(method);
+         method = method->sibling();
+      }
+   }
+   m_parsedRegions++;
+   return rc;
+}
+
+/**
+ * @brief Replaces the methods of a region by the parse of its current text.
+ *
+ * The old methods are kept until the next update: the VM may still
+ * refer to them.
+ *
+ * @param region    the region to parse
+ * @return          <code>true</code>: success<br>
+ *                  <code>false</code>: the region contains statements too:
+ *                  the total module must be parsed
+ */
+bool ReMFIncrementalParser::reparseMethods(Region* region) {
+   ReSymbolSpace* module = m_tree.findmodule(m_moduleName);
+   for (int ix = 0; module != NULL && ix < region->m_methods.size(); ix++) {
+      ReASMethod* method = region->m_methods.at(ix);
+      if (module->removeMethod(method))
+         m_retiredMethods.append(method);
+   }
+   ReASMethodCall::invalidateCaches();
+   ReASItem* body = parseRegion(region);
+   bool rc = body == NULL;
+   delete body;
+   return rc;
+}
+
+/**
+ * @brief Returns the regions of the module.
+ *
+ * @return  the regions in the order of the text
+ */
+const QList<ReMFIncrementalParser::Region*>& ReMFIncrementalParser::regions()
+const {
+   return m_regions;
+}
+
+/**
+ * @brief Returns the number of methods kept for a VM after a partial parse.
+ *
+ * @return  the number of retired methods (see <code>freeRetired()</code>)
+ */
+int ReMFIncrementalParser::retiredMethods() const {
+   return m_retiredMethods.size();
+}
+
+/**
+ * @brief Brings the tree in line with the current text of the module.
+ *
+ * @pre             no VM executes the module (see the class description)
+ * @param lines     the lines of the module
+ */
+void ReMFIncrementalParser::update(const QStringList& lines) {
+   // no VM runs: the methods retired by the last update are not used
+   freeRetired();
+   QList<Region*> regions;
+   findRegions(lines, regions);
+   m_parsedRegions = 0;
+   bool full = m_regions.isEmpty() || changesStructure(regions);
+   QList<int> changed;
+   for (int ix = 0; !full && ix < regions.size(); ix++) {
+      Region* current = m_regions.at(ix);
+      Region* region = regions.at(ix);
+      bool reparse;
+      if (current->m_hash != region->m_hash || current->m_text != region->m_text)
+         reparse = !(current->m_empty && region->m_empty);
+      else
+         // the positions in the messages are stored as text:
+         reparse = current->m_firstLine != region->m_firstLine
+                   && !current->m_messages.isEmpty();
+      if (reparse) {
+         if (current->m_type == RT_METHOD)
+            changed.append(ix);
+         else
+            full = true;
+      }
+   }
+   if (!full) {
+      for (int ix = 0; ix < regions.size(); ix++) {
+         Region* current = m_regions.at(ix);
+         Region* region = regions.at(ix);
+         int delta = region->m_firstLine - current->m_firstLine;
+         current->m_firstLine = region->m_firstLine;
+         current->m_lineCount = region->m_lineCount;
+         current->m_text = region->m_text;
+         current->m_hash = region->m_hash;
+         current->m_empty = region->m_empty;
+         if (!changed.contains(ix) && delta != 0 && current->m_source != NULL)
+            current->m_source->positionTable().shiftLines(delta);
+      }
+      for (int ix = 0; !full && ix < changed.size(); ix++)
+         full = !reparseMethods(m_regions.at(changed.at(ix)));
+      if (!full) {
+         for (int ix = 0; ix < regions.size(); ix++)
+            delete regions.at(ix);
+      }
+   }
+   if (full)
+      parseAll(regions);
+}
@@ -46,12 +46,13 @@ public:
       K_LAZY,
       K_NONE,
       K_TRUE, // 30
-      K_FALSE
+      K_FALSE,
+      K_PARALLEL
    };
 #define MF_KEYWORDS "if then else fi while do od repeat until" \
     " for from to step in case of esac leave continue pass" \
     " class endc endf func generator import" \
-    " const lazy none true false"
+    " const lazy none true false parallel"
    enum Operator {
       O_UNDEF,
       O_SEMI_SEMICOLON,
@@ -130,6 +131,7 @@ public:
    ReASItem* parseWhile();
    ReASItem* parseRepeat();
    ReASItem* parseFor();
+   ReASItem* parseParallel();
    ReASVarDefinition* parseVarDefinition(ReASNamedValue::Attributes attribute);
    ReASItem* parseExpr(int depth);
    ReASItem* parseBody(Keyword keywordStop, Keyword keywordStop2 = K_UNDEF,
@@ -149,7 +151,7 @@ protected:
                                ReASNode1* parent);
    ReASVariant* createFormula(ReASNode1* parent);
    ReASItem* buildVarOrField(const QByteArray& name,
-                             const ReSourcePosition* position, ReASItem* parent);
+                             ReSourcePositionHandle position, ReASItem* parent);
    ReASVarDefinition* parseParameterList();
    ReASItem* parseLocalVar();
    ReASVarDefinition* buildVarDef(ReASNamedValue* var);
@@ -162,4 +164,85 @@ private:
    ReLexer m_lexer;
 };
 
+/**
+ * Parses a module again after changes of its text.
+ *
+ * The module is split into regions: a method (<code>func ... endf</code>),
+ * a class (<code>class ... endc</code>) or the statements between them.
+ * Each region is parsed from its own source, so the AST of an unchanged
+ * region is kept. If only the text of methods has been changed, only these
+ * methods are parsed again. Moved regions get shifted line numbers.
+ * All other changes lead to a parse of the total module.
+ *
+ * The tree must contain only the module of this instance.
+ *
+ * Contract with the virtual machine: no VM may execute the module during
+ * <code>update()</code>. The methods replaced by a partial parse ("retired")
+ * stay alive until the next <code>update()</code> or until the caller, knowing
+ * that no VM refers to them, calls <code>freeRetired()</code>.
+ */
+class ReMFIncrementalParser {
+public:
+   enum RegionType {
+      /// the statements and comments outside of methods and classes
+      RT_STATEMENTS,
+      RT_METHOD,
+      RT_CLASS
+   };
+   /// a top level part of the module
+   class Region {
+   public:
+      Region(RegionType type, int firstLine);
+      ~Region();
+   public:
+      RegionType m_type;
+      /// the name of the method or class. Empty for statements
+      QByteArray m_name;
+      /// the index of the first line (0..N-1)
+      int m_firstLine;
+      int m_lineCount;
+      /// the lines of the region, each with a trailing '\n'
+      QByteArray m_text;
+      uint m_hash;
+      /// true: the region contains only spaces and comments
+      bool m_empty;
+      /// the source of the region's AST: must live as long as the AST
+      ReSource* m_source;
+      ReStringReader* m_reader;
+      /// the methods defined by the region
+      QList<ReASMethod*> m_methods;
+      /// the errors and warnings of the last parse of the region
+      ReParser::MessageList m_messages;
+   };
+public:
+   ReMFIncrementalParser(ReASTree& tree, const QByteArray& moduleName);
+   ~ReMFIncrementalParser();
+public:
+   void freeRetired();
+   ReParser::MessageList messages() const;
+   int parsedRegions() const;
+   const QList<Region*>& regions() const;
+   int retiredMethods() const;
+   void update(const QStringList& lines);
+protected:
+   bool changesStructure(const QList<Region*>& regions) const;
+   void findRegions(const QStringList& lines, QList<Region*>& regions);
+   void parseAll(QList<Region*>& regions);
+   ReASItem* parseRegion(Region* region);
+   bool reparseMethods(Region* region);
+protected:
+   ReASTree& m_tree;
+   QByteArray m_moduleName;
+   QList<Region*> m_regions;
+   /// the methods replaced by a partial parse: freed by the next update()
+   QList<ReASMethod*> m_retiredMethods;
+   /// the sources of the retired methods: freed with them
+   QList<ReStringReader*> m_retiredReaders;
+   QList<ReSource*> m_retiredSources;
+   /// the number of regions parsed by the last update()
+   int m_parsedRegions;
+   /// finds the keywords which limit the regions
+   ReLexer m_lexer;
+};
+
 #endif // REMFPARSER_HPP
@@ -246,3 +246,11 @@ int ReParser::warnings() const {
    return m_warnings;
 }
 
+/**
+ * @brief Returns the errors and warnings.
+ *
+ * @return the messages occurred until now
+ */
+const ReParser::MessageList& ReParser::messages() const {
+   return m_messages;
+}
@@ -52,6 +52,7 @@ public:
    void warning(int location, const char* format, ...);
    int errors() const;
    int warnings() const;
+   const MessageList& messages() const;
 protected:
    ReLexer& m_lexer;
    ReASTree& m_tree;
@@ -101,6 +101,10 @@ ReReader* ReSourceUnit::reader() const {
  * The mostly used source unit is a text file.
  *
  * A precice position is the stack of source unit positions.
+ *
+ * The positions of the tokens are stored compactly in a
+ * <code>ReSourcePositionTable</code>: an instance is only a decoded view
+ * of such an entry, built when it is needed.
  */
 
 /**
@@ -110,7 +114,8 @@ ReSourcePosition::ReSourcePosition() :
    m_sourceUnit(NULL),
    m_lineNo(0),
    m_column(0),
-   m_caller(NULL) {
+   m_caller(NULL),
+   m_handle(0) {
 }
 
 /**
@@ -124,27 +129,34 @@ ReSourcePosition::ReSourcePosition(ReSourceUnit* unit, int lineNo, int colNo) :
    m_sourceUnit(unit),
    m_lineNo(lineNo),
    m_column(colNo),
-   m_caller(NULL) {
+   m_caller(NULL),
+   m_handle(0) {
    ReReader* reader = dynamic_cast<ReReader*>(unit->reader());
    m_caller = reader->source().caller();
 }
+
 /**
- * @brief Destructor
+ * @brief Constructor.
+ *
+ * @param unit      name of the input source (normally a file)
+ * @param lineNo    line number inside the input source
+ * @param colNo     distance to the line start
+ * @param caller    NULL or the position of the include
+ * @param handle    the handle in the position table
  */
-ReSourcePosition::~ReSourcePosition() {
-   // That should never occure!
-   assert(false);
+ReSourcePosition::ReSourcePosition(ReSourceUnit* unit, int lineNo, int colNo,
+                                   const ReSourcePosition* caller, ReSourcePositionHandle handle) :
+   m_sourceUnit(unit),
+   m_lineNo(lineNo),
+   m_column(colNo),
+   m_caller(caller),
+   m_handle(handle) {
 }
 
 /**
- * @brief Placement new operator (for our own memory management).
- *
- * @param cbSize    size of the instance
- * @param buffer    buffer for the instance
- * @return          <code>buffer</code>
+ * @brief Destructor
  */
-void* ReSourcePosition::operator new(size_t, void* buffer) {
-   return buffer;
+ReSourcePosition::~ReSourcePosition() {
 }
 
 /**
@@ -301,19 +313,325 @@ void ReReader::removeSourceUnit() {
    ;
 }
 
-/** @class ReSourcePositionBlock ReSource.hpp "expr/ReSource.hpp"
+/** @class ReSourcePositionTable ReSource.hpp "expr/ReSource.hpp"
+ *
+ * @brief Stores the positions of all tokens of a source compactly.
  *
- * @brief Efficient heap of <code>ReSourcePosition</code> instances.
+ * Each entry is referenced by a 32 bit handle: the upper bits contain the
+ * number of a chunk, the lower bits the index inside the chunk. The chunk
+ * numbers are unique in the process, so a handle can be resolved without
+ * knowing the source (see <code>find()</code>).
  *
- * The <code>ReSourcePosition</code> heap is only growing. The deletion is
- * done for all entries together.
- * Therefore a simple allocation is possible with blocks.
+ * A chunk number consists of a slot in the registry and the generation of
+ * the slot. The slots of a cleared table are reused (the oldest free slot
+ * first) with the next generation, so the handles of the cleared table stay
+ * invalid until the same slot has been reused <code>GENERATION_COUNT</code>
+ * times.
+ *
+ * A chunk stores the line and the column of its entries as varint encoded
+ * deltas to the previous entry, normally 2 bytes per entry. The source unit
+ * and the caller change rarely: they are stored as runs.
+ *
+ * Decoding is only done when a position is needed (messages, traces):
+ * the decoded instances are cached until <code>clear()</code>.
  */
-ReSourcePositionBlock::ReSourcePositionBlock() :
-   m_successor(NULL)
-// m_positions
-{
-   memset(m_positions, 0, sizeof m_positions);
+
+QVector<ReSourcePositionTable::Chunk*> ReSourcePositionTable::m_registry;
+QVector<int> ReSourcePositionTable::m_generations;
+QQueue<int> ReSourcePositionTable::m_freeSlots;
+QMutex ReSourcePositionTable::m_mutex;
+
+/**
+ * @brief Writes an unsigned number with a variable length (7 bits per byte).
+ *
+ * @param data      IN/OUT: the number will be appended here
+ * @param value     the number to write
+ */
+static void writeVarInt(QByteArray& data, quint32 value) {
+   while (value >= 0x80) {
+      data.append(char(value | 0x80));
+      value >>= 7;
+   }
+   data.append(char(value));
+}
+
+/**
+ * @brief Reads an unsigned number written by <code>writeVarInt()</code>.
+ *
+ * @param data      the encoded data
+ * @param offset    IN/OUT: the position of the number in <code>data</code>
+ * @return          the number
+ */
+static quint32 readVarInt(const QByteArray& data, int& offset) {
+   quint32 rc = 0;
+   int shift = 0;
+   quint8 cc;
+   do {
+      cc = quint8(data.at(offset++));
+      rc |= quint32(cc & 0x7f) << shift;
+      shift += 7;
+   } while ((cc & 0x80) != 0);
+   return rc;
+}
+
+/**
+ * @brief Converts a signed delta into an unsigned number with small values
+ * for small absolute values.
+ *
+ * @param value the value to convert
+ * @return      0, -1, 1, -2 ... are converted to 0, 1, 2, 3 ...
+ */
+inline quint32 zigZag(int value) {
+   return (quint32(value) << 1) ^ quint32(value >> 31);
+}
+
+/**
+ * @brief Reverses <code>zigZag()</code>.
+ *
+ * @param value the value to convert
+ * @return      the signed value
+ */
+inline int unZigZag(quint32 value) {
+   return int(value >> 1) ^ -int(value & 1);
+}
+
+/**
+ * @brief Constructor.
+ *
+ * @param table     the owner
+ * @param number    the global chunk number
+ * @param first     the sequence number of the first entry
+ */
+ReSourcePositionTable::Chunk::Chunk(ReSourcePositionTable* table, int number,
+                                    int first) :
+   m_table(table),
+   m_number(number),
+   m_first(first),
+   m_count(0),
+   m_lastLineNo(0),
+   m_lastColumn(0),
+   m_data(),
+   m_checkpoints() {
+}
+
+/**
+ * @brief Constructor.
+ */
+ReSourcePositionTable::ReSourcePositionTable() :
+   m_count(0),
+   m_lineOffset(0),
+   m_chunks(),
+   m_runs(),
+   m_decoded() {
+}
+
+/**
+ * @brief Destructor.
+ */
+ReSourcePositionTable::~ReSourcePositionTable() {
+   clear();
+}
+
+/**
+ * @brief Stores a position.
+ *
+ * @param unit      the source unit
+ * @param lineNo    the line number
+ * @param column    the column
+ * @param caller    NULL or the position of the include
+ * @return          the handle of the new entry
+ */
+ReSourcePositionHandle ReSourcePositionTable::add(ReSourceUnit* unit,
+      int lineNo, int column, const ReSourcePosition* caller) {
+   if ((m_count & (CHUNK_SIZE - 1)) == 0) {
+      QMutexLocker locker(&m_mutex);
+      if (m_registry.isEmpty()) {
+         m_registry.append(NULL);
+         m_generations.append(0);
+      }
+      int slot;
+      if (!m_freeSlots.isEmpty())
+         slot = m_freeSlots.dequeue();
+      else {
+         slot = m_registry.size();
+         if (slot >= MAX_CHUNKS)
+            throw ReException("too many source positions");
+         m_registry.append(NULL);
+         m_generations.append(0);
+      }
+      int number = (slot << GENERATION_BITS) + m_generations.at(slot);
+      Chunk* chunk = new Chunk(this, number, m_count);
+      m_registry[slot] = chunk;
+      m_chunks.append(chunk);
+   }
+   if (m_runs.isEmpty() || m_runs.last().m_unit != unit
+         || m_runs.last().m_caller != caller) {
+      Run run;
+      run.m_first = m_count;
+      run.m_unit = unit;
+      run.m_caller = caller;
+      m_runs.append(run);
+   }
+   Chunk* chunk = m_chunks.last();
+   if (chunk->m_count % CHECKPOINT_DISTANCE == 0) {
+      Checkpoint checkpoint;
+      checkpoint.m_offset = chunk->m_data.size();
+      checkpoint.m_lineNo = chunk->m_lastLineNo;
+      checkpoint.m_column = chunk->m_lastColumn;
+      chunk->m_checkpoints.append(checkpoint);
+   }
+   writeVarInt(chunk->m_data, zigZag(lineNo - chunk->m_lastLineNo));
+   // a new line starts (nearly) at column 0: no delta
+   writeVarInt(chunk->m_data, zigZag(lineNo == chunk->m_lastLineNo ?
+                                     column - chunk->m_lastColumn : column));
+   chunk->m_lastLineNo = lineNo;
+   chunk->m_lastColumn = column;
+   ReSourcePositionHandle rc = (ReSourcePositionHandle(chunk->m_number)
+                                << CHUNK_BITS) + chunk->m_count;
+   chunk->m_count++;
+   m_count++;
+   return rc;
+}
+
+/**
+ * @brief Frees all entries.
+ *
+ * The handles of the entries become invalid.
+ */
+void ReSourcePositionTable::clear() {
+   QMutexLocker locker(&m_mutex);
+   for (int ix = 0; ix < m_chunks.size(); ix++) {
+      Chunk* chunk = m_chunks[ix];
+      int slot = chunk->m_number >> GENERATION_BITS;
+      m_registry[slot] = NULL;
+      // the next chunk in the slot gets another number: find() returns NULL
+      // for the handles of this chunk
+      m_generations[slot] = (m_generations.at(slot) + 1) % GENERATION_COUNT;
+      m_freeSlots.enqueue(slot);
+      delete chunk;
+   }
+   m_chunks.clear();
+   m_runs.clear();
+   m_count = 0;
+   m_lineOffset = 0;
+   QHash<ReSourcePositionHandle, ReSourcePosition*>::iterator it;
+   for (it = m_decoded.begin(); it != m_decoded.end(); ++it)
+      delete it.value();
+   m_decoded.clear();
+}
+
+/**
+ * @brief Decodes an entry of a chunk.
+ *
+ * @pre             <code>m_mutex</code> is locked
+ * @param chunk     the chunk containing the entry
+ * @param index     the index in the chunk
+ * @return          the decoded position
+ */
+const ReSourcePosition* ReSourcePositionTable::decode(const Chunk* chunk,
+      int index) {
+   ReSourcePositionHandle handle = (ReSourcePositionHandle(chunk->m_number)
+                                    << CHUNK_BITS) + index;
+   ReSourcePosition* rc = m_decoded.value(handle, NULL);
+   if (rc == NULL) {
+      const Checkpoint& checkpoint =
+         chunk->m_checkpoints.at(index / CHECKPOINT_DISTANCE);
+      int offset = checkpoint.m_offset;
+      int lineNo = checkpoint.m_lineNo;
+      int column = checkpoint.m_column;
+      for (int ix = index - index % CHECKPOINT_DISTANCE; ix <= index; ix++) {
+         int deltaLine = unZigZag(readVarInt(chunk->m_data, offset));
+         int value = unZigZag(readVarInt(chunk->m_data, offset));
+         column = deltaLine == 0 ? column + value : value;
+         lineNo += deltaLine;
+      }
+      int sequenceNo = chunk->m_first + index;
+      int ixRun = m_runs.size() - 1;
+      while (ixRun > 0 && m_runs.at(ixRun).m_first > sequenceNo)
+         ixRun--;
+      const Run& run = m_runs.at(ixRun);
+      rc = new ReSourcePosition(run.m_unit, lineNo + m_lineOffset, column,
+                                run.m_caller, handle);
+      m_decoded.insert(handle, rc);
+   }
+   return rc;
+}
+
+/**
+ * @brief Returns the number of bytes used for the line and column info.
+ *
+ * @return  the size of the encoded data
+ */
+int ReSourcePositionTable::encodedSize() const {
+   int rc = 0;
+   for (int ix = 0; ix < m_chunks.size(); ix++) {
+      const Chunk* chunk = m_chunks.at(ix);
+      rc += chunk->m_data.size()
+            + chunk->m_checkpoints.size() * sizeof(Checkpoint);
+   }
+   return rc + m_runs.size() * sizeof(Run);
+}
+
+/**
+ * @brief Returns the position of a handle of the instance.
+ *
+ * @param handle    the handle of the position
+ * @return          NULL: unknown handle or owned by another table<br>
+ *                  otherwise: the decoded position
+ */
+const ReSourcePosition* ReSourcePositionTable::position(
+   ReSourcePositionHandle handle) {
+   const ReSourcePosition* rc = NULL;
+   int number = handle >> CHUNK_BITS;
+   int slot = number >> GENERATION_BITS;
+   int index = handle & (CHUNK_SIZE - 1);
+   QMutexLocker locker(&m_mutex);
+   if (slot > 0 && slot < m_registry.size()) {
+      Chunk* chunk = m_registry.at(slot);
+      if (chunk != NULL && chunk->m_number == number && chunk->m_table == this
+            && index < chunk->m_count)
+         rc = decode(chunk, index);
+   }
+   return rc;
+}
+
+/**
+ * @brief Moves all positions of the table by some lines.
+ *
+ * Used by the incremental parser: lines in front of the positions have been
+ * inserted or removed. The decoded positions stay valid.
+ *
+ * @param delta the number of lines to add to the line numbers
+ */
+void ReSourcePositionTable::shiftLines(int delta) {
+   QMutexLocker locker(&m_mutex);
+   m_lineOffset += delta;
+   QHash<ReSourcePositionHandle, ReSourcePosition*>::iterator it;
+   for (it = m_decoded.begin(); it != m_decoded.end(); ++it)
+      it.value()->setLineNo(it.value()->lineNo() + delta);
+}
+
+/**
+ * @brief Returns the position of a handle of any table.
+ *
+ * @param handle    the handle of the position
+ * @return          NULL: unknown handle, e.g. the source has been cleared<br>
+ *                  otherwise: the decoded position
+ */
+const ReSourcePosition* ReSourcePositionTable::find(
+   ReSourcePositionHandle handle) {
+   const ReSourcePosition* rc = NULL;
+   int number = handle >> CHUNK_BITS;
+   int slot = number >> GENERATION_BITS;
+   int index = handle & (CHUNK_SIZE - 1);
+   QMutexLocker locker(&m_mutex);
+   if (slot > 0 && slot < m_registry.size()) {
+      Chunk* chunk = m_registry.at(slot);
+      // another generation: the handle belongs to a cleared table
+      if (chunk != NULL && chunk->m_number == number && index < chunk->m_count)
+         rc = chunk->m_table->decode(chunk, index);
+   }
+   return rc;
 }
 
 /** @class ReSource ReSource.hpp "expr/ReSource.hpp"
@@ -328,8 +646,9 @@ ReSourcePositionBlock::ReSourcePositionBlock() :
  */
 ReSource::ReSource() :
    m_sourcePositionStack(),
-   m_sourcePositionBlock(NULL),
-   m_countPositionBlock(RPL_POSITIONS_PER_BLOCK + 1),
+   m_positionTable(),
+   // m_recentPositions
+   m_nextRecent(0),
    m_readers(),
    m_sourceUnits(),
    m_unitStack(),
@@ -353,14 +672,8 @@ void ReSource::destroy() {
    m_readers.clear();
    m_sourceUnits.clear();
    m_currentReader = NULL;
-   ReSourcePositionBlock* block = m_sourcePositionBlock;
-   m_sourcePositionBlock = NULL;
-   m_countPositionBlock = RPL_POSITIONS_PER_BLOCK + 1;
-   while (block != NULL) {
-      ReSourcePositionBlock* last = block;
-      block = block->m_successor;
-      delete last;
-   }
+   m_positionTable.clear();
+   m_nextRecent = 0;
 }
 
 /**
@@ -426,7 +739,10 @@ void ReSource::addSourceUnit(ReSourceUnit* unit) {
  */
 bool ReSource::startUnit(ReSourceUnitName unit,
                          const ReSourcePosition& caller) {
-   m_sourcePositionStack.push_back(&caller);
+   // the caller is normally a short living instance from newPosition():
+   const ReSourcePosition* stored = caller.handle() == 0 ? &caller
+                                    : m_positionTable.position(caller.handle());
+   m_sourcePositionStack.push_back(stored);
    ReReader* reader = NULL;
    QList<ReReader*>::iterator it;
    for (it = m_readers.begin(); reader == NULL && it != m_readers.end();
@@ -487,27 +803,26 @@ ReReader* ReSource::currentReader() {
 }
 
 /**
- * @brief Returns a new instance of the current source position.
+ * @brief Stores the current source position and returns a view of it.
  *
- * The storage is done in a block (efficency).
+ * The position is stored in the position table. The returned instance is
+ * only valid for the next <code>RPL_RECENT_POSITIONS</code> calls:
+ * a permanent reference is the handle (<code>ReSourcePosition::handle()</code>).
  *
  * @param colNo     the column in the line
- * @return          a new instance of a source position
+ * @return          a short living instance of the current source position
  */
 const ReSourcePosition* ReSource::newPosition(int colNo) {
-   if (m_countPositionBlock >= RPL_POSITIONS_PER_BLOCK) {
-      ReSourcePositionBlock* newBlock = new ReSourcePositionBlock;
-      newBlock->m_successor = m_sourcePositionBlock;
-      m_sourcePositionBlock = newBlock;
-      m_countPositionBlock = 0;
-   }
-   unsigned offset = m_countPositionBlock * sizeof(ReSourcePosition);
-   m_countPositionBlock++;
-   char* posInBlock = &m_sourcePositionBlock->m_positions[offset];
    ReSourceUnit* unit = dynamic_cast<ReSourceUnit*>(m_currentReader
                         ->currentSourceUnit());
-   ReSourcePosition* rc = new (posInBlock) ReSourcePosition(unit,
-         unit->lineNo(), colNo);
+   const ReSourcePosition* caller = this->caller();
+   ReSourcePosition* rc = &m_recentPositions[m_nextRecent];
+   m_nextRecent = (m_nextRecent + 1) % RPL_RECENT_POSITIONS;
+   rc->m_sourceUnit = unit;
+   rc->m_lineNo = unit->lineNo();
+   rc->m_column = colNo;
+   rc->m_caller = caller;
+   rc->m_handle = m_positionTable.add(unit, rc->m_lineNo, colNo, caller);
    return rc;
 }
 
@@ -36,12 +36,18 @@ protected:
    ReReader* m_reader;
 };
 
+/// a compact reference to a source position (see ReSourcePositionTable).
+/// 0: no position
+typedef quint32 ReSourcePositionHandle;
+
 class ReSourcePosition {
+   friend class ReSource;
 public:
    ReSourcePosition();
    ReSourcePosition(ReSourceUnit* unit, int lineNo, int colNo);
+   ReSourcePosition(ReSourceUnit* unit, int lineNo, int colNo,
+                    const ReSourcePosition* caller, ReSourcePositionHandle handle);
    ~ ReSourcePosition();
-   void* operator new(size_t cbSize, void* buffer);
 private:
    /// forbid usage of the copy constructor!
    ReSourcePosition(const ReSourcePosition& source);
@@ -55,6 +61,13 @@ public:
    int column() const;
    void setColumn(int column);
 
+   /** Returns the handle of the position in the position table.
+    * @return  0: not stored in a table<br>
+    *          otherwise: the handle (see <code>ReSourcePositionTable</code>)
+    */
+   inline ReSourcePositionHandle handle() const {
+      return m_handle;
+   }
    ReSourceUnit* sourceUnit() const;
    void setSourceUnit(ReSourceUnit* sourceUnit);
    char* utf8(char buffer[], size_t bufferSize) const;
@@ -63,6 +76,7 @@ private:
    int m_lineNo;
    int m_column;
    const ReSourcePosition* m_caller;
+   ReSourcePositionHandle m_handle;
 };
 
 class ReReader {
@@ -119,16 +133,96 @@ protected:
    ReSource& m_source;
 };
 
-#define RPL_POSITIONS_PER_BLOCK 512
-class ReSourcePositionBlock {
-   friend class ReSource;
+class ReSourcePositionTable {
+public:
+   enum {
+      /// a handle contains the chunk number and the index in the chunk
+      CHUNK_BITS = 12,
+      CHUNK_SIZE = 1 << CHUNK_BITS,
+      /// every n-th entry of a chunk can be decoded without its predecessors
+      CHECKPOINT_DISTANCE = 32,
+      /// the lower bits of a chunk number: incremented when a slot is reused
+      GENERATION_BITS = 6,
+      GENERATION_COUNT = 1 << GENERATION_BITS,
+      /// the chunks existing at the same time: the upper bits of a number
+      MAX_CHUNKS = 1 << (32 - CHUNK_BITS - GENERATION_BITS)
+   };
+private:
+   class Checkpoint {
+   public:
+      int m_offset;
+      int m_lineNo;
+      int m_column;
+   };
+   class Chunk {
+   public:
+      Chunk(ReSourcePositionTable* table, int number, int first);
+   public:
+      ReSourcePositionTable* m_table;
+      /// the global number: the upper bits of the handle.
+      /// It contains the slot in m_registry and the generation of the slot
+      int m_number;
+      /// the sequence number of the first entry in the table
+      int m_first;
+      int m_count;
+      int m_lastLineNo;
+      int m_lastColumn;
+      /// the varint encoded deltas of line and column
+      QByteArray m_data;
+      QVector<Checkpoint> m_checkpoints;
+   };
+   /// all entries from m_first to the next run have the same unit and caller
+   class Run {
+   public:
+      int m_first;
+      ReSourceUnit* m_unit;
+      const ReSourcePosition* m_caller;
+   };
+public:
+   ReSourcePositionTable();
+   ~ReSourcePositionTable();
+private:
+   /// forbid usage of the copy constructor!
+   ReSourcePositionTable(const ReSourcePositionTable& source);
+   /// forbid usage of the the assignment!
+   ReSourcePositionTable& operator=(const ReSourcePositionTable& source);
+public:
+   ReSourcePositionHandle add(ReSourceUnit* unit, int lineNo, int column,
+                              const ReSourcePosition* caller);
+   void clear();
+   /** Returns the number of the stored positions.
+    * @return  the number of entries
+    */
+   inline int count() const {
+      return m_count;
+   }
+   int encodedSize() const;
+   const ReSourcePosition* position(ReSourcePositionHandle handle);
+   void shiftLines(int delta);
 public:
-   ReSourcePositionBlock();
+   static const ReSourcePosition* find(ReSourcePositionHandle handle);
+private:
+   const ReSourcePosition* decode(const Chunk* chunk, int index);
 private:
-   ReSourcePositionBlock* m_successor;
-   char m_positions[RPL_POSITIONS_PER_BLOCK* sizeof(ReSourcePosition)];
+   int m_count;
+   /// will be added to the stored line numbers (see shiftLines())
+   int m_lineOffset;
+   QVector<Chunk*> m_chunks;
+   QVector<Run> m_runs;
+   /// the positions decoded on demand: handle -> position
+   QHash<ReSourcePositionHandle, ReSourcePosition*> m_decoded;
+private:
+   /// slot -> chunk. Entry 0 is never used: handle 0 means "none".
+   /// The entries of cleared tables are NULL until the slot is reused
+   static QVector<Chunk*> m_registry;
+   /// slot -> the generation of the next chunk in the slot
+   static QVector<int> m_generations;
+   /// the unused slots: the oldest is reused first
+   static QQueue<int> m_freeSlots;
+   static QMutex m_mutex;
 };
 
+#define RPL_RECENT_POSITIONS 8
 class ReSource {
 public:
    ReSource();
@@ -148,13 +242,21 @@ public:
    const ReSourcePosition* newPosition(int colNo);
    void clear();
    const ReSourcePosition* caller() const;
+   /** Returns the table containing the positions of all scanned tokens.
+    * @return  the position table
+    */
+   inline ReSourcePositionTable& positionTable() {
+      return m_positionTable;
+   }
 protected:
    void destroy();
 protected:
    // stack of the info about the stacked (open) source units:
    QStack<const ReSourcePosition*> m_sourcePositionStack;
-   ReSourcePositionBlock* m_sourcePositionBlock;
-   int m_countPositionBlock;
+   ReSourcePositionTable m_positionTable;
+   /// the last positions returned by newPosition() (used as ring buffer)
+   ReSourcePosition m_recentPositions[RPL_RECENT_POSITIONS];
+   int m_nextRecent;
    QList<ReReader*> m_readers;
    QList<ReSourceUnit*> m_sourceUnits;
    // setCurrentSourceUnit() pushes one entry, removeSourceUnit() pops it
@@ -21,6 +21,10 @@
 
 #include "base/rebase.hpp"
 #include "expr/reexpr.hpp"
+#if defined __linux__
+#include <signal.h>
+#include <sys/time.h>
+#endif
 
 enum {
    LOC_VAL_OF_VAR_1 = LOC_FIRST_OF(LOC_VM), // 11401
@@ -29,10 +33,17 @@ enum {
    LOC_UNOP_3,
    LOC_UNOP_4, // 10005
    LOC_BINOP_1,
+   LOC_RUN_1,
    LOC_COUNT
 };
 
-int ReVMThread::m_nextId = 1;
+QAtomicInt ReVMThread::m_nextId(1);
+#if defined __linux__
+/// the profile of the running thread: used by the signal handler
+static __thread ReVMProfile* s_activeProfile = NULL;
+/// the signal action replaced by the sampling profiler
+static struct sigaction s_oldProfileAction;
+#endif
 
 /** @class ReVMException ReVM.hpp "expr/ReVM.hpp"
  *
@@ -61,59 +72,542 @@ ReVMException::ReVMException(const char* format, ...) :
  * The owner of a symbol space can be "global", a module, a class, or a method.
  * Some symbol spaces have more than one stack frame, e.g. a recursive called
  * method.
+ *
+ * The variables are not stored in the frame but in a window of the value
+ * stack of the thread: the arguments of a method call are calculated
+ * directly into the variables of the parameters.
  */
 
 /**
  * @brief Constructor.
- *
- * @param caller	name of the caller (for debugging)
- * @param symbols   the symbol space belonging to the stack frame
  */
+ReStackFrame::ReStackFrame() :
+   m_base(0),
+   m_countVariables(0),
+   m_symbols(NULL),
+   m_caller(NULL) {
+}
 
-ReStackFrame::ReStackFrame(ReASItem* caller, ReSymbolSpace* symbols) :
-   m_countVariables(symbols->listOfVars().size()),
-   m_variables(NULL),
+/**
+ * @brief Constructor.
+ *
+ * @param caller            the caller (for debugging)
+ * @param symbols           the symbol space belonging to the stack frame
+ * @param base              the index of the first variable in the value stack
+ * @param countVariables    the number of variables of the symbol space
+ */
+ReStackFrame::ReStackFrame(ReASItem* caller, ReSymbolSpace* symbols,
+                           int base, int countVariables) :
+   m_base(base),
+   m_countVariables(countVariables),
    m_symbols(symbols),
    m_caller(caller) {
-   if (m_countVariables > 0)
-      m_variables = new ReASVariant[m_countVariables];
+}
+
+/**
+ * @brief Returns the caller of the frame.
+ *
+ * @return  NULL or the node which has created the frame
+ */
+ReASItem* ReStackFrame::caller() const {
+   return m_caller;
+}
+
+/**
+ * @brief Returns the symbol space of the frame.
+ *
+ * @return  the symbol space
+ */
+ReSymbolSpace* ReStackFrame::symbols() const {
+   return m_symbols;
+}
+
+/** @class ReVMChannel ReVM.hpp "expr/ReVM.hpp"
+ *
+ * @brief Implements a synchronized queue of values.
+ *
+ * The channels are the way to exchange data between VM threads: a writer
+ * blocks if the channel is full, a reader blocks while it is empty.
+ */
+
+/**
+ * @brief Constructor.
+ *
+ * @param capacity  the maximal number of values waiting for a reader
+ */
+ReVMChannel::ReVMChannel(int capacity) :
+   m_capacity(capacity),
+   m_closed(false),
+   m_values(),
+   m_mutex(),
+   m_notEmpty(),
+   m_notFull() {
+}
+
+/**
+ * @brief Closes the channel.
+ *
+ * The values in the queue can still be read. After that <code>take()</code>
+ * returns immediately.
+ */
+void ReVMChannel::close() {
+   QMutexLocker locker(&m_mutex);
+   m_closed = true;
+   m_notEmpty.wakeAll();
+   m_notFull.wakeAll();
+}
+
+/**
+ * @brief Appends a value to the queue.
+ *
+ * Waits while the queue is full.
+ *
+ * @param value the value to append. Objects will be shared (copy on write)
+ */
+void ReVMChannel::put(const ReASVariant& value) {
+   QMutexLocker locker(&m_mutex);
+   while (!m_closed && m_values.size() >= m_capacity)
+      m_notFull.wait(&m_mutex);
+   if (m_closed)
+      throw ReVMException("put(): the channel is closed");
+   m_values.enqueue(value);
+   m_notEmpty.wakeOne();
+}
+
+/**
+ * @brief Removes the first value of the queue.
+ *
+ * Waits while the queue is empty and the channel is not closed.
+ *
+ * @param value OUT: the value. Undefined if the channel is closed and empty
+ * @return      <code>true</code>: a value has been read<br>
+ *              <code>false</code>: the channel is closed and empty
+ */
+bool ReVMChannel::take(ReASVariant& value) {
+   QMutexLocker locker(&m_mutex);
+   while (!m_closed && m_values.isEmpty())
+      m_notEmpty.wait(&m_mutex);
+   bool rc = !m_values.isEmpty();
+   if (!rc)
+      value.destroyValue();
+   else {
+      value = m_values.dequeue();
+      m_notFull.wakeOne();
+   }
+   return rc;
+}
+
+/** @class ReVMProfile ReVM.hpp "expr/ReVM.hpp"
+ *
+ * @brief Implements the execution profile of one VM thread.
+ *
+ * In counting mode each statement execution is counted and timed, in sampling
+ * mode only the running statement is stored: a timer signal takes samples
+ * of it (see <code>ReVMProfiler</code>).
+ *
+ * The method calls build a call tree: each node stands for a call stack.
+ */
+
+/**
+ * @brief Constructor.
+ *
+ * @param sampling      <code>true</code>: sampling mode<br>
+ *                      <code>false</code>: counting mode
+ * @param maxSamples    the capacity of the sample buffer
+ */
+ReVMProfile::ReVMProfile(bool sampling, int maxSamples) :
+   m_sampling(sampling),
+   m_clock(),
+   m_entries(),
+   m_nodes(),
+   m_current(NULL),
+   m_currentNode(0),
+   m_sampleItems(NULL),
+   m_sampleNodes(NULL),
+   m_maxSamples(sampling ? maxSamples : 0),
+   m_countSamples(0) {
+   m_clock.start();
+   CallNode root;
+   root.m_name = "vm";
+   root.m_parent = -1;
+   root.m_count = 0;
+   root.m_ticks = 0;
+   root.m_samples = 0;
+   m_nodes.append(root);
+   if (m_maxSamples > 0) {
+      m_sampleItems = new const ReASItem*[m_maxSamples];
+      m_sampleNodes = new int[m_maxSamples];
+   }
 }
 
 /**
  * @brief Destructor.
  */
-ReStackFrame::~ReStackFrame() {
-   delete[] m_variables;
-   m_variables = NULL;
+ReVMProfile::~ReVMProfile() {
+   delete[] m_sampleItems;
+   m_sampleItems = NULL;
+   delete[] m_sampleNodes;
+   m_sampleNodes = NULL;
 }
 
 /**
- * @brief Returns the storage of a variable given by the index.
+ * @brief Returns the call tree.
  *
- * @param index the index of the variable
+ * @return  the nodes of the call tree. Index 0 is the root
+ */
+const QVector<ReVMProfile::CallNode>& ReVMProfile::callNodes() const {
+   return m_nodes;
+}
+
+/**
+ * @brief Marks the start of a method call.
  *
- * @return      the storage of the variable
+ * @param name  the name of the method
+ * @param mark  OUT: the state to restore by <code>leaveCall()</code>
  */
-ReASVariant& ReStackFrame::valueOfVariable(int index) {
-   if (index < 0 || index >= m_countVariables)
-      throw ReVMException("valueOfVariable(): invalid index: %d", index);
-   return m_variables[index];
+void ReVMProfile::enterCall(const QByteArray& name, Mark& mark) {
+   mark.m_outer = m_current;
+   mark.m_outerNode = m_currentNode;
+   int node = m_nodes.at(m_currentNode).m_children.value(name, -1);
+   if (node < 0) {
+      CallNode child;
+      child.m_name = name;
+      child.m_parent = m_currentNode;
+      child.m_count = 0;
+      child.m_ticks = 0;
+      child.m_samples = 0;
+      node = m_nodes.size();
+      m_nodes.append(child);
+      m_nodes[m_currentNode].m_children.insert(name, node);
+   }
+   m_currentNode = node;
+   mark.m_start = m_sampling ? 0 : m_clock.nsecsElapsed();
 }
+
 /**
- * @brief Returns the symbol space of the frame.
+ * @brief Returns the statistics of the executed nodes.
  *
- * @return  the symbol space
+ * @return  the statistics (key: the node)
  */
-ReSymbolSpace* ReStackFrame::symbols() const {
-   return m_symbols;
+const ReVMProfile::EntryMap& ReVMProfile::entries() const {
+   return m_entries;
+}
+
+/**
+ * @brief Moves the samples into the statistics of the nodes.
+ *
+ * Must not be called while the sampling signal can interrupt the thread.
+ */
+void ReVMProfile::evaluateSamples() {
+   for (int ix = 0; ix < m_countSamples; ix++) {
+      m_entries[m_sampleItems[ix]].m_samples++;
+      m_nodes[m_sampleNodes[ix]].m_samples++;
+   }
+   m_countSamples = 0;
+}
+
+/**
+ * @brief Marks the end of a method call.
+ *
+ * @param mark  the state stored by <code>enterCall()</code>
+ */
+void ReVMProfile::leaveCall(const Mark& mark) {
+   CallNode& node = m_nodes[m_currentNode];
+   node.m_count++;
+   if (!m_sampling)
+      node.m_ticks += m_clock.nsecsElapsed() - mark.m_start;
+   m_currentNode = mark.m_outerNode;
+   m_current = mark.m_outer;
+}
+
+/**
+ * @brief Stores the running node and call stack.
+ *
+ * Called by the signal handler: no memory allocation, no locks.
+ */
+void ReVMProfile::sample() {
+   int ix = m_countSamples;
+   if (ix < m_maxSamples && m_current != NULL) {
+      m_sampleItems[ix] = m_current;
+      m_sampleNodes[ix] = m_currentNode;
+      m_countSamples = ix + 1;
+   }
+}
+
+/**
+ * @brief Returns the profile of the running thread.
+ *
+ * @return  NULL or the profile seen by the sampling signal handler
+ */
+ReVMProfile* ReVMProfile::active() {
+#if defined __linux__
+   return s_activeProfile;
+#else
+   return NULL;
+#endif
+}
+
+/**
+ * @brief Sets the profile of the running thread.
+ *
+ * @param profile   NULL or the profile seen by the sampling signal handler
+ */
+void ReVMProfile::setActive(ReVMProfile* profile) {
+#if defined __linux__
+   s_activeProfile = profile;
+#else
+   RE_UNUSED(profile);
+#endif
+}
+
+#if defined __linux__
+/**
+ * @brief Handles the signal of the sampling timer.
+ *
+ * @param signal    the signal number (SIGPROF)
+ */
+static void onProfileSignal(int signal) {
+   RE_UNUSED(signal);
+   ReVMProfile* profile = s_activeProfile;
+   if (profile != NULL)
+      profile->sample();
+}
+#endif
+
+/** @class ReVMProfiler ReVM.hpp "expr/ReVM.hpp"
+ *
+ * @brief Implements a profiler for the virtual machine.
+ *
+ * Each thread started while the profiler is running gets its own profile:
+ * the threads are not synchronized while they are profiled.
+ *
+ * The results are attributed to the source positions of the nodes. They can
+ * be written as a flat report or as "collapsed stacks", the input format of
+ * the flamegraph tools.
+ *
+ * Sampling mode uses the timer <code>ITIMER_PROF</code> and is only
+ * available under Linux.
+ */
+
+/**
+ * @brief Constructor.
+ */
+ReVMProfiler::ReVMProfiler() :
+   m_mode(PM_OFF),
+   m_running(0),
+   m_profiles(),
+   m_mutex() {
+}
+
+/**
+ * @brief Destructor.
+ */
+ReVMProfiler::~ReVMProfiler() {
+   stop();
+   clear();
+}
+
+/**
+ * @brief Removes the collected profiles.
+ */
+void ReVMProfiler::clear() {
+   QMutexLocker locker(&m_mutex);
+   qDeleteAll(m_profiles);
+   m_profiles.clear();
+}
+
+/**
+ * @brief Creates the profile of a new thread.
+ *
+ * @return  NULL: the profiler is not running<br>
+ *          otherwise: the profile (owned by the profiler)
+ */
+ReVMProfile* ReVMProfiler::createProfile() {
+   ReVMProfile* rc = NULL;
+   // acquire: start() sets the mode before m_running
+   if (m_running.loadAcquire() != 0) {
+      rc = new ReVMProfile(m_mode == PM_SAMPLE);
+      QMutexLocker locker(&m_mutex);
+      m_profiles.append(rc);
+   }
+   return rc;
+}
+
+/**
+ * @brief Starts the profiling.
+ *
+ * Only the threads created after this call are profiled.
+ *
+ * @param mode              PM_COUNT or PM_SAMPLE
+ * @param intervalMicroSec  sampling mode: the distance of two samples in
+ *                          microseconds (CPU time)
+ */
+void ReVMProfiler::start(Mode mode, int intervalMicroSec) {
+   stop();
+   clear();
+#if ! defined __linux__
+   // no sampling timer: counting is the best we can do
+   if (mode == PM_SAMPLE)
+      mode = PM_COUNT;
+#endif
+   m_mode = mode;
+#if defined __linux__
+   if (mode == PM_SAMPLE) {
+      struct sigaction action;
+      memset(&action, 0, sizeof action);
+      action.sa_handler = onProfileSignal;
+      action.sa_flags = SA_RESTART;
+      sigemptyset(&action.sa_mask);
+      sigaction(SIGPROF, &action, &s_oldProfileAction);
+      struct itimerval timer;
+      timer.it_interval.tv_sec = intervalMicroSec / 1000000;
+      timer.it_interval.tv_usec = intervalMicroSec % 1000000;
+      timer.it_value = timer.it_interval;
+      setitimer(ITIMER_PROF, &timer, NULL);
+   }
+#else
+   RE_UNUSED(intervalMicroSec);
+#endif
+   m_running.storeRelease(mode != PM_OFF);
+}
+
+/**
+ * @brief Stops the profiling.
+ *
+ * The profiles are kept until the next <code>start()</code> or
+ * <code>clear()</code>. The samples are evaluated by the output methods:
+ * the profiled threads may still run.
+ */
+void ReVMProfiler::stop() {
+   if (m_running.fetchAndStoreOrdered(0) != 0 && m_mode == PM_SAMPLE) {
+#if defined __linux__
+      struct itimerval timer;
+      memset(&timer, 0, sizeof timer);
+      setitimer(ITIMER_PROF, &timer, NULL);
+      // ignoring discards a pending signal, then the old action is restored:
+      signal(SIGPROF, SIG_IGN);
+      sigaction(SIGPROF, &s_oldProfileAction, NULL);
+#endif
+   }
+}
+
+/**
+ * @brief Moves the samples of all profiles into their statistics.
+ *
+ * @pre     the profiled threads have finished
+ * @pre     the caller holds <code>m_mutex</code>
+ */
+void ReVMProfiler::evaluateSamples() {
+   if (m_mode == PM_SAMPLE)
+      for (int ix = 0; ix < m_profiles.size(); ix++)
+         m_profiles.at(ix)->evaluateSamples();
+}
+
+/**
+ * @brief Writes the call stacks in the "collapsed" format.
+ *
+ * Each line contains the names of the methods of a call stack separated by
+ * ';' and the time spent in the last method (counting mode: in
+ * nanoseconds) or the number of samples.
+ * This is the input of flamegraph tools.
+ *
+ * @param writer    OUT: the output medium
+ * @pre             the profiled threads have finished
+ */
+void ReVMProfiler::writeCollapsedStacks(ReWriter& writer) {
+   QMap<QByteArray, qint64> stacks;
+   QMutexLocker locker(&m_mutex);
+   evaluateSamples();
+   for (int ixProfile = 0; ixProfile < m_profiles.size(); ixProfile++) {
+      const QVector<ReVMProfile::CallNode>& nodes =
+         m_profiles.at(ixProfile)->callNodes();
+      for (int ix = 0; ix < nodes.size(); ix++) {
+         const ReVMProfile::CallNode& node = nodes.at(ix);
+         qint64 value;
+         if (m_mode == PM_SAMPLE)
+            value = node.m_samples;
+         else {
+            // the time of the callees is not spent in the node:
+            value = node.m_ticks;
+            QMap<QByteArray, int>::const_iterator it;
+            for (it = node.m_children.constBegin();
+                  it != node.m_children.constEnd(); ++it)
+               value -= nodes.at(it.value()).m_ticks;
+         }
+         if (value > 0) {
+            QByteArray path = node.m_name;
+            for (int parent = node.m_parent; parent >= 0;
+                  parent = nodes.at(parent).m_parent)
+               path = nodes.at(parent).m_name + ";" + path;
+            stacks[path] += value;
+         }
+      }
+   }
+   QMap<QByteArray, qint64>::const_iterator it;
+   for (it = stacks.constBegin(); it != stacks.constEnd(); ++it)
+      writer.formatLine("%s %lld", it.key().constData(), it.value());
+}
+
+/**
+ * @brief Writes the hot spots: the statistics of the source positions.
+ *
+ * The lines are sorted by the time (counting mode) or by the number of
+ * samples (sampling mode). The time of a statement contains the time of
+ * its nested statements.
+ *
+ * @param writer    OUT: the output medium
+ * @param maxLines  the maximal number of positions to write
+ * @pre             the profiled threads have finished
+ */
+void ReVMProfiler::writeReport(ReWriter& writer, int maxLines) {
+   QMap<QByteArray, ReVMProfile::Entry> positions;
+   QMap<QByteArray, const char*> types;
+   QMutexLocker locker(&m_mutex);
+   evaluateSamples();
+   for (int ixProfile = 0; ixProfile < m_profiles.size(); ixProfile++) {
+      const ReVMProfile::EntryMap& entries = m_profiles.at(ixProfile)->entries();
+      ReVMProfile::EntryMap::const_iterator it;
+      for (it = entries.constBegin(); it != entries.constEnd(); ++it) {
+         const ReASItem* item = it.key();
+         char buffer[512];
+         const ReSourcePosition* position = item->position();
+         QByteArray key = position == NULL ? "?"
+                          : position->utf8(buffer, sizeof buffer);
+         ReVMProfile::Entry& entry = positions[key];
+         entry.m_count += it.value().m_count;
+         entry.m_ticks += it.value().m_ticks;
+         entry.m_samples += it.value().m_samples;
+         types[key] = item->nameOfItemType();
+      }
+   }
+   // sorting: the hottest position at the end
+   QMultiMap<qint64, QByteArray> sorted;
+   QMap<QByteArray, ReVMProfile::Entry>::const_iterator it;
+   for (it = positions.constBegin(); it != positions.constEnd(); ++it)
+      sorted.insert(m_mode == PM_SAMPLE ? it.value().m_samples
+                    : it.value().m_ticks, it.key());
+   writer.formatLine("%12s %12s %8s %s", "count", "msec", "samples",
+                     "position");
+   QMultiMap<qint64, QByteArray>::const_iterator it2 = sorted.constEnd();
+   while (maxLines-- > 0 && it2 != sorted.constBegin()) {
+      --it2;
+      const ReVMProfile::Entry& entry = positions[it2.value()];
+      writer.formatLine("%12lld %12.3f %8lld %s %s", entry.m_count,
+                        entry.m_ticks / 1E6, entry.m_samples,
+                        it2.value().constData(), types[it2.value()]);
+   }
 }
 
 /** @class ReVMThread ReVM.hpp "expr/ReVM.hpp"
  *
  * @brief Implements a thread of the virtual machine.
  *
- * The virtual machine can execute many threads at the same time.
- * Each thread has its own stack.
+ * The virtual machine can execute many threads at the same time: each
+ * instance runs in its own OS thread (<code>start()</code>) and has its own
+ * stacks. The checked syntax tree is shared and must not be changed.
+ *
+ * A thread created for a part of a parallel loop has a parent thread: the
+ * variables not stored in its own frames are the variables of the parent.
  */
 
 /**
@@ -121,30 +615,82 @@ ReSymbolSpace* ReStackFrame::symbols() const {
  *
  * @param maxStack  the maximal number of nested stack frames
  * @param vm        the parent, the virtual machine
+ * @param parent    NULL or the thread sharing its variables with the instance
  */
-ReVMThread::ReVMThread(int maxStack, ReVirtualMachine* vm) :
-   m_id(m_nextId++),
+ReVMThread::ReVMThread(int maxStack, ReVirtualMachine* vm,
+                       ReVMThread* parent) :
+   m_id(m_nextId.fetchAndAddOrdered(1)),
    m_debugMode(false),
    m_singleStep(false),
    m_tracing(false),
    m_maxStack(maxStack),
    m_frameStack(),
-   // the stack is never empty!
-   m_topOfFrames(0),
    m_valueStack(),
    // the stack is never empty!
    m_topOfValues(0),
+   m_lastValue(),
    m_vm(vm),
-   m_logger(new ReLogger()) {
-   QByteArray prefix = "vm_thread_" + QByteArray::number(m_id);
-   m_logger->buildStandardAppender(prefix);
+   // the parts of a parallel loop use the logger of the caller:
+   m_logger(parent == NULL ? new ReLogger() : parent->logger()),
+   m_parentThread(parent),
+   m_privateVariables(),
+   m_initialization(NULL),
+   m_spaceInitialization(NULL),
+   m_statements(NULL),
+   m_space(NULL),
+   m_loop(NULL),
+   m_loopStart(0),
+   m_loopEnd(0),
+   m_loopStep(1),
+   m_error(),
+   m_profile(vm->profiler().createProfile()) {
    m_frameStack.reserve(maxStack);
    // the stack is never empty!
-   //@ToDo:
-   //m_frameStack.append(new ReStackFrame(vm->tree().symbolSpaces()[0]));
-   throw ReNotImplementedException("ReVMThread::ReVMThread");
-   // the stack is never empty!
    m_valueStack.append(new ReASVariant);
+   if (parent != NULL) {
+      m_tracing = parent->tracing();
+      // the parts of the loop log concurrently:
+      m_logger->setWithLocking(true);
+   } else {
+      QByteArray prefix = "vm_thread_" + QByteArray::number(m_id);
+      m_logger->buildStandardAppender(prefix);
+      // the stack is never empty!
+      ReSymbolSpace* global = vm->tree().symbolSpaces()[0];
+      pushFrame(NULL, global, global->listOfVars().size(), 0);
+   }
+}
+
+/**
+ * @brief Destructor.
+ */
+ReVMThread::~ReVMThread() {
+   qDeleteAll(m_valueStack);
+   m_valueStack.clear();
+   if (m_parentThread == NULL)
+      delete m_logger;
+   m_logger = NULL;
+}
+
+/**
+ * @brief Pushes a copy of a frame of another thread.
+ *
+ * Used for the parts of a parallel loop: each thread has its own loop
+ * variable and local variables. The other variables of the frame are
+ * copies of shared variables: they are read-only.
+ *
+ * @param source    the thread containing the frame
+ * @param symbols   the symbol space of the frame to copy
+ * @param isPrivate isPrivate[n] is <code>true</code> if the variable with
+ *                  the number n may be changed by this thread
+ */
+void ReVMThread::copyFrame(ReVMThread& source, ReSymbolSpace* symbols,
+                           const QVector<bool>& isPrivate) {
+   int count = symbols->listOfVars().size();
+   m_privateVariables = isPrivate;
+   pushFrame(NULL, symbols, count, 0);
+   for (int ix = 0; ix < count; ix++)
+      valueOfVariable(symbols, ix).copyValue(source.valueOfVariable(symbols,
+                                             ix));
 }
 
 /**
@@ -155,19 +701,35 @@ ReVMThread::ReVMThread(int maxStack, ReVirtualMachine* vm) :
  * @param space         the current symbol space
  */
 void ReVMThread::execute(ReASNode1* statements, ReSymbolSpace* space) {
-   RE_UNUSED(space);
+   // the frame stays alive: e.g. the module variables are used by main()
+   if (space != NULL && m_frameStack.last().symbols() != space)
+      pushFrame(NULL, space, space->listOfVars().size(), 0);
    bool debugMode = m_debugMode;
-   ReASNode1* next;
-   while (statements != NULL) {
-      if (debugMode
-            && (m_singleStep
-                || (statements->flags() & ReASItem::NF_BREAKPOINT) != 0))
-         debug(statements);
-      ReASStatement* statement = dynamic_cast<ReASStatement*>(statements);
-      if (statement != NULL)
-         statement->execute(*this);
-      statements = dynamic_cast<ReASNode1*>(statements->child());
+   ReVMProfile* outerProfile = ReVMProfile::active();
+   if (m_profile != NULL)
+      ReVMProfile::setActive(m_profile);
+   try {
+      while (statements != NULL) {
+         if (debugMode
+               && (m_singleStep
+                   || (statements->flags() & ReASItem::NF_BREAKPOINT) != 0))
+            debug(statements);
+         ReASStatement* statement = dynamic_cast<ReASStatement*>(statements);
+         if (statement != NULL && m_profile == NULL)
+            statement->execute(*this);
+         else if (statement != NULL) {
+            ReVMProfile::Mark mark;
+            m_profile->enter(statements, mark);
+            statement->execute(*this);
+            m_profile->leave(mark);
+         }
+         statements = dynamic_cast<ReASNode1*>(statements->child());
+      }
+   } catch (...) {
+      ReVMProfile::setActive(outerProfile);
+      throw;
    }
+   ReVMProfile::setActive(outerProfile);
 }
 
 /**
@@ -178,6 +740,16 @@ void ReVMThread::execute(ReASNode1* statements, ReSymbolSpace* space) {
 void ReVMThread::debug(ReASNode1* statement) {
 }
 
+/**
+ * @brief Returns the error message of the last <code>run()</code>.
+ *
+ * @return  "": success<br>
+ *          otherwise: the message of the exception stopping the thread
+ */
+const QByteArray& ReVMThread::error() const {
+   return m_error;
+}
+
 /**
  * @brief Returns the logger of the instance.
  *
@@ -242,7 +814,20 @@ ReASVariant& ReVMThread::popValue() {
  * @param variableNo    the current no of the variable in the symbol space
  */
 void ReVMThread::valueToTop(ReSymbolSpace* symbolSpace, int variableNo) {
-   //@ToDo
+   // the variables are stored below the top: reserveValue() does not touch them
+   ReASVariant& value = valueOfVariable(symbolSpace, variableNo);
+   reserveValue().copyValue(value);
+}
+
+/**
+ * @brief Returns the value of the last executed expression statement.
+ *
+ * This is the result of a method call.
+ *
+ * @return  the value of the last expression statement
+ */
+ReASVariant& ReVMThread::lastValue() {
+   return m_lastValue;
 }
 
 /**
@@ -255,10 +840,12 @@ ReASVariant& ReVMThread::lValue(ReASItem* item) {
    switch (item->nodeType()) {
    case AST_NAMED_VALUE: {
       ReASNamedValue* var = dynamic_cast<ReASNamedValue*>(item);
-      rc = &valueOfVariable(var->symbolSpace(), var->variableNo());
+      rc = &writableVariable(var->symbolSpace(), var->variableNo());
       break;
    }
    default:
+      throw ReVMException("lValue(): not a variable: %s",
+                          item->nameOfItemType());
       break;
    }
    return *rc;
@@ -267,26 +854,58 @@ ReASVariant& ReVMThread::lValue(ReASItem* item) {
 /**
  * @brief Returns the reference of the value of a variable.
  *
+ * The most inner frame of the symbol space is used: the local variables of
+ * the running method are found with the first test.
+ *
  * @param symbolSpace   the symbol space
  * @param variableNo    the current number in the symbol space
  * @return
  */
 ReASVariant& ReVMThread::valueOfVariable(ReSymbolSpace* symbolSpace,
       int variableNo) {
-   ReASVariant& rc = *m_valueStack[0];
-   int ix = m_topOfFrames;
-   ReStackFrame* frame = NULL;
-   for (int ix = m_topOfFrames; ix >= 0; ix--) {
-      frame = m_frameStack[ix];
-      if (frame->symbols() == symbolSpace) {
-         rc = frame->valueOfVariable(variableNo);
-         break;
+   for (int ix = m_frameStack.size() - 1; ix >= 0; ix--) {
+      const ReStackFrame& frame = m_frameStack.at(ix);
+      if (frame.symbols() == symbolSpace) {
+         if (variableNo < 0 || variableNo >= frame.countVariables())
+            throw ReVMException("valueOfVariable(): invalid index: %d",
+                                variableNo);
+         return *m_valueStack[frame.base() + variableNo];
       }
    }
-   if (frame == NULL)
-      m_logger->logv(LOG_ERROR, LOC_VAL_OF_VAR_1,
-                     "no frame has symbolspace %s", symbolSpace->name().constData());
-   return rc;
+   // a part of a parallel loop shares the outer variables:
+   if (m_parentThread != NULL)
+      return m_parentThread->valueOfVariable(symbolSpace, variableNo);
+   m_logger->logv(LOG_ERROR, LOC_VAL_OF_VAR_1, "no frame has symbolspace %s",
+                  symbolSpace->name().constData());
+   throw ReVMException("valueOfVariable(): no frame has symbolspace %s",
+                       symbolSpace->name().constData());
+}
+
+/**
+ * @brief Returns the reference of a variable which will be changed.
+ *
+ * A part of a parallel loop may only change its own variables: the outer
+ * variables are shared with the other parts and therefore read-only. This
+ * is true for the shared variables in the copied frame too.
+ *
+ * @param symbolSpace   the symbol space
+ * @param variableNo    the current number in the symbol space
+ * @return              the value of the variable
+ */
+ReASVariant& ReVMThread::writableVariable(ReSymbolSpace* symbolSpace,
+      int variableNo) {
+   if (m_parentThread != NULL) {
+      int ix = m_frameStack.size() - 1;
+      while (ix >= 0 && m_frameStack.at(ix).symbols() != symbolSpace)
+         ix--;
+      // frame 0 is the copied frame (see copyFrame()):
+      if (ix < 0 || (ix == 0 && (variableNo < 0
+                                 || variableNo >= m_privateVariables.size()
+                                 || !m_privateVariables.at(variableNo))))
+         throw ReVMException("parallel for: outer variable is read-only: "
+                             "%s[%d]", symbolSpace->name().constData(), variableNo);
+   }
+   return valueOfVariable(symbolSpace, variableNo);
 }
 /**
  * @brief Returns whether each execution step should be dumped.
@@ -318,21 +937,99 @@ ReVirtualMachine* ReVMThread::vm() const {
 /**
  * @brief Adds a frame to the frame stack.
  *
- * @param frame     frame to add
+ * The variables of the frame are the top <code>countArgs</code> entries of
+ * the value stack (the arguments of a call) and the following entries.
+ *
+ * @param caller            the node creating the frame (for debugging)
+ * @param symbols           the symbol space of the frame
+ * @param countVariables    the number of variables of the symbol space
+ * @param countArgs         the number of arguments on the value stack
  */
-void ReVMThread::pushFrame(ReStackFrame* frame) {
+void ReVMThread::pushFrame(ReASItem* caller, ReSymbolSpace* symbols,
+                           int countVariables, int countArgs) {
    if (m_frameStack.size() >= m_maxStack)
       throw ReASException(NULL, "too deep recursion: %d", m_maxStack);
-   m_frameStack.push_back(frame);
+   int base = m_topOfValues - countArgs + 1;
+   // reserveValue() resets the reused entries:
+   for (int ix = countArgs; ix < countVariables; ix++)
+      reserveValue();
+   m_frameStack.append(ReStackFrame(caller, symbols, base, countVariables));
 }
 
 /**
  * @brief Removes the top of the frames from the stack.
+ *
+ * The variables of the frame are removed from the value stack.
  */
 void ReVMThread::popFrame() {
-   if (m_frameStack.size() <= 0)
+   if (m_frameStack.size() <= 1)
       throw ReASException(NULL, "frame stack is empty");
-   m_frameStack.pop_back();
+   const ReStackFrame& frame = m_frameStack.last();
+   int base = frame.base();
+   // frees the objects (strings, lists...) of the local variables:
+   for (int ix = m_topOfValues; ix >= base; ix--)
+      m_valueStack[ix]->destroyValue();
+   m_topOfValues = base - 1;
+   m_frameStack.removeLast();
+}
+
+/**
+ * @brief Does the work of the thread.
+ *
+ * This method is called by <code>start()</code> in a new OS thread.
+ * An exception stops the thread: see <code>error()</code>.
+ */
+void ReVMThread::run() {
+   // the signal handler of the sampling profiler needs the profile:
+   ReVMProfile::setActive(m_profile);
+   try {
+      if (m_loop != NULL)
+         m_loop->executeRange(*this, m_loopStart, m_loopEnd, m_loopStep);
+      else {
+         if (m_initialization != NULL)
+            execute(dynamic_cast<ReASNode1*>(m_initialization),
+                    m_spaceInitialization);
+         if (m_statements != NULL)
+            execute(dynamic_cast<ReASNode1*>(m_statements), m_space);
+      }
+   } catch (ReException& exc) {
+      m_error = exc.getMessage();
+      m_logger->logv(LOG_ERROR, LOC_RUN_1, "thread %d: %s", m_id,
+                     m_error.constData());
+   }
+   ReVMProfile::setActive(NULL);
+}
+
+/**
+ * @brief Sets the work of the thread to a part of a counted loop.
+ *
+ * @param loop  the loop statement
+ * @param start the first value of the loop variable
+ * @param end   the last value of the loop variable
+ * @param step  the distance between two values of the loop variable
+ */
+void ReVMThread::setLoop(ReASForCounted* loop, int start, int end, int step) {
+   m_loop = loop;
+   m_loopStart = start;
+   m_loopEnd = end;
+   m_loopStep = step;
+}
+
+/**
+ * @brief Sets the work of the thread to a program.
+ *
+ * @param initialization        NULL or the statements for initialization
+ * @param spaceInitialization   the symbol space of the initialization
+ * @param statements            NULL or the statement list to execute
+ * @param space                 the symbol space of the statements
+ */
+void ReVMThread::setProgram(ReASItem* initialization,
+                            ReSymbolSpace* spaceInitialization, ReASItem* statements,
+                            ReSymbolSpace* space) {
+   m_initialization = initialization;
+   m_spaceInitialization = spaceInitialization;
+   m_statements = statements;
+   m_space = space;
 }
 
 /** @class ReVirtualMachine ReVM.hpp "expr/ReVM.hpp"
@@ -340,6 +1037,11 @@ void ReVMThread::popFrame() {
  * @brief Implements a virtual machine.
  *
  * This is an execution unit which interprets an abstract syntax tree.
+ *
+ * The threads of the machine run concurrently. They share the syntax tree,
+ * the class singletons (<code>ReASString::m_instance</code>...) and the trace
+ * writer: the tree must be complete (parsed and checked) before the first
+ * thread starts, the trace writer is protected by a mutex.
  */
 ReVirtualMachine::ReVirtualMachine(ReASTree& tree, ReSource& source,
                                    int maxStack) :
@@ -348,23 +1050,43 @@ ReVirtualMachine::ReVirtualMachine(ReASTree& tree, ReSource& source,
    m_flags(VF_UNDEF),
    m_source(source),
    m_tree(tree),
-   m_trace() {
+   m_trace(),
+   m_traceWriter(NULL),
+   m_parallelism(QThread::idealThreadCount()),
+   m_channels(),
+   m_channelMutex(),
+   m_traceMutex(),
+   m_profiler() {
    m_threads.reserve(8);
    m_trace.reserve(1024);
+   if (m_parallelism < 1)
+      m_parallelism = 1;
+}
+
+/**
+ * @brief Destructor.
+ */
+ReVirtualMachine::~ReVirtualMachine() {
+   for (int ix = 0; ix < m_threads.size(); ix++)
+      m_threads.at(ix)->wait();
+   qDeleteAll(m_threads);
+   m_threads.clear();
+   qDeleteAll(m_channels);
+   m_channels.clear();
 }
 
 /**
  * @brief Executes the program in a module.
  *
+ * The program runs in its own thread. The method returns when all threads
+ * of the machine are finished.
+ *
  * @param module    the module's name
  */
 void ReVirtualMachine::executeModule(const char* module) {
    ReSymbolSpace* space = m_tree.findmodule(module);
    if (space == NULL)
       throw ReVMException("module not found: %s", module);
-   //@ToDo:
-   //ReStackFrame frame(space);
-   throw ReNotImplementedException("ReVirtualMachine::executeModule");
    ReSymbolSpace* mainSpace = NULL;
    ReASItem* mainStatements = NULL;
    ReASMethod* method = space->findMethod("main");
@@ -373,10 +1095,14 @@ void ReVirtualMachine::executeModule(const char* module) {
       mainSpace = method->symbols();
    }
    addThread(space->body(), space, mainStatements, mainSpace);
+   waitForThreads();
 }
 
 /**
- * @brief Adds a thread to the instance.
+ * @brief Adds a thread to the instance and starts it.
+ *
+ * The thread runs concurrently to the caller: see
+ * <code>waitForThreads()</code>.
  *
  * @param initialization        the statements for initialization
  * @param spaceInitialization   the symbol space of the initialization
@@ -386,19 +1112,35 @@ void ReVirtualMachine::executeModule(const char* module) {
  *                              the symbol space of the main program
  * @param maxStack  the maximal number of nested stack frames.
  *                  <= 0: use the default
+ * @return          the started thread
  */
-void ReVirtualMachine::addThread(ReASItem* initialization,
-                                 ReSymbolSpace* spaceInitialization, ReASItem* statements,
-                                 ReSymbolSpace* space, int maxStack) {
+ReVMThread* ReVirtualMachine::addThread(ReASItem* initialization,
+                                        ReSymbolSpace* spaceInitialization, ReASItem* statements,
+                                        ReSymbolSpace* space, int maxStack) {
    ReVMThread* thread = new ReVMThread(maxStack <= 0 ? m_maxStack : maxStack,
                                        this);
    m_threads.append(thread);
-   if (initialization != NULL) {
-      thread->execute(dynamic_cast<ReASNode1*>(initialization),
-                      spaceInitialization);
+   thread->setProgram(initialization, spaceInitialization, statements, space);
+   thread->start();
+   return thread;
+}
+
+/**
+ * @brief Returns a channel given by name.
+ *
+ * The channel will be created if it does not exist.
+ *
+ * @param name  the name of the channel
+ * @return      the channel with the given name
+ */
+ReVMChannel* ReVirtualMachine::channel(const QByteArray& name) {
+   QMutexLocker locker(&m_channelMutex);
+   ReVMChannel* rc = m_channels.value(name, NULL);
+   if (rc == NULL) {
+      rc = new ReVMChannel();
+      m_channels.insert(name, rc);
    }
-   if (statements != NULL)
-      thread->execute(dynamic_cast<ReASNode1*>(statements), space);
+   return rc;
 }
 /**
  * @brief Tests whether a given flag is set.
@@ -431,6 +1173,101 @@ void ReVirtualMachine::clearFlag(ReVirtualMachine::VMFlag flag) {
    m_flags &= ~flag;
 }
 
+/**
+ * @brief Executes a counted loop in many threads.
+ *
+ * The range of the loop variable is split into contiguous parts, one part
+ * per thread. Each thread gets a copy of the frame containing the loop
+ * variable. Only the loop variable and the variables defined in the body
+ * are private, all other variables are shared with <code>thread</code>
+ * and read-only (see <code>ReVMThread::writableVariable()</code>). The caller waits until all
+ * parts are done.
+ *
+ * Note: "leave" stops only the part of the current thread.
+ *
+ * @param thread    the thread executing the loop statement
+ * @param loop      the loop statement
+ * @param start     the first value of the loop variable
+ * @param end       the last value of the loop variable
+ * @param step      the distance between two values of the loop variable
+ * @return          the result of the statement (see
+ *                  <code>ReASStatement::execute()</code>)
+ */
+int ReVirtualMachine::parallelFor(ReVMThread& thread, ReASForCounted* loop,
+                                  int start, int end, int step) {
+   int rc = 0;
+   int count = step <= 0 || end < start ? 0 : (end - start) / step + 1;
+   int countThreads = qMin(m_parallelism, count);
+   ReASNamedValue* var = dynamic_cast<ReASNamedValue*>(loop->child3());
+   if (countThreads <= 1 || var == NULL)
+      rc = loop->executeRange(thread, start, end, step);
+   else {
+      int countPerThread = (count + countThreads - 1) / countThreads;
+      QVector<bool> isPrivate;
+      loop->privateVariables(isPrivate);
+      QList<ReVMThread*> parts;
+      for (int ix = 0; ix < countThreads; ix++) {
+         int first = start + ix * countPerThread * step;
+         if (first > end)
+            break;
+         int last = qMin(end, first + (countPerThread - 1) * step);
+         ReVMThread* part = new ReVMThread(m_maxStack, this, &thread);
+         part->copyFrame(thread, var->symbolSpace(), isPrivate);
+         part->setLoop(loop, first, last, step);
+         parts.append(part);
+      }
+      for (int ix = 0; ix < parts.size(); ix++)
+         parts.at(ix)->start();
+      QByteArray error;
+      for (int ix = 0; ix < parts.size(); ix++) {
+         ReVMThread* part = parts.at(ix);
+         part->wait();
+         if (error.isEmpty())
+            error = part->error();
+      }
+      qDeleteAll(parts);
+      if (!error.isEmpty())
+         throw ReVMException("parallel for: %s", error.constData());
+   }
+   return rc;
+}
+
+/**
+ * @brief Sets the maximal number of threads of a parallel for loop.
+ *
+ * @param parallelism   the number of threads. < 1: 1
+ */
+void ReVirtualMachine::setParallelism(int parallelism) {
+   m_parallelism = parallelism < 1 ? 1 : parallelism;
+}
+
+/**
+ * @brief Returns the profiler.
+ *
+ * @return  the profiler of the machine
+ */
+ReVMProfiler& ReVirtualMachine::profiler() {
+   return m_profiler;
+}
+
+/**
+ * @brief Writes a formatted message to the trace writer.
+ *
+ * Thread safe: the threads of the machine share the trace writer.
+ *
+ * @param format    the message with placeholders (like <code>printf</code>)
+ * @param ...       the values of the placeholders
+ */
+void ReVirtualMachine::trace(const char* format, ...) {
+   QMutexLocker locker(&m_traceMutex);
+   if (m_traceWriter != NULL) {
+      va_list ap;
+      va_start(ap, format);
+      m_traceWriter->write(ap, format);
+      va_end(ap);
+   }
+}
+
 /**
  * @brief Returns the trace writer.
  * @return  the trace writer
@@ -456,3 +1293,733 @@ ReASTree& ReVirtualMachine::tree() const {
    return m_tree;
 }
 
+/**
+ * @brief Waits until all threads of the machine are finished.
+ *
+ * The finished threads are removed.
+ *
+ * @throws ReVMException    a thread has been stopped by an error
+ */
+void ReVirtualMachine::waitForThreads() {
+   QByteArray error;
+   for (int ix = 0; ix < m_threads.size(); ix++) {
+      ReVMThread* thread = m_threads.at(ix);
+      thread->wait();
+      if (error.isEmpty())
+         error = thread->error();
+   }
+   qDeleteAll(m_threads);
+   m_threads.clear();
+   if (!error.isEmpty())
+      throw ReVMException("%s", error.constData());
+}
+
+
+/** @class ReVMBatch ReVM.hpp "expr/ReVM.hpp"
+ *
+ * @brief Evaluates an expression over columns instead of single values.
+ *
+ * Usage:
+ * <pre>
+ * ReVMBatch batch;
+ * batch.bindFloat("price", prices);
+ * batch.bindInt("count", counts);
+ * if (batch.compile("price * count > 100.0"))
+ *    hits = batch.select(rows, mask);
+ * </pre>
+ */
+
+/**
+ * @brief Calculates an arithmetic operator for a block.
+ *
+ * @param op        the operator: BOP_PLUS, BOP_MINUS or BOP_TIMES
+ * @param rows      the number of rows
+ * @param target    OUT: the results
+ * @param op1       the left operands
+ * @param op2       the right operands
+ */
+template<class T>
+static void arithmeticKernel(ReASBinaryOp::BinOperator op, int rows,
+                             T* target, const T* op1, const T* op2) {
+   switch (op) {
+   case ReASBinaryOp::BOP_PLUS:
+      for (int ix = 0; ix < rows; ix++)
+         target[ix] = op1[ix] + op2[ix];
+      break;
+   case ReASBinaryOp::BOP_MINUS:
+      for (int ix = 0; ix < rows; ix++)
+         target[ix] = op1[ix] - op2[ix];
+      break;
+   case ReASBinaryOp::BOP_TIMES:
+      for (int ix = 0; ix < rows; ix++)
+         target[ix] = op1[ix] * op2[ix];
+      break;
+   default:
+      break;
+   }
+}
+
+/**
+ * @brief Calculates a comparison for a block.
+ *
+ * @param op        the operator: BOP_EQ ... BOP_GT
+ * @param rows      the number of rows
+ * @param target    OUT: the results: 0 or 1
+ * @param op1       the left operands
+ * @param op2       the right operands
+ */
+template<class T>
+static void compareKernel(ReASBinaryOp::BinOperator op, int rows,
+                          qint64* target, const T* op1, const T* op2) {
+   switch (op) {
+   case ReASBinaryOp::BOP_EQ:
+      for (int ix = 0; ix < rows; ix++)
+         target[ix] = op1[ix] == op2[ix];
+      break;
+   case ReASBinaryOp::BOP_NE:
+      for (int ix = 0; ix < rows; ix++)
+         target[ix] = op1[ix] != op2[ix];
+      break;
+   case ReASBinaryOp::BOP_LE:
+      for (int ix = 0; ix < rows; ix++)
+         target[ix] = op1[ix] <= op2[ix];
+      break;
+   case ReASBinaryOp::BOP_LT:
+      for (int ix = 0; ix < rows; ix++)
+         target[ix] = op1[ix] < op2[ix];
+      break;
+   case ReASBinaryOp::BOP_GE:
+      for (int ix = 0; ix < rows; ix++)
+         target[ix] = op1[ix] >= op2[ix];
+      break;
+   case ReASBinaryOp::BOP_GT:
+      for (int ix = 0; ix < rows; ix++)
+         target[ix] = op1[ix] > op2[ix];
+      break;
+   default:
+      break;
+   }
+}
+
+/// the right operand of the string comparisons
+static const qint64 s_zeros[ReVMBatch::BLOCK_SIZE] = { 0 };
+
+/**
+ * @brief Compares two strings like <code>strcmp()</code>.
+ *
+ * @param string1   the first string
+ * @param string2   the second string
+ * @return          &lt; 0: string1 &lt; string2<br>
+ *                  0: the strings are equal<br>
+ *                  &gt; 0: string1 &gt; string2
+ */
+static int compareStrings(const ReVMBatch::StringView& string1,
+                          const ReVMBatch::StringView& string2) {
+   int length = qMin(string1.m_length, string2.m_length);
+   int rc = memcmp(string1.m_data, string2.m_data, length);
+   if (rc == 0)
+      rc = string1.m_length - string2.m_length;
+   return rc;
+}
+
+/**
+ * @brief Constructor.
+ */
+ReVMBatch::ReVMBatch() :
+   m_columns(),
+   m_columnNames(),
+   m_registers(),
+   m_program(),
+   m_result(-1),
+   m_messages() {
+}
+
+/**
+ * @brief Adds an instruction to the program.
+ *
+ * @param opcode        the kind of the kernel
+ * @param type          the type of the operands
+ * @param resultType    the type of the result
+ * @param source1       the register of the (first) operand
+ * @param source2       -1 or the register of the second operand
+ * @param op            only for OP_BINARY: the operator
+ * @return              the register of the result
+ */
+int ReVMBatch::addInstruction(Opcode opcode, ColumnType type,
+                              ColumnType resultType, int source1, int source2,
+                              ReASBinaryOp::BinOperator op) {
+   Instruction instruction;
+   instruction.m_opcode = opcode;
+   instruction.m_operator = op;
+   instruction.m_type = type;
+   instruction.m_target = addRegister(resultType);
+   instruction.m_source1 = source1;
+   instruction.m_source2 = source2;
+   m_program.append(instruction);
+   return instruction.m_target;
+}
+
+/**
+ * @brief Adds a register for a constant or a temporary block.
+ *
+ * @param type  the type of the values
+ * @return      the index of the new register
+ */
+int ReVMBatch::addRegister(ColumnType type) {
+   Register reg;
+   reg.m_type = type;
+   reg.m_column = -1;
+   switch (type) {
+   case CT_INT:
+   case CT_BOOL:
+      reg.m_ints.resize(BLOCK_SIZE);
+      break;
+   case CT_FLOAT:
+      reg.m_floats.resize(BLOCK_SIZE);
+      break;
+   case CT_STRING:
+      reg.m_strings.resize(BLOCK_SIZE);
+      break;
+   default:
+      break;
+   }
+   m_registers.append(reg);
+   return m_registers.size() - 1;
+}
+
+/**
+ * @brief Binds a variable name to a column.
+ *
+ * A column may be bound again (e.g. the next chunk of data) without a new
+ * compilation as long as the type is the same.
+ *
+ * @param name      the name of the variable in the expression
+ * @param type      the type of the values
+ * @param column    the values: must live until the evaluation
+ */
+void ReVMBatch::bind(const char* name, ColumnType type, const void* column) {
+   QMap<QByteArray, int>::const_iterator it = m_columnNames.constFind(name);
+   if (it == m_columnNames.constEnd()) {
+      Column col;
+      col.m_type = type;
+      col.m_data = column;
+      m_columnNames.insert(name, m_columns.size());
+      m_columns.append(col);
+   } else {
+      Column& col = m_columns[it.value()];
+      // the program depends on the type:
+      if (col.m_type != type)
+         m_result = -1;
+      col.m_type = type;
+      col.m_data = column;
+   }
+}
+
+/**
+ * @brief Binds a variable name to a column of floats.
+ *
+ * @param name      the name of the variable in the expression
+ * @param column    the values: must live until the evaluation
+ */
+void ReVMBatch::bindFloat(const char* name, const double* column) {
+   bind(name, CT_FLOAT, column);
+}
+
+/**
+ * @brief Binds a variable name to a column of integers.
+ *
+ * @param name      the name of the variable in the expression
+ * @param column    the values: must live until the evaluation
+ */
+void ReVMBatch::bindInt(const char* name, const qint64* column) {
+   bind(name, CT_INT, column);
+}
+
+/**
+ * @brief Binds a variable name to a column of strings.
+ *
+ * @param name      the name of the variable in the expression
+ * @param column    the values: must live until the evaluation
+ */
+void ReVMBatch::bindString(const char* name, const StringView* column) {
+   bind(name, CT_STRING, column);
+}
+
+/**
+ * @brief Translates an expression into a program of kernels.
+ *
+ * The variables of the expression must be bound before.
+ *
+ * @param expression    the expression in MF syntax, e.g. "a * 2 < b"
+ * @return              <code>true</code>: success<br>
+ *                      <code>false</code>: error: see <code>messages()</code>
+ */
+bool ReVMBatch::compile(const char* expression) {
+   m_registers.clear();
+   m_program.clear();
+   m_messages.clear();
+   m_result = -1;
+   ReSource source;
+   ReStringReader reader(source);
+   reader.addSource("<batch>", expression);
+   source.addReader(&reader);
+   source.addSourceUnit(reader.currentSourceUnit());
+   ReASTree tree;
+   ReMFParser parser(source, tree);
+   ReASItem* body = NULL;
+   bool ok = true;
+   try {
+      body = parser.parseModule("<batch>");
+   } catch (ReSyntaxError exc) {
+      ok = false;
+   } catch (ReException exc) {
+      m_messages.append(exc.getMessage());
+      ok = false;
+   }
+   m_messages += parser.messages();
+   if (ok && parser.errors() == 0) {
+      ReASExprStatement* statement = dynamic_cast<ReASExprStatement*>(body);
+      if (statement == NULL || statement->child() != NULL
+            || statement->child2() == NULL)
+         error("exactly one expression expected");
+      else
+         m_result = compileNode(statement->child2());
+   }
+   delete body;
+   return m_result >= 0;
+}
+
+/**
+ * @brief Translates a binary operation.
+ *
+ * @param node  the operation
+ * @return      -1: error<br>
+ *              otherwise: the register of the result
+ */
+int ReVMBatch::compileBinary(ReASBinaryOp* node) {
+   int rc = -1;
+   ReASBinaryOp::BinOperator op = node->getOperator();
+   int source1 = compileNode(node->child());
+   int source2 = source1 < 0 ? -1 : compileNode(node->child2());
+   if (source2 >= 0) {
+      ColumnType type1 = m_registers.at(source1).m_type;
+      ColumnType type2 = m_registers.at(source2).m_type;
+      bool numeric = (type1 == CT_INT || type1 == CT_FLOAT)
+                     && (type2 == CT_INT || type2 == CT_FLOAT);
+      if (numeric && type1 != type2) {
+         // mixed operands are calculated as floats:
+         if (type1 == CT_INT)
+            source1 = toFloat(source1);
+         else
+            source2 = toFloat(source2);
+         type1 = type2 = CT_FLOAT;
+      }
+      switch (op) {
+      case ReASBinaryOp::BOP_PLUS:
+      case ReASBinaryOp::BOP_MINUS:
+      case ReASBinaryOp::BOP_TIMES:
+      case ReASBinaryOp::BOP_DIV:
+      case ReASBinaryOp::BOP_MOD:
+         if (!numeric)
+            rc = error("numeric operands expected");
+         else
+            rc = addInstruction(OP_BINARY, type1, type1, source1, source2, op);
+         break;
+      case ReASBinaryOp::BOP_EQ:
+      case ReASBinaryOp::BOP_NE:
+      case ReASBinaryOp::BOP_LE:
+      case ReASBinaryOp::BOP_LT:
+      case ReASBinaryOp::BOP_GE:
+      case ReASBinaryOp::BOP_GT:
+         if (!numeric && type1 != type2)
+            rc = error("operands of a comparison must have the same type");
+         else
+            rc = addInstruction(OP_BINARY, type1, CT_BOOL, source1, source2, op);
+         break;
+      case ReASBinaryOp::BOP_LOG_AND:
+      case ReASBinaryOp::BOP_LOG_OR:
+         if (type1 != CT_BOOL || type2 != CT_BOOL)
+            rc = error("boolean operands expected");
+         else
+            rc = addInstruction(OP_BINARY, CT_BOOL, CT_BOOL, source1, source2,
+                                op);
+         break;
+      default:
+         rc = error("operator not supported: %d", op);
+         break;
+      }
+   }
+   return rc;
+}
+
+/**
+ * @brief Translates a node of the syntax tree.
+ *
+ * @param node  the node to translate
+ * @return      -1: error<br>
+ *              otherwise: the register of the result
+ */
+int ReVMBatch::compileNode(ReASItem* node) {
+   int rc = -1;
+   switch (node == NULL ? AST_UNDEF : node->nodeType()) {
+   case AST_CONSTANT: {
+      ReASVariant& value = dynamic_cast<ReASConstant*>(node)->value();
+      switch (value.variantType()) {
+      case ReASVariant::VT_INTEGER:
+         rc = addRegister(CT_INT);
+         m_registers[rc].m_ints.fill(value.asInt());
+         break;
+      case ReASVariant::VT_FLOAT:
+         rc = addRegister(CT_FLOAT);
+         m_registers[rc].m_floats.fill(value.asFloat());
+         break;
+      case ReASVariant::VT_BOOL:
+         rc = addRegister(CT_BOOL);
+         m_registers[rc].m_ints.fill(value.asBool() ? 1 : 0);
+         break;
+      default:
+         // asString() throws for other classes:
+         if (value.variantType() != ReASVariant::VT_OBJECT
+               || value.getClass() != ReASString::m_instance)
+            rc = error("constant not supported: %s", value.nameOfType());
+         else {
+            rc = addRegister(CT_STRING);
+            Register& reg = m_registers[rc];
+            reg.m_text = *value.asString();
+            StringView view;
+            view.m_data = reg.m_text.constData();
+            view.m_length = reg.m_text.length();
+            reg.m_strings.fill(view);
+         }
+         break;
+      }
+      break;
+   }
+   case AST_NAMED_VALUE: {
+      const QByteArray& name = dynamic_cast<ReASNamedValue*>(node)->name();
+      QMap<QByteArray, int>::const_iterator it = m_columnNames.constFind(name);
+      if (it == m_columnNames.constEnd())
+         rc = error("unbound variable: %s", name.constData());
+      else {
+         Register reg;
+         reg.m_type = m_columns.at(it.value()).m_type;
+         reg.m_column = it.value();
+         m_registers.append(reg);
+         rc = m_registers.size() - 1;
+      }
+      break;
+   }
+   case AST_PRE_UNARY_OP: {
+      ReASUnaryOp* unary = dynamic_cast<ReASUnaryOp*>(node);
+      int source = compileNode(unary->child());
+      ColumnType type = source < 0 ? CT_UNDEF : m_registers.at(source).m_type;
+      switch (source < 0 ? ReASUnaryOp::UOP_UNDEF : unary->getOperator()) {
+      case ReASUnaryOp::UOP_UNDEF:
+         break;
+      case ReASUnaryOp::UOP_PLUS:
+         rc = source;
+         break;
+      case ReASUnaryOp::UOP_MINUS_INT:
+      case ReASUnaryOp::UOP_MINUS_FLOAT:
+         if (type != CT_INT && type != CT_FLOAT)
+            rc = error("numeric operand expected");
+         else
+            rc = addInstruction(OP_NEGATE, type, type, source);
+         break;
+      case ReASUnaryOp::UOP_NOT_BOOL:
+         if (type != CT_BOOL)
+            rc = error("boolean operand expected");
+         else
+            rc = addInstruction(OP_NOT, type, type, source);
+         break;
+      default:
+         rc = error("unary operator not supported: %d", unary->getOperator());
+         break;
+      }
+      break;
+   }
+   case AST_BINARY_OP:
+      rc = compileBinary(dynamic_cast<ReASBinaryOp*>(node));
+      break;
+   default:
+      rc = error("not supported in batch mode: %s",
+                 node == NULL ? "<null>" : node->nameOfItemType());
+      break;
+   }
+   return rc;
+}
+
+/**
+ * @brief Stores an error message.
+ *
+ * @param format    the message with placeholders
+ * @param ...       the values for the placeholders
+ * @return          -1 (for chaining)
+ */
+int ReVMBatch::error(const char* format, ...) {
+   char buffer[1024];
+   va_list ap;
+   va_start(ap, format);
+   qvsnprintf(buffer, sizeof buffer, format, ap);
+   va_end(ap);
+   m_messages.append(buffer);
+   return -1;
+}
+
+/**
+ * @brief Evaluates the expression and stores the results as floats.
+ *
+ * @param rows      the number of rows of the bound columns
+ * @param result    OUT: the results: an array with at least <code>rows</code>
+ *                  elements
+ */
+void ReVMBatch::evaluate(int rows, double* result) {
+   ColumnType type = resultType();
+   if (type != CT_FLOAT && type != CT_INT)
+      throw ReVMException("evaluate(): no numeric result: %d", type);
+   for (int offset = 0; offset < rows; offset += BLOCK_SIZE) {
+      int count = qMin((int) BLOCK_SIZE, rows - offset);
+      run(offset, count);
+      if (type == CT_FLOAT)
+         memcpy(result + offset, floats(m_result, offset), count * sizeof *result);
+      else {
+         const qint64* values = ints(m_result, offset);
+         for (int ix = 0; ix < count; ix++)
+            result[offset + ix] = double(values[ix]);
+      }
+   }
+}
+
+/**
+ * @brief Evaluates the expression and stores the results as integers.
+ *
+ * @param rows      the number of rows of the bound columns
+ * @param result    OUT: the results: an array with at least <code>rows</code>
+ *                  elements
+ */
+void ReVMBatch::evaluate(int rows, qint64* result) {
+   ColumnType type = resultType();
+   if (type != CT_INT && type != CT_BOOL)
+      throw ReVMException("evaluate(): no integer result: %d", type);
+   for (int offset = 0; offset < rows; offset += BLOCK_SIZE) {
+      int count = qMin((int) BLOCK_SIZE, rows - offset);
+      run(offset, count);
+      memcpy(result + offset, ints(m_result, offset), count * sizeof *result);
+   }
+}
+
+/**
+ * @brief Calls the kernel of one instruction.
+ *
+ * @param instruction   the instruction to execute
+ * @param offset        the index of the first row of the block
+ * @param rows          the number of rows of the block
+ */
+void ReVMBatch::execute(const Instruction& instruction, int offset,
+                        int rows) {
+   Register& target = m_registers[instruction.m_target];
+   int source1 = instruction.m_source1;
+   int source2 = instruction.m_source2;
+   switch (instruction.m_opcode) {
+   case OP_TO_FLOAT: {
+      const qint64* values = ints(source1, offset);
+      double* result = target.m_floats.data();
+      for (int ix = 0; ix < rows; ix++)
+         result[ix] = double(values[ix]);
+      break;
+   }
+   case OP_NEGATE:
+      if (instruction.m_type == CT_INT) {
+         const qint64* values = ints(source1, offset);
+         qint64* result = target.m_ints.data();
+         for (int ix = 0; ix < rows; ix++)
+            result[ix] = -values[ix];
+      } else {
+         const double* values = floats(source1, offset);
+         double* result = target.m_floats.data();
+         for (int ix = 0; ix < rows; ix++)
+            result[ix] = -values[ix];
+      }
+      break;
+   case OP_NOT: {
+      const qint64* values = ints(source1, offset);
+      qint64* result = target.m_ints.data();
+      for (int ix = 0; ix < rows; ix++)
+         result[ix] = values[ix] ^ 1;
+      break;
+   }
+   case OP_BINARY: {
+      ReASBinaryOp::BinOperator op = instruction.m_operator;
+      bool compare = op >= ReASBinaryOp::BOP_EQ && op <= ReASBinaryOp::BOP_GT;
+      switch (instruction.m_type) {
+      case CT_INT:
+      case CT_BOOL: {
+         const qint64* op1 = ints(source1, offset);
+         const qint64* op2 = ints(source2, offset);
+         qint64* result = target.m_ints.data();
+         if (compare)
+            compareKernel(op, rows, result, op1, op2);
+         else if (op == ReASBinaryOp::BOP_LOG_AND) {
+            for (int ix = 0; ix < rows; ix++)
+               result[ix] = op1[ix] & op2[ix];
+         } else if (op == ReASBinaryOp::BOP_LOG_OR) {
+            for (int ix = 0; ix < rows; ix++)
+               result[ix] = op1[ix] | op2[ix];
+         } else if (op == ReASBinaryOp::BOP_DIV) {
+            // a division by 0 results in 0: one row must not stop the batch.
+            // INT64_MIN / -1 overflows (a trap on x86): the negation wraps
+            for (int ix = 0; ix < rows; ix++)
+               result[ix] = op2[ix] == 0 ? 0
+                            : op2[ix] == -1 ? qint64(0ULL - quint64(op1[ix]))
+                            : op1[ix] / op2[ix];
+         } else if (op == ReASBinaryOp::BOP_MOD) {
+            for (int ix = 0; ix < rows; ix++)
+               result[ix] = op2[ix] == 0 || op2[ix] == -1 ? 0
+                            : op1[ix] % op2[ix];
+         } else
+            arithmeticKernel(op, rows, result, op1, op2);
+         break;
+      }
+      case CT_FLOAT: {
+         const double* op1 = floats(source1, offset);
+         const double* op2 = floats(source2, offset);
+         if (compare)
+            compareKernel(op, rows, target.m_ints.data(), op1, op2);
+         else {
+            double* result = target.m_floats.data();
+            if (op == ReASBinaryOp::BOP_DIV) {
+               for (int ix = 0; ix < rows; ix++)
+                  result[ix] = op1[ix] / op2[ix];
+            } else if (op == ReASBinaryOp::BOP_MOD) {
+               for (int ix = 0; ix < rows; ix++)
+                  result[ix] = fmod(op1[ix], op2[ix]);
+            } else
+               arithmeticKernel(op, rows, result, op1, op2);
+         }
+         break;
+      }
+      case CT_STRING: {
+         const StringView* op1 = strings(source1, offset);
+         const StringView* op2 = strings(source2, offset);
+         qint64* result = target.m_ints.data();
+         for (int ix = 0; ix < rows; ix++)
+            result[ix] = compareStrings(op1[ix], op2[ix]);
+         // "a < b" has the same result as "strcmp(a, b) < 0":
+         compareKernel(op, rows, result, result, s_zeros);
+         break;
+      }
+      default:
+         break;
+      }
+      break;
+   }
+   default:
+      break;
+   }
+}
+
+/**
+ * @brief Returns the values of a register as floats.
+ *
+ * @param reg       the index of the register
+ * @param offset    the index of the first row of the block
+ * @return          the values of the block
+ */
+const double* ReVMBatch::floats(int reg, int offset) {
+   const Register& current = m_registers.at(reg);
+   return current.m_column >= 0
+          ? (const double*) m_columns.at(current.m_column).m_data + offset
+          : current.m_floats.constData();
+}
+
+/**
+ * @brief Returns the values of a register as integers.
+ *
+ * @param reg       the index of the register
+ * @param offset    the index of the first row of the block
+ * @return          the values of the block
+ */
+const qint64* ReVMBatch::ints(int reg, int offset) {
+   const Register& current = m_registers.at(reg);
+   return current.m_column >= 0
+          ? (const qint64*) m_columns.at(current.m_column).m_data + offset
+          : current.m_ints.constData();
+}
+
+/**
+ * @brief Returns the error messages of the last compilation.
+ *
+ * @return  the messages
+ */
+const QList<QByteArray>& ReVMBatch::messages() const {
+   return m_messages;
+}
+
+/**
+ * @brief Returns the type of the result of the compiled expression.
+ *
+ * @return  CT_UNDEF: not compiled<br>
+ *          otherwise: the type of the result
+ */
+ReVMBatch::ColumnType ReVMBatch::resultType() const {
+   return m_result < 0 ? CT_UNDEF : m_registers.at(m_result).m_type;
+}
+
+/**
+ * @brief Executes the program for one block.
+ *
+ * @param offset    the index of the first row of the block
+ * @param rows      the number of rows of the block
+ */
+void ReVMBatch::run(int offset, int rows) {
+   for (int ix = 0; ix < m_program.size(); ix++)
+      execute(m_program.at(ix), offset, rows);
+}
+
+/**
+ * @brief Evaluates a boolean expression into a selection mask.
+ *
+ * @param rows  the number of rows of the bound columns
+ * @param mask  OUT: <code>true</code>: the row fulfills the expression.
+ *              An array with at least <code>rows</code> elements
+ * @return      the number of selected rows
+ */
+int ReVMBatch::select(int rows, bool* mask) {
+   if (resultType() != CT_BOOL)
+      throw ReVMException("select(): no boolean result: %d", resultType());
+   int rc = 0;
+   for (int offset = 0; offset < rows; offset += BLOCK_SIZE) {
+      int count = qMin((int) BLOCK_SIZE, rows - offset);
+      run(offset, count);
+      const qint64* values = ints(m_result, offset);
+      for (int ix = 0; ix < count; ix++) {
+         mask[offset + ix] = values[ix] != 0;
+         rc += int(values[ix]);
+      }
+   }
+   return rc;
+}
+
+/**
+ * @brief Returns the values of a register as strings.
+ *
+ * @param reg       the index of the register
+ * @param offset    the index of the first row of the block
+ * @return          the values of the block
+ */
+const ReVMBatch::StringView* ReVMBatch::strings(int reg, int offset) {
+   const Register& current = m_registers.at(reg);
+   return current.m_column >= 0
+          ? (const StringView*) m_columns.at(current.m_column).m_data + offset
+          : current.m_strings.constData();
+}
+
+/**
+ * @brief Converts an integer register into a float register.
+ *
+ * @param reg   the index of the integer register
+ * @return      the index of the float register
+ */
+int ReVMBatch::toFloat(int reg) {
+   return addInstruction(OP_TO_FLOAT, CT_INT, CT_FLOAT, reg);
+}
@@ -18,32 +18,202 @@ public:
 };
 class ReStackFrame {
 public:
-   ReStackFrame(ReASItem* caller, ReSymbolSpace* symbols);
-   ~ReStackFrame();
+   ReStackFrame();
+   ReStackFrame(ReASItem* caller, ReSymbolSpace* symbols, int base,
+                int countVariables);
 public:
-   ReASVariant& valueOfVariable(int index);
+   /** Returns the index of the first variable in the value stack.
+    * @return  the start of the frame window
+    */
+   inline int base() const {
+      return m_base;
+   }
+   ReASItem* caller() const;
+   /** Returns the number of variables of the frame.
+    * @return  the size of the frame window
+    */
+   inline int countVariables() const {
+      return m_countVariables;
+   }
    ReSymbolSpace* symbols() const;
 
 private:
+   // the variables are stored in the value stack of the thread:
+   int m_base;
    int m_countVariables;
-   ReASVariant* m_variables;
    ReSymbolSpace* m_symbols;
    ReASItem* m_caller;
 };
 
+/**
+ * A synchronized queue of values: the communication between VM threads.
+ */
+class ReVMChannel {
+public:
+   ReVMChannel(int capacity = 1024);
+public:
+   void close();
+   void put(const ReASVariant& value);
+   bool take(ReASVariant& value);
+private:
+   int m_capacity;
+   bool m_closed;
+   QQueue<ReASVariant> m_values;
+   QMutex m_mutex;
+   QWaitCondition m_notEmpty;
+   QWaitCondition m_notFull;
+};
+
+/**
+ * The execution profile of one VM thread.
+ *
+ * Only the owning thread (and its signal handler) writes into the profile.
+ */
+class ReVMProfile {
+public:
+   /// the statistic of one node of the syntax tree
+   class Entry {
+   public:
+      Entry() :
+         m_count(0),
+         m_ticks(0),
+         m_samples(0) {
+      }
+   public:
+      qint64 m_count;
+      /// nanoseconds spent in the node (inclusive the nested nodes)
+      qint64 m_ticks;
+      qint64 m_samples;
+   };
+   /// a node of the call tree: one instance for each call stack
+   class CallNode {
+   public:
+      QByteArray m_name;
+      /// index of the caller in m_nodes. -1: root
+      int m_parent;
+      qint64 m_count;
+      /// nanoseconds spent in the method (inclusive the called methods)
+      qint64 m_ticks;
+      qint64 m_samples;
+      QMap<QByteArray, int> m_children;
+   };
+   /// the state saved by <code>enter()</code> and restored by <code>leave()</code>
+   class Mark {
+   public:
+      const ReASItem* m_outer;
+      int m_outerNode;
+      qint64 m_start;
+   };
+   typedef QHash<const ReASItem*, Entry> EntryMap;
+public:
+   ReVMProfile(bool sampling, int maxSamples = 0x10000);
+   ~ReVMProfile();
+private:
+   /// forbid usage of the copy constructor!
+   ReVMProfile(const ReVMProfile& source);
+   /// forbid usage of the the assignment!
+   ReVMProfile& operator=(const ReVMProfile& source);
+public:
+   const QVector<CallNode>& callNodes() const;
+   /** Marks the start of the execution of a node.
+    * @param item  the node to execute
+    * @param mark  OUT: the state to restore by <code>leave()</code>
+    */
+   inline void enter(const ReASItem* item, Mark& mark) {
+      mark.m_outer = m_current;
+      m_current = item;
+      mark.m_start = m_sampling ? 0 : m_clock.nsecsElapsed();
+   }
+   void enterCall(const QByteArray& name, Mark& mark);
+   const EntryMap& entries() const;
+   void evaluateSamples();
+   /** Marks the end of the execution of a node.
+    * @param mark  the state stored by <code>enter()</code>
+    */
+   inline void leave(const Mark& mark) {
+      if (!m_sampling) {
+         const ReASItem* item = m_current;
+         Entry& entry = m_entries[item];
+         entry.m_count++;
+         entry.m_ticks += m_clock.nsecsElapsed() - mark.m_start;
+      }
+      m_current = mark.m_outer;
+   }
+   void leaveCall(const Mark& mark);
+   void sample();
+public:
+   static ReVMProfile* active();
+   static void setActive(ReVMProfile* profile);
+private:
+   bool m_sampling;
+   QElapsedTimer m_clock;
+   EntryMap m_entries;
+   QVector<CallNode> m_nodes;
+   // the state seen by the sampling signal handler:
+   const ReASItem* volatile m_current;
+   volatile int m_currentNode;
+   // the sample buffer: allocated before the first signal
+   const ReASItem** m_sampleItems;
+   int* m_sampleNodes;
+   int m_maxSamples;
+   volatile int m_countSamples;
+};
+
+/**
+ * Collects the execution profiles of the threads of a virtual machine.
+ */
+class ReVMProfiler {
+public:
+   enum Mode {
+      PM_OFF,
+      /// counts each execution of a statement and measures its time
+      PM_COUNT,
+      /// finds the running statement with a timer signal
+      PM_SAMPLE
+   };
+public:
+   ReVMProfiler();
+   ~ReVMProfiler();
+public:
+   void clear();
+   ReVMProfile* createProfile();
+   /** Returns the mode of the current (or last) profiling.
+    * @return  the mode
+    */
+   inline Mode mode() const {
+      return m_mode;
+   }
+   void start(Mode mode, int intervalMicroSec = 1000);
+   void stop();
+   void writeCollapsedStacks(ReWriter& writer);
+   void writeReport(ReWriter& writer, int maxLines = 50);
+private:
+   void evaluateSamples();
+private:
+   Mode m_mode;
+   QAtomicInt m_running;
+   QList<ReVMProfile*> m_profiles;
+   QMutex m_mutex;
+};
+
 class ReVirtualMachine;
-class ReVMThread {
+class ReASForCounted;
+class ReVMThread: public QThread {
    friend class ReASItem;
    friend class ReASStatement;
    friend class ReASCalculable;
    friend class ReASCondition;
 public:
-   typedef QList<ReStackFrame*> StackFrameList;
+   typedef QVector<ReStackFrame> StackFrameList;
 public:
-   ReVMThread(int maxStack, ReVirtualMachine* vm);
+   ReVMThread(int maxStack, ReVirtualMachine* vm, ReVMThread* parent = NULL);
+   ~ReVMThread();
 public:
+   void copyFrame(ReVMThread& source, ReSymbolSpace* symbols,
+                  const QVector<bool>& isPrivate);
    void execute(ReASNode1* statements, ReSymbolSpace* space);
    virtual void debug(ReASNode1* statement);
+   const QByteArray& error() const;
    ReWriter* errorWriter() const;
    void setErrorWriter(ReWriter* errorWriter);
    ReLogger* logger() const;
@@ -52,13 +222,27 @@ public:
    ReASVariant& top2OfValues();
    ReASVariant& popValue();
    void valueToTop(ReSymbolSpace* symbolSpace, int variableNo);
+   ReASVariant& lastValue();
    ReASVariant& lValue(ReASItem* item);
    ReASVariant& valueOfVariable(ReSymbolSpace* symbolSpace, int variableNo);
+   ReASVariant& writableVariable(ReSymbolSpace* symbolSpace, int variableNo);
    bool tracing() const;
    void setTracing(bool tracing);
    ReVirtualMachine* vm() const;
-   void pushFrame(ReStackFrame* frame);
+   void pushFrame(ReASItem* caller, ReSymbolSpace* symbols, int countVariables,
+                  int countArgs);
    void popFrame();
+   /** Returns the execution profile of the thread.
+    * @return  NULL: no profiling<br>
+    *          otherwise: the profile
+    */
+   inline ReVMProfile* profile() const {
+      return m_profile;
+   }
+   virtual void run();
+   void setLoop(ReASForCounted* loop, int start, int end, int step);
+   void setProgram(ReASItem* initialization, ReSymbolSpace* spaceInitialization,
+                   ReASItem* statements, ReSymbolSpace* space);
 
 protected:
    int m_id;
@@ -67,13 +251,31 @@ protected:
    bool m_tracing;
    int m_maxStack;
    StackFrameList m_frameStack;
-   int m_topOfFrames;
    QList<ReASVariant*> m_valueStack;
    int m_topOfValues;
+   /// the value of the last expression statement: the result of a method
+   ReASVariant m_lastValue;
    ReVirtualMachine* m_vm;
    ReLogger* m_logger;
+   /// NULL or the thread owning the variables not found in m_frameStack
+   ReVMThread* m_parentThread;
+   /// the writable variables of the copied frame (see copyFrame())
+   QVector<bool> m_privateVariables;
+   // the work done by run(): a program or a part of a parallel for loop
+   ReASItem* m_initialization;
+   ReSymbolSpace* m_spaceInitialization;
+   ReASItem* m_statements;
+   ReSymbolSpace* m_space;
+   ReASForCounted* m_loop;
+   int m_loopStart;
+   int m_loopEnd;
+   int m_loopStep;
+   /// the message of the exception stopping run(). Empty: success
+   QByteArray m_error;
+   /// NULL or the execution profile (owned by the profiler of the VM)
+   ReVMProfile* m_profile;
 private:
-   static int m_nextId;
+   static QAtomicInt m_nextId;
 };
 
 class ReVirtualMachine {
@@ -88,16 +290,31 @@ public:
    typedef QList<const char*> LineList;
 public:
    ReVirtualMachine(ReASTree& tree, ReSource& source, int maxStack = 1024);
+   ~ReVirtualMachine();
 public:
    void executeModule(const char* module);
-   void addThread(ReASItem* initialization, ReSymbolSpace* spaceInitialization,
-                  ReASItem* statements, ReSymbolSpace* space, int maxStack = 0);
+   ReVMThread* addThread(ReASItem* initialization,
+                         ReSymbolSpace* spaceInitialization, ReASItem* statements,
+                         ReSymbolSpace* space, int maxStack = 0);
+   ReVMChannel* channel(const QByteArray& name);
    bool hasFlag(VMFlag flag) const;
    void setFlag(VMFlag flag);
    void clearFlag(VMFlag flag);
+   int parallelFor(ReVMThread& thread, ReASForCounted* loop, int start, int end,
+                   int step);
+   /** Returns the maximal number of threads of a parallel for loop.
+    * @return  the number of threads sharing a loop
+    */
+   inline int parallelism() const {
+      return m_parallelism;
+   }
+   void setParallelism(int parallelism);
+   ReVMProfiler& profiler();
+   void trace(const char* format, ...);
    ReWriter* traceWriter() const;
    void setTraceWriter(ReWriter* traceWriter);
    ReASTree& tree() const;
+   void waitForThreads();
 
 private:
    int m_maxStack;
@@ -107,6 +324,123 @@ private:
    ReASTree& m_tree;
    LineList m_trace;
    ReWriter* m_traceWriter;
+   /// the number of threads executing a parallel for loop
+   int m_parallelism;
+   QMap<QByteArray, ReVMChannel*> m_channels;
+   QMutex m_channelMutex;
+   /// the threads share the trace writer
+   QMutex m_traceMutex;
+   ReVMProfiler m_profiler;
+};
+
+/**
+ * Evaluates an expression over many rows at once ("column at a time").
+ *
+ * The expression is compiled once into a list of kernels. Its variables are
+ * bound to columns (arrays) of the caller. The rows are processed in blocks
+ * of <code>BLOCK_SIZE</code> rows: each kernel is a plain loop over a block
+ * which can be vectorized by the compiler.
+ *
+ * Supported: Int, Float and Str columns, constants of these types and Bool,
+ * the operators + - * / %, the comparisons, && || ! and the unary minus.
+ */
+class ReVMBatch {
+public:
+   enum {
+      BLOCK_SIZE = 1024
+   };
+   enum ColumnType {
+      CT_UNDEF,
+      /// qint64
+      CT_INT,
+      /// double
+      CT_FLOAT,
+      /// stored as qint64: 0 or 1
+      CT_BOOL,
+      /// StringView
+      CT_STRING
+   };
+   /// a string owned by the caller: not terminated by '\0'
+   class StringView {
+   public:
+      const char* m_data;
+      int m_length;
+   };
+private:
+   enum Opcode {
+      OP_UNDEF,
+      /// target = source1 op source2
+      OP_BINARY,
+      OP_NEGATE,
+      OP_NOT,
+      OP_TO_FLOAT
+   };
+   /// the array of a column bound by the caller
+   class Column {
+   public:
+      ColumnType m_type;
+      const void* m_data;
+   };
+   /// the values of one block: a bound column, a constant or a temporary
+   class Register {
+   public:
+      ColumnType m_type;
+      /// -1 or the index in m_columns
+      int m_column;
+      /// CT_INT, CT_BOOL
+      QVector<qint64> m_ints;
+      QVector<double> m_floats;
+      QVector<StringView> m_strings;
+      /// the content of a string constant
+      QByteArray m_text;
+   };
+   /// one kernel call of the program
+   class Instruction {
+   public:
+      Opcode m_opcode;
+      /// only OP_BINARY
+      ReASBinaryOp::BinOperator m_operator;
+      /// the type of the operands
+      ColumnType m_type;
+      int m_target;
+      int m_source1;
+      int m_source2;
+   };
+public:
+   ReVMBatch();
+public:
+   void bindFloat(const char* name, const double* column);
+   void bindInt(const char* name, const qint64* column);
+   void bindString(const char* name, const StringView* column);
+   bool compile(const char* expression);
+   void evaluate(int rows, double* result);
+   void evaluate(int rows, qint64* result);
+   const QList<QByteArray>& messages() const;
+   ColumnType resultType() const;
+   int select(int rows, bool* mask);
+private:
+   int addInstruction(Opcode opcode, ColumnType type, ColumnType resultType,
+                      int source1, int source2 = -1,
+                      ReASBinaryOp::BinOperator op = ReASBinaryOp::BOP_UNDEF);
+   int addRegister(ColumnType type);
+   void bind(const char* name, ColumnType type, const void* column);
+   int compileBinary(ReASBinaryOp* node);
+   int compileNode(ReASItem* node);
+   int error(const char* format, ...);
+   void execute(const Instruction& instruction, int offset, int rows);
+   const double* floats(int reg, int offset);
+   const qint64* ints(int reg, int offset);
+   void run(int offset, int rows);
+   const StringView* strings(int reg, int offset);
+   int toFloat(int reg);
+private:
+   QVector<Column> m_columns;
+   QMap<QByteArray, int> m_columnNames;
+   QVector<Register> m_registers;
+   QVector<Instruction> m_program;
+   /// the register containing the result. -1: not compiled
+   int m_result;
+   QList<QByteArray> m_messages;
 };
 
 #endif // ReVM_HPP
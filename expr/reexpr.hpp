@@ -19,6 +19,10 @@
 #include <QDir>
 #include <QtAlgorithms>
 #include <QVariant>
+#include <QQueue>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QWaitCondition>
 
 #include "expr/ReSource.hpp"
 #include "expr/ReLexer.hpp"
@@ -47,7 +47,31 @@ ReLook::ReLook() :
  */
 ReEditText::ReEditText(const QString& text, ReLook* look) :
    m_text(text),
-   m_look(look) {
+   m_look(look),
+   m_width(-1) {
+}
+
+/**
+ * Sets the text and the look of the instance.
+ *
+ * @param text  text of the part of paragraph
+ * @param look  the presentation of the text
+ */
+void ReEditText::set(const QString& text, ReLook* look) {
+   m_text = text;
+   m_look = look;
+   m_width = -1;
+}
+
+/**
+ * Sets the look of the instance.
+ *
+ * @param look  the new look
+ */
+void ReEditText::setLook(ReLook* look) {
+   if (m_look == NULL || look->m_metrics != m_look->m_metrics)
+      m_width = -1;
+   m_look = look;
 }
 
 /**
@@ -102,6 +126,7 @@ ReEdit::ReEdit(QWidget* parent) :
    m_insertMode(true),
    m_breakLines(false),
    m_widthLineNumbers(50),
+   m_widthDigit(0),
    m_widthVScrollBar(16),
    m_heightHScrollBar(16),
    m_looks(),
@@ -126,6 +151,7 @@ ReEdit::ReEdit(QWidget* parent) :
    m_standardFont->setStyleHint(QFont::TypeWriter);
    m_standardFont->setPixelSize(16);
    m_standardMetrics = new QFontMetrics(*m_standardFont);
+   m_widthDigit = m_standardMetrics->width('0');
    m_standardBrush->setColor(Qt::white);
    QColor color1(214, 210, 208);
    m_scrollbarBrush->setColor(color1);
@@ -556,7 +582,7 @@ void ReEdit::keyPressEvent(QKeyEvent* event) {
  */
 ReLines& ReEdit::lines() {
    if (m_lines == NULL)
-      m_lines = new ReLines();
+      setLines(new ReLines());
    return *m_lines;
 }
 
@@ -652,7 +678,6 @@ inline static double fraction(int a, int b, double exception) {
  * @param event     the trigger event
  */
 void ReEdit::paintEvent(QPaintEvent* event) {
-   clock_t start = clock();
    QRect rect = event->rect();
    m_widthEdit = rect.width();
    m_heightEdit = rect.height();
@@ -685,7 +710,8 @@ void ReEdit::paintEvent(QPaintEvent* event) {
          lineNo == m_cursorLineNo + 1 ?
          lookOf(ReLook::FG_CURRENT_LINE, ReLook::BG_CURRENT_LINE) :
          lookStd;
-      int width = look->m_metrics->width(number);
+      // all digits have the same width: no measurement needed
+      int width = number.length() * m_widthDigit;
       if (ix == 0)
          y = rect.top() + look->m_metrics->height()
              - look->m_metrics->descent();
@@ -712,8 +738,6 @@ void ReEdit::paintEvent(QPaintEvent* event) {
                   fraction(m_firstLine, maxLines, 0.0),
                   fraction(m_screenWidth, m_maxCols, 1.0),
                   fraction(m_firstCol, max(0, m_maxCols - m_screenWidth), 0.0));
-   ReLogger::globalLogger()->logv(LOG_INFO, 3, "draw: %.4f",
-                                  double(clock() - start) / CLOCKS_PER_SEC);
 }
 
 /**
@@ -783,7 +807,13 @@ ReParagraphs::ReParagraphs() :
    m_list(),
    m_maxCols(0),
    m_screenWidth(0),
-   m_cursorVisible(true) {
+   m_cursorVisible(true),
+   m_freeParagraphs(),
+   m_freeTexts(),
+   m_cacheRevision(0),
+   m_cacheFirstCol(0),
+   m_cacheScreenWidth(0),
+   m_cacheCursorLineNo(-1) {
 }
 
 /**
@@ -791,6 +821,60 @@ ReParagraphs::ReParagraphs() :
  */
 ReParagraphs::~ReParagraphs() {
    clear();
+   for (int ix = m_freeParagraphs.length() - 1; ix >= 0; ix--)
+      delete m_freeParagraphs.at(ix);
+   for (int ix = m_freeTexts.length() - 1; ix >= 0; ix--)
+      delete m_freeTexts.at(ix);
+}
+
+/**
+ * Returns a text instance, if possible from the pool of unused texts.
+ *
+ * The builders should use this method instead of <code>new</code>.
+ *
+ * @param text  text of the part of paragraph
+ * @param look  the presentation of the text
+ * @return      a text instance owned by the paragraph it will be appended to
+ */
+ReEditText* ReParagraphs::allocText(const QString& text, ReLook* look) {
+   ReEditText* rc;
+   if (m_freeTexts.isEmpty())
+      rc = new ReEditText(text, look);
+   else {
+      rc = m_freeTexts.takeLast();
+      rc->set(text, look);
+   }
+   return rc;
+}
+
+/**
+ * Updates the line numbers of the cached paragraphs with the changes of the
+ * lines since the last load.
+ *
+ * Paragraphs of changed lines are invalidated, the paragraphs behind them
+ * are moved.
+ */
+void ReParagraphs::applyChanges() {
+   QList<ReLineChange> changes;
+   if (m_lines == NULL)
+      invalidate();
+   else if (!m_lines->changesSince(m_cacheRevision, changes))
+      invalidate();
+   else {
+      for (int ixChange = 0; ixChange < changes.length(); ixChange++) {
+         const ReLineChange& change = changes.at(ixChange);
+         int end = change.m_lineNo + change.m_oldCount;
+         int delta = change.m_newCount - change.m_oldCount;
+         for (int ix = 0; ix < m_list.length(); ix++) {
+            ReParagraph* current = m_list.at(ix);
+            if (current->m_lineNo >= end)
+               current->m_lineNo += delta;
+            else if (current->m_lineNo >= change.m_lineNo)
+               current->m_lineNo = -1;
+         }
+      }
+   }
+   m_cacheRevision = m_lines == NULL ? 0 : m_lines->revision();
 }
 
 /**
@@ -798,10 +882,8 @@ ReParagraphs::~ReParagraphs() {
  */
 void ReParagraphs::clear() {
    m_maxCols = 0;
-   for (int ix = m_list.length() - 1; ix >= 0; ix--) {
-      ReParagraph* current = m_list.at(ix);
-      delete current;
-   }
+   for (int ix = m_list.length() - 1; ix >= 0; ix--)
+      freeParagraph(m_list.at(ix));
    m_list.clear();
 }
 
@@ -937,24 +1019,93 @@ int ReParagraphs::indexToColumn(int index) {
    return rc;
 }
 
+/**
+ * Puts a paragraph and its texts into the pools of unused objects.
+ *
+ * @param paragraph the paragraph to free
+ */
+void ReParagraphs::freeParagraph(ReParagraph* paragraph) {
+   m_freeTexts.append(*paragraph);
+   paragraph->clear();
+   paragraph->m_columns = 0;
+   paragraph->m_lineNo = -1;
+   m_freeParagraphs.append(paragraph);
+}
+
+/**
+ * Marks the layout of some lines as invalid.
+ *
+ * The paragraphs of these lines will be built again in the next
+ * <code>load()</code>. A builder must call it if the presentation of a line
+ * changes without a change of its text, e.g. a new search hit.
+ *
+ * @param lineNo    the first line (0..N-1) to invalidate
+ * @param count     the number of lines to invalidate. -1: until the end
+ */
+void ReParagraphs::invalidate(int lineNo, int count) {
+   for (int ix = 0; ix < m_list.length(); ix++) {
+      ReParagraph* current = m_list.at(ix);
+      if (current->m_lineNo >= lineNo
+            && (count < 0 || current->m_lineNo < lineNo + count))
+         current->m_lineNo = -1;
+   }
+}
+
 /**
  * Transfers some lines starting with a given start into a paragraph list.
  *
+ * The paragraphs are cached: only the lines changed since the last call
+ * (and the lines not visible before) are built again.
+ *
  * @param lineNo    the line number of the first line to transfer
  * @param count     the number of lines to transfer
  * @param width		width of the screen (in chars)
  * @param edit		the parent (instance of the editor)
  */
 void ReParagraphs::load(int lineNo, int count, int width, ReEdit* edit) {
-   clear();
-   m_maxCols = 0;
+   // the first column and the width are part of the layout:
+   if (m_firstCol != m_cacheFirstCol || width != m_cacheScreenWidth) {
+      invalidate();
+      m_cacheFirstCol = m_firstCol;
+      m_cacheScreenWidth = width;
+   }
+   // the cursor line has its own look. An edit may move it:
+   bool cursorMoved = m_cursorLineNo != m_cacheCursorLineNo || m_lines == NULL
+                      || m_lines->revision() != m_cacheRevision;
+   if (cursorMoved)
+      invalidate(m_cacheCursorLineNo, 1);
+   applyChanges();
+   if (cursorMoved) {
+      invalidate(m_cursorLineNo, 1);
+      m_cacheCursorLineNo = m_cursorLineNo;
+   }
+   for (int builder = 0; builder < m_builders.length(); builder++)
+      m_builders.at(builder)->prepareLoad(edit);
    m_firstLine = lineNo;
    m_screenWidth = width;
-   for (int ix = lineNo; ix < lineNo + count; ix++) {
-      ReParagraph* para = new ReParagraph();
+   // the paragraphs still on the screen are moved to their new places:
+   QVector<ReParagraph*> places(max(0, count), NULL);
+   for (int ix = 0; ix < m_list.length(); ix++) {
+      ReParagraph* current = m_list.at(ix);
+      int place = current->m_lineNo - lineNo;
+      if (current->m_lineNo >= 0 && place >= 0 && place < count
+            && places.at(place) == NULL)
+         places[place] = current;
+      else
+         freeParagraph(current);
+   }
+   m_list.clear();
+   m_maxCols = 0;
+   for (int ix = 0; ix < count; ix++) {
+      ReParagraph* para = places.at(ix);
+      if (para == NULL) {
+         para = m_freeParagraphs.isEmpty()
+                ? new ReParagraph() : m_freeParagraphs.takeLast();
+         para->m_lineNo = lineNo + ix;
+         for (int builder = 0; builder < m_builders.length(); builder++)
+            m_builders.at(builder)->buildParagraph(*para, lineNo + ix, edit);
+      }
       m_list.append(para);
-      for (int builder = 0; builder < m_builders.length(); builder++)
-         m_builders.at(builder)->buildParagraph(*para, ix, edit);
       m_maxCols = max(m_maxCols, para->m_columns);
    }
 }
@@ -966,6 +1117,10 @@ void ReParagraphs::load(int lineNo, int count, int width, ReEdit* edit) {
  */
 void ReParagraphs::setLines(ReLines* lines) {
    m_lines = lines;
+   for (int builder = 0; builder < m_builders.length(); builder++)
+      m_builders.at(builder)->setLines(lines);
+   invalidate();
+   m_cacheRevision = lines == NULL ? 0 : lines->revision();
 }
 
 /**
@@ -989,7 +1144,7 @@ void ReParagraphBuilder::buildParagraph(ReParagraph& paragraph, int lineNo,
       int start = 0;
       int cursor = 0;
       int length, length2, start2;
-      int maxCol = edit->m_maxCols;
+      int maxCol = firstCol + edit->m_screenWidth;
       while ((ixTab = text.indexOf('\t', start)) >= 0) {
          if (ixTab > start) {
             length = ixTab - start;
@@ -1000,7 +1155,7 @@ void ReParagraphBuilder::buildParagraph(ReParagraph& paragraph, int lineNo,
                   start2 -= firstCol - cursor;
                   length2 -= firstCol - cursor;
                }
-               part = new ReEditText(text.mid(start2, length2), look);
+               part = edit->allocText(text.mid(start2, length2), look);
                paragraph.append(part);
             }
             cursor += length;
@@ -1010,7 +1165,7 @@ void ReParagraphBuilder::buildParagraph(ReParagraph& paragraph, int lineNo,
          if (cursor + length > firstCol && cursor < maxCol) {
             if (cursor < firstCol)
                tabs = tabs.left(length - firstCol - cursor);
-            paragraph.append(new ReEditText(tabs, lookTab));
+            paragraph.append(edit->allocText(tabs, lookTab));
          }
          cursor += length;
          start = ixTab + 1;
@@ -1018,16 +1173,25 @@ void ReParagraphBuilder::buildParagraph(ReParagraph& paragraph, int lineNo,
       if (cursor < firstCol) {
          start2 = start + (firstCol - cursor);
          cursor += text.length() - start;
-         part = new ReEditText(text.mid(start2), look);
+         part = edit->allocText(text.mid(start2), look);
       } else {
          cursor += text.length() - start;
-         part = new ReEditText(start == 0 ? text : text.mid(start), look);
+         part = edit->allocText(start == 0 ? text : text.mid(start), look);
       }
       paragraph.m_columns = cursor;
       paragraph.append(part);
    }
 }
 
+/**
+ * Constructor.
+ */
+ReParagraph::ReParagraph() :
+   QList<ReEditText*>(),
+   m_columns(0),
+   m_lineNo(-1) {
+}
+
 /**
  * Destructor.
  */
@@ -1053,15 +1217,17 @@ void ReParagraph::draw(QPainter& painter, int& top, int left) {
    int height = metrics->height();
    int y = top + height - metrics->descent();
    top += heightToFullHeight(height);
+   ReLook* lastLook = NULL;
    for (int ix = 0; ix < length(); ix++) {
       ReEditText* current = at(ix);
       ReLook* look = current->look();
-      painter.setFont(*look->m_font);
-      const ReLook::ForeGround fg = look->m_foreground;
-      QPen pen(*look->m_edit->foregroundColors()[fg]);
-      painter.setPen(pen);
+      if (look != lastLook) {
+         painter.setFont(*look->m_font);
+         painter.setPen(*look->m_pen);
+         lastLook = look;
+      }
       painter.drawText(x, y, current->text());
-      x += metrics->width(current->text());
+      x += current->width();
    }
 }
 
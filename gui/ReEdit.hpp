@@ -86,7 +86,8 @@ public:
     */
    inline ReEditText(const ReEditText& source) :
       m_text(source.m_text),
-      m_look(source.m_look) {
+      m_look(source.m_look),
+      m_width(source.m_width) {
    }
    /** Assignment operator.
     * @param source    source to copy
@@ -95,6 +96,7 @@ public:
    inline ReEditText& operator =(const ReEditText& source) {
       m_text = source.m_text;
       m_look = source.m_look;
+      m_width = source.m_width;
       return *this;
    }
 
@@ -105,21 +107,27 @@ public:
    ReLook* look() const {
       return m_look;
    }
-   /** Sets the look of the instance
-    * @param look  the new look
-    */
-   void setLook(ReLook* look) {
-      m_look = look;
-   }
+   void set(const QString& text, ReLook* look);
+   void setLook(ReLook* look);
    /** Returns the text.
     * @return the text
     */
    inline const QString& text() const {
       return m_text;
    }
+   /** Returns the width of the text in pixels.
+    * @return the width of the text (measured only once)
+    */
+   inline int width() {
+      if (m_width < 0)
+         m_width = m_look->m_metrics->width(m_text);
+      return m_width;
+   }
 private:
    QString m_text;
    ReLook* m_look;
+   /// the width in pixels. -1: not yet measured
+   int m_width;
 };
 
 /**
@@ -129,12 +137,15 @@ private:
  */
 class ReParagraph: public QList<ReEditText*> {
 public:
+   ReParagraph();
    virtual ~ReParagraph();
 public:
    void draw(QPainter& painter, int& top, int left);
 public:
    // number of columns of the paragraph (length with expanded tabs).
    int m_columns;
+   // the line number (0..N-1) of the paragraph. -1: the layout is invalid
+   int m_lineNo;
 };
 
 /**
@@ -144,9 +155,26 @@ public:
  * inside the paragraph. It should <b>never</b> change the text!
  */
 class ReParagraphBuilder {
+public:
+   virtual ~ReParagraphBuilder() {
+   }
 public:
    virtual void buildParagraph(ReParagraph& paragraph, int lineNo,
                                ReEdit* edit);
+   /** Will be called at the start of <code>ReParagraphs::load()</code>.
+    *
+    * The builder can invalidate lines here whose presentation has changed.
+    * @param edit  the parent, the edit field
+    */
+   virtual void prepareLoad(ReEdit* edit) {
+      ReUseParameter(edit);
+   }
+   /** Will be called if the text source of the edit field changes.
+    * @param lines the new text source
+    */
+   virtual void setLines(ReLines* lines) {
+      ReUseParameter(lines);
+   }
 };
 
 class ReCursortLineBuilder: public ReParagraphBuilder {
@@ -170,6 +198,7 @@ public:
    ReParagraphs();
    virtual ~ReParagraphs();
 public:
+   ReEditText* allocText(const QString& text, ReLook* look);
    /** Appends a paragraph builder to the list
     * @param builder   the paragraph builder to append
     */
@@ -178,6 +207,12 @@ public:
    }
    void clear();
    ReParagraph* cursorParagraph();
+   /** Returns the first visible column.
+    * @return the first visible column (horizontal scrolling)
+    */
+   inline int firstCol() const {
+      return m_firstCol;
+   }
    void draw(QPainter& painter, int top, int left);
    int columnToIndex(int cursorCol);
    /** Returns the paragraph with a given index from the list.
@@ -190,12 +225,30 @@ public:
    }
    void load(int lineNo, int count, int width, ReEdit* edit);
    int indexToColumn(int index);
+   /** Inserts a paragraph builder into the list.
+    * @param index     the position in the list, e.g. 1: behind the standard
+    *                  builder
+    * @param builder   the paragraph builder to insert
+    */
+   void insertBuilder(int index, ReParagraphBuilder* builder) {
+      m_builders.insert(index, builder);
+   }
+   void invalidate(int lineNo = 0, int count = -1);
+   /** Removes a paragraph builder from the list.
+    * @param builder   the paragraph builder to remove
+    */
+   void removeBuilder(ReParagraphBuilder* builder) {
+      m_builders.removeOne(builder);
+   }
 
 public:
    void setLines(ReLines* lines);
 public:
    static int columnToIndex(int column, int tabWidth, const QString& string);
    static int indexToColumn(int index, int tabWidth, const QString& string);
+protected:
+   void applyChanges();
+   void freeParagraph(ReParagraph* paragraph);
 protected:
    QList<ReParagraphBuilder*> m_builders;
    /// the m_list.at(0) belongs to m_lines.atLine(m_firstLine)
@@ -212,6 +265,18 @@ protected:
    int m_screenWidth;
    /// true: the text cursor is visible (blinking)
    bool m_cursorVisible;
+   /// the unused paragraphs (for reuse)
+   QList<ReParagraph*> m_freeParagraphs;
+   /// the unused texts (for reuse)
+   QList<ReEditText*> m_freeTexts;
+   /// the revision of m_lines the paragraphs in m_list belong to
+   int m_cacheRevision;
+   /// the first column the paragraphs in m_list are built with
+   int m_cacheFirstCol;
+   /// the screen width the paragraphs in m_list are built with
+   int m_cacheScreenWidth;
+   /// the cursor line the paragraphs in m_list are built with
+   int m_cacheCursorLineNo;
 protected:
    static QStringList m_tabStrings;
    static QChar m_tabChar;
@@ -372,6 +437,8 @@ protected:
    bool m_breakLines;
    /// number of pixels for the line number
    int m_widthLineNumbers;
+   /// number of pixels of a digit (of a line number)
+   int m_widthDigit;
    /// number of pixels for the right scroll bar
    int m_widthVScrollBar;
    /// number of pixels for the bottom scroll bar
@@ -0,0 +1,612 @@
+/*
+ * ReFileTableModel.cpp
+ *
+ * (Un)License: Public Domain
+ * You can use and modify this file without any restriction.
+ * Do what you want.
+ * No warranties and disclaimer of any damages.
+ * More info: http://unlicense.org
+ * The latest sources: https://github.com/republib
+ */
+
+#include "base/rebase.hpp"
+#include "gui/regui.hpp"
+
+/** @class ReFileResultStore ReFileTableModel.hpp "gui/ReFileTableModel.hpp"
+ *
+ * @brief Stores the meta data of many files with a few bytes per file.
+ *
+ * Each attribute has its own array (a column). The nodes are stored
+ * UTF-8 encoded in one byte array, the paths are stored only once.
+ * A record needs about 25 bytes plus the length of the node.
+ */
+
+/**
+ * Constructor.
+ */
+ReFileResultStore::ReFileResultStore() :
+   m_nodes(),
+   m_nodeStarts(),
+   m_sizes(),
+   m_modified(),
+   m_pathIndexes(),
+   m_types(),
+   m_paths(),
+   m_pathMap(),
+   m_lastPathIndex(-1) {
+   m_nodeStarts.append(0);
+}
+
+/**
+ * Adds a record.
+ *
+ * @param node      the filename without path
+ * @param path      the directory of the file
+ * @param size      the file size in bytes
+ * @param modified  the modification time in msec since the epoch
+ * @param type      the file type, e.g. FT_DIR
+ */
+void ReFileResultStore::add(const QString& node, const QString& path,
+                            int64_t size, int64_t modified, FileType type) {
+   m_nodes.append(node.toUtf8());
+   m_nodeStarts.append(m_nodes.size());
+   m_sizes.append(size);
+   m_modified.append(modified);
+   m_pathIndexes.append(indexOfPath(path));
+   m_types.append(uint8_t(type));
+}
+
+/**
+ * Appends all records of another store.
+ *
+ * @param source    the store to copy
+ */
+void ReFileResultStore::append(const ReFileResultStore& source) {
+   QVector<int> pathIndexes;
+   pathIndexes.reserve(source.m_paths.size());
+   for (int ix = 0; ix < source.m_paths.size(); ix++)
+      pathIndexes.append(indexOfPath(source.m_paths.at(ix)));
+   int base = m_nodes.size();
+   m_nodes.append(source.m_nodes);
+   int count = source.count();
+   reserve(this->count() + count);
+   for (int ix = 0; ix < count; ix++) {
+      m_nodeStarts.append(base + source.m_nodeStarts.at(ix + 1));
+      m_pathIndexes.append(pathIndexes.at(source.m_pathIndexes.at(ix)));
+   }
+   m_sizes += source.m_sizes;
+   m_modified += source.m_modified;
+   m_types += source.m_types;
+}
+
+/**
+ * Removes all records.
+ */
+void ReFileResultStore::clear() {
+   m_nodes.clear();
+   m_nodeStarts.resize(1);
+   m_sizes.clear();
+   m_modified.clear();
+   m_pathIndexes.clear();
+   m_types.clear();
+   m_paths.clear();
+   m_pathMap.clear();
+   m_lastPathIndex = -1;
+}
+
+/**
+ * Returns the index of a path in the path list.
+ *
+ * If the path is unknown it will be added.
+ *
+ * @param path  the path to find
+ * @return      the index of <code>path</code> in <code>m_paths</code>
+ */
+int ReFileResultStore::indexOfPath(const QString& path) {
+   if (m_lastPathIndex < 0 || m_paths.at(m_lastPathIndex) != path) {
+      QHash<QString, int>::const_iterator it = m_pathMap.find(path);
+      if (it != m_pathMap.cend())
+         m_lastPathIndex = it.value();
+      else {
+         m_lastPathIndex = m_paths.size();
+         m_paths.append(path);
+         m_pathMap.insert(path, m_lastPathIndex);
+      }
+   }
+   return m_lastPathIndex;
+}
+
+/**
+ * Returns the memory used by the records (without the paths).
+ *
+ * @return  the count of reserved bytes
+ */
+size_t ReFileResultStore::memoryUsage() const {
+   size_t rc = m_nodes.capacity() + m_nodeStarts.capacity() * sizeof(int)
+               + (m_sizes.capacity() + m_modified.capacity()) * sizeof(int64_t)
+               + m_pathIndexes.capacity() * sizeof(int) + m_types.capacity();
+   return rc;
+}
+
+/**
+ * Returns the node of a record.
+ *
+ * @param record    the index of the record: 0..count()-1
+ * @return          the filename without path
+ */
+QString ReFileResultStore::node(int record) const {
+   int length;
+   const char* data = nodeData(record, length);
+   return QString::fromUtf8(data, length);
+}
+
+/**
+ * Returns the path of a record.
+ *
+ * @param record    the index of the record: 0..count()-1
+ * @return          the directory of the file
+ */
+QString ReFileResultStore::path(int record) const {
+   return m_paths.at(m_pathIndexes.at(record));
+}
+
+/**
+ * Reserves the space for a given count of records.
+ *
+ * @param count the expected count of records
+ */
+void ReFileResultStore::reserve(int count) {
+   m_nodeStarts.reserve(count + 1);
+   m_sizes.reserve(count);
+   m_modified.reserve(count);
+   m_pathIndexes.reserve(count);
+   m_types.reserve(count);
+}
+
+/**
+ * Compares two records of a file table model by a given column.
+ */
+class ReFileRecordLess {
+public:
+   ReFileRecordLess(const ReFileTableModel* model,
+                    ReFileTableModel::Column column, Qt::SortOrder order) :
+      m_model(model),
+      m_column(column),
+      m_descending(order == Qt::DescendingOrder) {
+   }
+public:
+   bool operator()(int record1, int record2) const {
+      return m_descending ? m_model->lessThan(record2, record1, m_column)
+             : m_model->lessThan(record1, record2, m_column);
+   }
+private:
+   const ReFileTableModel* m_model;
+   ReFileTableModel::Column m_column;
+   bool m_descending;
+};
+
+/** @class ReFileTableModel ReFileTableModel.hpp "gui/ReFileTableModel.hpp"
+ *
+ * @brief A table model showing file meta data stored in columns.
+ *
+ * The model does not hold any cell text: the cells are formatted in
+ * <code>data()</code>, which is called by the view only for the visible rows.
+ * Sorting changes only a permutation of the record indexes.
+ *
+ * Other threads can add records with <code>add()</code>. These records
+ * become visible with <code>flushPending()</code>, which must be called
+ * by the main thread.
+ */
+
+/**
+ * Constructor.
+ *
+ * @param columns   defines the content of the columns
+ * @param parent    NULL or the parent
+ */
+ReFileTableModel::ReFileTableModel(const QList<Column>& columns,
+                                   QObject* parent) :
+   QAbstractTableModel(parent),
+   m_columns(columns),
+   m_labels(),
+   m_dateFormat("yyyy.MM.dd hh:mm:ss"),
+   m_store(),
+   m_order(),
+   m_pending(),
+   m_pendingMutex(),
+   m_pathRanks() {
+}
+
+/**
+ * Destructor.
+ */
+ReFileTableModel::~ReFileTableModel() {
+}
+
+/**
+ * Adds a record which becomes visible with the next <code>flushPending()</code>.
+ *
+ * This method can be used by all threads.
+ *
+ * @param node      the filename without path
+ * @param path      the directory of the file
+ * @param size      the file size in bytes
+ * @param modified  the modification time in msec since the epoch
+ * @param type      the file type, e.g. FT_DIR
+ */
+void ReFileTableModel::add(const QString& node, const QString& path,
+                           int64_t size, int64_t modified,
+                           ReFileResultStore::FileType type) {
+   QMutexLocker locker(&m_pendingMutex);
+   m_pending.add(node, path, size, modified, type);
+}
+
+/**
+ * Gets the content of the given cell as string.
+ *
+ * @param row   the row number: 0..R-1
+ * @param col   the column number: 0..C-1
+ * @return      the text of the given cell
+ */
+QString ReFileTableModel::cellText(int row, int col) const {
+   QString rc;
+   if (row >= 0 && row < m_order.size() && col >= 0 && col < m_columns.size())
+      rc = format(m_order.at(row), m_columns.at(col));
+   return rc;
+}
+
+/**
+ * Removes all records: the visible and the pending ones.
+ */
+void ReFileTableModel::clear() {
+   beginResetModel();
+   {
+      // rows added by a still running search are discarded too:
+      QMutexLocker locker(&m_pendingMutex);
+      m_pending.clear();
+   }
+   m_store.clear();
+   m_order.clear();
+   m_pathRanks.clear();
+   endResetModel();
+}
+
+/**
+ * Returns the count of columns.
+ *
+ * @param parent    the parent index (not used in a table)
+ * @return          the count of columns
+ */
+int ReFileTableModel::columnCount(const QModelIndex& parent) const {
+   return parent.isValid() ? 0 : m_columns.size();
+}
+
+/**
+ * Returns the data of a cell.
+ *
+ * @param index the cell index
+ * @param role  the kind of the data, e.g. Qt::DisplayRole
+ * @return      the data of the cell
+ */
+QVariant ReFileTableModel::data(const QModelIndex& index, int role) const {
+   QVariant rc;
+   if (index.isValid()) {
+      if (role == Qt::DisplayRole)
+         rc = cellText(index.row(), index.column());
+      else if (role == Qt::TextAlignmentRole) {
+         Column column = m_columns.value(index.column(), COL_NODE);
+         if (column == COL_SIZE || column == COL_SIZE_MBYTE)
+            rc = int(Qt::AlignRight | Qt::AlignVCenter);
+      }
+   }
+   return rc;
+}
+
+/**
+ * Returns the properties of a cell.
+ *
+ * @param index the cell index
+ * @return      the cell properties: selectable and dragable, not editable
+ */
+Qt::ItemFlags ReFileTableModel::flags(const QModelIndex& index) const {
+   Qt::ItemFlags rc = QAbstractTableModel::flags(index);
+   if (index.isValid())
+      rc |= Qt::ItemIsDragEnabled;
+   return rc;
+}
+
+/**
+ * Makes the records added by <code>add()</code> visible.
+ *
+ * This method should be called only by the main thread.
+ *
+ * @return  the count of new rows
+ */
+int ReFileTableModel::flushPending() {
+   ReFileResultStore pending;
+   {
+      QMutexLocker locker(&m_pendingMutex);
+      if (m_pending.count() == 0)
+         return 0;
+      pending = m_pending;
+      m_pending.clear();
+   }
+   int first = m_order.size();
+   int count = pending.count();
+   beginInsertRows(QModelIndex(), first, first + count - 1);
+   m_store.append(pending);
+   m_order.reserve(m_store.count());
+   for (int ix = 0; ix < count; ix++)
+      m_order.append(first + ix);
+   m_pathRanks.clear();
+   endInsertRows();
+   return count;
+}
+
+/**
+ * Formats one attribute of a record.
+ *
+ * @param record    the index of the record in the store
+ * @param column    the attribute to format
+ * @return          the formatted attribute
+ */
+QString ReFileTableModel::format(int record, Column column) const {
+   QString rc;
+   switch (column) {
+   case COL_NODE:
+      rc = m_store.node(record);
+      break;
+   case COL_EXT: {
+      QString node = m_store.node(record);
+      int ix = node.lastIndexOf('.');
+      if (ix > 0)
+         rc = node.mid(ix + 1).toLower();
+      break;
+   }
+   case COL_EXT_OR_DIR:
+      rc = m_store.isDir(record) ? QObject::tr("<dir>")
+           : ReFileUtils::extensionOf(m_store.node(record));
+      break;
+   case COL_SIZE:
+      if (!m_store.isDir(record))
+         rc = QString::number(m_store.size(record));
+      break;
+   case COL_SIZE_MBYTE:
+      if (!m_store.isDir(record))
+         rc.sprintf("%12.6f", (double) m_store.size(record) / 1000000.0);
+      break;
+   case COL_MODIFIED:
+      rc = QDateTime::fromMSecsSinceEpoch(m_store.modified(record)).toString(
+              m_dateFormat);
+      break;
+   case COL_TYPE:
+      switch (m_store.type(record)) {
+      case ReFileResultStore::FT_DIR:
+         rc = QObject::tr("dir");
+         break;
+      case ReFileResultStore::FT_LINK_DIR:
+         rc = QObject::tr("link (dir)");
+         break;
+      case ReFileResultStore::FT_LINK_FILE:
+         rc = QObject::tr("link (file)");
+         break;
+      default:
+         rc = QObject::tr("file");
+         break;
+      }
+      break;
+   case COL_PATH:
+      rc = m_store.path(record);
+      break;
+   default:
+      break;
+   }
+   return rc;
+}
+
+/**
+ * Returns the header of a column or a row.
+ *
+ * @param section       the column or row number
+ * @param orientation   Qt::Horizontal: column header<br>
+ *                      Qt::Vertical: row header
+ * @param role          the kind of the data, e.g. Qt::DisplayRole
+ * @return              the header data
+ */
+QVariant ReFileTableModel::headerData(int section,
+                                      Qt::Orientation orientation, int role) const {
+   QVariant rc;
+   if (role != Qt::DisplayRole)
+      rc = QAbstractTableModel::headerData(section, orientation, role);
+   else if (orientation == Qt::Horizontal)
+      rc = m_labels.value(section);
+   else
+      rc = section + 1;
+   return rc;
+}
+
+/**
+ * Compares the UTF-8 strings given by pointer and length.
+ *
+ * @param str1          the first string
+ * @param length1       the length of <code>str1</code>
+ * @param str2          the second string
+ * @param length2       the length of <code>str2</code>
+ * @param ignoreCase    <code>true</code>: the comparison is case insensitive
+ * @return              &lt; 0: str1 &lt; str2<br>
+ *                      0: the strings are equal<br>
+ *                      &gt; 0: str1 &gt; str2
+ */
+static int compareStrings(const char* str1, int length1, const char* str2,
+                          int length2, bool ignoreCase) {
+   int length = min(length1, length2);
+   int rc = length == 0 ? 0 : ignoreCase ? qstrnicmp(str1, str2, length)
+            : memcmp(str1, str2, length);
+   if (rc == 0)
+      rc = length1 - length2;
+   return rc;
+}
+
+/**
+ * Returns the start of the extension of a node.
+ *
+ * @param node      the node (UTF-8)
+ * @param length    IN: the length of the node<br>
+ *                  OUT: the length of the extension
+ * @return          the start of the extension (behind the '.')
+ */
+static const char* nodeExtension(const char* node, int& length) {
+   int ix = length - 1;
+   while (ix > 0 && node[ix] != '.')
+      ix--;
+   const char* rc = node + length;
+   if (ix > 0)
+      rc = node + ix + 1;
+   length = node + length - rc;
+   return rc;
+}
+
+/**
+ * Compares two records by a given column.
+ *
+ * @param record1   the index of the first record in the store
+ * @param record2   the index of the second record in the store
+ * @param column    the attribute to compare
+ * @return          <code>true</code>: record1 &lt; record2
+ */
+bool ReFileTableModel::lessThan(int record1, int record2, Column column) const {
+   bool rc = false;
+   int length1, length2;
+   const char* node1;
+   const char* node2;
+   switch (column) {
+   case COL_NODE:
+      node1 = m_store.nodeData(record1, length1);
+      node2 = m_store.nodeData(record2, length2);
+      rc = compareStrings(node1, length1, node2, length2, false) < 0;
+      break;
+   case COL_EXT_OR_DIR:
+      if (m_store.isDir(record1) != m_store.isDir(record2)) {
+         rc = m_store.isDir(record1);
+         break;
+      }
+   // no break: compare the extensions
+   case COL_EXT:
+      node1 = m_store.nodeData(record1, length1);
+      node2 = m_store.nodeData(record2, length2);
+      node1 = nodeExtension(node1, length1);
+      node2 = nodeExtension(node2, length2);
+      rc = compareStrings(node1, length1, node2, length2,
+                          column == COL_EXT) < 0;
+      break;
+   case COL_SIZE:
+   case COL_SIZE_MBYTE:
+      rc = (m_store.isDir(record1) ? -1 : m_store.size(record1))
+           < (m_store.isDir(record2) ? -1 : m_store.size(record2));
+      break;
+   case COL_MODIFIED:
+      rc = m_store.modified(record1) < m_store.modified(record2);
+      break;
+   case COL_TYPE:
+      rc = m_store.type(record1) < m_store.type(record2);
+      break;
+   case COL_PATH:
+      rc = m_pathRanks.at(m_store.pathIndex(record1))
+           < m_pathRanks.at(m_store.pathIndex(record2));
+      break;
+   default:
+      break;
+   }
+   return rc;
+}
+
+/**
+ * Returns the count of rows.
+ *
+ * @param parent    the parent index (not used in a table)
+ * @return          the count of rows
+ */
+int ReFileTableModel::rowCount(const QModelIndex& parent) const {
+   return parent.isValid() ? 0 : m_order.size();
+}
+
+/**
+ * Sets the format of the modification time.
+ *
+ * @param dateFormat    the format, e.g. "yyyy.MM.dd hh:mm:ss"
+ */
+void ReFileTableModel::setDateFormat(const QString& dateFormat) {
+   m_dateFormat = dateFormat;
+}
+
+/**
+ * Sets the column headers.
+ *
+ * @param labels    the header texts of the columns
+ */
+void ReFileTableModel::setHeaderLabels(const QStringList& labels) {
+   m_labels = labels;
+   emit headerDataChanged(Qt::Horizontal, 0, m_columns.size() - 1);
+}
+
+/**
+ * Replaces all visible records.
+ *
+ * @param store the new records
+ */
+void ReFileTableModel::setStore(const ReFileResultStore& store) {
+   beginResetModel();
+   m_store = store;
+   int count = m_store.count();
+   m_order.resize(count);
+   for (int ix = 0; ix < count; ix++)
+      m_order[ix] = ix;
+   m_pathRanks.clear();
+   endResetModel();
+}
+
+/**
+ * Sorts the rows by a given column.
+ *
+ * Only the permutation of the records is changed. The sorting is stable:
+ * rows with equal values keep their order.
+ *
+ * @param column    the column to sort
+ * @param order     Qt::AscendingOrder or Qt::DescendingOrder
+ */
+void ReFileTableModel::sort(int column, Qt::SortOrder order) {
+   if (column >= 0 && column < m_columns.size()) {
+      Column kind = m_columns.at(column);
+      if (kind == COL_PATH && m_pathRanks.size() != m_store.paths().size()) {
+         const QStringList& paths = m_store.paths();
+         QMap<QString, int> sorted;
+         for (int ix = 0; ix < paths.size(); ix++)
+            sorted.insert(paths.at(ix), ix);
+         m_pathRanks.resize(paths.size());
+         int rank = 0;
+         QMap<QString, int>::const_iterator it;
+         for (it = sorted.cbegin(); it != sorted.cend(); ++it)
+            m_pathRanks[it.value()] = rank++;
+      }
+      emit layoutAboutToBeChanged();
+      QModelIndexList oldIndexes = persistentIndexList();
+      QVector<int> records;
+      records.reserve(oldIndexes.size());
+      for (int ix = 0; ix < oldIndexes.size(); ix++)
+         records.append(m_order.at(oldIndexes.at(ix).row()));
+      std::stable_sort(m_order.begin(), m_order.end(),
+                       ReFileRecordLess(this, kind, order));
+      if (! oldIndexes.isEmpty()) {
+         QVector<int> rowOf(m_order.size());
+         for (int row = 0; row < m_order.size(); row++)
+            rowOf[m_order.at(row)] = row;
+         QModelIndexList newIndexes;
+         newIndexes.reserve(oldIndexes.size());
+         for (int ix = 0; ix < oldIndexes.size(); ix++)
+            newIndexes.append(index(rowOf.at(records.at(ix)),
+                                    oldIndexes.at(ix).column()));
+         changePersistentIndexList(oldIndexes, newIndexes);
+      }
+      emit layoutChanged();
+   }
+}
@@ -0,0 +1,192 @@
+/*
+ * ReFileTableModel.hpp
+ *
+ * (Un)License: Public Domain
+ * You can use and modify this file without any restriction.
+ * Do what you want.
+ * No warranties and disclaimer of any damages.
+ * More info: http://unlicense.org
+ * The latest sources: https://github.com/republib
+ */
+
+#ifndef REFILETABLEMODEL_HPP
+#define REFILETABLEMODEL_HPP
+#include <QAbstractTableModel>
+
+/**
+ * Stores the meta data of many files in columns.
+ */
+class ReFileResultStore {
+public:
+   /// the order is the alphabetical order of the english type names
+   enum FileType {
+      FT_DIR, FT_FILE, FT_LINK_DIR, FT_LINK_FILE
+   };
+public:
+   ReFileResultStore();
+public:
+   void add(const QString& node, const QString& path, int64_t size,
+            int64_t modified, FileType type);
+   void append(const ReFileResultStore& source);
+   void clear();
+   size_t memoryUsage() const;
+   QString node(int record) const;
+   QString path(int record) const;
+   void reserve(int count);
+   /** Returns the count of records.
+    * @return  the count of records
+    */
+   inline int count() const {
+      return m_types.size();
+   }
+   /** Returns the node of a record as UTF-8 string (not terminated).
+    * @param record    the index of the record: 0..count()-1
+    * @param length    OUT: the length of the node in bytes
+    * @return          the start of the node
+    */
+   inline const char* nodeData(int record, int& length) const {
+      int start = m_nodeStarts.at(record);
+      length = m_nodeStarts.at(record + 1) - start;
+      return m_nodes.constData() + start;
+   }
+   /** Returns whether the record is a directory (or a link to it).
+    * @param record    the index of the record: 0..count()-1
+    * @return          <code>true</code>: the record is a directory
+    */
+   inline bool isDir(int record) const {
+      FileType type = this->type(record);
+      return type == FT_DIR || type == FT_LINK_DIR;
+   }
+   /** Returns the modification time of a record.
+    * @param record    the index of the record: 0..count()-1
+    * @return          the modification time in msec since the epoch
+    */
+   inline int64_t modified(int record) const {
+      return m_modified.at(record);
+   }
+   /** Returns the index of the path of a record in the path list.
+    * @param record    the index of the record: 0..count()-1
+    * @return          the index of the path
+    */
+   inline int pathIndex(int record) const {
+      return m_pathIndexes.at(record);
+   }
+   /** Returns the list of the different paths.
+    * @return  the list of paths
+    */
+   inline const QStringList& paths() const {
+      return m_paths;
+   }
+   /** Returns the file size of a record.
+    * @param record    the index of the record: 0..count()-1
+    * @return          the size in bytes
+    */
+   inline int64_t size(int record) const {
+      return m_sizes.at(record);
+   }
+   /** Returns the file type of a record.
+    * @param record    the index of the record: 0..count()-1
+    * @return          the file type, e.g. FT_DIR
+    */
+   inline FileType type(int record) const {
+      return FileType(m_types.at(record));
+   }
+private:
+   int indexOfPath(const QString& path);
+private:
+   // the UTF-8 encoded nodes without separators:
+   QByteArray m_nodes;
+   // the start of the node of each record in m_nodes (count()+1 entries):
+   QVector<int> m_nodeStarts;
+   QVector<int64_t> m_sizes;
+   // msec since the epoch:
+   QVector<int64_t> m_modified;
+   // the index of the path of each record in m_paths:
+   QVector<int> m_pathIndexes;
+   // the FileType of each record:
+   QVector<uint8_t> m_types;
+   // each path only once:
+   QStringList m_paths;
+   // path -> index in m_paths:
+   QHash<QString, int> m_pathMap;
+   // the last result of indexOfPath() (the most files share the path)
+   int m_lastPathIndex;
+};
+
+/**
+ * A table model showing the records of a <code>ReFileResultStore</code>.
+ *
+ * The cells are formatted only when the view asks for them,
+ * so only the visible rows are formatted.
+ */
+class ReFileTableModel : public QAbstractTableModel {
+   friend class ReFileRecordLess;
+public:
+   enum Column {
+      /// the filename without path
+      COL_NODE,
+      /// the extension in lower case without '.'
+      COL_EXT,
+      /// the extension with '.' or "<dir>"
+      COL_EXT_OR_DIR,
+      /// the size in bytes. Empty for directories
+      COL_SIZE,
+      /// the size in MByte with 6 decimals. Empty for directories
+      COL_SIZE_MBYTE,
+      COL_MODIFIED,
+      /// "dir", "file", "link (dir)" or "link (file)"
+      COL_TYPE,
+      COL_PATH
+   };
+public:
+   ReFileTableModel(const QList<Column>& columns, QObject* parent = NULL);
+   virtual ~ReFileTableModel();
+public:
+   void add(const QString& node, const QString& path, int64_t size,
+            int64_t modified, ReFileResultStore::FileType type);
+   QString cellText(int row, int col) const;
+   void clear();
+   virtual int columnCount(const QModelIndex& parent = QModelIndex()) const;
+   virtual QVariant data(const QModelIndex& index,
+                         int role = Qt::DisplayRole) const;
+   virtual Qt::ItemFlags flags(const QModelIndex& index) const;
+   int flushPending();
+   virtual QVariant headerData(int section, Qt::Orientation orientation,
+                               int role = Qt::DisplayRole) const;
+   virtual int rowCount(const QModelIndex& parent = QModelIndex()) const;
+   void setDateFormat(const QString& dateFormat);
+   void setHeaderLabels(const QStringList& labels);
+   void setStore(const ReFileResultStore& store);
+   virtual void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
+   /** Returns the index of the record shown in a given row.
+    * @param row   the row number: 0..rowCount()-1
+    * @return      the index of the record in <code>store()</code>
+    */
+   inline int record(int row) const {
+      return m_order.at(row);
+   }
+   /** Returns the store containing the records.
+    * @return  the store
+    */
+   inline const ReFileResultStore& store() const {
+      return m_store;
+   }
+protected:
+   QString format(int record, Column column) const;
+   bool lessThan(int record1, int record2, Column column) const;
+private:
+   QList<Column> m_columns;
+   QStringList m_labels;
+   QString m_dateFormat;
+   ReFileResultStore m_store;
+   // row -> record: sorting changes only this permutation
+   QVector<int> m_order;
+   // the records added by other threads, not visible until flushPending()
+   ReFileResultStore m_pending;
+   // protects m_pending:
+   QMutex m_pendingMutex;
+   // the sort rank of each path in m_store.paths(). Empty if not computed
+   QVector<int> m_pathRanks;
+};
+
+#endif // REFILETABLEMODEL_HPP
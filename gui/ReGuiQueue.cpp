@@ -12,12 +12,44 @@
 #include "base/rebase.hpp"
 #include "gui/regui.hpp"
 
+/** @class ReGuiQueue ReGuiQueue.hpp "gui/ReGuiQueue.hpp"
+ *
+ * @brief A ring buffer transporting GUI changes to the main thread.
+ *
+ * The consumer (the main thread) works without locking: it takes all
+ * available items at once (see <code>popFront(QVector&)</code>).
+ * The producers are serialized by a mutex which is never locked by the
+ * consumer. If the buffer is full the producer waits (on a wait condition)
+ * until the consumer has taken some items.
+ */
+
 /**
  * Constructor.
+ *
+ * @param capacity	the maximal count of waiting items. Will be rounded up
+ *					to a power of 2
  */
-ReGuiQueue::ReGuiQueue() :
-   QVector<ReGuiQueueItem>(),
-   m_locker() {
+ReGuiQueue::ReGuiQueue(int capacity) :
+   m_locker(),
+   m_items(NULL),
+   m_capacity(16),
+   m_positionMask(0),
+   m_head(0),
+   m_tail(0),
+   m_notFull(),
+   m_waiting(0) {
+   while (m_capacity < capacity)
+      m_capacity *= 2;
+   m_positionMask = 2 * m_capacity - 1;
+   m_items = new ReGuiQueueItem[m_capacity];
+}
+
+/**
+ * Destructor.
+ */
+ReGuiQueue::~ReGuiQueue() {
+   delete[] m_items;
+   m_items = NULL;
 }
 
 /**
@@ -28,9 +60,20 @@ ReGuiQueue::ReGuiQueue() :
  * @param item	the item to add
  */
 void ReGuiQueue::pushBack(const ReGuiQueueItem& item) {
-   m_locker.lock();
-   append(item);
-   m_locker.unlock();
+   QMutexLocker locker(&m_locker);
+   int tail;
+   // full? wait for the consumer:
+   while ((((tail = m_tail.load()) - m_head.loadAcquire()) & m_positionMask)
+          >= m_capacity) {
+      m_waiting.fetchAndAddOrdered(1);
+      // the consumer may have taken items in the meantime.
+      // Ordered access: the consumer sees m_waiting or we see its head
+      if (((tail - m_head.fetchAndAddOrdered(0)) & m_positionMask) >= m_capacity)
+         m_notFull.wait(&m_locker);
+      m_waiting.fetchAndAddOrdered(-1);
+   }
+   m_items[tail & (m_capacity - 1)] = item;
+   m_tail.storeRelease((tail + 1) & m_positionMask);
 }
 
 /**
@@ -42,7 +85,7 @@ void ReGuiQueue::pushBack(const ReGuiQueueItem& item) {
  */
 int ReGuiQueue::count() const {
    // no locking is necessary: removing is done only by the same thread
-   return size();
+   return (m_tail.loadAcquire() - m_head.load()) & m_positionMask;
 }
 
 /**
@@ -50,15 +93,59 @@ int ReGuiQueue::count() const {
  *
  * This method should be called only by the master thread.
  *
- * @return the first elements
+ * @return the first element or an item with type <code>Undef</code>
  */
 ReGuiQueueItem ReGuiQueue::popFront() {
-   m_locker.lock();
-   ReGuiQueueItem rc = takeFirst();
-   m_locker.unlock();
+   ReGuiQueueItem rc;
+   int head = m_head.load();
+   if (head != m_tail.loadAcquire()) {
+      ReGuiQueueItem& item = m_items[head & (m_capacity - 1)];
+      rc = item;
+      item = ReGuiQueueItem();
+      setHead((head + 1) & m_positionMask);
+   }
    return rc;
 }
 
+/**
+ * Takes all (or a maximal count of) elements from the queue.
+ *
+ * This method should be called only by the master thread.
+ *
+ * @param items		OUT: the taken elements
+ * @param maxCount	the maximal count of elements to take
+ * @return			the count of taken elements
+ */
+int ReGuiQueue::popFront(QVector<ReGuiQueueItem>& items, int maxCount) {
+   int head = m_head.load();
+   int count = min(maxCount, (m_tail.loadAcquire() - head) & m_positionMask);
+   items.resize(count);
+   for (int ix = 0; ix < count; ix++) {
+      ReGuiQueueItem& item = m_items[(head + ix) & (m_capacity - 1)];
+      items[ix] = item;
+      // frees the strings:
+      item = ReGuiQueueItem();
+   }
+   if (count > 0)
+      setHead((head + count) & m_positionMask);
+   return count;
+}
+
+/**
+ * Sets the read position and wakes the waiting producers.
+ *
+ * The producer mutex is locked only if a producer waits.
+ *
+ * @param head  the new read position
+ */
+void ReGuiQueue::setHead(int head) {
+   m_head.fetchAndStoreOrdered(head);
+   if (m_waiting.fetchAndAddOrdered(0) > 0) {
+      QMutexLocker locker(&m_locker);
+      m_notFull.wakeAll();
+   }
+}
+
 /**
  * Takes the info from the instance and put it into the widget.
  *
@@ -12,6 +12,8 @@
 #ifndef REGUIQUEUE_HPP
 #define REGUIQUEUE_HPP
 
+#include <QWaitCondition>
+
 class ReGuiQueueItem {
 public:
    enum WidgetType {
@@ -70,15 +72,39 @@ public:
  * Qt allows manipulating GUI elements only in the main thread.
  * This queue allows the exchange of information from other threads.
  */
-class ReGuiQueue : protected QVector<ReGuiQueueItem> {
+class ReGuiQueue {
 public:
-   ReGuiQueue();
+   ReGuiQueue(int capacity = 64 * 1024);
+   ~ReGuiQueue();
+private:
+   // No copy constructor: no implementation!
+   ReGuiQueue(const ReGuiQueue& source);
+   // No assignment operator: no implementation!
+   ReGuiQueue& operator =(const ReGuiQueue& source);
 public:
    int count() const;
    ReGuiQueueItem popFront();
+   int popFront(QVector<ReGuiQueueItem>& items, int maxCount = 0x7fffffff);
    void pushBack(const ReGuiQueueItem& item);
+private:
+   void setHead(int head);
 protected:
+   // serializes the producers. The consumer does not lock
    QMutex m_locker;
+   // the ring buffer:
+   ReGuiQueueItem* m_items;
+   // count of entries in m_items: a power of 2
+   int m_capacity;
+   // the positions run from 0 to 2*m_capacity-1: full and empty differ
+   int m_positionMask;
+   // the next position to read. Changed only by the consumer
+   QAtomicInt m_head;
+   // the next position to write. Changed only by the producers
+   QAtomicInt m_tail;
+   // signaled by the consumer if a producer waits for a free slot
+   QWaitCondition m_notFull;
+   // the count of producers waiting for a free slot
+   QAtomicInt m_waiting;
 };
 
 #endif // REGUIQUEUE_HPP
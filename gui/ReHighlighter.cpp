@@ -0,0 +1,465 @@
+/*
+ * ReHighlighter.cpp
+ *
+ * (Un)License: Public Domain
+ * You can use and modify this file without any restriction.
+ * Do what you want.
+ * No warranties and disclaimer of any damages.
+ * More info: http://unlicense.org
+ * The latest sources: https://github.com/republib
+ */
+
+#include "base/rebase.hpp"
+#include "gui/regui.hpp"
+#include "expr/reexpr.hpp"
+
+#define CPP_KEYWORDS "alignas alignof asm auto bool break case catch char" \
+   " class const constexpr const_cast continue decltype default delete do" \
+   " double dynamic_cast else enum explicit export extern false float for" \
+   " friend goto if inline int long mutable namespace new noexcept nullptr" \
+   " operator private protected public register reinterpret_cast return" \
+   " short signed sizeof static static_assert static_cast struct switch" \
+   " template this thread_local throw true try typedef typeid typename" \
+   " union unsigned using virtual void volatile wchar_t while"
+/// \n separates the priority classes
+#define CPP_OPERATORS "; , :: : ? #\n" \
+   "= += -= *= /= %= &= |= ^= <<= >>=\n" \
+   "|| &&\n" \
+   "== != < > <= >=\n" \
+   "+ - * / % ! ~ & | ^ << >> ++ --\n" \
+   "-> . ->* .*\n" \
+   "( ) [ ] { }"
+
+/**
+ * Maps a line number of an older revision to the current revision.
+ *
+ * @param lineNo    the line number in the older revision
+ * @param changes   the changes since the older revision
+ * @return          -1: the line has been changed<br>
+ *                  otherwise: the line number in the current revision
+ */
+static int mapLine(int lineNo, const QList<ReLineChange>& changes) {
+   for (int ix = 0; lineNo >= 0 && ix < changes.length(); ix++) {
+      const ReLineChange& change = changes.at(ix);
+      if (lineNo >= change.m_lineNo + change.m_oldCount)
+         lineNo += change.m_newCount - change.m_oldCount;
+      else if (lineNo >= change.m_lineNo)
+         lineNo = -1;
+   }
+   return lineNo;
+}
+
+/**
+ * Constructor.
+ */
+ReHighlightJob::ReHighlightJob() :
+   m_lines(),
+   m_revision(0),
+   m_changes(),
+   m_complete(false),
+   m_generation(0) {
+}
+
+/**
+ * Constructor.
+ *
+ * @param edit  the edit field to highlight
+ * @param lexer the lexer for the language, created without source.
+ *              Will be freed in the destructor
+ */
+ReHighlighter::ReHighlighter(ReEdit* edit, ReLexer* lexer) :
+   QThread(),
+   ReParagraphBuilder(),
+   m_edit(edit),
+   m_lexer(lexer),
+   m_spans(),
+   m_revision(-1),
+   m_generation(0),
+   m_lines(),
+   m_endStates(),
+   m_threadRevision(0),
+   m_threadGeneration(0),
+   m_next(-1),
+   m_mutex(),
+   m_condition(),
+   m_job(),
+   m_hasJob(false),
+   m_results(),
+   m_stop(0) {
+}
+
+/**
+ * Destructor.
+ */
+ReHighlighter::~ReHighlighter() {
+   stop();
+   wait();
+   delete m_lexer;
+   m_lexer = NULL;
+}
+
+/**
+ * Moves the spans of the lines behind the changed lines.
+ *
+ * The spans of changed lines remain until the new spans are available:
+ * this prevents flickering while typing.
+ *
+ * @param changes   the changes of the lines since the last call
+ */
+void ReHighlighter::applyChanges(const QList<ReLineChange>& changes) {
+   for (int ix = 0; ix < changes.length(); ix++) {
+      const ReLineChange& change = changes.at(ix);
+      int start = min(change.m_lineNo
+                      + min(change.m_oldCount, change.m_newCount), m_spans.size());
+      int diff = change.m_newCount - change.m_oldCount;
+      if (diff < 0)
+         m_spans.remove(start, min(-diff, m_spans.size() - start));
+      else if (diff > 0)
+         m_spans.insert(start, diff, QVector<ReHighlightSpan>());
+   }
+}
+
+/**
+ * Changes the presentation of the tokens in a paragraph.
+ *
+ * Only the standard texts (not the tabulators) will be changed.
+ *
+ * @param paragraph the paragraph to change
+ * @param lineNo    the line number (0..N-1) of the paragraph in the source
+ * @param edit      the parent, the edit field
+ */
+void ReHighlighter::buildParagraph(ReParagraph& paragraph, int lineNo,
+                                   ReEdit* edit) {
+   if (lineNo < 0 || lineNo >= m_spans.size() || m_spans.at(lineNo).isEmpty())
+      return;
+   const QVector<ReHighlightSpan>& spans = m_spans.at(lineNo);
+   const QString& text = edit->lines().lineAt(lineNo);
+   // the spans are indexes in the line, the texts have expanded tabulators:
+   QVector<int> starts;
+   QVector<int> ends;
+   int ixSpan = 0;
+   int col = 0;
+   int tabWidth = ReEdit::tabString(0).length();
+   for (int ix = 0; ix <= text.length() && ixSpan < spans.size(); ix++) {
+      const ReHighlightSpan& span = spans.at(ixSpan);
+      if (ix == span.m_start)
+         starts.append(col);
+      if (ix == span.m_start + span.m_length) {
+         ends.append(col);
+         ixSpan++;
+         // the next span may start at the end of the current:
+         if (ixSpan < spans.size() && spans.at(ixSpan).m_start == ix)
+            starts.append(col);
+      }
+      if (ix < text.length())
+         col += text.at(ix) == '\t' ? tabWidth - col % tabWidth : 1;
+   }
+   col = edit->firstCol();
+   ixSpan = 0;
+   for (int ix = 0; ix < paragraph.length(); ix++) {
+      ReEditText* current = paragraph.at(ix);
+      ReLook* look = current->look();
+      int length = current->text().length();
+      if (look->m_foreground == ReLook::FG_STANDARD) {
+         QString piece = current->text();
+         int start = 0;
+         while (start < length && ixSpan < ends.size()) {
+            if (ends.at(ixSpan) <= col + start) {
+               ixSpan++;
+               continue;
+            }
+            int startSpan = starts.at(ixSpan) - col;
+            int end = min(length, ends.at(ixSpan) - col);
+            ReLook::ForeGround foreground = spans.at(ixSpan).m_foreground;
+            if (startSpan > start) {
+               // the text in front of the span remains:
+               end = min(length, startSpan);
+               foreground = ReLook::FG_STANDARD;
+            }
+            ReLook* look2 = edit->lookOf(foreground, look->m_background);
+            if (start == 0)
+               current->set(piece.mid(0, end), look2);
+            else
+               paragraph.insert(++ix, edit->allocText(piece.mid(start,
+                                                      end - start), look2));
+            start = end;
+         }
+         if (start > 0 && start < length)
+            paragraph.insert(++ix, edit->allocText(piece.mid(start),
+                                                   look));
+      }
+      col += length;
+   }
+}
+
+/**
+ * Creates a lexer for the language of a file.
+ *
+ * @param filename  the name of the file: the extension defines the language
+ * @return          NULL: unknown language<br>
+ *                  otherwise: a lexer in line mode (without source)
+ */
+ReLexer* ReHighlighter::createLexer(const QString& filename) {
+   ReLexer* rc = NULL;
+   QString extension = QFileInfo(filename).suffix().toLower();
+   if (extension == "mf")
+      rc = new ReLexer(NULL, MF_KEYWORDS, MF_OPERATORS, MF_RIGHT_ASSOCIATIVES,
+                       "/* */ // \n", "a-zA-Z_", "a-zA-Z0-9_",
+                       ReLexer::NUMTYPE_ALL, ReLexer::SF_LIKE_C);
+   else if (extension == "cpp" || extension == "hpp" || extension == "c"
+            || extension == "h" || extension == "cc" || extension == "hh"
+            || extension == "cxx" || extension == "hxx")
+      rc = new ReLexer(NULL, CPP_KEYWORDS, CPP_OPERATORS, "= += -= *= /=",
+                       "/* */ // \n", "a-zA-Z_", "a-zA-Z0-9_",
+                       ReLexer::NUMTYPE_ALL, ReLexer::SF_LIKE_C);
+   return rc;
+}
+
+/**
+ * Scans a line and finds the spans with a syntax specific presentation.
+ *
+ * @param line  the line to scan
+ * @param state the lexer state at the start of the line
+ * @param spans OUT: the spans with a non standard presentation
+ * @return      the lexer state at the end of the line
+ */
+int ReHighlighter::highlightLine(const QString& line, int state,
+                                 QVector<ReHighlightSpan>& spans) {
+   // one byte per char: the token positions are the indexes of the line
+   QByteArray input;
+   input.resize(line.length());
+   for (int ix = 0; ix < line.length(); ix++) {
+      ushort cc = line.at(ix).unicode();
+      // non ASCII chars are treated like letters:
+      input[ix] = cc < 128 ? char(cc) : 'x';
+   }
+   QVector<ReTokenSpan> tokens;
+   int rc = m_lexer->scanLine(input, state, tokens);
+   spans.clear();
+   ReHighlightSpan span;
+   for (int ix = 0; ix < tokens.size(); ix++) {
+      const ReTokenSpan& token = tokens.at(ix);
+      switch (token.m_type) {
+      case TOKEN_KEYWORD:
+         span.m_foreground = ReLook::FG_BLUE_DARK;
+         break;
+      case TOKEN_STRING:
+         span.m_foreground = ReLook::FG_MAGENTA_DARK;
+         break;
+      case TOKEN_NUMBER:
+      case TOKEN_REAL:
+         span.m_foreground = ReLook::FG_CYAN_DARK;
+         break;
+      case TOKEN_COMMENT_START:
+      case TOKEN_COMMENT_REST_OF_LINE:
+         span.m_foreground = ReLook::FG_GREEN_DARK;
+         break;
+      case TOKEN_UNDEF:
+         span.m_foreground = ReLook::FG_RED_DARK;
+         break;
+      default:
+         span.m_foreground = ReLook::FG_STANDARD;
+         break;
+      }
+      if (span.m_foreground != ReLook::FG_STANDARD && token.m_length > 0) {
+         span.m_start = token.m_start;
+         span.m_length = token.m_length;
+         spans.append(span);
+      }
+   }
+   return rc;
+}
+
+/**
+ * Highlights the next part of the lines (thread only).
+ *
+ * Only lines with an unknown end state are scanned and their successors as
+ * long as the start state differs from the last scan.
+ */
+void ReHighlighter::highlightSome() {
+   // the number of scanned lines between two publications:
+   static const int BATCH_SIZE = 500;
+   QList<ReHighlightLine> results;
+   int count = m_lines.size();
+   int lineNo = m_next;
+   bool mustScan = false;
+   while (lineNo < count && results.size() < BATCH_SIZE) {
+      if (m_endStates.at(lineNo) >= 0 && !mustScan) {
+         lineNo++;
+         continue;
+      }
+      int state = lineNo == 0 ? 0 : m_endStates.at(lineNo - 1);
+      ReHighlightLine line;
+      line.m_generation = m_threadGeneration;
+      line.m_revision = m_threadRevision;
+      line.m_lineNo = lineNo;
+      int endState = highlightLine(m_lines.at(lineNo), state, line.m_spans);
+      results.append(line);
+      // the state has converged if the next line starts as in the last scan:
+      mustScan = m_endStates.at(lineNo) != endState;
+      m_endStates[lineNo] = endState;
+      lineNo++;
+   }
+   if (lineNo < count) {
+      m_next = lineNo;
+      if (mustScan)
+         m_endStates[lineNo] = -1;
+   } else {
+      m_next = -1;
+      // a copy held by the thread would force a deep copy in the next edit:
+      m_lines.clear();
+   }
+   publish(results);
+}
+
+/**
+ * Transfers the lines changed since the last call to the highlighter thread
+ * and takes the results of the thread.
+ *
+ * Will be called in the GUI thread at the start of the paragraph loading.
+ *
+ * @param edit  the parent, the edit field
+ */
+void ReHighlighter::prepareLoad(ReEdit* edit) {
+   ReLines& lines = edit->lines();
+   if (lines.revision() != m_revision) {
+      QList<ReLineChange> changes;
+      bool complete = m_revision >= 0
+                      && lines.changesSince(m_revision, changes);
+      if (complete)
+         applyChanges(changes);
+      else {
+         m_spans.clear();
+         m_spans.resize(lines.lineCount());
+      }
+      m_revision = lines.revision();
+      QMutexLocker locker(&m_mutex);
+      // a waiting job has not been seen by the thread: the changes are added
+      if (m_hasJob && m_job.m_complete && m_job.m_generation == m_generation)
+         m_job.m_changes.append(changes);
+      else {
+         complete = complete && !m_hasJob;
+         m_job.m_changes = changes;
+      }
+      m_job.m_complete = complete;
+      m_job.m_lines = lines.snapshot();
+      m_job.m_revision = m_revision;
+      m_job.m_generation = m_generation;
+      m_hasJob = true;
+      m_condition.wakeOne();
+   }
+   QList<ReHighlightLine> results;
+   {
+      QMutexLocker locker(&m_mutex);
+      results = m_results;
+      m_results.clear();
+   }
+   QList<ReLineChange> changes;
+   int lastRevision = -1;
+   bool valid = false;
+   for (int ix = 0; ix < results.length(); ix++) {
+      const ReHighlightLine& result = results.at(ix);
+      if (result.m_generation != m_generation)
+         continue;
+      if (result.m_revision != lastRevision) {
+         lastRevision = result.m_revision;
+         valid = lines.changesSince(lastRevision, changes);
+      }
+      int lineNo = valid ? mapLine(result.m_lineNo, changes) : -1;
+      if (lineNo >= 0 && lineNo < m_spans.size()) {
+         m_spans[lineNo] = result.m_spans;
+         edit->invalidate(lineNo, 1);
+      }
+   }
+}
+
+/**
+ * Makes the results available for the GUI thread.
+ *
+ * @param results   the highlighted lines
+ */
+void ReHighlighter::publish(QList<ReHighlightLine>& results) {
+   if (!results.isEmpty()) {
+      {
+         QMutexLocker locker(&m_mutex);
+         m_results.append(results);
+      }
+      // the results will be taken in the next paint event:
+      QMetaObject::invokeMethod(m_edit, "update", Qt::QueuedConnection);
+   }
+}
+
+/**
+ * The main loop of the highlighter thread.
+ */
+void ReHighlighter::run() {
+   while (!m_stop.loadAcquire()) {
+      {
+         QMutexLocker locker(&m_mutex);
+         while (!m_stop.loadAcquire() && !m_hasJob && m_next < 0)
+            m_condition.wait(&m_mutex);
+         if (m_hasJob)
+            takeJob();
+      }
+      if (!m_stop.loadAcquire() && m_next >= 0)
+         highlightSome();
+   }
+}
+
+/**
+ * Starts a new highlighting because the text source has been changed.
+ *
+ * @param lines the new text source
+ */
+void ReHighlighter::setLines(ReLines* lines) {
+   ReUseParameter(lines);
+   m_revision = -1;
+   m_generation++;
+   m_spans.clear();
+}
+
+/**
+ * Stops the highlighter thread.
+ */
+void ReHighlighter::stop() {
+   QMutexLocker locker(&m_mutex);
+   m_stop.storeRelease(1);
+   m_condition.wakeAll();
+}
+
+/**
+ * Takes the waiting job (thread only).
+ *
+ * precondition: m_mutex is locked
+ */
+void ReHighlighter::takeJob() {
+   int first = 0;
+   if (!m_job.m_complete || m_job.m_generation != m_threadGeneration) {
+      m_endStates.fill(-1, m_job.m_lines.size());
+   } else {
+      first = m_endStates.size();
+      for (int ix = 0; ix < m_job.m_changes.length(); ix++) {
+         const ReLineChange& change = m_job.m_changes.at(ix);
+         int lineNo = min(change.m_lineNo, m_endStates.size());
+         m_endStates.remove(lineNo, min(change.m_oldCount,
+                                        m_endStates.size() - lineNo));
+         m_endStates.insert(lineNo, change.m_newCount, -1);
+         // the start state of the successor may be changed:
+         if (lineNo + change.m_newCount < m_endStates.size())
+            m_endStates[lineNo + change.m_newCount] = -1;
+         first = min(first, lineNo);
+      }
+      // protection against inconsistent changes:
+      while (m_endStates.size() < m_job.m_lines.size())
+         m_endStates.append(-1);
+      m_endStates.resize(m_job.m_lines.size());
+   }
+   m_lines = m_job.m_lines;
+   m_threadRevision = m_job.m_revision;
+   m_threadGeneration = m_job.m_generation;
+   m_job.m_lines.clear();
+   m_job.m_changes.clear();
+   m_hasJob = false;
+   // unfinished work: the lines marked with -1 must be found again:
+   m_next = m_next >= 0 ? 0 : min(first, m_lines.size());
+}
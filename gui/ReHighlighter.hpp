@@ -0,0 +1,121 @@
+/*
+ * ReHighlighter.hpp
+ *
+ * (Un)License: Public Domain
+ * You can use and modify this file without any restriction.
+ * Do what you want.
+ * No warranties and disclaimer of any damages.
+ * More info: http://unlicense.org
+ * The latest sources: https://github.com/republib
+ */
+
+#ifndef REHIGHLIGHTER_HPP
+#define REHIGHLIGHTER_HPP
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
+
+class ReLexer;
+
+/**
+ * A piece of a line with a syntax specific presentation.
+ */
+class ReHighlightSpan {
+public:
+   // the index of the first char in the line
+   int m_start;
+   int m_length;
+   ReLook::ForeGround m_foreground;
+};
+
+/**
+ * The spans of one line found by the highlighter thread.
+ */
+class ReHighlightLine {
+public:
+   // the generation of the text source (see ReHighlighter::setLines())
+   int m_generation;
+   // the revision of the lines the line number belongs to
+   int m_revision;
+   int m_lineNo;
+   QVector<ReHighlightSpan> m_spans;
+};
+
+/**
+ * The lines to highlight, passed from the edit field to the highlighter thread.
+ */
+class ReHighlightJob {
+public:
+   ReHighlightJob();
+public:
+   QStringList m_lines;
+   int m_revision;
+   // the changes since the last job
+   QList<ReLineChange> m_changes;
+   // false: m_changes is incomplete: all lines must be highlighted
+   bool m_complete;
+   int m_generation;
+};
+
+/**
+ * A syntax highlighter running in a background thread.
+ *
+ * The lexer stores the lexer state at the end of each line. After an edit
+ * only the changed lines are scanned again and the following lines as long
+ * as their start state differs from the stored one.
+ *
+ * The found token spans are published to the GUI thread: the paint path
+ * (<code>buildParagraph()</code>) only reads them.
+ */
+class ReHighlighter: public QThread, public ReParagraphBuilder {
+public:
+   ReHighlighter(ReEdit* edit, ReLexer* lexer);
+   ~ReHighlighter();
+public:
+   virtual void buildParagraph(ReParagraph& paragraph, int lineNo,
+                               ReEdit* edit);
+   virtual void prepareLoad(ReEdit* edit);
+   virtual void run();
+   virtual void setLines(ReLines* lines);
+   void stop();
+public:
+   static ReLexer* createLexer(const QString& filename);
+protected:
+   void applyChanges(const QList<ReLineChange>& changes);
+   int highlightLine(const QString& line, int state,
+                     QVector<ReHighlightSpan>& spans);
+   void highlightSome();
+   void publish(QList<ReHighlightLine>& results);
+   void takeJob();
+protected:
+   ReEdit* m_edit;
+   ReLexer* m_lexer;
+   // GUI thread only:
+   /// the spans of each line (index: line number)
+   QVector<QVector<ReHighlightSpan> > m_spans;
+   /// the revision of the lines the spans belong to. -1: not initialized
+   int m_revision;
+   /// incremented with each new text source
+   int m_generation;
+   // thread only:
+   /// the lines of the current job
+   QStringList m_lines;
+   /// the lexer state at the end of each line. -1: must be scanned
+   QVector<int> m_endStates;
+   /// the revision of m_lines
+   int m_threadRevision;
+   int m_threadGeneration;
+   /// the line to continue the highlighting. -1: nothing to do
+   int m_next;
+   // shared, protected by m_mutex:
+   QMutex m_mutex;
+   QWaitCondition m_condition;
+   ReHighlightJob m_job;
+   bool m_hasJob;
+   QList<ReHighlightLine> m_results;
+   /// 1: the thread must stop. Read by run() without the lock
+   QAtomicInt m_stop;
+};
+
+#endif // REHIGHLIGHTER_HPP
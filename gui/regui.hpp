@@ -19,8 +19,10 @@
 #include "gui/ReStateStorage.hpp"
 #include "gui/ReGuiValidator.hpp"
 #include "gui/ReEdit.hpp"
+#include "gui/ReHighlighter.hpp"
 #include "gui/ReSettings.hpp"
 #include "gui/ReFileTree.hpp"
+#include "gui/ReFileTableModel.hpp"
 /**
  * Tests whether a point is inside the rectangle (including border).
  * @param rect  rectangle to test
@@ -21,7 +21,8 @@ ReFileTable::ReFileTable(QWidget* parent) :
    pushButtonDevice(new QPushButton("...", this)),
    pushButtonUp(new QPushButton("^", this)),
    pushButtonRoot(new QPushButton("/", this)),
-   tableWidget(new QTableWidget(this)),
+   tableWidget(new QTableView(this)),
+   model(NULL),
    fileSystem(NULL),
    matcher("*"),
    m_dateFormat("yyyy.MM.dd hh:mm:ss"),
@@ -47,7 +48,18 @@ ReFileTable::ReFileTable(QWidget* parent) :
    labels.append(tr("Modified"));
    labels.append(tr("Size"));
    labels.append(tr("Name"));
-   tableWidget->setColumnCount(COL_COUNT);
+   QList<ReFileTableModel::Column> columns;
+   // TYPE, MODIFIED, SIZE, NAME
+   columns << ReFileTableModel::COL_EXT_OR_DIR << ReFileTableModel::COL_MODIFIED
+           << ReFileTableModel::COL_SIZE << ReFileTableModel::COL_NODE;
+   model = new ReFileTableModel(columns, this);
+   model->setDateFormat(m_dateFormat);
+   model->setHeaderLabels(labels);
+   tableWidget->setModel(model);
+   // rows of equal height: scrolling does not need to measure all rows
+   tableWidget->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+   tableWidget->verticalHeader()->setDefaultSectionSize(
+      tableWidget->fontMetrics().height() + 6);
    tableWidget->setColumnWidth(TYPE, 60);
    tableWidget->setColumnWidth(SIZE, 125);
    tableWidget->setColumnWidth(MODIFIED, 175);
@@ -57,11 +69,11 @@ ReFileTable::ReFileTable(QWidget* parent) :
    tableWidget->setAcceptDrops(true);
    connect(pushButtonUp, SIGNAL(clicked()), SLOT(pushButtonUpClicked()));
    connect(pushButtonRoot, SIGNAL(clicked()), SLOT(pushButtonRootClicked()));
-   connect(tableWidget, SIGNAL(cellDoubleClicked(int, int)), this,
-           SLOT(tableDoubleClicked(int, int)));
-   tableWidget->setHorizontalHeaderLabels(labels);
+   connect(tableWidget, SIGNAL(doubleClicked(const QModelIndex&)), this,
+           SLOT(tableDoubleClicked(const QModelIndex&)));
    tableWidget->horizontalHeader()->setStretchLastSection(true);
    tableWidget->setSelectionMode(QAbstractItemView::ExtendedSelection);
+   tableWidget->setSelectionBehavior(QAbstractItemView::SelectRows);
 }
 
 /**
@@ -103,11 +115,7 @@ QString ReFileTable::buildAbsPath(int row, bool withNode, bool uriFormat) {
  * @return      the text of the given cell
  */
 QString ReFileTable::cellAsText(int row, int col) {
-   QTableWidgetItem* widget = tableWidget->item(row, col);
-   QString rc;
-   if (widget != NULL)
-      rc = widget->text();
-   return rc;
+   return model->cellText(row, col);
 }
 
 /**
@@ -117,14 +125,13 @@ void ReFileTable::fileDragging() {
    QDrag* drag = new QDrag(this);
    QMimeData* mimeData = new QMimeData;
    QList < QUrl > urls;
-   QList < QTableWidgetSelectionRange > ranges =
-      tableWidget->selectedRanges();
-   QList <QTableWidgetSelectionRange>::iterator it;
+   QItemSelection ranges = tableWidget->selectionModel()->selection();
+   QItemSelection::const_iterator it;
    int files = 0;
    int dirs = 0;
    bool isDir = false;
    for (it = ranges.begin(); it != ranges.end(); ++it) {
-      for (int row = (*it).topRow(); row <= (*it).bottomRow(); row++) {
+      for (int row = (*it).top(); row <= (*it).bottom(); row++) {
          isDir = cellAsText(row, SIZE).isEmpty();
          QUrl url(buildAbsPath(row, true, true));
          urls.append(url);
@@ -195,13 +202,12 @@ void ReFileTable::copyToClipboard(int currentRow, const QString& full) {
    QMimeData* mimeData = new QMimeData;
    QList < QUrl > urls;
    bool isInSelection = currentRow == -1;
-   QList < QTableWidgetSelectionRange > ranges =
-      tableWidget->selectedRanges();
-   QList <QTableWidgetSelectionRange>::iterator it;
+   QItemSelection ranges = tableWidget->selectionModel()->selection();
+   QItemSelection::const_iterator it;
    QString textList;
-   textList.reserve(tableWidget->rowCount() * 80);
+   textList.reserve(model->rowCount() * 80);
    for (it = ranges.begin(); it != ranges.end(); ++it) {
-      for (int row = (*it).topRow(); row <= (*it).bottomRow(); row++) {
+      for (int row = (*it).top(); row <= (*it).bottom(); row++) {
          if (currentRow != -1)
             isInSelection = isInSelection || row == currentRow;
          QString name(buildAbsPath(row, true));
@@ -242,41 +248,24 @@ void ReFileTable::dropEvent(QDropEvent* event) {
 
 /**
  * Fills the table with the file data of the filesystem.
+ *
+ * Only the raw data are stored: the cells are formatted by the model
+ * when they become visible.
  */
 void ReFileTable::fillTable() {
    if (fileSystem != NULL) {
       ReFileMetaDataList list;
       fileSystem->listInfos(matcher, list);
       ReFileMetaDataList::const_iterator it;
-      tableWidget->setRowCount(list.length());
-      int row = 0;
+      ReFileResultStore store;
+      store.reserve(list.length());
       for (it = list.cbegin(); it != list.cend(); ++it) {
          bool isDir = S_ISDIR(it->m_mode);
-         QString modified = it->m_modified.toString(m_dateFormat);
-         QString size = isDir ? ReQStringUtils::m_empty : QString::number(it->m_size);
-         QString ext = isDir ? tr("<dir>") : ReFileUtils::extensionOf(it->m_node);
-         if (tableWidget->item(row, 0) == NULL) {
-            QTableWidgetItem* item = new QTableWidgetItem(it->m_node);
-            item->setFlags(item->flags() ^ Qt::ItemIsEditable);
-            tableWidget->setItem(row, NAME, item);
-            item = new QTableWidgetItem(modified);
-            item->setFlags(item->flags() ^ Qt::ItemIsEditable);
-            tableWidget->setItem(row, MODIFIED, item);
-            item = new QTableWidgetItem(ext);
-            item->setFlags(item->flags() ^ Qt::ItemIsEditable);
-            tableWidget->setItem(row, TYPE, item);
-            item = new QTableWidgetItem(size);
-            item->setFlags(item->flags() ^ Qt::ItemIsEditable);
-            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-            tableWidget->setItem(row, SIZE, item);
-         } else {
-            tableWidget->item(row, NAME)->setText(it->m_node);
-            tableWidget->item(row, MODIFIED)->setText(modified);
-            tableWidget->item(row, TYPE)->setText(ext);
-            tableWidget->item(row, SIZE)->setText(size);
-         }
-         row++;
+         store.add(it->m_node, ReQStringUtils::m_empty, it->m_size,
+                   it->m_modified.toMSecsSinceEpoch(),
+                   isDir ? ReFileResultStore::FT_DIR : ReFileResultStore::FT_FILE);
       }
+      model->setStore(store);
    }
 }
 
@@ -339,7 +328,7 @@ void ReFileTable::keyPressEvent(QKeyEvent* event) {
          changePatterns(comboBoxPatterns->currentText());
    } else if (sender == tableWidget) {
       if (key == Qt::Key_Return && modifiers == Qt::NoModifier)
-         openEntry(tableWidget->currentRow());
+         openEntry(tableWidget->currentIndex().row());
       else if (key == Qt::Key_C && modifiers == Qt::ControlModifier)
          copyToClipboard();
    }
@@ -351,8 +340,10 @@ void ReFileTable::keyPressEvent(QKeyEvent* event) {
  * @param row	the row containing the entry to open
  */
 void ReFileTable::openEntry(int row) {
-   bool isDir = tableWidget->item(row, TYPE)->text().startsWith('<');
-   QString node = tableWidget->item(row, NAME)->text();
+   if (row < 0 || row >= model->rowCount())
+      return;
+   bool isDir = model->store().isDir(model->record(row));
+   QString node = cellAsText(row, NAME);
    if (isDir) {
       changeDirectory(fileSystem->directory() + node);
    } else {
@@ -393,9 +384,8 @@ bool ReFileTable::say(ReLoggerLevel level, const QString& message) {
 /**
  * Handles the double click of a table cell.
  *
- * @param row		the row of the cell has been clicked
- * @param column	the column of the cell has been clicked
+ * @param index		the cell which has been clicked
  */
-void ReFileTable::tableDoubleClicked(int row, int column) {
-   openEntry(row);
+void ReFileTable::tableDoubleClicked(const QModelIndex& index) {
+   openEntry(index.row());
 }
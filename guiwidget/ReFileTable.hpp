@@ -36,7 +36,7 @@ public:
    virtual void fileDragging();
    virtual void keyPressEvent(QKeyEvent* event);
 public slots:
-   void tableDoubleClicked(int row, int column);
+   void tableDoubleClicked(const QModelIndex& index);
    void pushButtonUpClicked();
    void pushButtonRootClicked();
 protected:
@@ -57,7 +57,8 @@ public:
    QPushButton* pushButtonDevice;
    QPushButton* pushButtonUp;
    QPushButton* pushButtonRoot;
-   QTableWidget* tableWidget;
+   QTableView* tableWidget;
+   ReFileTableModel* model;
    ReFileSystem* fileSystem;
    ReIncludeExcludeMatcher matcher;
    ReAnnouncer* announcer;
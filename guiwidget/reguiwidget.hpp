@@ -26,7 +26,7 @@
 #include "QPushButton"
 #include "QHBoxLayout"
 #include "QVBoxLayout"
-#include "QTableWidget"
+#include "QTableView"
 #include "QHeaderView"
 #include "QKeyEvent"
 #include "QApplication"
@@ -19,6 +19,45 @@
 
 #include "base/rebase.hpp"
 #include "math/remath.hpp"
+#include <QThreadPool>
+#include <QRunnable>
+#if defined __AVX2__ && defined __FMA__ && ! defined QT_COORD_TYPE
+// qreal is double: the AVX2 kernel can be used
+#define RPL_MATRIX_AVX2
+#include <immintrin.h>
+#endif
+
+// the edge length of the blocks: a block of doubles fits into the L1 cache
+static const int BLOCK_SIZE = 64;
+// below this count of multiplications the work is done in one thread:
+static const double MIN_PARALLEL_OPERATIONS = 2.0 * 1000 * 1000;
+
+/**
+ * Multiplies some rows of two matrices in a thread of a pool.
+ */
+class RplMatrixMultiplyTask: public QRunnable {
+public:
+   RplMatrixMultiplyTask(const RplMatrix& left, const RplMatrix& right,
+                         RplMatrix& result, int firstRow, int lastRow) :
+      QRunnable(),
+      m_left(left),
+      m_right(right),
+      m_result(result),
+      m_firstRow(firstRow),
+      m_lastRow(lastRow) {
+   }
+public:
+   virtual void run() {
+      RplMatrix::multiplyRows(m_left, m_right, m_result, m_firstRow,
+                              m_lastRow);
+   }
+private:
+   const RplMatrix& m_left;
+   const RplMatrix& m_right;
+   RplMatrix& m_result;
+   int m_firstRow;
+   int m_lastRow;
+};
 
 RplMatrixException::RplMatrixException(const RplMatrix& RplMatrix,
                                        const char* format, ...) :
@@ -60,7 +99,7 @@ RplMatrix::RplMatrix(int rows, int cols, const char* name) :
  * Destructor.
  */
 RplMatrix::~RplMatrix() {
-   delete m_values;
+   delete[] m_values;
    m_values = NULL;
 }
 
@@ -77,6 +116,25 @@ RplMatrix::RplMatrix(const RplMatrix& source) :
    resize(source.m_rows, source.m_cols, source.m_values);
 }
 
+/**
+ * Adds a scaled matrix to the instance: this += factor * operand.
+ *
+ * The operation is done in one pass.
+ *
+ * @param operand   the matrix to add
+ * @param factor    the factor of the operand
+ * @return          the instance itself
+ */
+RplMatrix& RplMatrix::addScaled(const RplMatrix& operand, MatVal factor) {
+   checkSameDimension(operand);
+   MatVal* values = m_values;
+   const MatVal* values2 = operand.m_values;
+   for (int ix = m_rows * m_cols - 1; ix >= 0; ix--) {
+      values[ix] += factor * values2[ix];
+   }
+   return *this;
+}
+
 /**
  * Checks the validity of the definition parameters.
  *
@@ -227,6 +285,67 @@ RplMatrix RplMatrix::operator -(MatVal scalar) {
    rc -= scalar;
    return rc;
 }
+/**
+ * Multiplies the instance with a scalar.
+ *
+ * @param scalar	the factor
+ * @return			the instance itself
+ */
+RplMatrix& RplMatrix::operator *=(MatVal scalar) {
+   for (int ix = m_rows * m_cols - 1; ix >= 0; ix--) {
+      m_values[ix] *= scalar;
+   }
+   return *this;
+}
+/**
+ * Builds the product of the instance and a given scalar.
+ *
+ * @param scalar	the factor
+ * @return			a new matrix with the product
+ */
+RplMatrix RplMatrix::operator *(MatVal scalar) const {
+   RplMatrix rc(*this);
+   rc *= scalar;
+   return rc;
+}
+/**
+ * Builds the matrix product of the instance and a given matrix.
+ *
+ * The work is done in cache sized blocks. Large matrices are multiplied
+ * by a thread pool: each thread calculates a range of rows.
+ *
+ * @param operand	the right factor. Its row count must be the column count
+ *                  of the instance
+ * @return			a new matrix with the product
+ * @throws RplMatrixException
+ */
+RplMatrix RplMatrix::operator *(const RplMatrix& operand) const {
+   if (m_cols != operand.m_rows)
+      throw RplMatrixException(*this,
+                               "%s has a wrong row count: %d instead of %d",
+                               operand.getName().constData(), operand.m_rows, m_cols);
+   RplMatrix rc;
+   rc.resize(m_rows, operand.m_cols);
+   int threads = QThread::idealThreadCount();
+   if (threads <= 1 || m_rows < 2 * threads
+         || double(m_rows) * m_cols * operand.m_cols < MIN_PARALLEL_OPERATIONS)
+      multiplyRows(*this, operand, rc, 0, m_rows);
+   else {
+      QThreadPool pool;
+      pool.setMaxThreadCount(threads);
+      // the row ranges are multiples of the block size if possible:
+      int rowsPerTask = (m_rows + threads - 1) / threads;
+      if (rowsPerTask > BLOCK_SIZE)
+         rowsPerTask = (rowsPerTask + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+      for (int row = 0; row < m_rows; row += rowsPerTask) {
+         int lastRow = row + rowsPerTask;
+         pool.start(new RplMatrixMultiplyTask(*this, operand, rc, row,
+                                              lastRow < m_rows ? lastRow : m_rows));
+      }
+      pool.waitForDone();
+   }
+   return rc;
+}
 /**
  * Tests the equiness of the instance with a given matrix.
  *
@@ -269,7 +388,7 @@ RplMatrix& RplMatrix::resize(int rows, int cols, const MatVal values[],
                              MatVal defaultValue) {
    checkDefinition(rows, cols);
    if (rows != m_rows || cols != m_cols) {
-      delete m_values;
+      delete[] m_values;
       m_values = new MatVal[rows * cols];
       m_rows = rows;
       m_cols = cols;
@@ -306,16 +425,89 @@ Tuple2 RplMatrix::minMax() const {
    return rc;
 }
 
+/**
+ * Multiplies a range of rows: result[rows] += left[rows] * right.
+ *
+ * The multiplication is done in blocks which fit into the cache.
+ * The innermost loop runs over contiguous memory (the rows of
+ * <code>right</code> and <code>result</code>), so it can be vectorized.
+ *
+ * @param left      the left factor
+ * @param right     the right factor
+ * @param result    IN/OUT: the product. Must be initialized with 0
+ * @param firstRow  the first row of the range
+ * @param lastRow   the row behind the range
+ */
+void RplMatrix::multiplyRows(const RplMatrix& left, const RplMatrix& right,
+                             RplMatrix& result, int firstRow, int lastRow) {
+   int inner = left.m_cols;
+   int cols = right.m_cols;
+   for (int row0 = firstRow; row0 < lastRow; row0 += BLOCK_SIZE) {
+      int rowEnd = min(row0 + BLOCK_SIZE, lastRow);
+      for (int inner0 = 0; inner0 < inner; inner0 += BLOCK_SIZE) {
+         int innerEnd = min(inner0 + BLOCK_SIZE, inner);
+         for (int col0 = 0; col0 < cols; col0 += BLOCK_SIZE) {
+            int colEnd = min(col0 + BLOCK_SIZE, cols);
+            for (int row = row0; row < rowEnd; row++) {
+               MatVal* target = result.row(row);
+               const MatVal* source = left.row(row);
+               for (int ix = inner0; ix < innerEnd; ix++) {
+                  MatVal factor = source[ix];
+                  const MatVal* source2 = right.row(ix);
+                  int col = col0;
+#if defined RPL_MATRIX_AVX2
+                  __m256d factor4 = _mm256_set1_pd(factor);
+                  for (; col + 4 <= colEnd; col += 4)
+                     _mm256_storeu_pd(target + col,
+                                      _mm256_fmadd_pd(factor4, _mm256_loadu_pd(source2 + col),
+                                            _mm256_loadu_pd(target + col)));
+#endif
+                  for (; col < colEnd; col++)
+                     target[col] += factor * source2[col];
+               }
+            }
+         }
+      }
+   }
+}
+
+/**
+ * Replaces each element x by factor * x + summand.
+ *
+ * The operation is done in one pass.
+ *
+ * @param factor    the factor
+ * @param summand   the value to add after the multiplication
+ * @return          the instance itself
+ */
+RplMatrix& RplMatrix::scaleAndShift(MatVal factor, MatVal summand) {
+   for (int ix = m_rows * m_cols - 1; ix >= 0; ix--) {
+      m_values[ix] = factor * m_values[ix] + summand;
+   }
+   return *this;
+}
+
 /**
  * Builds a matrix with exchanged rows and cols.
  *
+ * The work is done in tiles: both the source and the target tile
+ * remain in the cache.
+ *
  * @return	the transposed matrix
  */
 RplMatrix RplMatrix::transpose() const {
+   // a tile of 32x32 doubles: 8 KiByte
+   static const int TILE_SIZE = 32;
    RplMatrix rc(m_cols, m_rows);
-   for (int row = 0; row < m_rows; row++) {
-      for (int col = 0; col < m_cols; col++) {
-         rc.m_values[m_rows * col + row] = m_values[row * m_cols + col];
+   for (int row0 = 0; row0 < m_rows; row0 += TILE_SIZE) {
+      int rowEnd = min(row0 + TILE_SIZE, m_rows);
+      for (int col0 = 0; col0 < m_cols; col0 += TILE_SIZE) {
+         int colEnd = min(col0 + TILE_SIZE, m_cols);
+         for (int row = row0; row < rowEnd; row++) {
+            const MatVal* source = m_values + row * m_cols;
+            for (int col = col0; col < colEnd; col++)
+               rc.m_values[m_rows * col + row] = source[col];
+         }
       }
    }
    return rc;
@@ -395,7 +587,7 @@ static int lengthOfColumn(const char* text, char separator) {
  */
 static const char* skipNonNumbers(const char* line, char separator) {
    int len1, len2 = 0;
-   while ((len1 = ReStringUtil::lengthOfNumber(line)) == 0 && (len2 =
+   while ((len1 = ReStringUtils::lengthOfNumber(line)) == 0 && (len2 =
              lengthOfColumn(line, separator)) > 0)
       line += len2;
    if (*line == separator)
@@ -415,7 +607,7 @@ static int countNumbers(const char* line, char separator) {
    int rc = 0;
    char cc;
    while (again && (cc = *line) != '\0' && cc != '\n' && cc != '\r') {
-      int length = ReStringUtil::lengthOfNumber(line, true);
+      int length = ReStringUtils::lengthOfNumber(line, true);
       if (length == 0) {
          rc = 0;
          again = false;
@@ -438,7 +630,7 @@ void RplMatrix::readFromCvs(const char* filename, int maxLineLength) {
       throw RplMatrixException(*this, "Cannot open %s (%d)", filename, errno);
    char* buffer = new char[maxLineLength + 1];
    const char* line;
-   char separator = ReStringUtil::findCsvSeparator(fp, buffer, maxLineLength);
+   char separator = ReStringUtils::findCsvSeparator(fp, buffer, maxLineLength);
    int rows = 0;
    int cols = 0;
    int nCols;
@@ -462,7 +654,7 @@ void RplMatrix::readFromCvs(const char* filename, int maxLineLength) {
          int col = -1;
          int length;
          const char* ptr;
-         while ((length = ReStringUtil::lengthOfNumber(line, true)) > 0) {
+         while ((length = ReStringUtils::lengthOfNumber(line, true)) > 0) {
             col++;
             ptr = line;
             line += length;
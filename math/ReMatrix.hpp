@@ -55,6 +55,9 @@ public:
    RplMatrix& operator -=(MatVal scalar);
    RplMatrix operator +(MatVal scalar);
    RplMatrix operator -(MatVal scalar);
+   RplMatrix& operator *=(MatVal scalar);
+   RplMatrix operator *(MatVal scalar) const;
+   RplMatrix operator *(const RplMatrix& operand) const;
    bool operator ==(const RplMatrix& operand) const;
    bool operator ==(MatVal scalar) const;
    inline bool operator !=(const RplMatrix& operand) const {
@@ -82,13 +85,29 @@ public:
    inline int getCols() const {
       return m_cols;
    }
+   /** Returns a row without index check: for inner loops.
+    * @param row   the row index: 0..N-1
+    * @return      the first element of the row
+    */
+   inline MatVal* row(int row) {
+      return m_values + row * m_cols;
+   }
+   /** Returns a row without index check: for inner loops.
+    * @param row   the row index: 0..N-1
+    * @return      the first element of the row
+    */
+   inline const MatVal* row(int row) const {
+      return m_values + row * m_cols;
+   }
 public:
+   RplMatrix& addScaled(const RplMatrix& operand, MatVal factor);
    void checkDefinition(int rows, int cols) const;
    void check(int row, int col) const;
    void checkSameDimension(const RplMatrix& operand) const;
    RplMatrix& resize(int rows, int cols, const MatVal values[] = NULL,
                      MatVal defaultValue = 0.0);
    Tuple2 minMax() const;
+   RplMatrix& scaleAndShift(MatVal factor, MatVal summand);
    RplMatrix transpose() const;
    QByteArray toString(const char* prefix = NULL, const char* format = "%f",
                        const char* rowSeparator = "\n", const char* colSeparator = ",") const;
@@ -96,6 +115,9 @@ public:
    void readFromXml(const char* filename, const char* tagCol,
                     const char* tagRow, const char* tagTable,
                     int maxLineLength = 1024 * 1024);
+public:
+   static void multiplyRows(const RplMatrix& left, const RplMatrix& right,
+                            RplMatrix& result, int firstRow, int lastRow);
 protected:
    int m_rows;
    int m_cols;
@@ -105,9 +105,11 @@ ReTCPPeer::~ReTCPPeer() {
 bool ReTCPPeer::send(qint8 flags, const char* command, const QByteArray& data) {
    bool rc = false;
    QByteArray header;
-   QByteArray data2 = ReStringUtil::toCString(data.constData(), 20);
-   m_logger->logv(LOG_INFO, LOC_SEND_1, "send: flags: %x %s %s (%d)", flags,
-                  command, data2.constData(), data.length());
+   if (m_logger->isActive(LOG_INFO)) {
+      QByteArray data2 = ReStringUtil::toCString(data.constData(), 20);
+      m_logger->logv(LOG_INFO, LOC_SEND_1, "send: flags: %x %s %s (%d)", flags,
+                     command, data2.constData(), data.length());
+   }
    header.reserve(16);
    header.append((char) flags);
    if (flags & FLAG_ENCRYPT) {
@@ -163,6 +165,29 @@ bool ReTCPPeer::send(qint8 flags, const char* command, const QByteArray& data) {
  *                  otherwise: the read bytes
  */
 QByteArray ReTCPPeer::readBytes(int bytes, time_t maxTime, int& loops) {
+   QByteArray rc;
+   if (!readBytes(rc, bytes, maxTime, loops))
+      rc.clear();
+   return rc;
+}
+
+/**
+ * @brief Reads an amount of bytes with a timeout into a given buffer.
+ *
+ * The memory of the buffer is reused if it is large enough and not shared.
+ * Therefore a caller receiving many messages should use the same buffer
+ * for all messages.
+ *
+ * @param buffer    OUT: the read bytes
+ * @param bytes     count of bytes to read
+ * @param maxTime   IN/OUT: last time the read must be ready
+ * @param loops     IN/OUT: number of sleeps
+ *
+ * @return          <code>true</code>: success<br>
+ *                  <code>false</code>: timeout or termination or error
+ */
+bool ReTCPPeer::readBytes(QByteArray& buffer, int bytes, time_t maxTime,
+                          int& loops) {
    QAbstractSocket* socket = getSocket();
    bool success = true;
    int64_t available;
@@ -191,16 +216,20 @@ QByteArray ReTCPPeer::readBytes(int bytes, time_t maxTime, int& loops) {
    }
    available = socket->bytesAvailable();
    m_logger->logv(LOG_DEBUG, LOC_READ_BYTES_4,
-                  "readBytes(): available: %ld/%ld", available, bytes);
-   QByteArray rc;
+                  "readBytes(): available: %lld/%d", (long long) available, bytes);
    if (success) {
-      rc = socket->read(bytes);
-      if (rc.length() != bytes) {
+      // reserve() marks the capacity as reserved: resize() keeps the memory
+      buffer.reserve(bytes);
+      buffer.resize(bytes);
+      int64_t length = socket->read(buffer.data(), bytes);
+      if (length != bytes) {
          m_logger->logv(LOG_ERROR, LOC_READ_BYTES_3,
-                        "receive: too few bytes: %d of %d", rc.length(), bytes);
+                        "receive: too few bytes: %d of %d", (int) length, bytes);
+         buffer.resize(length < 0 ? 0 : length);
+         success = false;
       }
    }
-   return rc;
+   return success;
 }
 
 int getInt(const QByteArray& data, int offset, int size) {
@@ -215,14 +244,16 @@ int getInt(const QByteArray& data, int offset, int size) {
  * @brief Receives a message via TCP.
  *
  * @param command   OUT: defines the content of the read message
- * @param data      OUT: "" or additional data
+ * @param data      OUT: "" or additional data. The memory is reused for the
+ *                  next message if the caller does not share it
  * @return          true: success<br>
  *                  false: error occurred
  */
 bool ReTCPPeer::receive(QByteArray& command, QByteArray& data) {
    bool rc = true;
    command.clear();
-   data.clear();
+   // keeps the memory of the buffer for the next message (if reserved):
+   data.resize(0);
    QByteArray header;
    header.reserve(16);
    int minHeaderSize = 8;
@@ -252,8 +283,7 @@ bool ReTCPPeer::receive(QByteArray& command, QByteArray& data) {
       int size = (flags & FLAG_4_BYTE_SIZE) == 0 ? 4 : 2;
       int dataLength = getInt(header, offset, size);
       command = header.mid(offset - 5, 5);
-      data = readBytes(dataLength, maxTime, loops);
-      rc = data.length() == dataLength;
+      rc = readBytes(data, dataLength, maxTime, loops);
    }
    return rc;
 }
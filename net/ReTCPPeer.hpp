@@ -58,6 +58,7 @@ public:
    void setAddress(const char* ip, int port);
 private:
    QByteArray readBytes(int bytes, time_t maxTime, int& loops);
+   bool readBytes(QByteArray& buffer, int bytes, time_t maxTime, int& loops);
 
 public slots:
    void readTcpData();
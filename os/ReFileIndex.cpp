@@ -0,0 +1,1119 @@
+/*
+ * ReFileIndex.cpp
+ *
+ * (Un)License: Public Domain
+ * You can use and modify this file without any restriction.
+ * Do what you want.
+ * No warranties and disclaimer of any damages.
+ * More info: http://unlicense.org
+ * The latest sources: https://github.com/republib
+ */
+
+#include "base/rebase.hpp"
+#include "os/reos.hpp"
+#if defined __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#endif
+
+enum {
+   LOC_LOAD_1 = LOC_FIRST_OF(LOC_FILEINDEX), // 12401
+   LOC_LOAD_2,		// 12402
+   LOC_SAVE_1,		// 12403
+   LOC_WATCH_1,	// 12404
+   LOC_WATCH_2,	// 12405
+   LOC_START_WATCHING_1,	// 12406
+};
+
+/// the first bytes of an index file:
+static const char* s_magic = "reindex1";
+static const int s_magicLength = 8;
+#if defined __linux__
+static const uint32_t s_watchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM
+                                    | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ATTRIB | IN_ONLYDIR;
+#endif
+
+/**
+ * Returns the hash of the trigram at the given position.
+ *
+ * Only ASCII letters are folded: the hash of a lower case trigram is the
+ * same as the hash of the upper case variant.
+ *
+ * @param text  the start of the trigram
+ * @return      a number in [0..255]
+ */
+inline int trigramOf(const char* text) {
+   int rc = 0;
+   for (int ix = 0; ix < 3; ix++) {
+      uint8_t cc = text[ix];
+      if (cc >= 'A' && cc <= 'Z')
+         cc += 'a' - 'A';
+      rc = rc * 37 + cc;
+   }
+   return rc & 255;
+}
+
+/**
+ * Returns the modification time of a directory.
+ *
+ * @param path  the name of the directory
+ * @return      -1: the directory does not exist<br>
+ *              otherwise: the modification time in msec since the epoch
+ */
+static int64_t modificationOf(const QByteArray& path) {
+   int64_t rc = -1;
+   struct stat info;
+   if (stat(path.constData(), &info) == 0 && S_ISDIR(info.st_mode)) {
+#if defined __linux__
+      rc = ReDirStatus_t::filetimeToMSec(&info.st_mtim);
+#else
+      rc = int64_t(info.st_mtime) * 1000;
+#endif
+   }
+   return rc;
+}
+
+/**
+ * Appends an integer to a buffer (native byte order).
+ *
+ * @param buffer    IN/OUT: the buffer to extend
+ * @param value     the value to append
+ */
+template<class T> inline void appendRaw(QByteArray& buffer, T value) {
+   buffer.append(reinterpret_cast<const char*>(&value), sizeof value);
+}
+
+/**
+ * Appends a string with a preceding length to a buffer.
+ *
+ * @param buffer    IN/OUT: the buffer to extend
+ * @param value     the string to append
+ */
+inline void appendString(QByteArray& buffer, const QByteArray& value) {
+   appendRaw(buffer, int32_t(value.length()));
+   buffer.append(value);
+}
+
+/**
+ * Reads the data written by <code>appendRaw()</code> and
+ * <code>appendString()</code>.
+ */
+class ReIndexReader {
+public:
+   ReIndexReader(const QByteArray& data) :
+      m_data(data),
+      m_position(0),
+      m_ok(true) {
+   }
+public:
+   /** Reads raw data.
+    * @param target    OUT: the place for the data
+    * @param length    the count of bytes to read
+    * @return          <code>false</code>: the data are too short
+    */
+   bool read(void* target, int length) {
+      if (length < 0 || m_position + length > m_data.length())
+         m_ok = false;
+      else if (length > 0) {
+         memcpy(target, m_data.constData() + m_position, length);
+         m_position += length;
+      }
+      return m_ok;
+   }
+   /** Reads an integer.
+    * @return  the integer. 0 on errors
+    */
+   int32_t readInt() {
+      int32_t rc = 0;
+      read(&rc, sizeof rc);
+      return rc;
+   }
+   /** Reads a string stored with a preceding length.
+    * @param value     OUT: the string
+    * @return          <code>false</code>: the data are too short
+    */
+   bool readString(QByteArray& value) {
+      int length = readInt();
+      if (m_ok && length >= 0 && m_position + length <= m_data.length()) {
+         value = m_data.mid(m_position, length);
+         m_position += length;
+      } else
+         m_ok = false;
+      return m_ok;
+   }
+public:
+   const QByteArray& m_data;
+   int m_position;
+   bool m_ok;
+};
+
+/**
+ * The parameters and the precomputed data of a query.
+ */
+class ReIndexQuery_t {
+public:
+   ReIndexQuery_t(const ReDirEntryFilter& filter, ReFileIndexVisitor& visitor) :
+      m_filter(filter),
+      m_visitor(visitor),
+      m_trigrams(),
+      m_minModified(-1),
+      m_maxModified(-1),
+      m_hits(0) {
+      ReFileTime_t time = filter.m_maxAge;
+      if (!filetimeIsUndefined(time))
+         m_minModified = ReDirStatus_t::filetimeToMSec(&time);
+      time = filter.m_minAge;
+      if (!filetimeIsUndefined(time))
+         m_maxModified = ReDirStatus_t::filetimeToMSec(&time);
+      if (filter.m_nodePatterns != NULL && !filter.m_allDirectories)
+         addTrigrams(filter.m_nodePatterns->includes().patterns());
+   }
+public:
+   /**
+    * Tests whether an entry matches the conditions of the filter.
+    *
+    * @param dir    the directory containing the entry
+    * @param index  the index of the entry in the directory
+    * @return       <code>true</code>: the entry matches
+    */
+   bool matches(const ReIndexDir_t& dir, int index) const {
+      const ReIndexEntry_t& entry = dir.m_entries.at(index);
+      bool rc = false;
+      do {
+         bool isDir = entry.m_type == ReDirStatus_t::TF_SUBDIR
+                      || entry.m_type == ReDirStatus_t::TF_LINK_DIR;
+         if (m_filter.m_allDirectories && isDir) {
+            rc = true;
+            break;
+         }
+         if (m_filter.m_nodePatterns != NULL
+               && !m_filter.m_nodePatterns->matches(dir.node(index), -1))
+            break;
+         if (0 == (entry.m_type & m_filter.m_types))
+            break;
+         if (m_filter.m_minSize > 0 && entry.m_size < m_filter.m_minSize)
+            break;
+         if (m_filter.m_maxSize >= 0 && entry.m_size > m_filter.m_maxSize)
+            break;
+         if (m_maxModified >= 0 && entry.m_modified > m_maxModified)
+            break;
+         if (m_minModified >= 0 && entry.m_modified < m_minModified)
+            break;
+         rc = true;
+      } while (false);
+      return rc;
+   }
+   /**
+    * Tests whether a directory may contain entries matching the node patterns.
+    *
+    * @param dir    the directory to test
+    * @return       <code>false</code>: no entry of the directory can match
+    */
+   bool mayMatch(const ReIndexDir_t& dir) const {
+      bool rc = m_trigrams.size() == 0;
+      for (int ix = 0; !rc && ix < m_trigrams.size(); ix++)
+         rc = dir.hasTrigrams(m_trigrams.at(ix));
+      return rc;
+   }
+private:
+   /**
+    * Collects the trigrams of the literal parts of the include patterns.
+    *
+    * If one pattern has no trigram the directories cannot be skipped.
+    *
+    * @param patterns  the include patterns of the node filter
+    */
+   void addTrigrams(const QStringList& patterns) {
+      for (int ix = 0; ix < patterns.size(); ix++) {
+         QByteArray pattern = I18N::s2b(patterns.at(ix));
+         QList<int> trigrams;
+         const char* ptr = pattern.constData();
+         for (int pos = 0; pos + 3 <= pattern.length(); pos++) {
+            // the case folding of the matcher knows more than ASCII:
+            if (ptr[pos] != '*' && ptr[pos + 1] != '*' && ptr[pos + 2] != '*'
+                  && (ptr[pos] & 0x80) == 0 && (ptr[pos + 1] & 0x80) == 0
+                  && (ptr[pos + 2] & 0x80) == 0)
+               trigrams.append(trigramOf(ptr + pos));
+         }
+         if (trigrams.size() == 0) {
+            m_trigrams.clear();
+            break;
+         }
+         m_trigrams.append(trigrams);
+      }
+   }
+public:
+   const ReDirEntryFilter& m_filter;
+   ReFileIndexVisitor& m_visitor;
+   // the trigrams of each include pattern. Empty: no directory can be skipped
+   QList<QList<int> > m_trigrams;
+   // -1 or the lower bound of the modification time (msec)
+   int64_t m_minModified;
+   // -1 or the upper bound of the modification time (msec)
+   int64_t m_maxModified;
+   int m_hits;
+};
+
+/** @class ReIndexDir_t ReFileIndex.hpp "os/ReFileIndex.hpp"
+ *
+ * @brief Stores the entries of one directory of a file index.
+ *
+ * The names are stored in one buffer. A signature of the contained trigrams
+ * allows to skip the directory if the search pattern cannot match.
+ */
+
+/**
+ * Constructor.
+ */
+ReIndexDir_t::ReIndexDir_t() :
+   m_parent(-2),
+   m_node(),
+   m_modified(-1),
+   m_names(),
+   m_entries(),
+   m_subdirs(),
+   m_watch(-1) {
+   memset(m_trigrams, 0, sizeof m_trigrams);
+}
+
+/**
+ * Adds the trigrams of a name to the signature of the directory.
+ *
+ * @param node      the name of an entry
+ * @param length    the length of <code>node</code>
+ */
+void ReIndexDir_t::addTrigrams(const char* node, int length) {
+   for (int ix = 0; ix + 3 <= length; ix++) {
+      int bit = trigramOf(node + ix);
+      m_trigrams[bit >> 6] |= uint64_t(1) << (bit & 63);
+   }
+}
+
+/**
+ * Tests whether the signature contains all given trigrams.
+ *
+ * @param trigrams  a list of trigram hashes
+ * @return          <code>true</code>: all trigrams may be part of a name
+ */
+bool ReIndexDir_t::hasTrigrams(const QList<int>& trigrams) const {
+   bool rc = true;
+   for (int ix = 0; rc && ix < trigrams.size(); ix++) {
+      int bit = trigrams.at(ix);
+      rc = (m_trigrams[bit >> 6] & (uint64_t(1) << (bit & 63))) != 0;
+   }
+   return rc;
+}
+
+/** @class ReFileIndex ReFileIndex.hpp "os/ReFileIndex.hpp"
+ *
+ * @brief A persistent index of the file names below a base directory.
+ *
+ * Each directory is stored with its modification time. A refresh reads only
+ * the directories whose modification time has changed. A query does not
+ * access the disk: the entries are filtered by the conditions of a
+ * <code>ReDirEntryFilter</code>.
+ *
+ * Only one thread may change the index, but many threads may query it.
+ */
+
+/**
+ * Constructor.
+ *
+ * @param base      the base directory of the index
+ * @param logger    the logger
+ */
+ReFileIndex::ReFileIndex(const QByteArray& base, ReLogger* logger) :
+   m_base(base),
+   m_dirs(),
+   m_freeDirs(),
+   m_logger(logger),
+   m_lock(),
+   m_dirty(false),
+   m_inotify(-1),
+   m_watches(),
+   m_watchLimit(false) {
+   if (m_base.length() > 1 && m_base.endsWith(OS_SEPARATOR))
+      m_base.chop(1);
+   allocDir(-1, m_base);
+}
+
+/**
+ * Destructor.
+ */
+ReFileIndex::~ReFileIndex() {
+   stopWatching();
+}
+
+/**
+ * Reserves a directory slot.
+ *
+ * @param parent    the index of the parent directory. -1: the base
+ * @param node      the name of the directory
+ * @return          the index of the new slot
+ */
+int ReFileIndex::allocDir(int parent, const QByteArray& node) {
+   int rc = -1;
+   // a directory is always stored behind its parent (checked by load()):
+   for (int ix = m_freeDirs.size() - 1; rc < 0 && ix >= 0; ix--) {
+      if (m_freeDirs.at(ix) > parent) {
+         rc = m_freeDirs.at(ix);
+         m_freeDirs.remove(ix);
+      }
+   }
+   if (rc >= 0)
+      m_dirs[rc] = ReIndexDir_t();
+   else {
+      rc = m_dirs.size();
+      m_dirs.append(ReIndexDir_t());
+   }
+   m_dirs[rc].m_parent = parent;
+   m_dirs[rc].m_node = node;
+   return rc;
+}
+
+/**
+ * Returns the base directory stored in an index file.
+ *
+ * @param filename  the name of the index file
+ * @return          "": not an index file<br>
+ *                  otherwise: the base directory
+ */
+QByteArray ReFileIndex::baseOf(const QByteArray& filename) {
+   QByteArray rc;
+   QFile file(filename);
+   if (file.open(QIODevice::ReadOnly)) {
+      QByteArray header = file.read(s_magicLength + sizeof(int32_t));
+      if (header.length() == int(s_magicLength + sizeof(int32_t))
+            && header.startsWith(s_magic)) {
+         int32_t length;
+         memcpy(&length, header.constData() + s_magicLength, sizeof length);
+         if (length > 0 && length < 64 * 1024)
+            rc = file.read(length);
+      }
+      file.close();
+   }
+   return rc;
+}
+
+/**
+ * Tests whether a directory is part of the index.
+ *
+ * @param path  the name of the directory
+ * @return      <code>true</code>: the directory is indexed
+ */
+bool ReFileIndex::contains(const QByteArray& path) const {
+   QReadLocker locker(&m_lock);
+   return findDir(path) >= 0;
+}
+
+/**
+ * Returns the number of indexed entries.
+ *
+ * @return the number of files, links and directories in the index
+ */
+int ReFileIndex::entries() const {
+   QReadLocker locker(&m_lock);
+   int rc = 0;
+   for (int ix = 0; ix < m_dirs.size(); ix++)
+      rc += m_dirs.at(ix).m_entries.size();
+   return rc;
+}
+
+/**
+ * Returns the index of a directory given by its name.
+ *
+ * @param path  the name of the directory
+ * @return      -1: the directory is not in the index<br>
+ *              otherwise: the index in <code>m_dirs</code>
+ */
+int ReFileIndex::findDir(const QByteArray& path) const {
+   int rc = -1;
+   int start = m_base.length();
+   if (path.startsWith(m_base)
+         && (path.length() == start || path.at(start) == OS_SEPARATOR
+             || m_base.endsWith(OS_SEPARATOR))) {
+      rc = 0;
+      while (rc >= 0 && start < path.length()) {
+         if (path.at(start) == OS_SEPARATOR)
+            start++;
+         int end = path.indexOf(OS_SEPARATOR, start);
+         if (end < 0)
+            end = path.length();
+         if (end > start) {
+            QByteArray node = path.mid(start, end - start);
+            const QVector<int>& subdirs = m_dirs.at(rc).m_subdirs;
+            rc = -1;
+            for (int ix = 0; ix < subdirs.size(); ix++) {
+               if (m_dirs.at(subdirs.at(ix)).m_node == node) {
+                  rc = subdirs.at(ix);
+                  break;
+               }
+            }
+         }
+         start = end;
+      }
+   }
+   return rc;
+}
+
+/**
+ * Releases a directory slot and the slots of its subdirectories.
+ *
+ * @param dir   the index of the directory in <code>m_dirs</code>
+ */
+void ReFileIndex::freeDir(int dir) {
+   QVector<int> subdirs = m_dirs.at(dir).m_subdirs;
+   for (int ix = 0; ix < subdirs.size(); ix++)
+      freeDir(subdirs.at(ix));
+   ReIndexDir_t& current = m_dirs[dir];
+#if defined __linux__
+   if (current.m_watch >= 0) {
+      inotify_rm_watch(m_inotify, current.m_watch);
+      m_watches.remove(current.m_watch);
+   }
+#endif
+   current = ReIndexDir_t();
+   m_freeDirs.append(dir);
+}
+
+/**
+ * Reads the index from a file written by <code>save()</code>.
+ *
+ * @param filename  the name of the index file
+ * @return          <code>true</code>: success
+ */
+bool ReFileIndex::load(const QByteArray& filename) {
+   QFile file(filename);
+   bool rc = file.open(QIODevice::ReadOnly);
+   if (!rc) {
+      m_logger->logv(LOG_ERROR, LOC_LOAD_1, "cannot open index: %s",
+                     filename.constData());
+   } else {
+      QByteArray data = file.readAll();
+      file.close();
+      ReIndexReader reader(data);
+      QVector<ReIndexDir_t> dirs;
+      QVector<int> freeDirs;
+      QByteArray base;
+      char magic[8];
+      rc = reader.read(magic, s_magicLength)
+           && memcmp(magic, s_magic, s_magicLength) == 0
+           && reader.readString(base) && base == m_base;
+      int count = rc ? reader.readInt() : 0;
+      for (int ix = 0; rc && ix < count; ix++) {
+         ReIndexDir_t dir;
+         dir.m_parent = reader.readInt();
+         // the base has no parent, the others are stored behind it.
+         // This excludes cycles in the parent chain:
+         if (ix == 0 ? dir.m_parent != -1
+               : dir.m_parent != -2 && (dir.m_parent < 0 || dir.m_parent >= ix))
+            rc = false;
+         reader.readString(dir.m_node);
+         reader.read(&dir.m_modified, sizeof dir.m_modified);
+         reader.readString(dir.m_names);
+         int entries = reader.readInt();
+         if (entries < 0 || entries > data.length())
+            rc = false;
+         else {
+            dir.m_entries.resize(entries);
+            reader.read(dir.m_entries.data(), entries * sizeof(ReIndexEntry_t));
+         }
+         int subdirs = reader.readInt();
+         if (subdirs < 0 || subdirs > count)
+            rc = false;
+         else {
+            dir.m_subdirs.resize(subdirs);
+            reader.read(dir.m_subdirs.data(), subdirs * sizeof(int));
+         }
+         rc = rc && reader.m_ok;
+         for (int ix2 = 0; rc && ix2 < entries; ix2++) {
+            int node = dir.m_entries.at(ix2).m_node;
+            if (node < 0 || node >= dir.m_names.length())
+               rc = false;
+            else
+               dir.addTrigrams(dir.node(ix2), strlen(dir.node(ix2)));
+         }
+         for (int ix2 = 0; rc && ix2 < subdirs; ix2++)
+            rc = dir.m_subdirs.at(ix2) > ix && dir.m_subdirs.at(ix2) < count;
+         if (dir.m_parent == -2)
+            freeDirs.append(ix);
+         dirs.append(dir);
+      }
+      rc = rc && count > 0;
+      if (!rc)
+         m_logger->logv(LOG_ERROR, LOC_LOAD_2, "invalid index: %s",
+                        filename.constData());
+      else {
+         stopWatching();
+         QWriteLocker locker(&m_lock);
+         m_dirs = dirs;
+         m_freeDirs = freeDirs;
+         m_dirty = false;
+      }
+   }
+   return rc;
+}
+
+/**
+ * Returns the full name of an indexed directory.
+ *
+ * @param dir   the index of the directory in <code>m_dirs</code>
+ * @return      the path with a trailing separator
+ */
+QByteArray ReFileIndex::pathOf(int dir) const {
+   QList<int> parents;
+   for (int ix = dir; ix >= 0; ix = m_dirs.at(ix).m_parent)
+      parents.prepend(ix);
+   QByteArray rc;
+   for (int ix = 0; ix < parents.size(); ix++) {
+      rc.append(m_dirs.at(parents.at(ix)).m_node);
+      if (!rc.endsWith(OS_SEPARATOR))
+         rc.append(OS_SEPARATOR);
+   }
+   return rc;
+}
+
+/**
+ * Applies the changes reported by inotify.
+ *
+ * Changed files are updated directly, the directories with new, removed
+ * or renamed entries are read again.
+ *
+ * @return  the number of processed events
+ */
+int ReFileIndex::processEvents() {
+   int rc = 0;
+#if defined __linux__
+   char buffer[64 * 1024] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+   QList<int> dirtyDirs;
+   bool overflow = false;
+   ssize_t length;
+   while (m_inotify >= 0
+          && (length = read(m_inotify, buffer, sizeof buffer)) > 0) {
+      for (char* ptr = buffer; ptr < buffer + length; rc++) {
+         const struct inotify_event* event = (const struct inotify_event*) ptr;
+         ptr += sizeof(struct inotify_event) + event->len;
+         if ((event->mask & IN_Q_OVERFLOW) != 0) {
+            overflow = true;
+            continue;
+         }
+         int dir = m_watches.value(event->wd, -1);
+         if (dir < 0)
+            continue;
+         if ((event->mask & IN_IGNORED) != 0) {
+            // the directory has been removed:
+            m_watches.remove(event->wd);
+            m_dirs[dir].m_watch = -1;
+         } else if ((event->mask & (IN_CLOSE_WRITE | IN_ATTRIB)) != 0
+                    && (event->mask & IN_ISDIR) == 0 && event->len > 0) {
+            if (!dirtyDirs.contains(dir))
+               updateEntry(dir, event->name);
+         } else if (!dirtyDirs.contains(dir))
+            dirtyDirs.append(dir);
+      }
+   }
+   if (overflow)
+      refresh();
+   else {
+      for (int ix = 0; ix < dirtyDirs.size(); ix++) {
+         int dir = dirtyDirs.at(ix);
+         // the directory may be removed by a previous update:
+         if (m_dirs.at(dir).m_parent != -2) {
+            QByteArray path = pathOf(dir);
+            m_dirs[dir].m_modified = -1;
+            refreshDir(dir, path, false);
+         }
+      }
+   }
+#endif
+   return rc;
+}
+
+/**
+ * Calls the visitor for all entries of a directory tree matching a filter.
+ *
+ * @param dir   the index of the directory in <code>m_dirs</code>
+ * @param path  IN/OUT: the path of the directory with a trailing separator
+ * @param level the depth of the directory relative to the query start
+ * @param query the query parameters
+ * @return      <code>false</code>: the visitor has stopped the query
+ */
+bool ReFileIndex::queryDir(int dir, QByteArray& path, int level,
+                           ReIndexQuery_t& query) const {
+   bool rc = true;
+   const ReIndexDir_t& current = m_dirs.at(dir);
+   if (level >= query.m_filter.m_minDepth && query.mayMatch(current)) {
+      for (int ix = 0; rc && ix < current.m_entries.size(); ix++) {
+         if (query.matches(current, ix)) {
+            query.m_hits++;
+            rc = query.m_visitor.visit(path, current.node(ix),
+                                       current.m_entries.at(ix));
+         }
+      }
+   }
+   if (level < query.m_filter.m_maxDepth) {
+      int length = path.length();
+      ReIncludeExcludeMatcher* dirPatterns = query.m_filter.m_pathPatterns;
+      for (int ix = 0; rc && ix < current.m_subdirs.size(); ix++) {
+         const ReIndexDir_t& subdir = m_dirs.at(current.m_subdirs.at(ix));
+         if (dirPatterns == NULL
+               || dirPatterns->matches(subdir.m_node.constData(),
+                                       subdir.m_node.length())) {
+            path.append(subdir.m_node).append(OS_SEPARATOR);
+            rc = queryDir(current.m_subdirs.at(ix), path, level + 1, query);
+            path.resize(length);
+         }
+      }
+   }
+   return rc;
+}
+
+/**
+ * Calls a visitor for all indexed entries below a directory matching a filter.
+ *
+ * The disk is not accessed. The depth limits and the directory patterns
+ * (<code>m_pathPatterns</code>) of the filter are respected.
+ *
+ * @param path      the directory to search. Must be part of the index
+ * @param filter    the conditions of the entries to find
+ * @param visitor   is called for each matching entry
+ * @return          -1: the directory is not indexed<br>
+ *                  otherwise: the number of matching entries
+ */
+int ReFileIndex::query(const QByteArray& path, const ReDirEntryFilter& filter,
+                       ReFileIndexVisitor& visitor) const {
+   QReadLocker locker(&m_lock);
+   int rc = -1;
+   int dir = findDir(path);
+   if (dir >= 0) {
+      ReIndexQuery_t query(filter, visitor);
+      QByteArray thePath = pathOf(dir);
+      queryDir(dir, thePath, 0, query);
+      rc = query.m_hits;
+   }
+   return rc;
+}
+
+/**
+ * Reads the entries of a directory and replaces the indexed entries.
+ *
+ * New subdirectories are only registered: they are read by the caller.
+ * Vanished subdirectories are removed from the index.
+ *
+ * @param dir   the index of the directory in <code>m_dirs</code>
+ * @param path  the full name of the directory with a trailing separator
+ */
+void ReFileIndex::readDir(int dir, const QByteArray& path) {
+   ReDirStatus_t status(m_logger);
+   status.m_path = path;
+   QByteArray names;
+   QVector<ReIndexEntry_t> entries;
+   QList<QByteArray> subdirNodes;
+   if (status.findFirst()) {
+      do {
+         if (status.isDotDir())
+            continue;
+         ReIndexEntry_t entry;
+         entry.m_node = names.length();
+         names.append(status.node()).append('\0');
+         entry.m_type = status.type();
+         entry.m_size = status.fileSize();
+         entry.m_modified = ReDirStatus_t::filetimeToMSec(status.modified());
+         entries.append(entry);
+         if (entry.m_type == ReDirStatus_t::TF_SUBDIR)
+            subdirNodes.append(QByteArray(status.node()));
+      } while (status.findNext());
+   }
+   status.close();
+   QWriteLocker locker(&m_lock);
+   QHash<QByteArray, int> oldSubdirs;
+   const QVector<int>& known = m_dirs.at(dir).m_subdirs;
+   for (int ix = 0; ix < known.size(); ix++)
+      oldSubdirs.insert(m_dirs.at(known.at(ix)).m_node, known.at(ix));
+   QVector<int> subdirs;
+   for (int ix = 0; ix < subdirNodes.size(); ix++) {
+      int subdir = oldSubdirs.take(subdirNodes.at(ix));
+      if (subdir <= 0)
+         subdir = allocDir(dir, subdirNodes.at(ix));
+      subdirs.append(subdir);
+   }
+   QHash<QByteArray, int>::const_iterator it;
+   for (it = oldSubdirs.cbegin(); it != oldSubdirs.cend(); ++it)
+      freeDir(it.value());
+   ReIndexDir_t& current = m_dirs[dir];
+   current.m_names = names;
+   current.m_entries = entries;
+   current.m_subdirs = subdirs;
+   memset(current.m_trigrams, 0, sizeof current.m_trigrams);
+   for (int ix = 0; ix < entries.size(); ix++)
+      current.addTrigrams(current.node(ix), strlen(current.node(ix)));
+   m_dirty = true;
+}
+
+/**
+ * Brings the index up to date.
+ *
+ * Only the directories with a changed modification time are read.
+ * Note: changing a file does not change the modification time of its
+ * directory, so only new, removed and renamed entries are detected.
+ * Directories changed in the last seconds are read again by the next call.
+ *
+ * @param stop  NULL or a flag: if set (!= 0) the refresh ends before the
+ *              next directory. The rest is done by the next call
+ * @return  the number of read directories
+ */
+int ReFileIndex::refresh(const QAtomicInt* stop) {
+   QByteArray path = pathOf(0);
+   return refreshDir(0, path, true, stop);
+}
+
+/**
+ * Brings a directory tree of the index up to date.
+ *
+ * @param dir   the index of the directory in <code>m_dirs</code>
+ * @param path  IN/OUT: the full name of the directory with trailing separator
+ * @param deep  <code>true</code>: all subdirectories are checked<br>
+ *              <code>false</code>: only the new subdirectories are read
+ * @param stop  NULL or a flag: if set (!= 0) no more directory is read
+ * @return      the number of read directories
+ */
+int ReFileIndex::refreshDir(int dir, QByteArray& path, bool deep,
+                            const QAtomicInt* stop) {
+   int rc = 0;
+   if (stop != NULL && stop->load() != 0)
+      return rc;
+   int64_t modified = modificationOf(path);
+   if (modified >= 0) {
+      if (m_inotify >= 0 && m_dirs.at(dir).m_watch < 0 && ! m_watchLimit)
+         watch(dir, path);
+      if (modified != m_dirs.at(dir).m_modified) {
+         readDir(dir, path);
+         // the file system clock is coarse: a change in the same tick as
+         // the reading would not change the modification time
+         bool racy = modified >= (int64_t(time(NULL)) - 2) * 1000;
+         m_dirs[dir].m_modified = racy ? -1 : modified;
+         rc++;
+      }
+      QVector<int> subdirs = m_dirs.at(dir).m_subdirs;
+      int length = path.length();
+      for (int ix = 0; ix < subdirs.size(); ix++) {
+         int subdir = subdirs.at(ix);
+         if (deep || m_dirs.at(subdir).m_modified < 0) {
+            path.append(m_dirs.at(subdir).m_node).append(OS_SEPARATOR);
+            rc += refreshDir(subdir, path, deep, stop);
+            path.resize(length);
+         }
+      }
+   }
+   return rc;
+}
+
+/**
+ * Writes the index into a file.
+ *
+ * @param filename  the name of the index file
+ * @return          <code>true</code>: success
+ */
+bool ReFileIndex::save(const QByteArray& filename) {
+   QByteArray data;
+   {
+      QReadLocker locker(&m_lock);
+      data.append(s_magic, s_magicLength);
+      appendString(data, m_base);
+      appendRaw(data, int32_t(m_dirs.size()));
+      for (int ix = 0; ix < m_dirs.size(); ix++) {
+         const ReIndexDir_t& dir = m_dirs.at(ix);
+         appendRaw(data, int32_t(dir.m_parent));
+         appendString(data, dir.m_node);
+         appendRaw(data, dir.m_modified);
+         appendString(data, dir.m_names);
+         appendRaw(data, int32_t(dir.m_entries.size()));
+         data.append(reinterpret_cast<const char*>(dir.m_entries.constData()),
+                     dir.m_entries.size() * sizeof(ReIndexEntry_t));
+         appendRaw(data, int32_t(dir.m_subdirs.size()));
+         data.append(reinterpret_cast<const char*>(dir.m_subdirs.constData()),
+                     dir.m_subdirs.size() * sizeof(int));
+      }
+   }
+   // a crash while writing should not destroy the old index:
+   QByteArray tempName(filename);
+   tempName.append(".tmp");
+   QFile file(tempName);
+   bool rc = file.open(QIODevice::WriteOnly)
+             && file.write(data) == data.length();
+   file.close();
+   if (rc) {
+      QFile::remove(filename);
+      rc = QFile::rename(tempName, filename);
+   }
+   if (!rc)
+      m_logger->logv(LOG_ERROR, LOC_SAVE_1, "cannot write index: %s",
+                     filename.constData());
+   else
+      m_dirty = false;
+   return rc;
+}
+
+/**
+ * Starts the observation of the indexed directories by inotify.
+ *
+ * The directories are registered by the next <code>refresh()</code>.
+ *
+ * @return  <code>true</code>: success<br>
+ *          <code>false</code>: not supported by the system
+ */
+bool ReFileIndex::startWatching() {
+   bool rc = false;
+#if defined __linux__
+   if (m_inotify < 0) {
+      m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+      if (m_inotify < 0)
+         m_logger->logv(LOG_ERROR, LOC_START_WATCHING_1, "inotify_init1(): %d",
+                        errno);
+   }
+   rc = m_inotify >= 0;
+#endif
+   return rc;
+}
+
+/**
+ * Stops the observation of the indexed directories.
+ */
+void ReFileIndex::stopWatching() {
+#if defined __linux__
+   if (m_inotify >= 0) {
+      ::close(m_inotify);
+      m_inotify = -1;
+   }
+#endif
+   m_watches.clear();
+   m_watchLimit = false;
+   for (int ix = 0; ix < m_dirs.size(); ix++)
+      m_dirs[ix].m_watch = -1;
+}
+
+/**
+ * Updates the meta data of an entry after a change of the file.
+ *
+ * @param dir   the index of the directory in <code>m_dirs</code>
+ * @param node  the name of the changed entry
+ */
+void ReFileIndex::updateEntry(int dir, const char* node) {
+   const ReIndexDir_t& current = m_dirs.at(dir);
+   for (int ix = 0; ix < current.m_entries.size(); ix++) {
+      if (strcmp(node, current.node(ix)) == 0) {
+         QByteArray full = pathOf(dir);
+         full.append(node);
+         struct stat info;
+         if (stat(full.constData(), &info) == 0) {
+            QWriteLocker locker(&m_lock);
+            ReIndexEntry_t& entry = m_dirs[dir].m_entries[ix];
+            entry.m_size = info.st_size;
+#if defined __linux__
+            entry.m_modified = ReDirStatus_t::filetimeToMSec(&info.st_mtim);
+#else
+            entry.m_modified = int64_t(info.st_mtime) * 1000;
+#endif
+            m_dirty = true;
+         }
+         break;
+      }
+   }
+}
+
+/**
+ * Registers a directory for the observation by inotify.
+ *
+ * @param dir   the index of the directory in <code>m_dirs</code>
+ * @param path  the full name of the directory
+ */
+void ReFileIndex::watch(int dir, const QByteArray& path) {
+#if defined __linux__
+   int wd = inotify_add_watch(m_inotify, path.constData(), s_watchMask);
+   if (wd >= 0) {
+      m_dirs[dir].m_watch = wd;
+      m_watches.insert(wd, dir);
+   } else if (errno == ENOSPC) {
+      // the changes are found by the next refresh():
+      m_watchLimit = true;
+      m_logger->logv(LOG_WARNING, LOC_WATCH_1,
+                     "inotify limit reached (see /proc/sys/fs/inotify/max_user_watches): %s",
+                     path.constData());
+   } else
+      m_logger->logv(LOG_WARNING, LOC_WATCH_2, "inotify_add_watch(%s): %d",
+                     path.constData(), errno);
+#endif
+}
+
+/** @class ReFileIndexer ReFileIndex.hpp "os/ReFileIndex.hpp"
+ *
+ * @brief Maintains the file indexes in a background thread.
+ *
+ * At start the index files found in the index directory are loaded and
+ * refreshed. After that the changes reported by inotify are applied.
+ * The indexes are saved regularly and at the end.
+ */
+
+/**
+ * Constructor.
+ *
+ * @param indexDir  the directory containing the index files
+ * @param logger    the logger
+ */
+ReFileIndexer::ReFileIndexer(const QByteArray& indexDir, ReLogger* logger) :
+   m_indexDir(indexDir),
+   m_logger(logger),
+   m_indexes(),
+   m_newBases(),
+   m_mutex(),
+   m_stop(0) {
+   if (!m_indexDir.endsWith(OS_SEPARATOR))
+      m_indexDir.append(OS_SEPARATOR);
+}
+
+/**
+ * Destructor.
+ */
+ReFileIndexer::~ReFileIndexer() {
+   stop();
+   wait();
+   for (int ix = 0; ix < m_indexes.size(); ix++)
+      delete m_indexes.at(ix);
+   m_indexes.clear();
+}
+
+/**
+ * Requests the indexing of a base directory.
+ *
+ * @param base  the directory to index
+ */
+void ReFileIndexer::addBase(const QByteArray& base) {
+   QMutexLocker locker(&m_mutex);
+   if (!m_newBases.contains(base))
+      m_newBases.append(base);
+}
+
+/**
+ * Returns the name of the index file of a base directory.
+ *
+ * @param base  the base directory of the index
+ * @return      the full name of the index file
+ */
+QByteArray ReFileIndexer::filenameOf(const QByteArray& base) const {
+   QByteArray rc(m_indexDir);
+   rc.append("index_").append(QByteArray::number(qHash(base), 16))
+   .append(".reindex");
+   return rc;
+}
+
+/**
+ * Returns the index containing a given directory.
+ *
+ * @param path  the directory to search
+ * @return      NULL: the directory is not indexed<br>
+ *              otherwise: the index containing the directory
+ */
+ReFileIndex* ReFileIndexer::indexOf(const QByteArray& path) {
+   QMutexLocker locker(&m_mutex);
+   ReFileIndex* rc = NULL;
+   for (int ix = 0; rc == NULL && ix < m_indexes.size(); ix++) {
+      if (m_indexes.at(ix)->contains(path))
+         rc = m_indexes.at(ix);
+   }
+   return rc;
+}
+
+/**
+ * Maintains the indexes until <code>stop()</code> is called.
+ */
+void ReFileIndexer::run() {
+   QDir dir(I18N::b2s(m_indexDir));
+   QStringList names = dir.entryList(QStringList("*.reindex"), QDir::Files);
+   for (int ix = 0; m_stop.load() == 0 && ix < names.size(); ix++) {
+      QByteArray filename = m_indexDir + I18N::s2b(names.at(ix));
+      QByteArray base = ReFileIndex::baseOf(filename);
+      ReFileIndex* index = new ReFileIndex(base, m_logger);
+      if (base.isEmpty() || !index->load(filename))
+         delete index;
+      else {
+         // the index is usable before the refresh:
+         QMutexLocker locker(&m_mutex);
+         m_indexes.append(index);
+      }
+   }
+   QList<ReFileIndex*> indexes = m_indexes;
+   for (int ix = 0; m_stop.load() == 0 && ix < indexes.size(); ix++) {
+      indexes.at(ix)->startWatching();
+      indexes.at(ix)->refresh(&m_stop);
+   }
+   saveAll();
+   time_t lastSave = time(NULL);
+   while (m_stop.load() == 0) {
+      QList<QByteArray> bases;
+      {
+         QMutexLocker locker(&m_mutex);
+         bases = m_newBases;
+         m_newBases.clear();
+      }
+      for (int ix = 0; m_stop.load() == 0 && ix < bases.size(); ix++) {
+         ReFileIndex* index = new ReFileIndex(bases.at(ix), m_logger);
+         index->startWatching();
+         index->refresh(&m_stop);
+         index->save(filenameOf(index->base()));
+         QMutexLocker locker(&m_mutex);
+         m_indexes.append(index);
+      }
+      indexes = m_indexes;
+#if defined __linux__
+      QVector<struct pollfd> fds;
+      for (int ix = 0; ix < indexes.size(); ix++) {
+         struct pollfd fd;
+         fd.fd = indexes.at(ix)->handle();
+         fd.events = POLLIN;
+         fd.revents = 0;
+         fds.append(fd);
+      }
+      if (poll(fds.data(), fds.size(), 500) > 0) {
+         for (int ix = 0; ix < fds.size(); ix++) {
+            if ((fds.at(ix).revents & POLLIN) != 0)
+               indexes.at(ix)->processEvents();
+         }
+      }
+#else
+      msleep(500);
+#endif
+      if (time(NULL) - lastSave >= 60) {
+         // without notifications (or over the watch limit of the system)
+         // the changes are found by polling:
+         for (int ix = 0; m_stop.load() == 0 && ix < indexes.size(); ix++) {
+            if (indexes.at(ix)->needsPolling())
+               indexes.at(ix)->refresh(&m_stop);
+         }
+         saveAll();
+         lastSave = time(NULL);
+      }
+   }
+   saveAll();
+}
+
+/**
+ * Saves the changed indexes.
+ */
+void ReFileIndexer::saveAll() {
+   QList<ReFileIndex*> indexes;
+   {
+      QMutexLocker locker(&m_mutex);
+      indexes = m_indexes;
+   }
+   for (int ix = 0; ix < indexes.size(); ix++) {
+      if (indexes.at(ix)->isDirty())
+         indexes.at(ix)->save(filenameOf(indexes.at(ix)->base()));
+   }
+}
+
+/**
+ * Requests the end of the thread.
+ */
+void ReFileIndexer::stop() {
+   m_stop.store(1);
+}
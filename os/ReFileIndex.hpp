@@ -0,0 +1,195 @@
+/*
+ * ReFileIndex.hpp
+ *
+ * (Un)License: Public Domain
+ * You can use and modify this file without any restriction.
+ * Do what you want.
+ * No warranties and disclaimer of any damages.
+ * More info: http://unlicense.org
+ * The latest sources: https://github.com/republib
+ */
+
+#ifndef OS_REFILEINDEX_HPP_
+#define OS_REFILEINDEX_HPP_
+
+#include <QReadWriteLock>
+#include <QThread>
+#include <QAtomicInt>
+
+/**
+ * One entry (file, link or subdirectory) of an indexed directory.
+ */
+class ReIndexEntry_t {
+public:
+   // the offset of the name in ReIndexDir_t::m_names:
+   int m_node;
+   // a ReDirStatus_t::Type_t value:
+   int m_type;
+   int64_t m_size;
+   // msec since the epoch:
+   int64_t m_modified;
+};
+
+/**
+ * One directory of a file index.
+ */
+class ReIndexDir_t {
+public:
+   ReIndexDir_t();
+public:
+   void addTrigrams(const char* node, int length);
+   bool hasTrigrams(const QList<int>& trigrams) const;
+   /** Returns the name of an entry.
+    * @param entry  the index of the entry in <code>m_entries</code>
+    * @return       the name of the entry ('\0' terminated)
+    */
+   inline const char* node(int entry) const {
+      return m_names.constData() + m_entries.at(entry).m_node;
+   }
+public:
+   /// the index of the parent in ReFileIndex::m_dirs. -1: the base.
+   /// -2: the slot is unused
+   int m_parent;
+   /// the name without path. The base has the full path
+   QByteArray m_node;
+   /// the modification time of the directory (msec). -1: not yet read
+   int64_t m_modified;
+   /// the '\0' terminated names of the entries
+   QByteArray m_names;
+   QVector<ReIndexEntry_t> m_entries;
+   /// the indexes of the (true) subdirectories in ReFileIndex::m_dirs
+   QVector<int> m_subdirs;
+   /// a bit for each (hashed) trigram of the lower case names of the entries
+   uint64_t m_trigrams[4];
+   /// the inotify watch descriptor. -1: not watched
+   int m_watch;
+};
+
+class ReIndexQuery_t;
+/**
+ * Receives the entries found by <code>ReFileIndex::query()</code>.
+ */
+class ReFileIndexVisitor {
+public:
+   virtual ~ReFileIndexVisitor() {
+   }
+public:
+   /** Processes a found entry.
+    * @param path   the directory of the entry with a trailing separator
+    * @param node   the name of the entry
+    * @param entry  the meta data of the entry
+    * @return       <code>false</code>: the query should be stopped
+    */
+   virtual bool visit(const QByteArray& path, const char* node,
+                      const ReIndexEntry_t& entry) = 0;
+};
+
+/**
+ * A persistent index of the file names below a base directory.
+ *
+ * The index can be refreshed incrementally: at startup only the directories
+ * with a changed modification time are read again. While running, the
+ * changes are reported by inotify (linux only).
+ */
+class ReFileIndex {
+public:
+   ReFileIndex(const QByteArray& base, ReLogger* logger);
+   ~ReFileIndex();
+public:
+   /** Returns the base directory of the index.
+    * @return the base directory (without trailing separator)
+    */
+   inline const QByteArray& base() const {
+      return m_base;
+   }
+   bool contains(const QByteArray& path) const;
+   int entries() const;
+   /** Returns the file descriptor of inotify.
+    * @return -1: not watching<br>
+    *          otherwise: the file descriptor for <code>poll()</code>
+    */
+   inline int handle() const {
+      return m_inotify;
+   }
+   /** Returns whether the index has been changed since the last save.
+    * @return <code>true</code>: the index should be saved
+    */
+   inline bool isDirty() const {
+      return m_dirty;
+   }
+   bool load(const QByteArray& filename);
+   /** Returns whether changes may be missed by the notifications.
+    * @return <code>true</code>: the index must be refreshed regularly
+    *          (not watching or the system limit of watches is reached)
+    */
+   inline bool needsPolling() const {
+      return m_inotify < 0 || m_watchLimit;
+   }
+   int processEvents();
+   int query(const QByteArray& path, const ReDirEntryFilter& filter,
+             ReFileIndexVisitor& visitor) const;
+   int refresh(const QAtomicInt* stop = NULL);
+   bool save(const QByteArray& filename);
+   bool startWatching();
+   void stopWatching();
+public:
+   static QByteArray baseOf(const QByteArray& filename);
+protected:
+   int allocDir(int parent, const QByteArray& node);
+   void freeDir(int dir);
+   int findDir(const QByteArray& path) const;
+   QByteArray pathOf(int dir) const;
+   bool queryDir(int dir, QByteArray& path, int level,
+                 ReIndexQuery_t& query) const;
+   void readDir(int dir, const QByteArray& path);
+   int refreshDir(int dir, QByteArray& path, bool deep,
+                  const QAtomicInt* stop = NULL);
+   void updateEntry(int dir, const char* node);
+   void watch(int dir, const QByteArray& path);
+protected:
+   QByteArray m_base;
+   // m_dirs[0] is the base:
+   QVector<ReIndexDir_t> m_dirs;
+   // the unused slots in m_dirs:
+   QVector<int> m_freeDirs;
+   ReLogger* m_logger;
+   // protects the members above against the indexer thread:
+   mutable QReadWriteLock m_lock;
+   bool m_dirty;
+   int m_inotify;
+   // inotify watch descriptor -> index in m_dirs
+   QHash<int, int> m_watches;
+   // true: the system limit of watches has been reached
+   bool m_watchLimit;
+};
+
+/**
+ * Builds, refreshes and saves the file indexes in a background thread.
+ */
+class ReFileIndexer : public QThread {
+public:
+   ReFileIndexer(const QByteArray& indexDir, ReLogger* logger);
+   ~ReFileIndexer();
+public:
+   void addBase(const QByteArray& base);
+   ReFileIndex* indexOf(const QByteArray& path);
+   void run();
+   void stop();
+protected:
+   QByteArray filenameOf(const QByteArray& base) const;
+   void saveAll();
+private:
+   // the directory containing the index files:
+   QByteArray m_indexDir;
+   ReLogger* m_logger;
+   // the ready to use indexes:
+   QList<ReFileIndex*> m_indexes;
+   // the base directories waiting for the first build:
+   QList<QByteArray> m_newBases;
+   // protects m_indexes and m_newBases:
+   QMutex m_mutex;
+   // != 0: the thread should end. Also stops a running refresh
+   QAtomicInt m_stop;
+};
+
+#endif /* OS_REFILEINDEX_HPP_ */
@@ -507,18 +507,20 @@ int ReLocalFileSystem::listInfos(const ReIncludeExcludeMatcher& matcher,
    for (it = nodes.cbegin(); it != nodes.cend(); it++) {
       QString node = *it;
       if (node != "." &&  node != "..") {
+         full.resize(pathLength);
+         full.append(I18N::s2b(node));
+         const char* node2 = full.constData() + pathLength;
+         int nodeLength = full.length() - pathLength;
          if (earlyMatching) {
-            if (excludeActive && excludeMatcher.matches(node))
+            if (excludeActive && excludeMatcher.matches(node2, nodeLength))
                continue;
          }
-         full.resize(pathLength);
-         full.append(I18N::s2b(node));
          if (stat(full.constData(), &info) == 0) {
             bool isDir = S_ISDIR(info.st_mode);
             if ((isDir && ! withDirs) || (! isDir && ! withFiles))
                continue;
             if (! earlyMatching) {
-               if ( (! isDir || matchDirs) && ! matcher.matches(node))
+               if ( (! isDir || matchDirs) && ! matcher.matches(node2, nodeLength))
                   continue;
             }
             list.append(
@@ -843,6 +845,29 @@ ReFileMetaData& ReFileMetaData::operator =(const ReFileMetaData& source) {
    return *this;
 }
 
+/**
+ * Allocates the memory of an instance.
+ *
+ * The entries of a <code>ReFileMetaDataList</code> are allocated one by one:
+ * the pool is much faster than the heap.
+ *
+ * @param size  the size of the instance
+ * @return      the memory for the instance
+ */
+void* ReFileMetaData::operator new(size_t size) {
+   return ReConcurrentPool::global().allocate(size);
+}
+
+/**
+ * Frees the memory of an instance.
+ *
+ * @param block the memory of the instance
+ * @param size  the size of the instance
+ */
+void ReFileMetaData::operator delete(void* block, size_t size) {
+   ReConcurrentPool::global().free(block, size);
+}
+
 /**
  * Constructor.
  */
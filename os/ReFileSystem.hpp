@@ -33,6 +33,9 @@ public:
    virtual ~ReFileMetaData();
    ReFileMetaData(const ReFileMetaData& source);
    ReFileMetaData& operator =(const ReFileMetaData& source);
+public:
+   static void* operator new(size_t size);
+   static void operator delete(void* block, size_t size);
 public:
    QString m_node;
    QDateTime m_modified;
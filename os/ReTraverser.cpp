@@ -28,8 +28,6 @@ enum {
    LC_GET_FILE_OWNER_2,	// 50408
 };
 
-int ReDirEntryFilter::m_serialId = buildSerialId(CLASSID_DIR_ENTRY_FILTER, 1);
-
 /**
  * Constructor.
  */
@@ -38,6 +36,8 @@ ReDirStatus_t::ReDirStatus_t(ReLogger* logger) :
    m_fullName(),
    m_passNo(0),
    m_logger(logger),
+   m_subdirs(),
+   m_nextSubdir(0),
 #ifdef __linux__
    m_handle(NULL),
    m_data(NULL)
@@ -68,6 +68,25 @@ const ReFileTime_t* ReDirStatus_t::accessed() {
 #endif
 }
 
+/**
+ * Releases the handle of the directory listing.
+ *
+ * The path and the collected subdirectories remain valid.
+ */
+void ReDirStatus_t::close() {
+#if defined __linux__
+   if (m_handle != NULL) {
+      closedir(m_handle);
+      m_handle = NULL;
+   }
+#elif defined __WIN32__
+   if (m_handle != INVALID_HANDLE_VALUE) {
+      FindClose(m_handle);
+      m_handle = INVALID_HANDLE_VALUE;
+   }
+#endif
+}
+
 /**
  * Returns the filesize.
  *
@@ -85,9 +104,9 @@ ReFileSize_t ReDirStatus_t::fileSize() {
  * Returns the file time as a string.
  *
  * @param buffer    OUT: the file time
- * @return          <code>buffer.str()</code> (for chaining)
+ * @return          <code>buffer.constData()</code> (for chaining)
  */
-const char* ReDirStatus_t::filetimeAsString(ReByteBuffer& buffer) {
+const char* ReDirStatus_t::filetimeAsString(QByteArray& buffer) {
    return filetimeToString(modified(), buffer);
 }
 
@@ -96,15 +115,34 @@ const char* ReDirStatus_t::filetimeAsString(ReByteBuffer& buffer) {
  *
  * @param time		the filetime to convert
  * @param buffer	OUT: the buffer for the string
- * @return 			<code>buffer.str()</code>, e.g. "2014.01.07 02:59:43"
+ * @return 			<code>buffer.constData()</code>, e.g. "2014.01.07 02:59:43"
  */
 const char* ReDirStatus_t::filetimeToString(const ReFileTime_t* time,
-      ReByteBuffer& buffer) {
+      QByteArray& buffer) {
    time_t time1 = filetimeToTime(time);
    struct tm* time2 = localtime(&time1);
-   buffer.setLength(4 + 2 * 2 + 2 * 2 + 1 + 3 * 2 + 2 * 1);
-   strftime(buffer.buffer(), buffer.length(), "%Y.%m.%d %H:%M:%S", time2);
-   return buffer.str();
+   buffer.resize(4 + 2 * 2 + 2 * 2 + 1 + 3 * 2 + 2 * 1 + 1);
+   int length = strftime(buffer.data(), buffer.length(), "%Y.%m.%d %H:%M:%S",
+                         time2);
+   buffer.resize(length);
+   return buffer.constData();
+}
+
+/**
+ * Converts a filetime to the milliseconds since the Epoche.
+ *
+ * @param filetime		the filetime to convert
+ * @return 				the count of milliseconds since 1.1.1970
+ */
+int64_t ReDirStatus_t::filetimeToMSec(const ReFileTime_t* filetime) {
+#ifdef __linux__
+   return int64_t(filetime->tv_sec) * 1000 + filetime->tv_nsec / 1000000;
+#elif defined __WIN32__
+   int64_t value = (int64_t(filetime->dwHighDateTime) << 32)
+                   + filetime->dwLowDateTime;
+   // 100-nanoseconds since 1601 -> milliseconds since 1970:
+   return value / 10000 - 11644473600000LL;
+#endif
 }
 
 /**
@@ -141,18 +179,18 @@ bool ReDirStatus_t::findFirst() {
 #if defined __linux__
    if (m_handle != NULL)
       closedir(m_handle);
-   m_handle = opendir(m_path.str());
+   m_handle = opendir(m_path.constData());
    rc = m_handle != NULL && (m_data = readdir(m_handle)) != NULL;
    m_status.st_ino = 0;
 #elif defined __WIN32__
    if (m_handle != INVALID_HANDLE_VALUE)
       FindClose(m_handle);
-   ReByteBuffer thePath(m_path);
-   thePath.append(m_path.lastChar() == '\\' ? "*" : "\\*");
-   m_handle = FindFirstFileA(thePath.str(), &m_data);
+   QByteArray thePath(m_path);
+   thePath.append(m_path.endsWith('\\') ? "*" : "\\*");
+   m_handle = FindFirstFileA(thePath.constData(), &m_data);
    rc = m_handle != INVALID_HANDLE_VALUE;
 #endif
-   m_fullName.setLength(0);
+   m_fullName.resize(0);
    return rc;
 }
 
@@ -168,7 +206,7 @@ bool ReDirStatus_t::findNext() {
 #elif defined __WIN32__
    bool rc = m_handle != INVALID_HANDLE_VALUE && FindNextFileA(m_handle, &m_data);
 #endif
-   m_fullName.setLength(0);
+   m_fullName.resize(0);
    return rc;
 }
 
@@ -176,19 +214,11 @@ bool ReDirStatus_t::findNext() {
  * Frees the resources of an instance.
  */
 void ReDirStatus_t::freeEntry() {
-#if defined __linux__
-   if (m_handle != NULL) {
-      closedir(m_handle);
-      m_handle = NULL;
-   }
-#elif defined __WIN32__
-   if (m_handle != INVALID_HANDLE_VALUE) {
-      FindClose(m_handle);
-      m_handle = INVALID_HANDLE_VALUE;
-   }
-#endif
-   m_path.setLength(0);
-   m_fullName.setLength(0);
+   close();
+   m_path.resize(0);
+   m_fullName.resize(0);
+   m_subdirs.clear();
+   m_nextSubdir = 0;
 }
 
 /**
@@ -198,8 +228,8 @@ void ReDirStatus_t::freeEntry() {
  */
 const char* ReDirStatus_t::fullName() {
    if (m_fullName.length() == 0)
-      m_fullName.set(m_path).append(node(), -1);
-   return m_fullName.str();
+      m_fullName.append(m_path).append(node());
+   return m_fullName.constData();
 }
 
 #if defined __WIN32__
@@ -210,15 +240,15 @@ const char* ReDirStatus_t::fullName() {
  * @return			<code>true</code>: success
  */
 bool ReDirStatus_t::getFileOwner(HANDLE handle, const char* file,
-                                 ReByteBuffer& name, ReLogger* logger) {
+                                 QByteArray& name, ReLogger* logger) {
    bool rc = false;
    PSID pSidOwner = NULL;
    PSECURITY_DESCRIPTOR pSD = NULL;
    if (GetSecurityInfo(handle, SE_FILE_OBJECT,
                        OWNER_SECURITY_INFORMATION, &pSidOwner, NULL, NULL, NULL, &pSD) != ERROR_SUCCESS) {
       if (logger != NULL)
-         logger->sayF(LOG_ERROR | CAT_FILE, LC_GET_FILE_OWNER_1,
-                      "GetSecurityInfo($1): $2").arg(file).arg((int) GetLastError()).end();
+         logger->logv(LOG_ERROR, LC_GET_FILE_OWNER_1, "GetSecurityInfo(%s): %d",
+                      file, (int) GetLastError());
    } else {
       char accountName[128];
       char domainName[128];
@@ -228,11 +258,11 @@ bool ReDirStatus_t::getFileOwner(HANDLE handle, const char* file,
       if (! LookupAccountSid(NULL, pSidOwner, accountName, &dwAcctName, domainName,
                              &dwDomainName, &eUse)) {
          if (logger != NULL)
-            logger->sayF(LOG_ERROR | CAT_SECURITY, LC_GET_FILE_OWNER_2,
-                         "LookupAccountSid(): $1").arg((int) GetLastError()).end();
+            logger->logv(LOG_ERROR, LC_GET_FILE_OWNER_2,
+                         "LookupAccountSid(): %d", (int) GetLastError());
       } else {
          if (dwDomainName > 0)
-            name.append(domainName).appendChar('\\');
+            name.append(domainName).append('\\');
          name.append(accountName);
          rc = true;
       }
@@ -254,12 +284,12 @@ bool ReDirStatus_t::getPrivilege(const char* privilege, ReLogger* logger) {
    if (! OpenProcessToken (GetCurrentProcess(),
                            TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &hAccessToken)) {
       if (logger != NULL)
-         logger->sayF(LOG_ERROR | CAT_FILE, LC_GET_PRIVILEGE_1,
-                      "OpenProcessToken(): $1").arg((int) GetLastError()).end();
+         logger->logv(LOG_ERROR, LC_GET_PRIVILEGE_1, "OpenProcessToken(): %d",
+                      (int) GetLastError());
    } else if (! LookupPrivilegeValue (NULL, SE_BACKUP_NAME, &luidPrivilege)) {
       if (logger != NULL)
-         logger->sayF(LOG_ERROR | CAT_FILE, LC_GET_PRIVILEGE_2,
-                      "LookupPrivilegeValue(): $1").arg((int) GetLastError()).end();
+         logger->logv(LOG_ERROR, LC_GET_PRIVILEGE_2,
+                      "LookupPrivilegeValue(): %d", (int) GetLastError());
    } else {
       TOKEN_PRIVILEGES tpPrivileges;
       tpPrivileges.PrivilegeCount = 1;
@@ -271,8 +301,8 @@ bool ReDirStatus_t::getPrivilege(const char* privilege, ReLogger* logger) {
       else {
          int error = GetLastError();
          if (error != 1300 && logger != NULL)
-            logger->sayF(LOG_ERROR | CAT_FILE, LC_GET_PRIVILEGE_3,
-                         "AdjustTokenPrivileges(): $1").arg((int) GetLastError()).end();
+            logger->logv(LOG_ERROR, LC_GET_PRIVILEGE_3,
+                         "AdjustTokenPrivileges(): %d", (int) GetLastError());
       }
    }
    return rc;
@@ -367,7 +397,7 @@ const char* ReDirStatus_t::node() const {
 #endif
 }
 
-inline void addRight(int mode, ReByteBuffer& buffer) {
+inline void addRight(int mode, QByteArray& buffer) {
    char right;
    switch (mode & 7) {
    case 1:
@@ -395,14 +425,14 @@ inline void addRight(int mode, ReByteBuffer& buffer) {
       right = '-';
       break;
    }
-   buffer.appendChar(right);
+   buffer.append(right);
 }
-inline void addId(const char* id, int maxLength, ReByteBuffer& buffer) {
+inline void addId(const char* id, int maxLength, QByteArray& buffer) {
    int length = strlen(id);
    if (length == maxLength)
       buffer.append(id, length);
    else if (length < maxLength)
-      buffer.append(id, length).appendChar(' ', maxLength - length);
+      buffer.append(id, length).append(QByteArray(maxLength - length, ' '));
    else {
       buffer.append(id, 2);
       buffer.append(id + length - maxLength - 2, maxLength - 2);
@@ -414,34 +444,38 @@ inline void addId(const char* id, int maxLength, ReByteBuffer& buffer) {
  * @param buffer		OUT: the file rights
  * @param numerical		<code>true</code>: the owner/group should be numerical (UID/GID)
  * @param ownerWidth	the width for group/owner
- * @return				<code>buffer.str()</code> (for chaining)
+ * @return				<code>buffer.constData()</code> (for chaining)
  */
-const char* ReDirStatus_t::rightsAsString(ReByteBuffer& buffer, bool numerical,
+const char* ReDirStatus_t::rightsAsString(QByteArray& buffer, bool numerical,
       int ownerWidth) {
-   buffer.setLength(0);
+   buffer.resize(0);
 #if defined __linux__
+   char number[32];
    if (numerical) {
-      buffer.appendInt(getStatus()->st_mode & ALLPERMS, "%04o");
-      buffer.appendInt(getStatus()->st_uid, " %4d");
-      buffer.appendInt(getStatus()->st_gid, " %4d");
+      qsnprintf(number, sizeof number, "%04o %4d %4d",
+                getStatus()->st_mode & ALLPERMS, getStatus()->st_uid,
+                getStatus()->st_gid);
+      buffer.append(number);
    } else {
       int mode = getStatus()->st_mode & ALLPERMS;
       addRight(mode >> 6, buffer);
       addRight(mode >> 3, buffer);
       addRight(mode, buffer);
-      buffer.appendChar(' ');
+      buffer.append(' ');
       struct passwd* passwd = getpwuid(getStatus()->st_uid);
-      if (passwd == NULL)
-         buffer.appendInt(getStatus()->st_uid, "%4d");
-      else
+      if (passwd == NULL) {
+         qsnprintf(number, sizeof number, "%4d", getStatus()->st_uid);
+         buffer.append(number);
+      } else
          addId(passwd->pw_name, 5, buffer);
-      buffer.appendChar(' ');
+      buffer.append(' ');
       struct group* group = getgrgid(getStatus()->st_gid);
-      if (group == NULL)
-         buffer.appendInt(getStatus()->st_gid, "%4d");
-      else
+      if (group == NULL) {
+         qsnprintf(number, sizeof number, "%4d", getStatus()->st_gid);
+         buffer.append(number);
+      } else
          addId(group->gr_name, 5, buffer);
-      buffer.appendChar(' ');
+      buffer.append(' ');
    }
 #elif defined __WIN32__
    const char* name = fullName();
@@ -449,25 +483,25 @@ const char* ReDirStatus_t::rightsAsString(ReByteBuffer& buffer, bool numerical,
    if (! isDirectory()) {
       if ( (handle = CreateFile(name, GENERIC_READ, FILE_SHARE_READ, NULL,
                                 OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL)) == INVALID_HANDLE_VALUE)
-         m_logger->sayF(LOG_ERROR | CAT_FILE, LC_RIGHTS_AS_STRING_1,
-                        "CreateFile($1): $2").arg(name).arg((int) GetLastError()).end();
+         m_logger->logv(LOG_ERROR, LC_RIGHTS_AS_STRING_1, "CreateFile(%s): %d",
+                        name, (int) GetLastError());
    } else if (m_getPrivilege) {
       // we try only one time:
       m_getPrivilege = false;
       if (getPrivilege(SE_BACKUP_NAME, m_logger)) {
          if ( (handle = CreateFile(name, 0, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
                                    NULL)) != INVALID_HANDLE_VALUE)
-            m_logger->sayF(LOG_ERROR | CAT_FILE, LC_RIGHTS_AS_STRING_2,
-                           "CreateFile($1): $2").arg(name).arg((int) GetLastError()).end();
+            m_logger->logv(LOG_ERROR, LC_RIGHTS_AS_STRING_2,
+                           "CreateFile(%s): %d", name, (int) GetLastError());
       }
    }
-   ReByteBuffer owner;
+   QByteArray owner;
    if (handle != INVALID_HANDLE_VALUE)
       getFileOwner(handle, name, owner, m_logger);
    CloseHandle(handle);
-   buffer.appendFix(owner.str(), owner.length(), ownerWidth, ownerWidth);
+   buffer.append(owner.leftJustified(ownerWidth, ' ', true));
 #endif
-   return buffer.str();
+   return buffer.constData();
 }
 
 /**
@@ -488,11 +522,27 @@ void ReDirStatus_t::timeToFiletime(time_t time, ReFileTime_t& filetime) {
 }
 /**
  * Returns the type of the entry.
+ *
+ * Under linux the type delivered by <code>readdir()</code> is used if
+ * available: the status of the file is read only for links and file systems
+ * without that info.
+ *
  * return       the file type, e.g. TF_REGULAR
  */
 ReDirStatus_t::Type_t ReDirStatus_t::type() {
    Type_t rc = TF_UNDEF;
 #if defined __linux__
+   switch (m_data->d_type) {
+   case DT_DIR:
+      return TF_SUBDIR;
+   case DT_REG:
+      return TF_REGULAR;
+   case DT_LNK:
+      // stat() follows the link:
+      return S_ISDIR(getStatus()->st_mode) ? TF_LINK_DIR : TF_LINK;
+   default:
+      break;
+   }
    int flags = getStatus()->st_mode;
    if (S_ISDIR(flags))
       rc = TF_SUBDIR;
@@ -547,6 +597,7 @@ char ReDirStatus_t::typeAsChar() {
       rc = ' ';
       break;
    case TF_LINK:
+   case TF_LINK_DIR:
       rc = 'l';
       break;
    case TF_SUBDIR:
@@ -574,7 +625,6 @@ char ReDirStatus_t::typeAsChar() {
  * Constructor.
  */
 ReDirEntryFilter::ReDirEntryFilter() :
-   ReSerializable(m_serialId),
    m_types(ReDirStatus_t::TC_ALL),
    m_nodePatterns(NULL),
    m_pathPatterns(NULL),
@@ -595,60 +645,12 @@ ReDirEntryFilter::ReDirEntryFilter() :
 ReDirEntryFilter::~ReDirEntryFilter() {
 }
 
-/**
- * Sets the members of the instance from a byte sequence.
- *
- * @param sequence	IN/OUT: the serialized byte sequence
- * @param length	INT/OUT	the length of <code>sequence</code>
- */
-void ReDirEntryFilter::deserialize(const uint8_t*& sequence, size_t& length) {
-   int id;
-   unpackInt24(sequence, length, id);
-   if (id != m_serialId)
-      throw ReSerializeFormatException("wrong serialId", this);
-   ReByteBuffer buffer;
-   unpackString64k(sequence, length, buffer);
-   bool ignoreCase;
-   unpackBool(sequence, length, ignoreCase);
-   m_nodePatterns->set(buffer.str(), ignoreCase);
-   unpackString64k(sequence, length, buffer);
-   unpackBool(sequence, length, ignoreCase);
-   unpackString64k(sequence, length, buffer);
-   m_pathPatterns->set(buffer.str(), ignoreCase);
-   unpackInt64(sequence, length, m_minSize);
-   unpackInt64(sequence, length, m_maxSize);
-   int64_t value;
-   unpackInt64(sequence, length, value);
-   unpackBool(sequence, length, m_allDirectories);
-}
-/**
- * Packs the members into a byte sequence.
- *
- * @param sequence	IN/OUT: the place for the byte sequence
- */
-ReByteBuffer& ReDirEntryFilter::serialize(ReByteBuffer& sequence) {
-   sequence.appendBits24(m_serialId);
-   packString64k(sequence, m_nodePatterns->patternString());
-   packBool(sequence, m_nodePatterns->ignoreCase());
-   packString64k(sequence, m_pathPatterns->patternString());
-   packBool(sequence, m_pathPatterns->ignoreCase());
-   sequence.appendBits64(m_minSize);
-   sequence.appendBits64(m_maxSize);
-   uint64_t value;
-#if defined __linux__
-   value = (m_minAge.tv_sec << 32) + m_minAge.tv_nsec;
-   sequence.appendBits64(int64_t(value));
-   value = (m_minAge.tv_sec << 32) + m_minAge.tv_nsec;
-#elif defined __WIN32__
-#error "missing impl"
-#endif
-   sequence.appendBits64(int64_t(value));
-   packBool(sequence, m_allDirectories);
-}
-
 /**
  * Tests whether an entry matches the conditions of the filter.
  *
+ * The cheap conditions are tested first: the name and (mostly) the type
+ * do not need the file status. The status is read at most once.
+ *
  * @param entry		entry to test
  * @return 			<code>true</code>: the entry matches the conditions of the filter<br>
  * 					<code>false</code>: otherwise
@@ -660,25 +662,25 @@ bool ReDirEntryFilter::match(ReDirStatus_t& entry) {
          rc = true;
          break;
       }
-      if (0 == (entry.type() & m_types))
-         break;
-      int64_t size = entry.fileSize();
-      if (m_minSize > 0 && size < m_minSize)
+      if (m_nodePatterns != NULL && !m_nodePatterns->matches(entry.node(), -1))
          break;
-      if (m_maxSize >= 0 && size > m_maxSize)
+      if (0 == (entry.type() & m_types))
          break;
+      if (m_minSize > 0 || m_maxSize >= 0) {
+         int64_t size = entry.fileSize();
+         if (m_minSize > 0 && size < m_minSize)
+            break;
+         if (m_maxSize >= 0 && size > m_maxSize)
+            break;
+      }
       if (!filetimeIsUndefined(m_minAge) && *entry.modified() > m_minAge)
          break;
       if (!filetimeIsUndefined(m_maxAge) && m_maxAge > *entry.modified())
          break;
-      const char* node = entry.node();
-      if (m_nodePatterns != NULL && !m_nodePatterns->match(node))
-         break;
       rc = true;
    } while (false);
    return rc;
 }
-;
 
 #ifdef __linux__
 /**
@@ -714,18 +716,22 @@ ReDirTreeStatistic::ReDirTreeStatistic() :
  * @param formatDirs	the <code>sprintf</code> format for the directory count, e.g. "%6d"
  * @return				a human readable string
  */
-const char* ReDirTreeStatistic::statisticAsString(ReByteBuffer& buffer,
+const char* ReDirTreeStatistic::statisticAsString(QByteArray& buffer,
       bool append, const char* formatFiles, const char* formatSizes,
       const char* formatDirs) {
+   char number[64];
    if (!append)
-      buffer.setLength(0);
-   buffer.appendInt(m_files, formatFiles);
-   buffer.append(i18n("file(s)")).appendChar(' ');
-   buffer.append(m_sizes / 1000.0 / 1000, formatSizes);
-   buffer.append(" ", 1).append(i18n("MByte")).appendChar(' ');
-   buffer.appendInt(m_directories, formatDirs);
-   buffer.append(i18n("dirs(s)"));
-   return buffer.str();
+      buffer.resize(0);
+   qsnprintf(number, sizeof number, formatFiles, m_files);
+   buffer.append(number);
+   buffer.append(I18N::s2b(QObject::tr("file(s)"))).append(' ');
+   qsnprintf(number, sizeof number, formatSizes, m_sizes / 1000.0 / 1000);
+   buffer.append(number);
+   buffer.append(' ').append(I18N::s2b(QObject::tr("MByte"))).append(' ');
+   qsnprintf(number, sizeof number, formatDirs, m_directories);
+   buffer.append(number);
+   buffer.append(I18N::s2b(QObject::tr("dirs(s)")));
+   return buffer.constData();
 }
 
 /**
@@ -783,8 +789,7 @@ ReTraverser::ReTraverser(const char* base, ReTraceUnit* tracer,
    memset(m_dirs, 0, sizeof m_dirs);
    m_dirs[0] = new ReDirStatus_t(m_logger);
    // remove a preceeding "./". This simplifies the pattern expressions:
-   if (m_base.startsWith(
-            ReByteBuffer(".").appendChar(OS_SEPARATOR_CHAR).str())) {
+   if (m_base.startsWith("." OS_SEPARATOR_STR)) {
       m_base.remove(0, 2);
    }
 }
@@ -803,12 +808,12 @@ ReTraverser::~ReTraverser() {
  */
 void ReTraverser::changeBase(const char* base) {
    destroy();
-   m_base.setLength(0).append(base);
+   m_level = -1;
+   m_base = base;
    memset(m_dirs, 0, sizeof m_dirs);
    m_dirs[0] = new ReDirStatus_t(m_logger);
    // remove a preceeding "./". This simplifies the pattern expressions:
-   if (m_base.startsWith(
-            ReByteBuffer(".").appendChar(OS_SEPARATOR_CHAR).str())) {
+   if (m_base.startsWith("." OS_SEPARATOR_STR)) {
       m_base.remove(0, 2);
    }
 }
@@ -828,6 +833,10 @@ void ReTraverser::destroy() {
 /**
  * Returns the info about the next file in the directory tree traversal.
  *
+ * In breadth first mode each directory is read only once: the subdirectories
+ * found while returning the entries are remembered and entered in the
+ * second pass. In depth first mode the directory is read twice.
+ *
  * @param level	OUT: the level relative to the base.<br>
  * 					0 means the file is inside the base.<br>
  * 					Not defined if the result is NULL
@@ -847,7 +856,7 @@ ReDirStatus_t* ReTraverser::rawNextFile(int& level) {
             rc = NULL;
          else {
             // first call:
-            if (initEntry(m_base.str(), NULL, 0)) {
+            if (initEntry(m_base, NULL, 0)) {
                m_directories++;
                if (1 != m_passNoForDirSearch)
                   rc = m_dirs[0];
@@ -857,7 +866,22 @@ ReDirStatus_t* ReTraverser::rawNextFile(int& level) {
          }
       } else {
          ReDirStatus_t* current = m_dirs[m_level];
-         if (alreadyRead || current->findNext()) {
+         if (current->m_passNo == 2 && m_passNoForDirSearch == 2) {
+            // breadth first: the subdirectories have been collected in pass 1
+            if (current->m_nextSubdir < current->m_subdirs.size()) {
+               const QByteArray& node = current->m_subdirs.at(
+                                           current->m_nextSubdir++);
+               // open a new level
+               alreadyRead = initEntry(current->m_path, node.constData(),
+                                       m_level + 1);
+               m_directories++;
+            } else {
+               // this subdirectory is complete. We continue in the parent directory:
+               current->freeEntry();
+               --m_level;
+            }
+            again = m_level >= 0;
+         } else if (alreadyRead || current->findNext()) {
             alreadyRead = false;
             // a file or directory found:
             if (m_tracer != NULL && m_tracer->isCountTriggered()
@@ -869,10 +893,7 @@ ReDirStatus_t* ReTraverser::rawNextFile(int& level) {
             } else {
                // we are interested only in true subdirectories:
                again = true;
-               if (m_level < m_maxLevel && current->isDirectory()
-                     && !current->isDotDir() && !current->isLink()
-                     && (m_dirPatterns == NULL
-                         || isAllowedDir(current->node()))) {
+               if (isEnterable(current)) {
                   // open a new level
                   alreadyRead = initEntry(current->m_path,
                                           current->node(), m_level + 1);
@@ -883,7 +904,11 @@ ReDirStatus_t* ReTraverser::rawNextFile(int& level) {
             // the current subdir does not have more files:
             if (current->m_passNo == 1) {
                // we start the second pass:
-               alreadyRead = initEntry(current->m_path, NULL, -1);
+               if (m_passNoForDirSearch == 2) {
+                  current->close();
+                  current->m_nextSubdir = 0;
+               } else
+                  alreadyRead = initEntry(current->m_path, NULL, -1);
                current->m_passNo = 2;
                again = true;
             } else {
@@ -895,20 +920,23 @@ ReDirStatus_t* ReTraverser::rawNextFile(int& level) {
             }
          }
       }
-      if (rc != NULL && rc->isDotDir())
-         again = true;
+      if (rc != NULL) {
+         if (rc->isDotDir()) {
+            rc = NULL;
+            again = true;
+         } else if (m_passNoForDirSearch == 2 && rc->m_passNo == 1
+                    && isEnterable(rc))
+            rc->m_subdirs.append(QByteArray(rc->node()));
+      }
    } while (again);
-   if (rc != NULL && !rc->isDirectory()) {
-      m_files++;
-      if (m_sizes >= 0)
-         m_sizes += rc->fileSize();
-   }
    level = m_level;
    return rc;
 }
 /**
  * Returns the info about the next file matching the filter options.
  *
+ * Only the returned files are counted in the statistic.
+ *
  * @param level	OUT: the level relative to the base.<br>
  * 					0 means the file is inside the base.<br>
  * 					Not defined if the result is NULL
@@ -921,11 +949,16 @@ ReDirStatus_t* ReTraverser::rawNextFile(int& level) {
 ReDirStatus_t* ReTraverser::nextFile(int& level, ReDirEntryFilter* filter) {
    ReDirStatus_t* rc = rawNextFile(level);
    while (rc != NULL) {
-      if (filter == NULL || filter->match(*rc)) {
+      if (level >= m_minLevel && (filter == NULL || filter->match(*rc))) {
          break;
       }
       rc = rawNextFile(level);
    }
+   if (rc != NULL && !rc->isDirectory()) {
+      m_files++;
+      if (m_sizes >= 0)
+         m_sizes += rc->fileSize();
+   }
    return rc;
 }
 
@@ -939,7 +972,7 @@ ReDirStatus_t* ReTraverser::nextFile(int& level, ReDirEntryFilter* filter) {
  * @return          <code>true</code>: a new file is available<br>
  *                  <code>false</code>: findFirstEntry() signals: no entry.
  */
-bool ReTraverser::initEntry(const ReByteBuffer& parent, const char* node,
+bool ReTraverser::initEntry(const QByteArray& parent, const char* node,
                             int level) {
    bool rc = false;
    if (level < MAX_ENTRY_STACK_DEPTH) {
@@ -950,11 +983,13 @@ bool ReTraverser::initEntry(const ReByteBuffer& parent, const char* node,
       ReDirStatus_t* current = m_dirs[m_level];
       current->m_passNo = 1;
       if (level >= 0) {
-         current->m_path.set(parent.str(), parent.length());
+         current->m_path = parent;
          if (!parent.endsWith(OS_SEPARATOR))
             current->m_path.append(OS_SEPARATOR);
          if (node != NULL)
             current->m_path.append(node).append(OS_SEPARATOR);
+         current->m_subdirs.clear();
+         current->m_nextSubdir = 0;
       }
       rc = current->findFirst();
    }
@@ -65,6 +65,7 @@ public:
    ReDirStatus_t(ReLogger* logger);
 public:
    const ReFileTime_t* accessed();
+   void close();
    ReFileSize_t fileSize();
    const char* filetimeAsString(QByteArray& buffer);
    bool findFirst();
@@ -84,6 +85,7 @@ public:
 public:
    static const char* filetimeToString(const ReFileTime_t* time,
                                        QByteArray& buffer);
+   static int64_t filetimeToMSec(const ReFileTime_t* time);
    static time_t filetimeToTime(const ReFileTime_t* time);
 #if defined __WIN32__
    static bool getFileOwner(HANDLE handle, const char* file, QByteArray& name,
@@ -96,6 +98,10 @@ public:
    QByteArray m_fullName;
    int m_passNo;
    ReLogger* m_logger;
+   // the subdirectories found in the first pass (breadth first only):
+   QList<QByteArray> m_subdirs;
+   // the index of the next subdirectory to enter in m_subdirs:
+   int m_nextSubdir;
 #ifdef __linux__
    DIR* m_handle;
    struct dirent* m_data;
@@ -113,13 +119,13 @@ public:
    ReDirEntryFilter();
    ~ReDirEntryFilter();
 public:
-   virtual void deserialize(const uint8_t*& sequence, size_t& length);
    bool match(ReDirStatus_t& entry);
-   virtual QByteArray& serialize(QByteArray& sequence);
 public:
    ReDirStatus_t::Type_t m_types;
-   RePatternList* m_nodePatterns;
-   RePatternList* m_pathPatterns;
+   // NULL or the patterns of the nodes to find:
+   ReIncludeExcludeMatcher* m_nodePatterns;
+   // NULL or the patterns of the directories to enter:
+   ReIncludeExcludeMatcher* m_pathPatterns;
    ReFileSize_t m_minSize;
    ReFileSize_t m_maxSize;
    ReFileTime_t m_minAge;
@@ -127,8 +133,6 @@ public:
    int m_minDepth;
    int m_maxDepth;
    bool m_allDirectories;
-private:
-   static int m_serialId;
 };
 
 class ReTraceUnit {
@@ -230,10 +234,10 @@ public:
    /** Sets directory filter (pattern list).
     * @param pattern 	pattern list for the subdirs to be entered
     */
-   inline void setDirPattern(RePatternList* pattern) {
+   inline void setDirPattern(ReIncludeExcludeMatcher* pattern) {
       m_dirPatterns = pattern;
       if (pattern != NULL)
-         m_dirPatterns->setIgnoreCase(true);
+         m_dirPatterns->setCaseSensivitiy(Qt::CaseInsensitive);
    }
    /** Sets the maximal depth.
     * @param value     the value to set
@@ -258,7 +262,6 @@ public:
    ReDirStatus_t* topOfStack(int offset = 0);
 protected:
    void destroy();
-   void freeEntry(int level);
    bool initEntry(const QByteArray& parent, const char* node, int level);
    /**
     * Tests whether a directory should be processed.
@@ -267,9 +270,19 @@ protected:
     * 					<code>false</code>: do not enter this subdir
     */
    inline bool isAllowedDir(const char* node) {
-      bool rc = m_dirPatterns->match(node);
+      bool rc = m_dirPatterns->matches(node, -1);
       return rc;
    }
+   /**
+    * Tests whether the current entry is a directory which should be entered.
+    * @param entry		the entry to test
+    * @return			<code>true</code>: the subdir will be processed
+    */
+   inline bool isEnterable(ReDirStatus_t* entry) {
+      return m_level < m_maxLevel && entry->isDirectory()
+             && !entry->isDotDir() && !entry->isLink()
+             && (m_dirPatterns == NULL || isAllowedDir(entry->node()));
+   }
 protected:
    int m_minLevel;
    int m_maxLevel;
@@ -277,11 +290,13 @@ protected:
    QByteArray m_base;
    ReDirStatus_t* m_dirs[MAX_ENTRY_STACK_DEPTH];
    /// each directory will be passed twice: for all files + for directories only
-   /// 1: depth first 2: breadth first
+   /// 1: depth first 2: breadth first.
+   /// Breadth first reads each directory only once: the subdirectories
+   /// are collected in the first pass
    int m_passNoForDirSearch;
    /// a subdirectory will be entered only if this pattern list matches
    /// if NULL any directory will be entered
-   RePatternList* m_dirPatterns;
+   ReIncludeExcludeMatcher* m_dirPatterns;
    ReDirTreeStatistic m_statistic;
    ReTraceUnit* m_tracer;
    ReLogger* m_logger;
@@ -49,6 +49,8 @@ inline bool operator >(const ReFileTime_t& time1, const ReFileTime_t& time2) {
               && time1.dwLowDateTime > time2.dwLowDateTime);
 #endif
 }
+#include "os/ReTraverser.hpp"
+#include "os/ReFileIndex.hpp"
 #include "os/ReFileSystem.hpp"
 #include "os/ReCryptFileSystem.hpp"
 
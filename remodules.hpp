@@ -35,6 +35,7 @@ enum {
    LOC_FILESYSTEM,
    LOC_RANDOMIZER,
    LOC_CRYPTFILESYSTEM,
+   LOC_FILEINDEX,
 };
 #define LOC_FIRST_OF(moduleNo) (moduleNo*100+1)
 class RplModules {
@@ -0,0 +1,92 @@
+#! /usr/bin/perl
+#
+# Builds the format table for the decoding of binary log files
+# (see ReBinaryFileAppender and appl/rebinlog).
+#
+# Usage: mk_logformats.pl [<base_dir>] > logformats.txt
+#
+# Each output line contains the location number, a TAB and the format
+# of the ReLogger::logv() call with this location.
+#
+
+use strict;
+
+my $base = shift || ".";
+my %modules;
+
+&readModules("$base/remodules.hpp");
+&oneDir($base);
+exit 0;
+
+# Reads the module numbers (LOC_LOGGER ...) from remodules.hpp.
+sub readModules{
+	my $filename = shift;
+	open(my $INP, "<", $filename) || die "$filename: $!";
+	my $content = join("", <$INP>);
+	close $INP;
+	&scanEnums($content, \%modules);
+}
+
+# Sets the values of the entries of all enums of a source.
+sub scanEnums{
+	my $content = shift;
+	my $map = shift;
+	while ($content =~ /enum\s*\w*\s*\{([^}]*)\}/gs){
+		my $body = $1;
+		$body =~ s!//[^\n]*!!g;
+		my $value = -1;
+		for my $entry (split(/,/, $body)){
+			next if $entry !~ /(\w+)\s*(=\s*(.*\S))?/s;
+			my ($name, $expr) = ($1, $3);
+			if (! defined $expr){
+				$value++;
+			} elsif ($expr =~ /^\d+$/){
+				$value = $expr;
+			} elsif ($expr =~ /LOC_FIRST_OF\s*\(\s*(\w+)\s*\)/
+					&& defined $modules{$1}){
+				$value = $modules{$1} * 100 + 1;
+			} else {
+				$value++;
+			}
+			$map->{$name} = $value;
+		}
+	}
+}
+
+# Converts the logv() calls of a source file into table lines.
+sub oneFile{
+	my $filename = shift;
+	open(my $INP, "<", $filename) || die "$filename: $!";
+	my $content = join("", <$INP>);
+	close $INP;
+	my %locations;
+	&scanEnums($content, \%locations);
+	while ($content =~ /logv\s*\(\s*LOG_\w+\s*,\s*(\w+)\s*,\s*((?:"(?:[^"\\]|\\.)*"\s*)+)/gs){
+		my ($location, $literal) = ($1, $2);
+		my $no = $locations{$location};
+		$no = $location if $location =~ /^\d+$/;
+		next if ! defined $no;
+		my $format = "";
+		while ($literal =~ /"((?:[^"\\]|\\.)*)"/g){
+			$format .= $1;
+		}
+		print "$no\t$format\n";
+	}
+}
+
+# Processes all sources of a directory tree.
+sub oneDir{
+	my $dir = shift;
+	opendir(my $DIR, $dir) || die "$dir: $!";
+	my @nodes = readdir($DIR);
+	closedir($DIR);
+	for my $node (sort @nodes){
+		next if $node =~ /^\./;
+		my $full = "$dir/$node";
+		if (-d $full){
+			&oneDir($full);
+		} elsif ($node =~ /\.cpp$/){
+			&oneFile($full);
+		}
+	}
+}